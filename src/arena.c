@@ -0,0 +1,284 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Rounds the size up to the alignment of memory returned by the arena
+#define PKCS11_LOGGER_ARENA_ALIGN(size) (((size) + PKCS11_LOGGER_ARENA_ALIGNMENT - 1) & ~((size_t)PKCS11_LOGGER_ARENA_ALIGNMENT - 1))
+
+
+// Structure that holds memory allocated from the heap because it did not fit into the arena
+typedef struct PKCS11_LOGGER_ARENA_BLOCK
+{
+    // Next block in the list
+    struct PKCS11_LOGGER_ARENA_BLOCK *next;
+}
+PKCS11_LOGGER_ARENA_BLOCK;
+
+
+// Structure that holds arena of one thread (allocated together with the memory of the arena)
+typedef struct
+{
+    // Size of the memory of the arena
+    size_t size;
+    // Number of bytes of the arena allocated since the last reset
+    size_t used;
+    // Blocks allocated from the heap since the last reset
+    PKCS11_LOGGER_ARENA_BLOCK *blocks;
+    // Number of allocations served from the arena since the last reset
+    CK_ULONG allocations;
+    // Number of allocations served from the heap since the last reset
+    CK_ULONG heap_allocations;
+    // Number of bytes allocated from the heap since the last reset
+    CK_ULONG heap_used;
+}
+PKCS11_LOGGER_ARENA;
+
+
+// Number of allocations served from arenas of all threads
+static CK_ULONG pkcs11_logger_arena_allocations = 0;
+// Number of bytes allocated from arenas of all threads
+static CK_ULONG pkcs11_logger_arena_allocated = 0;
+// Number of allocations served from the heap because they did not fit into the arena
+static CK_ULONG pkcs11_logger_arena_heap_allocations = 0;
+// Number of bytes allocated from the heap because they did not fit into the arena
+static CK_ULONG pkcs11_logger_arena_heap_allocated = 0;
+// Highest number of bytes allocated by one PKCS#11 function call (protected by the lock)
+static CK_ULONG pkcs11_logger_arena_peak = 0;
+#ifndef _WIN32
+// Key that frees the arena when its thread exits
+static pthread_key_t pkcs11_logger_arena_key;
+// Flag indicating whether the key has been created
+static CK_BBOOL pkcs11_logger_arena_key_created = CK_FALSE;
+#endif
+
+// Arena of the current thread
+static PKCS11_LOGGER_THREAD_LOCAL PKCS11_LOGGER_ARENA *pkcs11_logger_arena = NULL;
+
+
+// Frees blocks allocated from the heap
+static void pkcs11_logger_arena_free_blocks(PKCS11_LOGGER_ARENA *arena)
+{
+    PKCS11_LOGGER_ARENA_BLOCK *block = NULL;
+
+    while (NULL != arena->blocks)
+    {
+        block = arena->blocks;
+        arena->blocks = block->next;
+        CALL_N_CLEAR(free, block);
+    }
+}
+
+
+// Frees the arena
+static void pkcs11_logger_arena_destroy(void *arena)
+{
+    if (NULL == arena)
+        return;
+
+    pkcs11_logger_arena_free_blocks((PKCS11_LOGGER_ARENA *)arena);
+    free(arena);
+}
+
+
+// Creates the arena of the current thread
+static PKCS11_LOGGER_ARENA* pkcs11_logger_arena_create(void)
+{
+    PKCS11_LOGGER_ARENA *arena = NULL;
+    size_t size = PKCS11_LOGGER_ARENA_ALIGN((size_t)pkcs11_logger_globals.arena_size);
+
+    arena = (PKCS11_LOGGER_ARENA*) malloc(PKCS11_LOGGER_ARENA_ALIGN(sizeof(PKCS11_LOGGER_ARENA)) + size);
+    if (NULL == arena)
+        return NULL;
+
+    memset(arena, 0, sizeof(PKCS11_LOGGER_ARENA));
+    arena->size = size;
+
+#ifndef _WIN32
+    // Note: Arena of the thread that exits is freed by the key destructor
+    if (CK_TRUE == pkcs11_logger_arena_key_created)
+        pthread_setspecific(pkcs11_logger_arena_key, arena);
+#endif
+
+    pkcs11_logger_arena = arena;
+
+    return arena;
+}
+
+
+// Prepares release of arenas of exiting threads
+int pkcs11_logger_arena_start(void)
+{
+#ifndef _WIN32
+    if (CK_TRUE != pkcs11_logger_arena_key_created)
+    {
+        if (0 != pthread_key_create(&pkcs11_logger_arena_key, pkcs11_logger_arena_destroy))
+            return PKCS11_LOGGER_RV_ERROR;
+
+        pkcs11_logger_arena_key_created = CK_TRUE;
+    }
+#endif
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Allocates memory that remains valid until the arena of the current thread is reset
+void* pkcs11_logger_arena_alloc(size_t size)
+{
+    PKCS11_LOGGER_ARENA *arena = pkcs11_logger_arena;
+    PKCS11_LOGGER_ARENA_BLOCK *block = NULL;
+    void *memory = NULL;
+
+    if (NULL == arena)
+    {
+        arena = pkcs11_logger_arena_create();
+        if (NULL == arena)
+            return NULL;
+    }
+
+    size = PKCS11_LOGGER_ARENA_ALIGN(size);
+
+    if (size <= arena->size - arena->used)
+    {
+        memory = (char *)arena + PKCS11_LOGGER_ARENA_ALIGN(sizeof(PKCS11_LOGGER_ARENA)) + arena->used;
+        arena->used += size;
+        arena->allocations++;
+        return memory;
+    }
+
+    // Note: Oversized blobs are allocated from the heap and freed together with the arena reset
+    block = (PKCS11_LOGGER_ARENA_BLOCK*) malloc(PKCS11_LOGGER_ARENA_ALIGN(sizeof(PKCS11_LOGGER_ARENA_BLOCK)) + size);
+    if (NULL == block)
+        return NULL;
+
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->heap_allocations++;
+    arena->heap_used += (CK_ULONG)size;
+
+    return (char *)block + PKCS11_LOGGER_ARENA_ALIGN(sizeof(PKCS11_LOGGER_ARENA_BLOCK));
+}
+
+
+// Frees all memory allocated from the arena of the current thread
+void pkcs11_logger_arena_reset(void)
+{
+    PKCS11_LOGGER_ARENA *arena = pkcs11_logger_arena;
+    CK_ULONG usage = 0;
+
+    unsigned long enable_stats = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_STATS) == PKCS11_LOGGER_FLAG_ENABLE_STATS);
+
+    if (NULL == arena)
+        return;
+
+    // Note: Statistics are published once per function call so the allocations do not touch shared memory
+    if ((enable_stats) && ((0 != arena->allocations) || (0 != arena->heap_allocations)))
+    {
+        usage = (CK_ULONG)arena->used + arena->heap_used;
+
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_arena_allocations, arena->allocations);
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_arena_allocated, (CK_ULONG)arena->used);
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_arena_heap_allocations, arena->heap_allocations);
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_arena_heap_allocated, arena->heap_used);
+
+        if (usage > PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_arena_peak))
+        {
+            pkcs11_logger_lock_acquire();
+            if (usage > pkcs11_logger_arena_peak)
+                (void)PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_arena_peak, usage);
+            pkcs11_logger_lock_release();
+        }
+    }
+
+    pkcs11_logger_arena_free_blocks(arena);
+    arena->used = 0;
+    arena->allocations = 0;
+    arena->heap_allocations = 0;
+    arena->heap_used = 0;
+}
+
+
+// Frees the arena of the current thread
+void pkcs11_logger_arena_release(void)
+{
+    PKCS11_LOGGER_ARENA *arena = pkcs11_logger_arena;
+
+    if (NULL == arena)
+        return;
+
+    pkcs11_logger_arena = NULL;
+
+#ifndef _WIN32
+    if (CK_TRUE == pkcs11_logger_arena_key_created)
+        pthread_setspecific(pkcs11_logger_arena_key, NULL);
+#endif
+
+    pkcs11_logger_arena_destroy(arena);
+}
+
+
+// Logs allocation statistics of arenas
+void pkcs11_logger_arena_dump(const char *reason)
+{
+    unsigned long enable_stats = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_STATS) == PKCS11_LOGGER_FLAG_ENABLE_STATS);
+
+    if (!enable_stats)
+        return;
+
+    pkcs11_logger_log("Allocation statistics of thread arenas (dumped on %s)", reason);
+    pkcs11_logger_log(" Arena size: %lu bytes", pkcs11_logger_globals.arena_size);
+    pkcs11_logger_log(" Allocated from arenas: %lu times, %lu bytes",
+        PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_arena_allocations),
+        PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_arena_allocated));
+    pkcs11_logger_log(" Allocated from heap: %lu times, %lu bytes",
+        PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_arena_heap_allocations),
+        PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_arena_heap_allocated));
+    pkcs11_logger_log(" Highest usage by one function call: %lu bytes", PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_arena_peak));
+    pkcs11_logger_log_separator();
+}
+
+
+// Frees the arena of the current thread and resets statistics
+void pkcs11_logger_arena_stop(void)
+{
+    // Note: Arenas of other threads are still used by them and they are no longer freed when the threads exit
+    pkcs11_logger_arena_release();
+
+#ifndef _WIN32
+    if (CK_TRUE == pkcs11_logger_arena_key_created)
+    {
+        pthread_key_delete(pkcs11_logger_arena_key);
+        pkcs11_logger_arena_key_created = CK_FALSE;
+    }
+#endif
+
+    pkcs11_logger_arena_allocations = 0;
+    pkcs11_logger_arena_allocated = 0;
+    pkcs11_logger_arena_heap_allocations = 0;
+    pkcs11_logger_arena_heap_allocated = 0;
+    pkcs11_logger_arena_peak = 0;
+}
@@ -0,0 +1,585 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+// Measures throughput of performance critical logger routines on the current machine
+
+
+#include "pkcs11-logger.h"
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Sizes of byte arrays encoded by hex encoder benchmark
+static const CK_ULONG pkcs11_logger_benchmark_hex_sizes[] = { 16, 64, 256, 1024, 4096, 65536, 1048576, 16777216 };
+// Number of bytes encoded by each implementation for each size
+#define PKCS11_LOGGER_BENCHMARK_HEX_VOLUME 268435456ULL
+// Number of bytes checksummed by each CRC32C implementation for each size
+#define PKCS11_LOGGER_BENCHMARK_CRC32C_VOLUME 1073741824ULL
+// CRC32C checksum of ASCII string "123456789"
+#define PKCS11_LOGGER_BENCHMARK_CRC32C_CHECK 0xE3069283UL
+// Numbers of threads writing log records concurrently
+static const CK_ULONG pkcs11_logger_benchmark_queue_threads[] = { 1, 8, 32, 128 };
+// Number of log records written by all threads together for each number of threads
+#define PKCS11_LOGGER_BENCHMARK_QUEUE_RECORDS 256000
+// Log file written by log record benchmark
+#define PKCS11_LOGGER_BENCHMARK_QUEUE_LOG_FILE "pkcs11-logger-benchmark.log"
+// Maximal length of log record written by log record benchmark
+#define PKCS11_LOGGER_BENCHMARK_QUEUE_RECORD_SIZE 64
+
+// Ways of writing log records compared by log record benchmark
+#define PKCS11_LOGGER_BENCHMARK_QUEUE_MODE_LOCK 0
+#define PKCS11_LOGGER_BENCHMARK_QUEUE_MODE_SYNC 1
+#define PKCS11_LOGGER_BENCHMARK_QUEUE_MODE_ASYNC 2
+
+
+// Structure that holds arguments of a thread writing log records
+typedef struct
+{
+    // Index of the thread
+    CK_ULONG index;
+    // Number of records written by the thread
+    CK_ULONG records;
+    // One of PKCS11_LOGGER_BENCHMARK_QUEUE_MODE_* values
+    int mode;
+}
+PKCS11_LOGGER_BENCHMARK_QUEUE_THREAD;
+
+
+// Returns monotonic time in nanoseconds
+static unsigned long long pkcs11_logger_benchmark_get_time(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (unsigned long long)((double)counter.QuadPart * 1000000000.0 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+
+// Encodes bytes the way pkcs11_logger_translate_ck_byte_ptr did before hex encoders were introduced
+static void pkcs11_logger_benchmark_hex_encode_reference(const CK_BYTE *bytes, CK_ULONG length, char *output)
+{
+    CK_ULONG i = 0;
+    const char *t = "0123456789ABCDEF";
+
+    memset(output, 0, (length * 2) + 1);
+
+    for (i = 0; i < length; i++)
+    {
+        int lo = bytes[i] & 0x0F;
+        int hi = bytes[i] >> 4;
+        output[i * 2] = t[hi];
+        output[i * 2 + 1] = t[lo];
+    }
+}
+
+
+// Measures throughput of the encoder in MB/s
+static double pkcs11_logger_benchmark_hex_measure(PKCS11_LOGGER_HEX_ENCODER encoder, const CK_BYTE *bytes, CK_ULONG length, char *output)
+{
+    unsigned long long iterations = PKCS11_LOGGER_BENCHMARK_HEX_VOLUME / length;
+    unsigned long long start = 0;
+    unsigned long long elapsed = 0;
+    unsigned long long i = 0;
+
+    // Note: Output of the first run is discarded so the pages of the output buffer are already mapped
+    encoder(bytes, length, output);
+
+    start = pkcs11_logger_benchmark_get_time();
+    for (i = 0; i < iterations; i++)
+        encoder(bytes, length, output);
+    elapsed = pkcs11_logger_benchmark_get_time() - start;
+
+    if (0 == elapsed)
+        elapsed = 1;
+
+    return ((double)length * (double)iterations * 1000.0) / (double)elapsed;
+}
+
+
+// Compares hex encoders with the reference implementation
+static int pkcs11_logger_benchmark_hex(void)
+{
+    CK_ULONG max_size = pkcs11_logger_benchmark_hex_sizes[sizeof(pkcs11_logger_benchmark_hex_sizes) / sizeof(CK_ULONG) - 1];
+    CK_BYTE_PTR bytes = NULL;
+    char *expected = NULL;
+    char *output = NULL;
+    const char *name = NULL;
+    PKCS11_LOGGER_HEX_ENCODER encoder = NULL;
+    CK_ULONG i = 0;
+    CK_ULONG j = 0;
+    int rv = PKCS11_LOGGER_RV_ERROR;
+
+    bytes = (CK_BYTE_PTR) malloc(max_size);
+    expected = (char *) malloc((size_t)max_size * 2 + 1);
+    output = (char *) malloc((size_t)max_size * 2 + 1);
+    if ((NULL == bytes) || (NULL == expected) || (NULL == output))
+    {
+        fprintf(stderr, "Unable to allocate buffers\n");
+        goto err;
+    }
+
+    for (i = 0; i < max_size; i++)
+        bytes[i] = (CK_BYTE)((i * 2654435761UL) >> 13);
+
+    // Note: Every implementation must produce exactly the same output as the reference implementation
+    pkcs11_logger_benchmark_hex_encode_reference(bytes, max_size, expected);
+    for (j = 0; NULL != (name = pkcs11_logger_hex_get_implementation(j, &encoder)); j++)
+    {
+        if (NULL == encoder)
+            continue;
+
+        for (i = 0; i < 256; i++)
+        {
+            memset(output, 0, (size_t)i * 2 + 1);
+            encoder(bytes + i, i, output);
+            if ((0 != memcmp(output, expected + i * 2, i * 2)) || (0 != output[i * 2]))
+            {
+                fprintf(stderr, "Hex encoder %s produced invalid output for %lu bytes\n", name, i);
+                goto err;
+            }
+        }
+    }
+
+    printf("Hex encoder throughput in MB/s (speedup against reference implementation)\n");
+    printf("%10s %10s", "size", "reference");
+    for (j = 0; NULL != (name = pkcs11_logger_hex_get_implementation(j, NULL)); j++)
+        printf(" %18s", name);
+    printf("\n");
+
+    for (i = 0; i < sizeof(pkcs11_logger_benchmark_hex_sizes) / sizeof(CK_ULONG); i++)
+    {
+        CK_ULONG size = pkcs11_logger_benchmark_hex_sizes[i];
+        double reference = pkcs11_logger_benchmark_hex_measure(pkcs11_logger_benchmark_hex_encode_reference, bytes, size, output);
+
+        printf("%10lu %10.0f", size, reference);
+        for (j = 0; NULL != (name = pkcs11_logger_hex_get_implementation(j, &encoder)); j++)
+        {
+            double throughput = 0;
+
+            if (NULL == encoder)
+            {
+                printf(" %18s", "unsupported");
+                continue;
+            }
+
+            throughput = pkcs11_logger_benchmark_hex_measure(encoder, bytes, size, output);
+            printf(" %10.0f (%4.1fx)", throughput, throughput / reference);
+        }
+        printf("\n");
+    }
+
+    rv = PKCS11_LOGGER_RV_SUCCESS;
+
+err:
+
+    CALL_N_CLEAR(free, bytes);
+    CALL_N_CLEAR(free, expected);
+    CALL_N_CLEAR(free, output);
+
+    return rv;
+}
+
+
+// Measures throughput of the CRC32C implementation in MB/s
+static double pkcs11_logger_benchmark_crc32c_measure(PKCS11_LOGGER_CRC32C_FUNCTION function, const CK_BYTE *bytes, CK_ULONG length)
+{
+    unsigned long long iterations = PKCS11_LOGGER_BENCHMARK_CRC32C_VOLUME / length;
+    unsigned long long start = 0;
+    unsigned long long elapsed = 0;
+    unsigned long long i = 0;
+    volatile CK_ULONG crc = 0;
+
+    start = pkcs11_logger_benchmark_get_time();
+    for (i = 0; i < iterations; i++)
+        crc ^= function(bytes, length);
+    elapsed = pkcs11_logger_benchmark_get_time() - start;
+
+    if (0 == elapsed)
+        elapsed = 1;
+
+    return ((double)length * (double)iterations * 1000.0) / (double)elapsed;
+}
+
+
+// Compares CRC32C implementations with the scalar implementation
+static int pkcs11_logger_benchmark_crc32c(void)
+{
+    CK_ULONG max_size = pkcs11_logger_benchmark_hex_sizes[sizeof(pkcs11_logger_benchmark_hex_sizes) / sizeof(CK_ULONG) - 1];
+    CK_BYTE_PTR bytes = NULL;
+    const char *name = NULL;
+    PKCS11_LOGGER_CRC32C_FUNCTION function = NULL;
+    PKCS11_LOGGER_CRC32C_FUNCTION scalar = NULL;
+    CK_ULONG i = 0;
+    CK_ULONG j = 0;
+    int rv = PKCS11_LOGGER_RV_ERROR;
+
+    bytes = (CK_BYTE_PTR) malloc(max_size);
+    if (NULL == bytes)
+    {
+        fprintf(stderr, "Unable to allocate buffers\n");
+        goto err;
+    }
+
+    for (i = 0; i < max_size; i++)
+        bytes[i] = (CK_BYTE)((i * 2654435761UL) >> 13);
+
+    // Note: Every implementation must produce the standard check value and the same checksums as the scalar implementation
+    pkcs11_logger_crc32c_get_implementation(0, &scalar);
+    for (j = 0; NULL != (name = pkcs11_logger_crc32c_get_implementation(j, &function)); j++)
+    {
+        if (NULL == function)
+            continue;
+
+        if (PKCS11_LOGGER_BENCHMARK_CRC32C_CHECK != function((const CK_BYTE *)"123456789", 9))
+        {
+            fprintf(stderr, "CRC32C implementation %s produced invalid check value\n", name);
+            goto err;
+        }
+
+        for (i = 0; i < 256; i++)
+        {
+            if (scalar(bytes + i, i) != function(bytes + i, i))
+            {
+                fprintf(stderr, "CRC32C implementation %s produced invalid checksum of %lu bytes\n", name, i);
+                goto err;
+            }
+        }
+    }
+
+    printf("CRC32C throughput in MB/s (speedup against scalar implementation)\n");
+    printf("%10s", "size");
+    for (j = 0; NULL != (name = pkcs11_logger_crc32c_get_implementation(j, NULL)); j++)
+        printf(" %18s", name);
+    printf("\n");
+
+    for (i = 0; i < sizeof(pkcs11_logger_benchmark_hex_sizes) / sizeof(CK_ULONG); i++)
+    {
+        CK_ULONG size = pkcs11_logger_benchmark_hex_sizes[i];
+        double reference = pkcs11_logger_benchmark_crc32c_measure(scalar, bytes, size);
+
+        printf("%10lu", size);
+        for (j = 0; NULL != (name = pkcs11_logger_crc32c_get_implementation(j, &function)); j++)
+        {
+            double throughput = 0;
+
+            if (NULL == function)
+            {
+                printf(" %18s", "unsupported");
+                continue;
+            }
+
+            throughput = (function == scalar) ? reference : pkcs11_logger_benchmark_crc32c_measure(function, bytes, size);
+            printf(" %10.0f (%4.1fx)", throughput, throughput / reference);
+        }
+        printf("\n");
+    }
+
+    rv = PKCS11_LOGGER_RV_SUCCESS;
+
+err:
+
+    CALL_N_CLEAR(free, bytes);
+
+    return rv;
+}
+
+
+// Writes records of one thread in the selected way
+#ifdef _WIN32
+static DWORD WINAPI pkcs11_logger_benchmark_queue_thread_proc(LPVOID arg)
+#else
+static void* pkcs11_logger_benchmark_queue_thread_proc(void *arg)
+#endif
+{
+    PKCS11_LOGGER_BENCHMARK_QUEUE_THREAD *thread = (PKCS11_LOGGER_BENCHMARK_QUEUE_THREAD *)arg;
+    PKCS11_LOGGER_RECORD *record = NULL;
+    CK_ULONG i = 0;
+    union
+    {
+        PKCS11_LOGGER_RECORD record;
+        char bytes[sizeof(PKCS11_LOGGER_RECORD) + PKCS11_LOGGER_BENCHMARK_QUEUE_RECORD_SIZE];
+    }
+    buffer;
+
+    for (i = 0; i < thread->records; i++)
+    {
+        // Note: Queued record is freed by the background writer thread
+        record = (PKCS11_LOGGER_BENCHMARK_QUEUE_MODE_ASYNC == thread->mode) ? (PKCS11_LOGGER_RECORD*) malloc(sizeof(PKCS11_LOGGER_RECORD) + PKCS11_LOGGER_BENCHMARK_QUEUE_RECORD_SIZE) : &(buffer.record);
+        if (NULL == record)
+            break;
+
+        record->next = NULL;
+        record->data_len = (size_t)snprintf(record->data, PKCS11_LOGGER_BENCHMARK_QUEUE_RECORD_SIZE, "thread %lu record %lu\n", thread->index, i);
+
+        switch (thread->mode)
+        {
+            case PKCS11_LOGGER_BENCHMARK_QUEUE_MODE_LOCK:
+
+                // Note: Records were written this way before they were published through the lock-free stack
+                pkcs11_logger_lock_acquire();
+                if (NULL == pkcs11_logger_globals.log_file_handle)
+                    pkcs11_logger_globals.log_file_handle = fopen(PKCS11_LOGGER_BENCHMARK_QUEUE_LOG_FILE, "a");
+                fwrite(record->data, 1, record->data_len, pkcs11_logger_globals.log_file_handle);
+                fflush(pkcs11_logger_globals.log_file_handle);
+                pkcs11_logger_lock_release();
+                break;
+
+            case PKCS11_LOGGER_BENCHMARK_QUEUE_MODE_SYNC:
+
+                pkcs11_logger_log_write_records(record);
+                break;
+
+            default:
+
+                if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_queue_push(record))
+                    free(record);
+                break;
+        }
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+
+// Checks that the log file contains all records of all threads in the order each thread wrote them
+static int pkcs11_logger_benchmark_queue_verify(CK_ULONG threads_count, CK_ULONG records)
+{
+    FILE *file = NULL;
+    CK_ULONG *next = NULL;
+    CK_ULONG index = 0;
+    CK_ULONG record = 0;
+    CK_ULONG i = 0;
+    int rv = PKCS11_LOGGER_RV_ERROR;
+
+    next = (CK_ULONG *) calloc(threads_count, sizeof(CK_ULONG));
+    if (NULL == next)
+        goto err;
+
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable: 4996)
+#endif
+    file = fopen(PKCS11_LOGGER_BENCHMARK_QUEUE_LOG_FILE, "r");
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    if (NULL == file)
+        goto err;
+
+    while (2 == fscanf(file, "thread %lu record %lu\n", &index, &record))
+    {
+        if ((index >= threads_count) || (record != next[index]))
+            goto err;
+
+        next[index]++;
+    }
+
+    if (!feof(file))
+        goto err;
+
+    for (i = 0; i < threads_count; i++)
+    {
+        if (next[i] != records)
+            goto err;
+    }
+
+    rv = PKCS11_LOGGER_RV_SUCCESS;
+
+err:
+
+    CALL_N_CLEAR(fclose, file);
+    CALL_N_CLEAR(free, next);
+
+    return rv;
+}
+
+
+// Measures time in milliseconds needed by the threads to write their records in the selected way
+static double pkcs11_logger_benchmark_queue_measure(CK_ULONG threads_count, int mode)
+{
+    PKCS11_LOGGER_BENCHMARK_QUEUE_THREAD *threads = NULL;
+#ifdef _WIN32
+    HANDLE *handles = NULL;
+#else
+    pthread_t *handles = NULL;
+#endif
+    unsigned long long start = 0;
+    unsigned long long elapsed = 0;
+    CK_ULONG started = 0;
+    CK_ULONG i = 0;
+    double rv = -1;
+
+    remove(PKCS11_LOGGER_BENCHMARK_QUEUE_LOG_FILE);
+
+    threads = (PKCS11_LOGGER_BENCHMARK_QUEUE_THREAD *) calloc(threads_count, sizeof(PKCS11_LOGGER_BENCHMARK_QUEUE_THREAD));
+    handles = calloc(threads_count, sizeof(*handles));
+    if ((NULL == threads) || (NULL == handles))
+        goto err;
+
+    if ((PKCS11_LOGGER_BENCHMARK_QUEUE_MODE_ASYNC == mode) && (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_queue_start()))
+        goto err;
+
+    start = pkcs11_logger_benchmark_get_time();
+
+    for (started = 0; started < threads_count; started++)
+    {
+        threads[started].index = started;
+        threads[started].records = PKCS11_LOGGER_BENCHMARK_QUEUE_RECORDS / threads_count;
+        threads[started].mode = mode;
+
+#ifdef _WIN32
+        handles[started] = CreateThread(NULL, 0, pkcs11_logger_benchmark_queue_thread_proc, &threads[started], 0, NULL);
+        if (NULL == handles[started])
+            break;
+#else
+        if (0 != pthread_create(&handles[started], NULL, pkcs11_logger_benchmark_queue_thread_proc, &threads[started]))
+            break;
+#endif
+    }
+
+    for (i = 0; i < started; i++)
+    {
+#ifdef _WIN32
+        WaitForSingleObject(handles[i], INFINITE);
+        CloseHandle(handles[i]);
+#else
+        pthread_join(handles[i], NULL);
+#endif
+    }
+
+    // Note: Measured time includes writing of the records still waiting in the queue
+    if (PKCS11_LOGGER_BENCHMARK_QUEUE_MODE_ASYNC == mode)
+        pkcs11_logger_queue_stop(CK_TRUE);
+
+    elapsed = pkcs11_logger_benchmark_get_time() - start;
+
+    CALL_N_CLEAR(fclose, pkcs11_logger_globals.log_file_handle);
+
+    if ((started == threads_count) && (PKCS11_LOGGER_RV_SUCCESS == pkcs11_logger_benchmark_queue_verify(threads_count, PKCS11_LOGGER_BENCHMARK_QUEUE_RECORDS / threads_count)))
+        rv = (double)elapsed / 1000000.0;
+
+err:
+
+    CALL_N_CLEAR(free, threads);
+    CALL_N_CLEAR(free, handles);
+
+    remove(PKCS11_LOGGER_BENCHMARK_QUEUE_LOG_FILE);
+
+    return rv;
+}
+
+
+// Compares lock-free publishing of log records with writing of each record under the lock
+static int pkcs11_logger_benchmark_queue(void)
+{
+    const char *names[] = { "lock", "sync", "async" };
+    CK_ULONG i = 0;
+    int mode = 0;
+    int rv = PKCS11_LOGGER_RV_ERROR;
+
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_lock_create())
+    {
+        fprintf(stderr, "Unable to create lock\n");
+        return rv;
+    }
+
+    // Note: Records are written only to the log file and flushed after each write
+    pkcs11_logger_globals.env_var_log_file_path = (CK_CHAR_PTR) malloc(sizeof(PKCS11_LOGGER_BENCHMARK_QUEUE_LOG_FILE));
+    if (NULL == pkcs11_logger_globals.env_var_log_file_path)
+    {
+        fprintf(stderr, "Unable to allocate buffers\n");
+        goto err;
+    }
+
+    memcpy(pkcs11_logger_globals.env_var_log_file_path, PKCS11_LOGGER_BENCHMARK_QUEUE_LOG_FILE, sizeof(PKCS11_LOGGER_BENCHMARK_QUEUE_LOG_FILE));
+    pkcs11_logger_globals.env_vars_read = CK_TRUE;
+
+    printf("Time in ms needed to write %d log records (speedup against writing under the lock)\n", PKCS11_LOGGER_BENCHMARK_QUEUE_RECORDS);
+    printf("%10s", "threads");
+    for (mode = 0; mode < (int)(sizeof(names) / sizeof(const char *)); mode++)
+        printf(" %18s", names[mode]);
+    printf("\n");
+
+    for (i = 0; i < sizeof(pkcs11_logger_benchmark_queue_threads) / sizeof(CK_ULONG); i++)
+    {
+        CK_ULONG threads_count = pkcs11_logger_benchmark_queue_threads[i];
+        double reference = 0;
+
+        printf("%10lu", threads_count);
+        for (mode = 0; mode < (int)(sizeof(names) / sizeof(const char *)); mode++)
+        {
+            // Note: Every way of writing must keep all records of each thread in the order the thread wrote them
+            double elapsed = pkcs11_logger_benchmark_queue_measure(threads_count, mode);
+            if (elapsed < 0)
+            {
+                printf("\n");
+                fprintf(stderr, "Log records written in %s mode by %lu threads were lost or reordered\n", names[mode], threads_count);
+                goto err;
+            }
+
+            if (PKCS11_LOGGER_BENCHMARK_QUEUE_MODE_LOCK == mode)
+                reference = elapsed;
+
+            printf(" %10.0f (%4.1fx)", elapsed, reference / elapsed);
+        }
+        printf("\n");
+    }
+
+    rv = PKCS11_LOGGER_RV_SUCCESS;
+
+err:
+
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_log_file_path);
+
+    return rv;
+}
+
+
+int main(void)
+{
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_benchmark_hex())
+        return 1;
+
+    printf("\n");
+
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_benchmark_crc32c())
+        return 1;
+
+    printf("\n");
+
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_benchmark_queue())
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,359 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Process that owns the table of strings already written into the log file
+static int pkcs11_logger_binary_strings_pid = 0;
+// Table of strings already written into the log file (lock must be held by the user)
+static const char *pkcs11_logger_binary_strings[PKCS11_LOGGER_BINARY_STRINGS_SIZE];
+
+
+// Stores 32-bit value into the buffer (if present) and returns new offset
+static size_t pkcs11_logger_binary_put_u32(char *buffer, size_t offset, unsigned int value)
+{
+    if (NULL != buffer)
+        memcpy(buffer + offset, &value, sizeof(value));
+
+    return offset + sizeof(value);
+}
+
+
+// Stores 64-bit value into the buffer (if present) and returns new offset
+static size_t pkcs11_logger_binary_put_u64(char *buffer, size_t offset, unsigned long long value)
+{
+    if (NULL != buffer)
+        memcpy(buffer + offset, &value, sizeof(value));
+
+    return offset + sizeof(value);
+}
+
+
+// Stores length prefixed byte array into the buffer (if present) and returns new offset
+static size_t pkcs11_logger_binary_put_bytes(char *buffer, size_t offset, const void *bytes, size_t bytes_len)
+{
+    offset = pkcs11_logger_binary_put_u32(buffer, offset, (unsigned int)bytes_len);
+
+    if ((NULL != buffer) && (0 != bytes_len))
+        memcpy(buffer + offset, bytes, bytes_len);
+
+    return offset + bytes_len;
+}
+
+
+// Stores common entry header into the buffer (if present) and returns new offset
+static size_t pkcs11_logger_binary_put_header(char *buffer, size_t entry_len, unsigned char type, unsigned char flags)
+{
+    size_t offset = pkcs11_logger_binary_put_u32(buffer, 0, (unsigned int)entry_len);
+
+    if (NULL != buffer)
+    {
+        buffer[offset] = (char)type;
+        buffer[offset + 1] = (char)flags;
+        buffer[offset + 2] = 0;
+        buffer[offset + 3] = 0;
+    }
+
+    return PKCS11_LOGGER_BINARY_ENTRY_HEADER_SIZE;
+}
+
+
+// Stores message entry with raw arguments into the buffer (if present) and returns its length
+static size_t pkcs11_logger_binary_put_message(char *buffer, unsigned char flags, unsigned long long timestamp, const char* message, va_list ap)
+{
+    size_t offset = 0;
+    const char *p = NULL;
+    const char *str = NULL;
+    size_t str_len = 0;
+    CK_BYTE_PTR bytes = NULL;
+    CK_ULONG bytes_len = 0;
+    int precision = 0;
+    int long_count = 0;
+
+    offset = pkcs11_logger_binary_put_header(NULL, 0, PKCS11_LOGGER_BINARY_ENTRY_MESSAGE, flags);
+    offset = pkcs11_logger_binary_put_u64(buffer, offset, (unsigned long long)(size_t)message);
+    offset = pkcs11_logger_binary_put_u32(buffer, offset, (unsigned int)pkcs11_logger_utils_get_cached_process_id());
+    offset = pkcs11_logger_binary_put_u64(buffer, offset, (unsigned long long)pkcs11_logger_utils_get_cached_thread_id());
+    if (flags & PKCS11_LOGGER_BINARY_FLAG_TIMESTAMP)
+        offset = pkcs11_logger_binary_put_u64(buffer, offset, timestamp);
+
+    // Note: Only arguments are stored because the message is identified by the address of its format string
+    for (p = message; '\0' != *p; p++)
+    {
+        if ('%' != *p)
+            continue;
+
+        p++;
+        if (('\0' == *p) || ('%' == *p))
+        {
+            if ('\0' == *p)
+                break;
+            continue;
+        }
+
+        precision = -1;
+        long_count = 0;
+
+        while (('-' == *p) || ('+' == *p) || (' ' == *p) || ('#' == *p) || ('0' == *p))
+            p++;
+        while (('0' <= *p) && ('9' >= *p))
+            p++;
+        if ('.' == *p)
+        {
+            p++;
+            precision = 0;
+            while (('0' <= *p) && ('9' >= *p))
+            {
+                precision = (precision * 10) + (*p - '0');
+                p++;
+            }
+        }
+        while (('l' == *p) || ('h' == *p))
+        {
+            if ('l' == *p)
+                long_count++;
+            p++;
+        }
+
+        switch (*p)
+        {
+            case 'd':
+            case 'i':
+                if (long_count > 1)
+                    offset = pkcs11_logger_binary_put_u64(buffer, offset, (unsigned long long)va_arg(ap, long long));
+                else if (long_count == 1)
+                    offset = pkcs11_logger_binary_put_u64(buffer, offset, (unsigned long long)va_arg(ap, long));
+                else
+                    offset = pkcs11_logger_binary_put_u64(buffer, offset, (unsigned long long)va_arg(ap, int));
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'c':
+                if (long_count > 1)
+                    offset = pkcs11_logger_binary_put_u64(buffer, offset, va_arg(ap, unsigned long long));
+                else if (long_count == 1)
+                    offset = pkcs11_logger_binary_put_u64(buffer, offset, (unsigned long long)va_arg(ap, unsigned long));
+                else
+                    offset = pkcs11_logger_binary_put_u64(buffer, offset, (unsigned long long)va_arg(ap, unsigned int));
+                break;
+            case 'p':
+                offset = pkcs11_logger_binary_put_u64(buffer, offset, (unsigned long long)(size_t)va_arg(ap, void*));
+                break;
+            case 's':
+                str = va_arg(ap, const char*);
+                if (NULL == str)
+                    str = "(null)";
+                if (precision >= 0)
+                {
+                    // Note: String limited by precision does not need to be zero terminated
+                    const char *end = (const char*) memchr(str, 0, precision);
+                    str_len = (NULL != end) ? (size_t)(end - str) : (size_t)precision;
+                }
+                else
+                {
+                    str_len = strlen(str);
+                }
+                offset = pkcs11_logger_binary_put_bytes(buffer, offset, str, str_len);
+                break;
+            case PKCS11_LOGGER_BINARY_CONVERSION_BYTES:
+                bytes = va_arg(ap, CK_BYTE_PTR);
+                bytes_len = va_arg(ap, CK_ULONG);
+                offset = pkcs11_logger_binary_put_bytes(buffer, offset, bytes, bytes_len);
+                break;
+            default:
+                break;
+        }
+
+        if ('\0' == *p)
+            break;
+    }
+
+    pkcs11_logger_binary_put_header(buffer, offset, PKCS11_LOGGER_BINARY_ENTRY_MESSAGE, flags);
+
+    return offset;
+}
+
+
+// Encodes message and its raw arguments into the record
+PKCS11_LOGGER_RECORD* pkcs11_logger_binary_create_record(CK_BBOOL timestamp, const char* message, va_list ap)
+{
+    PKCS11_LOGGER_RECORD *record = NULL;
+    unsigned long long time = 0;
+    unsigned char flags = 0;
+    size_t len = 0;
+    va_list ap_copy;
+
+    unsigned long disable_process_id = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_DISABLE_PROCESS_ID) == PKCS11_LOGGER_FLAG_DISABLE_PROCESS_ID);
+    unsigned long disable_thread_id = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_DISABLE_THREAD_ID) == PKCS11_LOGGER_FLAG_DISABLE_THREAD_ID);
+
+    if (!disable_process_id)
+        flags |= PKCS11_LOGGER_BINARY_FLAG_PROCESS_ID;
+    if (!disable_thread_id)
+        flags |= PKCS11_LOGGER_BINARY_FLAG_THREAD_ID;
+    if (CK_TRUE == timestamp)
+    {
+        flags |= PKCS11_LOGGER_BINARY_FLAG_TIMESTAMP;
+        time = pkcs11_logger_utils_get_monotonic_time();
+    }
+
+    va_copy(ap_copy, ap);
+    len = pkcs11_logger_binary_put_message(NULL, flags, time, message, ap_copy);
+    va_end(ap_copy);
+
+    record = (PKCS11_LOGGER_RECORD*) malloc(sizeof(PKCS11_LOGGER_RECORD) + len);
+    if (NULL == record)
+        return NULL;
+
+    record->next = NULL;
+    record->data_len = pkcs11_logger_binary_put_message(record->data, flags, time, message, ap);
+
+    return record;
+}
+
+
+// Forgets all strings written into the log file
+static void pkcs11_logger_binary_reset_strings(void)
+{
+    memset(pkcs11_logger_binary_strings, 0, sizeof(pkcs11_logger_binary_strings));
+    pkcs11_logger_binary_strings_pid = pkcs11_logger_utils_get_process_id();
+}
+
+
+// Determines whether the string has been already written into the log file and remembers it otherwise
+static CK_BBOOL pkcs11_logger_binary_string_written(const char *string)
+{
+    size_t start = ((size_t)string >> 3) % PKCS11_LOGGER_BINARY_STRINGS_SIZE;
+    size_t i = 0;
+
+    for (i = 0; i < PKCS11_LOGGER_BINARY_STRINGS_SIZE; i++)
+    {
+        size_t slot = (start + i) % PKCS11_LOGGER_BINARY_STRINGS_SIZE;
+
+        if (string == pkcs11_logger_binary_strings[slot])
+            return CK_TRUE;
+
+        if (NULL == pkcs11_logger_binary_strings[slot])
+        {
+            pkcs11_logger_binary_strings[slot] = string;
+            return CK_FALSE;
+        }
+    }
+
+    // Note: Table is full so the string is written again
+    return CK_FALSE;
+}
+
+
+// Writes entry that defines string referenced by messages of current process
+static void pkcs11_logger_binary_write_string(FILE *file, const char *string)
+{
+    char buffer[PKCS11_LOGGER_BINARY_ENTRY_HEADER_SIZE + 12];
+    size_t string_len = strlen(string);
+    size_t offset = 0;
+
+    offset = pkcs11_logger_binary_put_header(buffer, sizeof(buffer) + string_len, PKCS11_LOGGER_BINARY_ENTRY_STRING, 0);
+    offset = pkcs11_logger_binary_put_u32(buffer, offset, (unsigned int)pkcs11_logger_binary_strings_pid);
+    offset = pkcs11_logger_binary_put_u64(buffer, offset, (unsigned long long)(size_t)string);
+
+    fwrite(buffer, 1, offset, file);
+    fwrite(string, 1, string_len, file);
+}
+
+
+// Writes file header if needed and entry that allows conversion of timestamps to system time (lock must be held by the caller)
+void pkcs11_logger_binary_open_file(FILE *file)
+{
+    char buffer[PKCS11_LOGGER_BINARY_ENTRY_HEADER_SIZE + 20];
+    size_t offset = 0;
+
+    if (NULL == file)
+        return;
+
+    if ((0 == fseek(file, 0, SEEK_END)) && (0 == ftell(file)))
+    {
+        // Note: Strings written into the previous file are not present in the new one
+        pkcs11_logger_binary_reset_strings();
+
+        memcpy(buffer, PKCS11_LOGGER_BINARY_MAGIC, sizeof(PKCS11_LOGGER_BINARY_MAGIC));
+        offset = pkcs11_logger_binary_put_u32(buffer, sizeof(PKCS11_LOGGER_BINARY_MAGIC), PKCS11_LOGGER_BINARY_VERSION);
+        offset = pkcs11_logger_binary_put_u32(buffer, offset, PKCS11_LOGGER_BINARY_BYTE_ORDER);
+        fwrite(buffer, 1, offset, file);
+    }
+
+    offset = pkcs11_logger_binary_put_header(buffer, sizeof(buffer), PKCS11_LOGGER_BINARY_ENTRY_CLOCK, 0);
+    offset = pkcs11_logger_binary_put_u32(buffer, offset, (unsigned int)pkcs11_logger_utils_get_process_id());
+    offset = pkcs11_logger_binary_put_u64(buffer, offset, pkcs11_logger_utils_get_realtime());
+    offset = pkcs11_logger_binary_put_u64(buffer, offset, pkcs11_logger_utils_get_monotonic_time());
+    fwrite(buffer, 1, offset, file);
+}
+
+
+// Writes binary records preceded by definitions of strings they reference (lock must be held by the caller)
+void pkcs11_logger_binary_write_records(FILE *file, PKCS11_LOGGER_RECORD *records)
+{
+    PKCS11_LOGGER_RECORD *record = NULL;
+
+    if (NULL == file)
+        return;
+
+    // Note: Strings written by the parent process are unknown to the forked child
+    if (pkcs11_logger_binary_strings_pid != pkcs11_logger_utils_get_process_id())
+        pkcs11_logger_binary_reset_strings();
+
+    for (record = records; NULL != record; record = record->next)
+    {
+        size_t start = 0;
+        size_t offset = 0;
+
+        // Note: Record may contain multiple entries when call records are enabled
+        while (offset + PKCS11_LOGGER_BINARY_ENTRY_HEADER_SIZE + 8 <= record->data_len)
+        {
+            unsigned int entry_len = 0;
+            unsigned long long id = 0;
+
+            memcpy(&entry_len, record->data + offset, sizeof(entry_len));
+            if ((entry_len < PKCS11_LOGGER_BINARY_ENTRY_HEADER_SIZE) || (offset + entry_len > record->data_len))
+                break;
+
+            if (PKCS11_LOGGER_BINARY_ENTRY_MESSAGE == (unsigned char)record->data[offset + 4])
+            {
+                memcpy(&id, record->data + offset + PKCS11_LOGGER_BINARY_ENTRY_HEADER_SIZE, sizeof(id));
+                if (CK_FALSE == pkcs11_logger_binary_string_written((const char*)(size_t)id))
+                {
+                    fwrite(record->data + start, 1, offset - start, file);
+                    pkcs11_logger_binary_write_string(file, (const char*)(size_t)id);
+                    start = offset;
+                }
+            }
+
+            offset += entry_len;
+        }
+
+        fwrite(record->data + start, 1, record->data_len - start, file);
+    }
+}
@@ -0,0 +1,1250 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Number of buckets of the hash table with cached responses
+#define PKCS11_LOGGER_CACHE_BUCKETS 256
+
+
+// Structure that holds cached response of one call (allocated together with the response)
+typedef struct PKCS11_LOGGER_CACHE_ENTRY
+{
+    // Next entry in the same bucket
+    struct PKCS11_LOGGER_CACHE_ENTRY *next;
+    // Identifier of PKCS#11 function
+    CK_ULONG function;
+    // Slot passed to the function
+    CK_SLOT_ID slot;
+    // Other argument of the function the response depends on (e.g. mechanism type or object handle)
+    CK_ULONG key;
+    // Additional argument of the function the response depends on (e.g. attribute type)
+    CK_ULONG subkey;
+    // Monotonic time in nanoseconds after which the response is no longer used
+    unsigned long long expires;
+    // Length of the response in bytes
+    CK_ULONG data_len;
+    // Response
+    CK_BYTE data[1];
+}
+PKCS11_LOGGER_CACHE_ENTRY;
+
+
+// Structure that holds search of objects answered from the cache or recorded for the cache
+typedef struct
+{
+    // Flag indicating whether the search is answered from the cache instead of the original library
+    CK_BBOOL cached;
+    // Flag indicating whether the original library has returned all found objects
+    CK_BBOOL complete;
+    // Generation of the cache in which the search was initialized
+    CK_ULONG generation;
+    // Hash of the canonical template
+    CK_ULONG hash;
+    // Canonical template followed by handles of found objects
+    CK_BYTE_PTR data;
+    // Length of the canonical template in bytes
+    CK_ULONG template_len;
+    // Number of handles of found objects
+    CK_ULONG count;
+    // Number of handles that fit into the allocated data
+    CK_ULONG capacity;
+    // Number of handles already returned from the cache
+    CK_ULONG position;
+}
+PKCS11_LOGGER_CACHE_SEARCH;
+
+
+// Structure that holds slot and active search of one open session
+typedef struct PKCS11_LOGGER_CACHE_SESSION
+{
+    // Next session in the same bucket
+    struct PKCS11_LOGGER_CACHE_SESSION *next;
+    // Handle of the session
+    CK_SESSION_HANDLE session;
+    // Slot of the session
+    CK_SLOT_ID slot;
+    // Active search of objects (NULL when there is none)
+    PKCS11_LOGGER_CACHE_SEARCH *search;
+}
+PKCS11_LOGGER_CACHE_SESSION;
+
+
+// Attributes that cannot be modified once the object is created and never hold secret values
+static const CK_ATTRIBUTE_TYPE pkcs11_logger_cache_immutable_attributes[] =
+{
+    CKA_CLASS,
+    CKA_TOKEN,
+    CKA_PRIVATE,
+    CKA_CERTIFICATE_TYPE,
+    CKA_KEY_TYPE,
+    CKA_LOCAL,
+    CKA_KEY_GEN_MECHANISM,
+    CKA_MODULUS,
+    CKA_MODULUS_BITS,
+    CKA_PUBLIC_EXPONENT,
+    CKA_PRIME_BITS,
+    CKA_SUBPRIME_BITS,
+    CKA_VALUE_BITS,
+    CKA_VALUE_LEN,
+    CKA_EC_PARAMS,
+    CKA_EC_POINT
+};
+
+
+// Hash table with cached responses (protected by the lock)
+static PKCS11_LOGGER_CACHE_ENTRY *pkcs11_logger_cache_buckets[PKCS11_LOGGER_CACHE_BUCKETS];
+// Hash table with slots of open sessions used by the caches of object attributes and searches (protected by the lock)
+static PKCS11_LOGGER_CACHE_SESSION *pkcs11_logger_cache_sessions[PKCS11_LOGGER_CACHE_BUCKETS];
+// Number of calls of each PKCS#11 function answered from the cache
+static CK_ULONG pkcs11_logger_cache_hits[PKCS11_LOGGER_FUNCTION_COUNT];
+// Number of calls of each PKCS#11 function passed to the original library because the cache had no response
+static CK_ULONG pkcs11_logger_cache_misses[PKCS11_LOGGER_FUNCTION_COUNT];
+// Number of invalidations of the whole cache
+static CK_ULONG pkcs11_logger_cache_invalidations = 0;
+// Number of removals of all cached responses (protected by the lock)
+static CK_ULONG pkcs11_logger_cache_generation = 0;
+
+#ifdef _WIN32
+// Lock that protects cached responses and open sessions
+static SRWLOCK pkcs11_logger_cache_lock = SRWLOCK_INIT;
+#define CACHE_LOCK() AcquireSRWLockExclusive(&pkcs11_logger_cache_lock)
+#define CACHE_UNLOCK() ReleaseSRWLockExclusive(&pkcs11_logger_cache_lock)
+#else
+// Lock that protects cached responses and open sessions
+static pthread_mutex_t pkcs11_logger_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#define CACHE_LOCK() pthread_mutex_lock(&pkcs11_logger_cache_lock)
+#define CACHE_UNLOCK() pthread_mutex_unlock(&pkcs11_logger_cache_lock)
+#endif
+
+
+// Determines whether object attributes are cached
+static CK_BBOOL pkcs11_logger_cache_attributes_enabled(void)
+{
+    unsigned long enable_attr_cache = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_ATTR_CACHE) == PKCS11_LOGGER_FLAG_ENABLE_ATTR_CACHE);
+
+    return ((enable_attr_cache) && (0 != pkcs11_logger_globals.cache_ttl)) ? CK_TRUE : CK_FALSE;
+}
+
+
+// Determines whether results of searches of objects are cached
+static CK_BBOOL pkcs11_logger_cache_searches_enabled(void)
+{
+    unsigned long enable_find_cache = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_FIND_CACHE) == PKCS11_LOGGER_FLAG_ENABLE_FIND_CACHE);
+
+    return ((enable_find_cache) && (0 != pkcs11_logger_globals.cache_ttl)) ? CK_TRUE : CK_FALSE;
+}
+
+
+// Determines whether slots of open sessions need to be tracked
+static CK_BBOOL pkcs11_logger_cache_sessions_enabled(void)
+{
+    return ((CK_TRUE == pkcs11_logger_cache_attributes_enabled()) || (CK_TRUE == pkcs11_logger_cache_searches_enabled())) ? CK_TRUE : CK_FALSE;
+}
+
+
+// Determines whether the value of the attribute can be cached
+static CK_BBOOL pkcs11_logger_cache_is_immutable(CK_ATTRIBUTE_TYPE type)
+{
+    CK_ULONG i = 0;
+
+    for (i = 0; i < sizeof(pkcs11_logger_cache_immutable_attributes) / sizeof(CK_ATTRIBUTE_TYPE); i++)
+    {
+        if (pkcs11_logger_cache_immutable_attributes[i] == type)
+            return CK_TRUE;
+    }
+
+    return CK_FALSE;
+}
+
+
+// Returns bucket of the hash table for the entry with the specified key
+static CK_ULONG pkcs11_logger_cache_get_bucket(CK_ULONG function, CK_SLOT_ID slot, CK_ULONG key, CK_ULONG subkey)
+{
+    CK_ULONG hash = ((function * 31 + slot) * 2654435761UL + key) * 31 + subkey;
+
+    return (hash ^ (hash >> 8) ^ (hash >> 16)) % PKCS11_LOGGER_CACHE_BUCKETS;
+}
+
+
+// Returns unexpired cached response (the lock needs to be held)
+static PKCS11_LOGGER_CACHE_ENTRY* pkcs11_logger_cache_find(CK_ULONG function, CK_SLOT_ID slot, CK_ULONG key, CK_ULONG subkey, unsigned long long now)
+{
+    PKCS11_LOGGER_CACHE_ENTRY *entry = NULL;
+
+    for (entry = pkcs11_logger_cache_buckets[pkcs11_logger_cache_get_bucket(function, slot, key, subkey)]; NULL != entry; entry = entry->next)
+    {
+        if ((entry->function == function) && (entry->slot == slot) && (entry->key == key) && (entry->subkey == subkey))
+            return (now < entry->expires) ? entry : NULL;
+    }
+
+    return NULL;
+}
+
+
+// Copies items of unexpired cached response into the buffer with capacity of *count items (only the number of items is returned when the buffer is NULL)
+static CK_BBOOL pkcs11_logger_cache_get(CK_ULONG function, CK_SLOT_ID slot, CK_ULONG key, CK_VOID_PTR items, CK_ULONG_PTR count, CK_ULONG item_size, CK_RV *rv)
+{
+    PKCS11_LOGGER_CACHE_ENTRY *entry = NULL;
+    unsigned long long now = pkcs11_logger_utils_get_monotonic_time();
+    CK_BBOOL found = CK_FALSE;
+
+    CACHE_LOCK();
+
+    entry = pkcs11_logger_cache_find(function, slot, key, 0, now);
+    if (NULL != entry)
+    {
+        found = CK_TRUE;
+
+        if (NULL == items)
+            *rv = CKR_OK;
+        else if (*count < entry->data_len / item_size)
+            *rv = CKR_BUFFER_TOO_SMALL;
+        else
+            *rv = CKR_OK;
+
+        if ((CKR_OK == *rv) && (NULL != items))
+            memcpy(items, entry->data, entry->data_len);
+
+        *count = entry->data_len / item_size;
+    }
+
+    CACHE_UNLOCK();
+
+    if (CK_TRUE == found)
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_cache_hits[function], 1);
+    else
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_cache_misses[function], 1);
+
+    return found;
+}
+
+
+// Stores the response of the call to the original library made in the specified generation of the cache
+static void pkcs11_logger_cache_put(CK_ULONG generation, CK_ULONG function, CK_SLOT_ID slot, CK_ULONG key, CK_ULONG subkey, const void *data, CK_ULONG data_len)
+{
+    PKCS11_LOGGER_CACHE_ENTRY *entry = NULL;
+    PKCS11_LOGGER_CACHE_ENTRY **link = NULL;
+    PKCS11_LOGGER_CACHE_ENTRY *removed = NULL;
+    PKCS11_LOGGER_CACHE_ENTRY *next = NULL;
+    CK_ULONG bucket = pkcs11_logger_cache_get_bucket(function, slot, key, subkey);
+    unsigned long long now = pkcs11_logger_utils_get_monotonic_time();
+
+    // Note: Entry is allocated and filled before the lock is taken
+    entry = (PKCS11_LOGGER_CACHE_ENTRY*) malloc(sizeof(PKCS11_LOGGER_CACHE_ENTRY) + data_len);
+    if (NULL == entry)
+        return;
+
+    entry->function = function;
+    entry->slot = slot;
+    entry->key = key;
+    entry->subkey = subkey;
+    entry->expires = now + (unsigned long long)pkcs11_logger_globals.cache_ttl * 1000000000ULL;
+    entry->data_len = data_len;
+    if (0 != data_len)
+        memcpy(entry->data, data, data_len);
+
+    CACHE_LOCK();
+
+    // Note: Response obtained before the cache was invalidated might be stale
+    if (generation != pkcs11_logger_cache_generation)
+    {
+        CACHE_UNLOCK();
+        CALL_N_CLEAR(free, entry);
+        return;
+    }
+
+    // Note: Replaced and expired entries of the bucket are removed so the cache holds only responses used within their time to live
+    link = &pkcs11_logger_cache_buckets[bucket];
+    while (NULL != *link)
+    {
+        if ((now >= (*link)->expires) || (((*link)->function == function) && ((*link)->slot == slot) && ((*link)->key == key) && ((*link)->subkey == subkey)))
+        {
+            next = (*link)->next;
+            (*link)->next = removed;
+            removed = *link;
+            *link = next;
+        }
+        else
+        {
+            link = &((*link)->next);
+        }
+    }
+
+    entry->next = pkcs11_logger_cache_buckets[bucket];
+    pkcs11_logger_cache_buckets[bucket] = entry;
+
+    CACHE_UNLOCK();
+
+    while (NULL != removed)
+    {
+        next = removed->next;
+        CALL_N_CLEAR(free, removed);
+        removed = next;
+    }
+}
+
+
+// Removes cached responses of the function for the slot and key (any slot or key is matched by CK_UNAVAILABLE_INFORMATION)
+static void pkcs11_logger_cache_remove(CK_ULONG function, CK_SLOT_ID slot, CK_ULONG key)
+{
+    PKCS11_LOGGER_CACHE_ENTRY **link = NULL;
+    PKCS11_LOGGER_CACHE_ENTRY *removed = NULL;
+    PKCS11_LOGGER_CACHE_ENTRY *next = NULL;
+    CK_ULONG i = 0;
+
+    CACHE_LOCK();
+
+    for (i = 0; i < PKCS11_LOGGER_CACHE_BUCKETS; i++)
+    {
+        link = &pkcs11_logger_cache_buckets[i];
+        while (NULL != *link)
+        {
+            if (((*link)->function == function) && ((CK_UNAVAILABLE_INFORMATION == slot) || ((*link)->slot == slot)) && ((CK_UNAVAILABLE_INFORMATION == key) || ((*link)->key == key)))
+            {
+                next = (*link)->next;
+                (*link)->next = removed;
+                removed = *link;
+                *link = next;
+            }
+            else
+            {
+                link = &((*link)->next);
+            }
+        }
+    }
+
+    // Note: Responses obtained before the removal are not stored
+    pkcs11_logger_cache_generation++;
+
+    CACHE_UNLOCK();
+
+    while (NULL != removed)
+    {
+        next = removed->next;
+        CALL_N_CLEAR(free, removed);
+        removed = next;
+    }
+}
+
+
+// Removes all cached responses
+static void pkcs11_logger_cache_clear(void)
+{
+    PKCS11_LOGGER_CACHE_ENTRY *buckets[PKCS11_LOGGER_CACHE_BUCKETS];
+    PKCS11_LOGGER_CACHE_ENTRY *entry = NULL;
+    CK_ULONG i = 0;
+
+    // Note: Entries are detached under the lock and freed without it
+    CACHE_LOCK();
+    memcpy(buckets, pkcs11_logger_cache_buckets, sizeof(buckets));
+    memset(pkcs11_logger_cache_buckets, 0, sizeof(pkcs11_logger_cache_buckets));
+    pkcs11_logger_cache_generation++;
+    CACHE_UNLOCK();
+
+    for (i = 0; i < PKCS11_LOGGER_CACHE_BUCKETS; i++)
+    {
+        while (NULL != buckets[i])
+        {
+            entry = buckets[i];
+            buckets[i] = entry->next;
+            CALL_N_CLEAR(free, entry);
+        }
+    }
+}
+
+
+// Remembers slot of the open session
+static void pkcs11_logger_cache_add_session(CK_SESSION_HANDLE hSession, CK_SLOT_ID slotID)
+{
+    PKCS11_LOGGER_CACHE_SESSION *session = NULL;
+    CK_ULONG bucket = hSession % PKCS11_LOGGER_CACHE_BUCKETS;
+
+    session = (PKCS11_LOGGER_CACHE_SESSION*) malloc(sizeof(PKCS11_LOGGER_CACHE_SESSION));
+    if (NULL == session)
+        return;
+
+    session->session = hSession;
+    session->slot = slotID;
+    session->search = NULL;
+
+    CACHE_LOCK();
+    session->next = pkcs11_logger_cache_sessions[bucket];
+    pkcs11_logger_cache_sessions[bucket] = session;
+    CACHE_UNLOCK();
+}
+
+
+// Returns the open session (the lock needs to be held)
+static PKCS11_LOGGER_CACHE_SESSION* pkcs11_logger_cache_find_session(CK_SESSION_HANDLE hSession)
+{
+    PKCS11_LOGGER_CACHE_SESSION *session = NULL;
+
+    for (session = pkcs11_logger_cache_sessions[hSession % PKCS11_LOGGER_CACHE_BUCKETS]; NULL != session; session = session->next)
+    {
+        if (session->session == hSession)
+            return session;
+    }
+
+    return NULL;
+}
+
+
+// Returns slot of the open session (CK_UNAVAILABLE_INFORMATION when the session is not known)
+static CK_SLOT_ID pkcs11_logger_cache_get_session_slot(CK_SESSION_HANDLE hSession)
+{
+    PKCS11_LOGGER_CACHE_SESSION *session = NULL;
+    CK_SLOT_ID slot = CK_UNAVAILABLE_INFORMATION;
+
+    CACHE_LOCK();
+
+    session = pkcs11_logger_cache_find_session(hSession);
+    if (NULL != session)
+        slot = session->slot;
+
+    CACHE_UNLOCK();
+
+    return slot;
+}
+
+
+// Frees the search of objects
+static void pkcs11_logger_cache_free_search(PKCS11_LOGGER_CACHE_SEARCH *search)
+{
+    if (NULL == search)
+        return;
+
+    CALL_N_CLEAR(free, search->data);
+    free(search);
+}
+
+
+// Takes the active search away from the open session so it can be used without the lock and returns slot of the session
+static PKCS11_LOGGER_CACHE_SEARCH* pkcs11_logger_cache_detach_search(CK_SESSION_HANDLE hSession, CK_SLOT_ID *slot)
+{
+    PKCS11_LOGGER_CACHE_SESSION *session = NULL;
+    PKCS11_LOGGER_CACHE_SEARCH *search = NULL;
+
+    *slot = CK_UNAVAILABLE_INFORMATION;
+
+    CACHE_LOCK();
+
+    session = pkcs11_logger_cache_find_session(hSession);
+    if (NULL != session)
+    {
+        *slot = session->slot;
+        search = session->search;
+        session->search = NULL;
+    }
+
+    CACHE_UNLOCK();
+
+    return search;
+}
+
+
+// Gives the search back to the open session (the search is freed when the session has been closed in the meantime)
+static void pkcs11_logger_cache_attach_search(CK_SESSION_HANDLE hSession, PKCS11_LOGGER_CACHE_SEARCH *search)
+{
+    PKCS11_LOGGER_CACHE_SESSION *session = NULL;
+
+    CACHE_LOCK();
+
+    session = pkcs11_logger_cache_find_session(hSession);
+    if ((NULL != session) && (NULL == session->search))
+    {
+        session->search = search;
+        search = NULL;
+    }
+
+    CACHE_UNLOCK();
+
+    pkcs11_logger_cache_free_search(search);
+}
+
+
+// Forgets the closed session or all sessions of the slot (any session or slot is matched by CK_UNAVAILABLE_INFORMATION)
+static void pkcs11_logger_cache_remove_sessions(CK_SESSION_HANDLE hSession, CK_SLOT_ID slotID)
+{
+    PKCS11_LOGGER_CACHE_SESSION **link = NULL;
+    PKCS11_LOGGER_CACHE_SESSION *removed = NULL;
+    PKCS11_LOGGER_CACHE_SESSION *next = NULL;
+    CK_ULONG i = 0;
+
+    CACHE_LOCK();
+
+    for (i = 0; i < PKCS11_LOGGER_CACHE_BUCKETS; i++)
+    {
+        link = &pkcs11_logger_cache_sessions[i];
+        while (NULL != *link)
+        {
+            if (((CK_UNAVAILABLE_INFORMATION == hSession) || ((*link)->session == hSession)) && ((CK_UNAVAILABLE_INFORMATION == slotID) || ((*link)->slot == slotID)))
+            {
+                next = (*link)->next;
+                (*link)->next = removed;
+                removed = *link;
+                *link = next;
+            }
+            else
+            {
+                link = &((*link)->next);
+            }
+        }
+    }
+
+    CACHE_UNLOCK();
+
+    while (NULL != removed)
+    {
+        next = removed->next;
+        pkcs11_logger_cache_free_search(removed->search);
+        CALL_N_CLEAR(free, removed);
+        removed = next;
+    }
+}
+
+
+// Orders attributes of the template by type, length and value
+static int pkcs11_logger_cache_compare_attributes(const void *a, const void *b)
+{
+    const CK_ATTRIBUTE *attr1 = (const CK_ATTRIBUTE *)a;
+    const CK_ATTRIBUTE *attr2 = (const CK_ATTRIBUTE *)b;
+
+    if (attr1->type != attr2->type)
+        return (attr1->type < attr2->type) ? -1 : 1;
+
+    if (attr1->ulValueLen != attr2->ulValueLen)
+        return (attr1->ulValueLen < attr2->ulValueLen) ? -1 : 1;
+
+    return (0 == attr1->ulValueLen) ? 0 : memcmp(attr1->pValue, attr2->pValue, attr1->ulValueLen);
+}
+
+
+// Serializes the template into form independent of the order of attributes (NULL is returned when the template cannot be cached)
+static CK_BYTE_PTR pkcs11_logger_cache_canonicalize_template(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, CK_ULONG *length)
+{
+    CK_ATTRIBUTE_PTR sorted = NULL;
+    CK_BYTE_PTR canonical = NULL;
+    CK_ULONG offset = 0;
+    CK_ULONG i = 0;
+
+    *length = 0;
+
+    if ((NULL == pTemplate) && (0 != ulCount))
+        return NULL;
+
+    for (i = 0; i < ulCount; i++)
+    {
+        // Note: Values of array attributes contain pointers which cannot be compared
+        if ((CK_UNAVAILABLE_INFORMATION == pTemplate[i].ulValueLen) || ((NULL == pTemplate[i].pValue) && (0 != pTemplate[i].ulValueLen)) || (CKF_ARRAY_ATTRIBUTE == (pTemplate[i].type & CKF_ARRAY_ATTRIBUTE)))
+            return NULL;
+
+        *length += 2 * sizeof(CK_ULONG) + pTemplate[i].ulValueLen;
+    }
+
+    // Note: One extra byte is allocated so the empty template does not lead to zero sized allocation
+    canonical = (CK_BYTE_PTR) malloc(*length + 1);
+    if (NULL == canonical)
+        return NULL;
+
+    if (0 != ulCount)
+    {
+        sorted = (CK_ATTRIBUTE_PTR) malloc(ulCount * sizeof(CK_ATTRIBUTE));
+        if (NULL == sorted)
+        {
+            CALL_N_CLEAR(free, canonical);
+            return NULL;
+        }
+
+        memcpy(sorted, pTemplate, ulCount * sizeof(CK_ATTRIBUTE));
+        qsort(sorted, ulCount, sizeof(CK_ATTRIBUTE), pkcs11_logger_cache_compare_attributes);
+
+        for (i = 0; i < ulCount; i++)
+        {
+            memcpy(canonical + offset, &sorted[i].type, sizeof(CK_ULONG));
+            offset += sizeof(CK_ULONG);
+            memcpy(canonical + offset, &sorted[i].ulValueLen, sizeof(CK_ULONG));
+            offset += sizeof(CK_ULONG);
+            if (0 != sorted[i].ulValueLen)
+                memcpy(canonical + offset, sorted[i].pValue, sorted[i].ulValueLen);
+            offset += sorted[i].ulValueLen;
+        }
+
+        CALL_N_CLEAR(free, sorted);
+    }
+
+    return canonical;
+}
+
+
+// Returns copy of unexpired cached search with the same canonical template (NULL is returned when there is none)
+static CK_BYTE_PTR pkcs11_logger_cache_get_search(CK_SLOT_ID slot, CK_ULONG hash, const CK_BYTE *canonical, CK_ULONG template_len, CK_ULONG *data_len)
+{
+    PKCS11_LOGGER_CACHE_ENTRY *entry = NULL;
+    CK_BYTE_PTR data = NULL;
+    CK_BBOOL found = CK_FALSE;
+    unsigned long long now = pkcs11_logger_utils_get_monotonic_time();
+
+    *data_len = 0;
+
+    // Note: Length of the response is obtained first so the copy is allocated without the lock
+    CACHE_LOCK();
+    entry = pkcs11_logger_cache_find(PKCS11_LOGGER_FUNCTION_C_FindObjectsInit, slot, hash, template_len, now);
+    if ((NULL != entry) && (0 == memcmp(entry->data, canonical, template_len)))
+    {
+        found = CK_TRUE;
+        *data_len = entry->data_len;
+    }
+    CACHE_UNLOCK();
+
+    if (CK_TRUE != found)
+        return NULL;
+
+    data = (CK_BYTE_PTR) malloc(*data_len + 1);
+    if (NULL == data)
+        return NULL;
+
+    // Note: Response replaced in the meantime is treated as a miss
+    CACHE_LOCK();
+    entry = pkcs11_logger_cache_find(PKCS11_LOGGER_FUNCTION_C_FindObjectsInit, slot, hash, template_len, now);
+    if ((NULL != entry) && (entry->data_len == *data_len) && (0 == memcmp(entry->data, canonical, template_len)))
+        memcpy(data, entry->data, *data_len);
+    else
+        CALL_N_CLEAR(free, data);
+    CACHE_UNLOCK();
+
+    return data;
+}
+
+
+// Calls C_GetSlotList or answers it from the cache
+CK_RV pkcs11_logger_cache_get_slot_list(CK_BBOOL tokenPresent, CK_SLOT_ID_PTR pSlotList, CK_ULONG_PTR pulCount, CK_BBOOL *cached)
+{
+    CK_RV rv = CKR_OK;
+    CK_ULONG generation = 0;
+
+    if (NULL != cached)
+        *cached = CK_FALSE;
+
+    if ((0 == pkcs11_logger_globals.cache_ttl) || (NULL == pulCount))
+        return CALL_ORIG(C_GetSlotList, (tokenPresent, pSlotList, pulCount));
+
+    if (CK_TRUE == pkcs11_logger_cache_get(PKCS11_LOGGER_FUNCTION_C_GetSlotList, 0, tokenPresent, pSlotList, pulCount, sizeof(CK_SLOT_ID), &rv))
+    {
+        if (NULL != cached)
+            *cached = CK_TRUE;
+
+        return rv;
+    }
+
+    generation = PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_cache_generation);
+    rv = CALL_ORIG(C_GetSlotList, (tokenPresent, pSlotList, pulCount));
+
+    // Note: Only complete lists are cached while the length queries are always passed to the original library on miss
+    if ((CKR_OK == rv) && (NULL != pSlotList))
+        pkcs11_logger_cache_put(generation, PKCS11_LOGGER_FUNCTION_C_GetSlotList, 0, tokenPresent, 0, pSlotList, *pulCount * sizeof(CK_SLOT_ID));
+
+    return rv;
+}
+
+
+// Calls C_GetSlotInfo or answers it from the cache
+CK_RV pkcs11_logger_cache_get_slot_info(CK_SLOT_ID slotID, CK_SLOT_INFO_PTR pInfo, CK_BBOOL *cached)
+{
+    CK_RV rv = CKR_OK;
+    CK_ULONG generation = 0;
+    CK_ULONG count = 1;
+
+    if (NULL != cached)
+        *cached = CK_FALSE;
+
+    if ((0 == pkcs11_logger_globals.cache_ttl) || (NULL == pInfo))
+        return CALL_ORIG(C_GetSlotInfo, (slotID, pInfo));
+
+    if (CK_TRUE == pkcs11_logger_cache_get(PKCS11_LOGGER_FUNCTION_C_GetSlotInfo, slotID, 0, pInfo, &count, sizeof(CK_SLOT_INFO), &rv))
+    {
+        if (NULL != cached)
+            *cached = CK_TRUE;
+
+        return rv;
+    }
+
+    generation = PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_cache_generation);
+    rv = CALL_ORIG(C_GetSlotInfo, (slotID, pInfo));
+    if (CKR_OK == rv)
+        pkcs11_logger_cache_put(generation, PKCS11_LOGGER_FUNCTION_C_GetSlotInfo, slotID, 0, 0, pInfo, sizeof(CK_SLOT_INFO));
+
+    return rv;
+}
+
+
+// Calls C_GetTokenInfo or answers it from the cache
+CK_RV pkcs11_logger_cache_get_token_info(CK_SLOT_ID slotID, CK_TOKEN_INFO_PTR pInfo, CK_BBOOL *cached)
+{
+    CK_RV rv = CKR_OK;
+    CK_ULONG generation = 0;
+    CK_ULONG count = 1;
+    CK_TOKEN_INFO info;
+
+    if (NULL != cached)
+        *cached = CK_FALSE;
+
+    if ((0 == pkcs11_logger_globals.cache_ttl) || (NULL == pInfo))
+        return CALL_ORIG(C_GetTokenInfo, (slotID, pInfo));
+
+    if (CK_TRUE == pkcs11_logger_cache_get(PKCS11_LOGGER_FUNCTION_C_GetTokenInfo, slotID, 0, pInfo, &count, sizeof(CK_TOKEN_INFO), &rv))
+    {
+        if (NULL != cached)
+            *cached = CK_TRUE;
+
+        return rv;
+    }
+
+    generation = PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_cache_generation);
+    rv = CALL_ORIG(C_GetTokenInfo, (slotID, pInfo));
+
+    // Note: Time of the token clock would be stale so such tokens are never cached
+    if ((CKR_OK != rv) || (CKF_CLOCK_ON_TOKEN == (pInfo->flags & CKF_CLOCK_ON_TOKEN)))
+        return rv;
+
+    // Note: Counts of sessions and free memory change all the time so the cached response does not provide them
+    memcpy(&info, pInfo, sizeof(CK_TOKEN_INFO));
+    info.ulSessionCount = CK_UNAVAILABLE_INFORMATION;
+    info.ulRwSessionCount = CK_UNAVAILABLE_INFORMATION;
+    info.ulFreePublicMemory = CK_UNAVAILABLE_INFORMATION;
+    info.ulFreePrivateMemory = CK_UNAVAILABLE_INFORMATION;
+
+    pkcs11_logger_cache_put(generation, PKCS11_LOGGER_FUNCTION_C_GetTokenInfo, slotID, 0, 0, &info, sizeof(CK_TOKEN_INFO));
+
+    return rv;
+}
+
+
+// Calls C_GetMechanismList or answers it from the cache
+CK_RV pkcs11_logger_cache_get_mechanism_list(CK_SLOT_ID slotID, CK_MECHANISM_TYPE_PTR pMechanismList, CK_ULONG_PTR pulCount, CK_BBOOL *cached)
+{
+    CK_RV rv = CKR_OK;
+    CK_ULONG generation = 0;
+
+    if (NULL != cached)
+        *cached = CK_FALSE;
+
+    if ((0 == pkcs11_logger_globals.cache_ttl) || (NULL == pulCount))
+        return CALL_ORIG(C_GetMechanismList, (slotID, pMechanismList, pulCount));
+
+    if (CK_TRUE == pkcs11_logger_cache_get(PKCS11_LOGGER_FUNCTION_C_GetMechanismList, slotID, 0, pMechanismList, pulCount, sizeof(CK_MECHANISM_TYPE), &rv))
+    {
+        if (NULL != cached)
+            *cached = CK_TRUE;
+
+        return rv;
+    }
+
+    generation = PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_cache_generation);
+    rv = CALL_ORIG(C_GetMechanismList, (slotID, pMechanismList, pulCount));
+    if ((CKR_OK == rv) && (NULL != pMechanismList))
+        pkcs11_logger_cache_put(generation, PKCS11_LOGGER_FUNCTION_C_GetMechanismList, slotID, 0, 0, pMechanismList, *pulCount * sizeof(CK_MECHANISM_TYPE));
+
+    return rv;
+}
+
+
+// Calls C_GetMechanismInfo or answers it from the cache
+CK_RV pkcs11_logger_cache_get_mechanism_info(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_MECHANISM_INFO_PTR pInfo, CK_BBOOL *cached)
+{
+    CK_RV rv = CKR_OK;
+    CK_ULONG generation = 0;
+    CK_ULONG count = 1;
+
+    if (NULL != cached)
+        *cached = CK_FALSE;
+
+    if ((0 == pkcs11_logger_globals.cache_ttl) || (NULL == pInfo))
+        return CALL_ORIG(C_GetMechanismInfo, (slotID, type, pInfo));
+
+    if (CK_TRUE == pkcs11_logger_cache_get(PKCS11_LOGGER_FUNCTION_C_GetMechanismInfo, slotID, type, pInfo, &count, sizeof(CK_MECHANISM_INFO), &rv))
+    {
+        if (NULL != cached)
+            *cached = CK_TRUE;
+
+        return rv;
+    }
+
+    generation = PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_cache_generation);
+    rv = CALL_ORIG(C_GetMechanismInfo, (slotID, type, pInfo));
+    if (CKR_OK == rv)
+        pkcs11_logger_cache_put(generation, PKCS11_LOGGER_FUNCTION_C_GetMechanismInfo, slotID, type, 0, pInfo, sizeof(CK_MECHANISM_INFO));
+
+    return rv;
+}
+
+
+// Calls C_OpenSession and remembers slot of the new session
+CK_RV pkcs11_logger_cache_open_session(CK_SLOT_ID slotID, CK_FLAGS flags, CK_VOID_PTR pApplication, CK_NOTIFY Notify, CK_SESSION_HANDLE_PTR phSession)
+{
+    CK_RV rv = CALL_ORIG(C_OpenSession, (slotID, flags, pApplication, Notify, phSession));
+
+    if ((CKR_OK == rv) && (CK_TRUE == pkcs11_logger_cache_sessions_enabled()))
+        pkcs11_logger_cache_add_session(*phSession, slotID);
+
+    return rv;
+}
+
+
+// Removes cached attributes and searches of objects in the slot (any slot is matched by CK_UNAVAILABLE_INFORMATION)
+static void pkcs11_logger_cache_remove_objects(CK_SLOT_ID slotID)
+{
+    if (CK_TRUE == pkcs11_logger_cache_attributes_enabled())
+        pkcs11_logger_cache_remove(PKCS11_LOGGER_FUNCTION_C_GetAttributeValue, slotID, CK_UNAVAILABLE_INFORMATION);
+
+    if (CK_TRUE == pkcs11_logger_cache_searches_enabled())
+        pkcs11_logger_cache_remove(PKCS11_LOGGER_FUNCTION_C_FindObjectsInit, slotID, CK_UNAVAILABLE_INFORMATION);
+}
+
+
+// Calls C_CloseSession and removes cached attributes and searches of objects that might have been destroyed with the session
+CK_RV pkcs11_logger_cache_close_session(CK_SESSION_HANDLE hSession)
+{
+    CK_RV rv = CALL_ORIG(C_CloseSession, (hSession));
+    CK_SLOT_ID slot = CK_UNAVAILABLE_INFORMATION;
+
+    if (CK_TRUE != pkcs11_logger_cache_sessions_enabled())
+        return rv;
+
+    // Note: Session objects are not distinguished from token objects so attributes and searches of all objects in the slot are removed
+    slot = pkcs11_logger_cache_get_session_slot(hSession);
+    pkcs11_logger_cache_remove_sessions(hSession, CK_UNAVAILABLE_INFORMATION);
+    pkcs11_logger_cache_remove_objects(slot);
+
+    return rv;
+}
+
+
+// Calls C_CloseAllSessions and removes cached attributes and searches of objects in the slot
+CK_RV pkcs11_logger_cache_close_all_sessions(CK_SLOT_ID slotID)
+{
+    CK_RV rv = CALL_ORIG(C_CloseAllSessions, (slotID));
+
+    if (CK_TRUE != pkcs11_logger_cache_sessions_enabled())
+        return rv;
+
+    pkcs11_logger_cache_remove_sessions(CK_UNAVAILABLE_INFORMATION, slotID);
+    pkcs11_logger_cache_remove_objects(slotID);
+
+    return rv;
+}
+
+
+// Calls C_GetAttributeValue or answers it from the cache when all attributes of the template are cached
+CK_RV pkcs11_logger_cache_get_attribute_value(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, CK_BBOOL *cached)
+{
+    CK_RV rv = CKR_OK;
+    CK_ULONG generation = 0;
+    CK_SLOT_ID slot = CK_UNAVAILABLE_INFORMATION;
+    PKCS11_LOGGER_CACHE_ENTRY *entry = NULL;
+    unsigned long long now = 0;
+    CK_BBOOL found = CK_TRUE;
+    CK_ULONG i = 0;
+
+    if (NULL != cached)
+        *cached = CK_FALSE;
+
+    if ((CK_TRUE != pkcs11_logger_cache_attributes_enabled()) || (NULL == pTemplate) || (0 == ulCount))
+        return CALL_ORIG(C_GetAttributeValue, (hSession, hObject, pTemplate, ulCount));
+
+    for (i = 0; i < ulCount; i++)
+    {
+        if (CK_TRUE != pkcs11_logger_cache_is_immutable(pTemplate[i].type))
+            return CALL_ORIG(C_GetAttributeValue, (hSession, hObject, pTemplate, ulCount));
+    }
+
+    slot = pkcs11_logger_cache_get_session_slot(hSession);
+    if (CK_UNAVAILABLE_INFORMATION == slot)
+        return CALL_ORIG(C_GetAttributeValue, (hSession, hObject, pTemplate, ulCount));
+
+    now = pkcs11_logger_utils_get_monotonic_time();
+
+    CACHE_LOCK();
+
+    for (i = 0; (i < ulCount) && (CK_TRUE == found); i++)
+    {
+        if (NULL == pkcs11_logger_cache_find(PKCS11_LOGGER_FUNCTION_C_GetAttributeValue, slot, hObject, pTemplate[i].type, now))
+            found = CK_FALSE;
+    }
+
+    // Note: Attributes are returned the same way as the original library returns them including the length queries with NULL pValue
+    for (i = 0; (i < ulCount) && (CK_TRUE == found); i++)
+    {
+        entry = pkcs11_logger_cache_find(PKCS11_LOGGER_FUNCTION_C_GetAttributeValue, slot, hObject, pTemplate[i].type, now);
+
+        if (NULL == pTemplate[i].pValue)
+        {
+            pTemplate[i].ulValueLen = entry->data_len;
+        }
+        else if (pTemplate[i].ulValueLen < entry->data_len)
+        {
+            pTemplate[i].ulValueLen = CK_UNAVAILABLE_INFORMATION;
+            rv = CKR_BUFFER_TOO_SMALL;
+        }
+        else
+        {
+            memcpy(pTemplate[i].pValue, entry->data, entry->data_len);
+            pTemplate[i].ulValueLen = entry->data_len;
+        }
+    }
+
+    CACHE_UNLOCK();
+
+    if (CK_TRUE == found)
+    {
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_cache_hits[PKCS11_LOGGER_FUNCTION_C_GetAttributeValue], 1);
+
+        if (NULL != cached)
+            *cached = CK_TRUE;
+
+        return rv;
+    }
+
+    PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_cache_misses[PKCS11_LOGGER_FUNCTION_C_GetAttributeValue], 1);
+
+    generation = PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_cache_generation);
+    rv = CALL_ORIG(C_GetAttributeValue, (hSession, hObject, pTemplate, ulCount));
+    if (CKR_OK != rv)
+        return rv;
+
+    for (i = 0; i < ulCount; i++)
+    {
+        if ((NULL != pTemplate[i].pValue) && (CK_UNAVAILABLE_INFORMATION != pTemplate[i].ulValueLen))
+            pkcs11_logger_cache_put(generation, PKCS11_LOGGER_FUNCTION_C_GetAttributeValue, slot, hObject, pTemplate[i].type, pTemplate[i].pValue, pTemplate[i].ulValueLen);
+    }
+
+    return rv;
+}
+
+
+// Calls C_SetAttributeValue and removes cached attributes of the object and cached searches of objects
+CK_RV pkcs11_logger_cache_set_attribute_value(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount)
+{
+    CK_RV rv = CALL_ORIG(C_SetAttributeValue, (hSession, hObject, pTemplate, ulCount));
+
+    if (CK_TRUE == pkcs11_logger_cache_attributes_enabled())
+        pkcs11_logger_cache_remove(PKCS11_LOGGER_FUNCTION_C_GetAttributeValue, pkcs11_logger_cache_get_session_slot(hSession), hObject);
+
+    return pkcs11_logger_cache_invalidate_searches(hSession, rv);
+}
+
+
+// Calls C_DestroyObject and removes cached attributes of the object and cached searches of objects
+CK_RV pkcs11_logger_cache_destroy_object(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject)
+{
+    CK_RV rv = CALL_ORIG(C_DestroyObject, (hSession, hObject));
+
+    if (CK_TRUE == pkcs11_logger_cache_attributes_enabled())
+        pkcs11_logger_cache_remove(PKCS11_LOGGER_FUNCTION_C_GetAttributeValue, pkcs11_logger_cache_get_session_slot(hSession), hObject);
+
+    return pkcs11_logger_cache_invalidate_searches(hSession, rv);
+}
+
+
+// Calls C_FindObjectsInit or starts the search answered from the cache
+CK_RV pkcs11_logger_cache_find_objects_init(CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, CK_BBOOL *cached)
+{
+    CK_RV rv = CKR_OK;
+    CK_SLOT_ID slot = CK_UNAVAILABLE_INFORMATION;
+    PKCS11_LOGGER_CACHE_SEARCH *search = NULL;
+    CK_BYTE_PTR canonical = NULL;
+    CK_BYTE_PTR data = NULL;
+    CK_ULONG template_len = 0;
+    CK_ULONG data_len = 0;
+    CK_ULONG hash = 0;
+
+    if (NULL != cached)
+        *cached = CK_FALSE;
+
+    if (CK_TRUE != pkcs11_logger_cache_searches_enabled())
+        return CALL_ORIG(C_FindObjectsInit, (hSession, pTemplate, ulCount));
+
+    // Note: The original library reports the search that is already active unless it is answered from the cache
+    search = pkcs11_logger_cache_detach_search(hSession, &slot);
+    if (NULL != search)
+    {
+        rv = (CK_TRUE == search->cached) ? CKR_OPERATION_ACTIVE : CALL_ORIG(C_FindObjectsInit, (hSession, pTemplate, ulCount));
+        pkcs11_logger_cache_attach_search(hSession, search);
+        return rv;
+    }
+
+    if (CK_UNAVAILABLE_INFORMATION == slot)
+        return CALL_ORIG(C_FindObjectsInit, (hSession, pTemplate, ulCount));
+
+    canonical = pkcs11_logger_cache_canonicalize_template(pTemplate, ulCount, &template_len);
+    if (NULL == canonical)
+        return CALL_ORIG(C_FindObjectsInit, (hSession, pTemplate, ulCount));
+
+    search = (PKCS11_LOGGER_CACHE_SEARCH*) malloc(sizeof(PKCS11_LOGGER_CACHE_SEARCH));
+    if (NULL == search)
+    {
+        CALL_N_CLEAR(free, canonical);
+        return CALL_ORIG(C_FindObjectsInit, (hSession, pTemplate, ulCount));
+    }
+
+    memset(search, 0, sizeof(PKCS11_LOGGER_CACHE_SEARCH));
+    hash = pkcs11_logger_crc32c_compute(canonical, template_len);
+
+    data = pkcs11_logger_cache_get_search(slot, hash, canonical, template_len, &data_len);
+    if (NULL != data)
+    {
+        CALL_N_CLEAR(free, canonical);
+
+        search->cached = CK_TRUE;
+        search->data = data;
+        search->template_len = template_len;
+        search->count = (data_len - template_len) / sizeof(CK_OBJECT_HANDLE);
+        pkcs11_logger_cache_attach_search(hSession, search);
+
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_cache_hits[PKCS11_LOGGER_FUNCTION_C_FindObjectsInit], 1);
+
+        if (NULL != cached)
+            *cached = CK_TRUE;
+
+        return CKR_OK;
+    }
+
+    PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_cache_misses[PKCS11_LOGGER_FUNCTION_C_FindObjectsInit], 1);
+
+    search->generation = PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_cache_generation);
+    search->hash = hash;
+    search->data = canonical;
+    search->template_len = template_len;
+
+    rv = CALL_ORIG(C_FindObjectsInit, (hSession, pTemplate, ulCount));
+    if (CKR_OK == rv)
+        pkcs11_logger_cache_attach_search(hSession, search);
+    else
+        pkcs11_logger_cache_free_search(search);
+
+    return rv;
+}
+
+
+// Calls C_FindObjects and records found objects or returns them from the cache
+CK_RV pkcs11_logger_cache_find_objects(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE_PTR phObject, CK_ULONG ulMaxObjectCount, CK_ULONG_PTR pulObjectCount, CK_BBOOL *cached)
+{
+    CK_RV rv = CKR_OK;
+    CK_SLOT_ID slot = CK_UNAVAILABLE_INFORMATION;
+    PKCS11_LOGGER_CACHE_SEARCH *search = NULL;
+    CK_BYTE_PTR data = NULL;
+    CK_ULONG count = 0;
+    CK_ULONG capacity = 0;
+
+    if (NULL != cached)
+        *cached = CK_FALSE;
+
+    if (CK_TRUE != pkcs11_logger_cache_searches_enabled())
+        return CALL_ORIG(C_FindObjects, (hSession, phObject, ulMaxObjectCount, pulObjectCount));
+
+    search = pkcs11_logger_cache_detach_search(hSession, &slot);
+    if (NULL == search)
+        return CALL_ORIG(C_FindObjects, (hSession, phObject, ulMaxObjectCount, pulObjectCount));
+
+    if (CK_TRUE == search->cached)
+    {
+        if (((NULL == phObject) && (0 != ulMaxObjectCount)) || (NULL == pulObjectCount))
+        {
+            rv = CKR_ARGUMENTS_BAD;
+        }
+        else
+        {
+            count = search->count - search->position;
+            if (count > ulMaxObjectCount)
+                count = ulMaxObjectCount;
+
+            if (0 != count)
+                memcpy(phObject, search->data + search->template_len + search->position * sizeof(CK_OBJECT_HANDLE), count * sizeof(CK_OBJECT_HANDLE));
+
+            search->position += count;
+            *pulObjectCount = count;
+        }
+
+        pkcs11_logger_cache_attach_search(hSession, search);
+
+        if (NULL != cached)
+            *cached = CK_TRUE;
+
+        return rv;
+    }
+
+    rv = CALL_ORIG(C_FindObjects, (hSession, phObject, ulMaxObjectCount, pulObjectCount));
+    if ((CKR_OK != rv) || (NULL == phObject) || (NULL == pulObjectCount) || (*pulObjectCount > ulMaxObjectCount))
+    {
+        // Note: Search that was not fully recorded cannot be cached but the original library still needs C_FindObjectsFinal
+        pkcs11_logger_cache_free_search(search);
+        return rv;
+    }
+
+    count = *pulObjectCount;
+    if (search->count + count > search->capacity)
+    {
+        capacity = (search->capacity < 16) ? 16 : search->capacity * 2;
+        if (capacity < search->count + count)
+            capacity = search->count + count;
+
+        data = (CK_BYTE_PTR) realloc(search->data, search->template_len + capacity * sizeof(CK_OBJECT_HANDLE));
+        if (NULL == data)
+        {
+            pkcs11_logger_cache_free_search(search);
+            return rv;
+        }
+
+        search->data = data;
+        search->capacity = capacity;
+    }
+
+    if (0 != count)
+        memcpy(search->data + search->template_len + search->count * sizeof(CK_OBJECT_HANDLE), phObject, count * sizeof(CK_OBJECT_HANDLE));
+
+    search->count += count;
+
+    // Note: Fewer objects than requested means the original library has returned all of them
+    if (count < ulMaxObjectCount)
+        search->complete = CK_TRUE;
+
+    pkcs11_logger_cache_attach_search(hSession, search);
+
+    return rv;
+}
+
+
+// Calls C_FindObjectsFinal and caches the complete search or finishes the search answered from the cache
+CK_RV pkcs11_logger_cache_find_objects_final(CK_SESSION_HANDLE hSession, CK_BBOOL *cached)
+{
+    CK_RV rv = CKR_OK;
+    CK_SLOT_ID slot = CK_UNAVAILABLE_INFORMATION;
+    PKCS11_LOGGER_CACHE_SEARCH *search = NULL;
+
+    if (NULL != cached)
+        *cached = CK_FALSE;
+
+    if (CK_TRUE != pkcs11_logger_cache_searches_enabled())
+        return CALL_ORIG(C_FindObjectsFinal, (hSession));
+
+    search = pkcs11_logger_cache_detach_search(hSession, &slot);
+    if (NULL == search)
+        return CALL_ORIG(C_FindObjectsFinal, (hSession));
+
+    if (CK_TRUE == search->cached)
+    {
+        if (NULL != cached)
+            *cached = CK_TRUE;
+    }
+    else
+    {
+        rv = CALL_ORIG(C_FindObjectsFinal, (hSession));
+        if ((CKR_OK == rv) && (CK_TRUE == search->complete))
+            pkcs11_logger_cache_put(search->generation, PKCS11_LOGGER_FUNCTION_C_FindObjectsInit, slot, search->hash, search->template_len, search->data, search->template_len + search->count * sizeof(CK_OBJECT_HANDLE));
+    }
+
+    pkcs11_logger_cache_free_search(search);
+
+    return rv;
+}
+
+
+// Calls C_Finalize and removes all cached responses and sessions
+CK_RV pkcs11_logger_cache_finalize(CK_VOID_PTR pReserved)
+{
+    CK_RV rv = CALL_ORIG(C_Finalize, (pReserved));
+
+    if (0 == pkcs11_logger_globals.cache_ttl)
+        return rv;
+
+    pkcs11_logger_cache_remove_sessions(CK_UNAVAILABLE_INFORMATION, CK_UNAVAILABLE_INFORMATION);
+
+    return pkcs11_logger_cache_invalidate(rv);
+}
+
+
+// Removes all cached responses after the call that might have changed slots or tokens and returns the value returned by the call
+CK_RV pkcs11_logger_cache_invalidate(CK_RV rv)
+{
+    // Note: Polling for slot events that did not happen does not invalidate the cache
+    if ((0 == pkcs11_logger_globals.cache_ttl) || (CKR_NO_EVENT == rv))
+        return rv;
+
+    pkcs11_logger_cache_clear();
+    PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_cache_invalidations, 1);
+
+    return rv;
+}
+
+
+// Removes cached searches of objects in the slot of the session after the call that might have created, destroyed or modified objects and returns the value returned by the call
+CK_RV pkcs11_logger_cache_invalidate_searches(CK_SESSION_HANDLE hSession, CK_RV rv)
+{
+    // Note: Objects of unknown session might be in any slot
+    if (CK_TRUE == pkcs11_logger_cache_searches_enabled())
+        pkcs11_logger_cache_remove(PKCS11_LOGGER_FUNCTION_C_FindObjectsInit, pkcs11_logger_cache_get_session_slot(hSession), CK_UNAVAILABLE_INFORMATION);
+
+    return rv;
+}
+
+
+// Logs numbers of calls answered from the cache and passed to the original library
+void pkcs11_logger_cache_dump(const char *reason)
+{
+    CK_ULONG function = 0;
+
+    if (0 == pkcs11_logger_globals.cache_ttl)
+        return;
+
+    pkcs11_logger_log("Cache of responses of the original library (dumped on %s)", reason);
+    pkcs11_logger_log(" Time to live: %lu seconds", pkcs11_logger_globals.cache_ttl);
+    pkcs11_logger_log(" Invalidations: %lu", PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_cache_invalidations));
+
+    for (function = 0; function < PKCS11_LOGGER_FUNCTION_COUNT; function++)
+    {
+        if ((0 == PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_cache_hits[function])) && (0 == PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_cache_misses[function])))
+            continue;
+
+        pkcs11_logger_log(" %s: %lu hits, %lu misses",
+            pkcs11_logger_translate_function_id(function),
+            PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_cache_hits[function]),
+            PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_cache_misses[function]));
+    }
+
+    pkcs11_logger_log_separator();
+}
+
+
+// Removes all cached responses and sessions and resets statistics
+void pkcs11_logger_cache_stop(void)
+{
+    pkcs11_logger_cache_clear();
+    pkcs11_logger_cache_remove_sessions(CK_UNAVAILABLE_INFORMATION, CK_UNAVAILABLE_INFORMATION);
+
+    memset(pkcs11_logger_cache_hits, 0, sizeof(pkcs11_logger_cache_hits));
+    memset(pkcs11_logger_cache_misses, 0, sizeof(pkcs11_logger_cache_misses));
+    pkcs11_logger_cache_invalidations = 0;
+}
@@ -0,0 +1,687 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Number of buckets of the hash table with sessions
+#define PKCS11_LOGGER_COALESCE_BUCKETS 256
+// Number of operations whose updates can be coalesced (digest, signature and verification)
+#define PKCS11_LOGGER_COALESCE_OPERATIONS 3
+
+
+// Structure that holds updates of one operation that have not been passed to the original library yet
+typedef struct
+{
+    // Flag indicating whether updates of the operation are coalesced
+    CK_BBOOL active;
+    // Buffer with PKCS11_LOGGER_COALESCE_SIZE bytes allocated when it is first needed and reused by later operations
+    CK_BYTE_PTR buffer;
+    // Number of buffered bytes
+    CK_ULONG len;
+}
+PKCS11_LOGGER_COALESCE_OPERATION;
+
+
+// Structure that holds one session opened in the original library while coalescing of updates is enabled
+typedef struct PKCS11_LOGGER_COALESCE_SESSION
+{
+    // Next session in the same bucket
+    struct PKCS11_LOGGER_COALESCE_SESSION *next;
+    // Handle of the session
+    CK_SESSION_HANDLE session;
+    // Slot of the session
+    CK_SLOT_ID slot;
+    // Digest, signature and verification operation of the session
+    PKCS11_LOGGER_COALESCE_OPERATION operations[PKCS11_LOGGER_COALESCE_OPERATIONS];
+    // Value returned by the original library when buffered updates could not be passed to it
+    CK_RV failed;
+    // Number of updates of coalesced operations called by the application
+    CK_ULONG updates;
+    // Number of updates of coalesced operations passed to the original library
+    CK_ULONG calls;
+}
+PKCS11_LOGGER_COALESCE_SESSION;
+
+
+// Mechanisms whose updates are coalesced when PKCS11_LOGGER_COALESCE_MECHANISMS environment variable is not set
+static const CK_MECHANISM_TYPE pkcs11_logger_coalesce_default_mechanisms[] =
+{
+    CKM_MD5,
+    CKM_MD5_HMAC,
+    CKM_SHA_1,
+    CKM_SHA_1_HMAC,
+    CKM_SHA256,
+    CKM_SHA256_HMAC,
+    CKM_SHA224,
+    CKM_SHA224_HMAC,
+    CKM_SHA384,
+    CKM_SHA384_HMAC,
+    CKM_SHA512,
+    CKM_SHA512_HMAC,
+    CKM_AES_CMAC
+};
+
+
+// Hash table with sessions (protected by the lock)
+static PKCS11_LOGGER_COALESCE_SESSION *pkcs11_logger_coalesce_sessions[PKCS11_LOGGER_COALESCE_BUCKETS];
+// Number of updates of coalesced operations called by the application
+static CK_ULONG pkcs11_logger_coalesce_updates = 0;
+// Number of updates copied into the buffer without calling the original library
+static CK_ULONG pkcs11_logger_coalesce_buffered = 0;
+// Number of updates passed to the original library
+static CK_ULONG pkcs11_logger_coalesce_calls = 0;
+// Number of bytes passed to the original library
+static CK_ULONG pkcs11_logger_coalesce_bytes = 0;
+// Number of updates that failed after the application had been told that they succeeded
+static CK_ULONG pkcs11_logger_coalesce_failed = 0;
+// Number of buffers discarded because the session was closed or its state was restored
+static CK_ULONG pkcs11_logger_coalesce_discarded = 0;
+
+#ifdef _WIN32
+// Lock that protects sessions with buffered updates
+static SRWLOCK pkcs11_logger_coalesce_lock = SRWLOCK_INIT;
+#define COALESCE_LOCK() AcquireSRWLockExclusive(&pkcs11_logger_coalesce_lock)
+#define COALESCE_UNLOCK() ReleaseSRWLockExclusive(&pkcs11_logger_coalesce_lock)
+#else
+// Lock that protects sessions with buffered updates
+static pthread_mutex_t pkcs11_logger_coalesce_lock = PTHREAD_MUTEX_INITIALIZER;
+#define COALESCE_LOCK() pthread_mutex_lock(&pkcs11_logger_coalesce_lock)
+#define COALESCE_UNLOCK() pthread_mutex_unlock(&pkcs11_logger_coalesce_lock)
+#endif
+
+
+// Returns index of the operation identified by PKCS11_LOGGER_POOL_STATE_* value
+static CK_ULONG pkcs11_logger_coalesce_index(CK_ULONG state)
+{
+    switch (state)
+    {
+        case PKCS11_LOGGER_POOL_STATE_DIGEST:
+            return 0;
+        case PKCS11_LOGGER_POOL_STATE_SIGN:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+
+// Calls update function of the operation identified by PKCS11_LOGGER_POOL_STATE_* value
+static CK_RV pkcs11_logger_coalesce_forward(CK_SESSION_HANDLE hSession, CK_ULONG state, CK_BYTE_PTR pPart, CK_ULONG ulPartLen)
+{
+    switch (state)
+    {
+        case PKCS11_LOGGER_POOL_STATE_DIGEST:
+            return CALL_ORIG(C_DigestUpdate, (hSession, pPart, ulPartLen));
+        case PKCS11_LOGGER_POOL_STATE_SIGN:
+            return CALL_ORIG(C_SignUpdate, (hSession, pPart, ulPartLen));
+        default:
+            return CALL_ORIG(C_VerifyUpdate, (hSession, pPart, ulPartLen));
+    }
+}
+
+
+// Checks whether updates of operations with the mechanism are coalesced
+static CK_BBOOL pkcs11_logger_coalesce_is_allowed(CK_MECHANISM_TYPE mechanism)
+{
+    CK_ULONG i = 0;
+
+    if (NULL == pkcs11_logger_globals.env_var_coalesce_mechanisms)
+    {
+        for (i = 0; i < sizeof(pkcs11_logger_coalesce_default_mechanisms) / sizeof(CK_MECHANISM_TYPE); i++)
+        {
+            if (pkcs11_logger_coalesce_default_mechanisms[i] == mechanism)
+                return CK_TRUE;
+        }
+
+        return CK_FALSE;
+    }
+
+    for (i = 0; i < pkcs11_logger_globals.coalesce_mechanisms_count; i++)
+    {
+        if (pkcs11_logger_globals.coalesce_mechanisms[i] == mechanism)
+            return CK_TRUE;
+    }
+
+    return CK_FALSE;
+}
+
+
+// Returns session and optionally removes it from the hash table (the lock needs to be held)
+static PKCS11_LOGGER_COALESCE_SESSION* pkcs11_logger_coalesce_find(CK_SESSION_HANDLE hSession, CK_BBOOL remove)
+{
+    PKCS11_LOGGER_COALESCE_SESSION **link = NULL;
+    PKCS11_LOGGER_COALESCE_SESSION *session = NULL;
+
+    for (link = &pkcs11_logger_coalesce_sessions[hSession % PKCS11_LOGGER_COALESCE_BUCKETS]; NULL != *link; link = &((*link)->next))
+    {
+        if ((*link)->session == hSession)
+        {
+            session = *link;
+            if (CK_TRUE == remove)
+                *link = session->next;
+            return session;
+        }
+    }
+
+    return NULL;
+}
+
+
+// Frees the session and buffers of its operations
+static void pkcs11_logger_coalesce_free(PKCS11_LOGGER_COALESCE_SESSION *session)
+{
+    CK_ULONG i = 0;
+
+    for (i = 0; i < PKCS11_LOGGER_COALESCE_OPERATIONS; i++)
+    {
+        if (0 != session->operations[i].len)
+            PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_discarded, 1);
+
+        CALL_N_CLEAR(free, session->operations[i].buffer);
+    }
+
+    CALL_N_CLEAR(free, session);
+}
+
+
+// Returns the buffer taken away from the operation while the original library was called
+static void pkcs11_logger_coalesce_attach(CK_SESSION_HANDLE hSession, CK_ULONG state, CK_BYTE_PTR buffer, CK_ULONG len, CK_ULONG calls, CK_RV rv)
+{
+    PKCS11_LOGGER_COALESCE_SESSION *session = NULL;
+    PKCS11_LOGGER_COALESCE_OPERATION *operation = NULL;
+
+    COALESCE_LOCK();
+
+    // Note: Session might have been closed by another thread while the lock was not held
+    session = pkcs11_logger_coalesce_find(hSession, CK_FALSE);
+    if (NULL != session)
+    {
+        operation = &session->operations[pkcs11_logger_coalesce_index(state)];
+        session->calls += calls;
+
+        // Note: Operation is terminated by the original library when its update fails
+        if (CKR_OK != rv)
+            operation->active = CK_FALSE;
+
+        if (NULL == operation->buffer)
+        {
+            operation->buffer = buffer;
+            operation->len = (CKR_OK == rv) ? len : 0;
+            buffer = NULL;
+        }
+    }
+
+    COALESCE_UNLOCK();
+
+    CALL_N_CLEAR(free, buffer);
+}
+
+
+// Removes sessions of the slot (any slot is matched by CK_UNAVAILABLE_INFORMATION)
+static void pkcs11_logger_coalesce_forget(CK_SLOT_ID slotID)
+{
+    PKCS11_LOGGER_COALESCE_SESSION **link = NULL;
+    PKCS11_LOGGER_COALESCE_SESSION *removed = NULL;
+    PKCS11_LOGGER_COALESCE_SESSION *next = NULL;
+    CK_ULONG i = 0;
+
+    COALESCE_LOCK();
+
+    for (i = 0; i < PKCS11_LOGGER_COALESCE_BUCKETS; i++)
+    {
+        link = &pkcs11_logger_coalesce_sessions[i];
+        while (NULL != *link)
+        {
+            if ((CK_UNAVAILABLE_INFORMATION == slotID) || ((*link)->slot == slotID))
+            {
+                next = (*link)->next;
+                (*link)->next = removed;
+                removed = *link;
+                *link = next;
+            }
+            else
+            {
+                link = &((*link)->next);
+            }
+        }
+    }
+
+    COALESCE_UNLOCK();
+
+    while (NULL != removed)
+    {
+        next = removed->next;
+        pkcs11_logger_coalesce_free(removed);
+        removed = next;
+    }
+}
+
+
+// Adds mechanism name or decimal number from the list to the mechanisms whose updates are coalesced
+static int pkcs11_logger_coalesce_parse_mechanism(char *name, char *value, void *context)
+{
+    CK_MECHANISM_TYPE mechanism = 0;
+
+    IGNORE_ARG(context);
+
+    if (NULL != value)
+        return PKCS11_LOGGER_RV_ERROR;
+
+    // Note: Vendor defined mechanisms have no names so they can be specified by their numbers
+    if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_translate_string_to_ck_mechanism_type(name, &mechanism)) &&
+        (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long(name, &mechanism)))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    if (pkcs11_logger_globals.coalesce_mechanisms_count >= PKCS11_LOGGER_COALESCE_MECHANISMS_MAX)
+        return PKCS11_LOGGER_RV_ERROR;
+
+    pkcs11_logger_globals.coalesce_mechanisms[pkcs11_logger_globals.coalesce_mechanisms_count] = mechanism;
+    pkcs11_logger_globals.coalesce_mechanisms_count++;
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Parses comma separated list of mechanism names or decimal numbers whose updates are coalesced
+int pkcs11_logger_coalesce_parse_mechanisms(const char *list)
+{
+    pkcs11_logger_globals.coalesce_mechanisms_count = 0;
+
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_parse_list(list, pkcs11_logger_coalesce_parse_mechanism, NULL))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    return (0 == pkcs11_logger_globals.coalesce_mechanisms_count) ? PKCS11_LOGGER_RV_ERROR : PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Calls C_OpenSession and remembers the session whose updates might be coalesced
+CK_RV pkcs11_logger_coalesce_open_session(CK_SLOT_ID slotID, CK_FLAGS flags, CK_VOID_PTR pApplication, CK_NOTIFY Notify, CK_SESSION_HANDLE_PTR phSession, CK_BBOOL *pooled)
+{
+    CK_RV rv = pkcs11_logger_pool_open_session(slotID, flags, pApplication, Notify, phSession, pooled);
+    PKCS11_LOGGER_COALESCE_SESSION *session = NULL;
+    PKCS11_LOGGER_COALESCE_SESSION *stale = NULL;
+
+    if ((0 == pkcs11_logger_globals.coalesce_size) || (CKR_OK != rv))
+        return rv;
+
+    // Note: Updates of sessions that could not be remembered are always passed to the original library
+    session = (PKCS11_LOGGER_COALESCE_SESSION*) malloc(sizeof(PKCS11_LOGGER_COALESCE_SESSION));
+    if (NULL == session)
+        return rv;
+
+    memset(session, 0, sizeof(PKCS11_LOGGER_COALESCE_SESSION));
+    session->session = *phSession;
+    session->slot = slotID;
+
+    COALESCE_LOCK();
+
+    // Note: Handle of the session closed behind the back of the logger (e.g. by C_Finalize of another application) might be reused
+    stale = pkcs11_logger_coalesce_find(session->session, CK_TRUE);
+
+    session->next = pkcs11_logger_coalesce_sessions[session->session % PKCS11_LOGGER_COALESCE_BUCKETS];
+    pkcs11_logger_coalesce_sessions[session->session % PKCS11_LOGGER_COALESCE_BUCKETS] = session;
+
+    COALESCE_UNLOCK();
+
+    if (NULL != stale)
+        pkcs11_logger_coalesce_free(stale);
+
+    return rv;
+}
+
+
+// Calls C_CloseSession, discards buffered updates of the session and returns numbers of its updates
+CK_RV pkcs11_logger_coalesce_close_session(CK_SESSION_HANDLE hSession, CK_BBOOL *pooled, CK_ULONG_PTR pulUpdates, CK_ULONG_PTR pulCalls)
+{
+    CK_RV rv = pkcs11_logger_pool_close_session(hSession, pooled);
+    PKCS11_LOGGER_COALESCE_SESSION *session = NULL;
+
+    if (NULL != pulUpdates)
+        *pulUpdates = 0;
+    if (NULL != pulCalls)
+        *pulCalls = 0;
+
+    if ((0 == pkcs11_logger_globals.coalesce_size) || (CKR_OK != rv))
+        return rv;
+
+    COALESCE_LOCK();
+    session = pkcs11_logger_coalesce_find(hSession, CK_TRUE);
+    COALESCE_UNLOCK();
+
+    if (NULL == session)
+        return rv;
+
+    if (NULL != pulUpdates)
+        *pulUpdates = session->updates;
+    if (NULL != pulCalls)
+        *pulCalls = session->calls;
+
+    pkcs11_logger_coalesce_free(session);
+
+    return rv;
+}
+
+
+// Calls C_CloseAllSessions and discards buffered updates of all sessions of the slot
+CK_RV pkcs11_logger_coalesce_close_all_sessions(CK_SLOT_ID slotID)
+{
+    CK_RV rv = pkcs11_logger_pool_close_all_sessions(slotID);
+
+    if ((0 != pkcs11_logger_globals.coalesce_size) && (CKR_OK == rv))
+        pkcs11_logger_coalesce_forget(slotID);
+
+    return rv;
+}
+
+
+// Calls C_Finalize and discards buffered updates of all sessions
+CK_RV pkcs11_logger_coalesce_finalize(CK_VOID_PTR pReserved)
+{
+    CK_RV rv = pkcs11_logger_pool_finalize(pReserved);
+
+    if ((0 != pkcs11_logger_globals.coalesce_size) && (CKR_OK == rv))
+        pkcs11_logger_coalesce_forget(CK_UNAVAILABLE_INFORMATION);
+
+    return rv;
+}
+
+
+// Starts coalescing of updates of the operation when the call initialized it with allowed mechanism and returns the value returned by the call
+CK_RV pkcs11_logger_coalesce_start(CK_SESSION_HANDLE hSession, CK_ULONG state, CK_MECHANISM_PTR pMechanism, CK_RV rv)
+{
+    PKCS11_LOGGER_COALESCE_SESSION *session = NULL;
+    PKCS11_LOGGER_COALESCE_OPERATION *operation = NULL;
+    CK_BBOOL allowed = CK_FALSE;
+
+    if ((0 == pkcs11_logger_globals.coalesce_size) || (CKR_OK != rv) || (0 == (state & PKCS11_LOGGER_COALESCE_STATES)))
+        return rv;
+
+    allowed = (NULL != pMechanism) ? pkcs11_logger_coalesce_is_allowed(pMechanism->mechanism) : CK_FALSE;
+
+    COALESCE_LOCK();
+    session = pkcs11_logger_coalesce_find(hSession, CK_FALSE);
+    if (NULL != session)
+    {
+        operation = &session->operations[pkcs11_logger_coalesce_index(state)];
+        operation->active = allowed;
+        operation->len = 0;
+    }
+    COALESCE_UNLOCK();
+
+    return rv;
+}
+
+
+// Copies the part into the buffer of the operation or passes buffered updates and the part to the original library
+CK_RV pkcs11_logger_coalesce_update(CK_SESSION_HANDLE hSession, CK_ULONG state, CK_BYTE_PTR pPart, CK_ULONG ulPartLen, CK_BBOOL *buffered)
+{
+    CK_RV rv = CKR_OK;
+    PKCS11_LOGGER_COALESCE_SESSION *session = NULL;
+    PKCS11_LOGGER_COALESCE_OPERATION *operation = NULL;
+    CK_BYTE_PTR buffer = NULL;
+    CK_ULONG len = 0;
+    CK_ULONG calls = 0;
+    CK_ULONG size = pkcs11_logger_globals.coalesce_size;
+
+    if (NULL != buffered)
+        *buffered = CK_FALSE;
+
+    if (0 == size)
+        return pkcs11_logger_coalesce_forward(hSession, state, pPart, ulPartLen);
+
+    COALESCE_LOCK();
+
+    session = pkcs11_logger_coalesce_find(hSession, CK_FALSE);
+    if (NULL != session)
+        operation = &session->operations[pkcs11_logger_coalesce_index(state)];
+
+    if ((NULL == operation) || (CK_TRUE != operation->active))
+    {
+        COALESCE_UNLOCK();
+        return pkcs11_logger_coalesce_forward(hSession, state, pPart, ulPartLen);
+    }
+
+    session->updates++;
+    PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_updates, 1);
+
+    if ((NULL == operation->buffer) && (0 != ulPartLen) && (ulPartLen <= size))
+        operation->buffer = (CK_BYTE_PTR) malloc(size);
+
+    // Note: Part that fits into the buffer is copied and the original library is not called at all
+    if ((NULL != pPart) && (ulPartLen <= size - operation->len) && ((0 == ulPartLen) || (NULL != operation->buffer)))
+    {
+        if (0 != ulPartLen)
+            memcpy(operation->buffer + operation->len, pPart, ulPartLen);
+        operation->len += ulPartLen;
+
+        COALESCE_UNLOCK();
+
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_buffered, 1);
+
+        if (NULL != buffered)
+            *buffered = CK_TRUE;
+
+        return CKR_OK;
+    }
+
+    // Note: Buffer is taken away from the session so the lock does not need to be held while the original library is called
+    buffer = operation->buffer;
+    len = operation->len;
+    operation->buffer = NULL;
+    operation->len = 0;
+
+    COALESCE_UNLOCK();
+
+    if (0 != len)
+    {
+        rv = pkcs11_logger_coalesce_forward(hSession, state, buffer, len);
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_calls, 1);
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_bytes, len);
+        calls++;
+        len = 0;
+
+        if (CKR_OK != rv)
+        {
+            PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_failed, 1);
+            pkcs11_logger_coalesce_attach(hSession, state, buffer, 0, calls, rv);
+            return rv;
+        }
+    }
+
+    // Note: Part that does not fit into the empty buffer is passed to the original library without copying
+    if ((NULL != pPart) && (NULL != buffer) && (ulPartLen <= size))
+    {
+        memcpy(buffer, pPart, ulPartLen);
+        len = ulPartLen;
+
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_buffered, 1);
+
+        if (NULL != buffered)
+            *buffered = CK_TRUE;
+    }
+    else
+    {
+        rv = pkcs11_logger_coalesce_forward(hSession, state, pPart, ulPartLen);
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_calls, 1);
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_bytes, ulPartLen);
+        calls++;
+    }
+
+    pkcs11_logger_coalesce_attach(hSession, state, buffer, len, calls, rv);
+
+    return rv;
+}
+
+
+// Passes buffered updates of the operations to the original library before another call that uses them
+CK_RV pkcs11_logger_coalesce_flush(CK_SESSION_HANDLE hSession, CK_ULONG state)
+{
+    CK_RV rv = CKR_OK;
+    PKCS11_LOGGER_COALESCE_SESSION *session = NULL;
+    PKCS11_LOGGER_COALESCE_OPERATION *operation = NULL;
+    CK_BYTE_PTR buffer = NULL;
+    CK_ULONG len = 0;
+    CK_ULONG operation_state = 0;
+
+    if ((0 == pkcs11_logger_globals.coalesce_size) || (0 == (state & PKCS11_LOGGER_COALESCE_STATES)))
+        return CKR_OK;
+
+    for (operation_state = PKCS11_LOGGER_POOL_STATE_DIGEST; operation_state <= PKCS11_LOGGER_POOL_STATE_VERIFY; operation_state <<= 1)
+    {
+        if (0 == (state & operation_state & PKCS11_LOGGER_COALESCE_STATES))
+            continue;
+
+        COALESCE_LOCK();
+
+        session = pkcs11_logger_coalesce_find(hSession, CK_FALSE);
+        operation = (NULL != session) ? &session->operations[pkcs11_logger_coalesce_index(operation_state)] : NULL;
+        if ((NULL == operation) || (0 == operation->len))
+        {
+            COALESCE_UNLOCK();
+            continue;
+        }
+
+        buffer = operation->buffer;
+        len = operation->len;
+        operation->buffer = NULL;
+        operation->len = 0;
+
+        COALESCE_UNLOCK();
+
+        rv = pkcs11_logger_coalesce_forward(hSession, operation_state, buffer, len);
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_calls, 1);
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_bytes, len);
+
+        if (CKR_OK != rv)
+            PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_failed, 1);
+
+        pkcs11_logger_coalesce_attach(hSession, operation_state, buffer, 0, 1, rv);
+
+        if (CKR_OK != rv)
+        {
+            // Note: Error is kept until pkcs11_logger_coalesce_error() returns it instead of the call that needed the buffered updates
+            COALESCE_LOCK();
+            session = pkcs11_logger_coalesce_find(hSession, CK_FALSE);
+            if (NULL != session)
+                session->failed = rv;
+            COALESCE_UNLOCK();
+
+            return rv;
+        }
+    }
+
+    return CKR_OK;
+}
+
+
+// Returns the value returned by the original library when pkcs11_logger_coalesce_flush() failed
+CK_RV pkcs11_logger_coalesce_error(CK_SESSION_HANDLE hSession)
+{
+    CK_RV rv = CKR_SESSION_HANDLE_INVALID;
+    PKCS11_LOGGER_COALESCE_SESSION *session = NULL;
+
+    COALESCE_LOCK();
+    session = pkcs11_logger_coalesce_find(hSession, CK_FALSE);
+    if (NULL != session)
+    {
+        rv = session->failed;
+        session->failed = CKR_OK;
+    }
+    COALESCE_UNLOCK();
+
+    // Note: Session might have been closed by another thread after the failure
+    return (CKR_OK == rv) ? CKR_SESSION_HANDLE_INVALID : rv;
+}
+
+
+// Stops coalescing of updates when the call terminated the operation and returns the value returned by the call
+CK_RV pkcs11_logger_coalesce_finish(CK_SESSION_HANDLE hSession, CK_ULONG state, CK_BBOOL condition, CK_RV rv)
+{
+    PKCS11_LOGGER_COALESCE_SESSION *session = NULL;
+    PKCS11_LOGGER_COALESCE_OPERATION *operation = NULL;
+    CK_ULONG operation_state = 0;
+
+    if ((0 == pkcs11_logger_globals.coalesce_size) || (0 == (state & PKCS11_LOGGER_COALESCE_STATES)))
+        return rv;
+
+    // Note: Operation stays active only when the call just returned the length of its output
+    if ((CKR_BUFFER_TOO_SMALL == rv) || ((CKR_OK == rv) && (CK_TRUE != condition)))
+        return rv;
+
+    COALESCE_LOCK();
+
+    session = pkcs11_logger_coalesce_find(hSession, CK_FALSE);
+    if (NULL != session)
+    {
+        for (operation_state = PKCS11_LOGGER_POOL_STATE_DIGEST; operation_state <= PKCS11_LOGGER_POOL_STATE_VERIFY; operation_state <<= 1)
+        {
+            if (0 == (state & operation_state & PKCS11_LOGGER_COALESCE_STATES))
+                continue;
+
+            operation = &session->operations[pkcs11_logger_coalesce_index(operation_state)];
+            if (0 != operation->len)
+                PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_coalesce_discarded, 1);
+
+            operation->active = CK_FALSE;
+            operation->len = 0;
+        }
+    }
+
+    COALESCE_UNLOCK();
+
+    return rv;
+}
+
+
+// Logs numbers of coalesced updates and calls passed to the original library
+void pkcs11_logger_coalesce_dump(const char *reason)
+{
+    if (0 == pkcs11_logger_globals.coalesce_size)
+        return;
+
+    pkcs11_logger_log("Coalescing of updates (dumped on %s)", reason);
+    pkcs11_logger_log(" Size: %lu bytes", pkcs11_logger_globals.coalesce_size);
+    pkcs11_logger_log(" Updates of coalesced operations: %lu", PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_coalesce_updates));
+    pkcs11_logger_log(" Buffered by the logger: %lu", PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_coalesce_buffered));
+    pkcs11_logger_log(" Passed to the original library: %lu calls with %lu bytes", PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_coalesce_calls), PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_coalesce_bytes));
+    pkcs11_logger_log(" Failed after being buffered: %lu", PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_coalesce_failed));
+    pkcs11_logger_log(" Discarded buffers: %lu", PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_coalesce_discarded));
+    pkcs11_logger_log_separator();
+}
+
+
+// Forgets all sessions and resets statistics
+void pkcs11_logger_coalesce_stop(void)
+{
+    pkcs11_logger_coalesce_forget(CK_UNAVAILABLE_INFORMATION);
+
+    pkcs11_logger_coalesce_updates = 0;
+    pkcs11_logger_coalesce_buffered = 0;
+    pkcs11_logger_coalesce_calls = 0;
+    pkcs11_logger_coalesce_bytes = 0;
+    pkcs11_logger_coalesce_failed = 0;
+    pkcs11_logger_coalesce_discarded = 0;
+}
@@ -0,0 +1,475 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+// Converts binary log produced with PKCS11_LOGGER_FLAG_ENABLE_BINARY flag into human-readable text log
+
+
+#include "pkcs11-logger.h"
+
+
+// Structure that holds string defined in binary log
+typedef struct
+{
+    // ID of process that defined the string
+    unsigned int pid;
+    // ID of the string (address of the string in the logging process)
+    unsigned long long id;
+    // The string itself
+    char *string;
+}
+PKCS11_LOGGER_DECODER_STRING;
+
+
+// Table of strings defined in binary log
+static PKCS11_LOGGER_DECODER_STRING *pkcs11_logger_decoder_strings = NULL;
+// Number of slots in the table of strings
+static size_t pkcs11_logger_decoder_strings_size = 0;
+// Number of used slots in the table of strings
+static size_t pkcs11_logger_decoder_strings_count = 0;
+// System time in microseconds from the last clock entry
+static unsigned long long pkcs11_logger_decoder_realtime = 0;
+// Monotonic time in nanoseconds from the last clock entry
+static unsigned long long pkcs11_logger_decoder_monotonic_time = 0;
+
+
+// Reads 32-bit value from the buffer
+static unsigned int pkcs11_logger_decoder_get_u32(const unsigned char *buffer)
+{
+    unsigned int value = 0;
+    memcpy(&value, buffer, sizeof(value));
+    return value;
+}
+
+
+// Reads 64-bit value from the buffer
+static unsigned long long pkcs11_logger_decoder_get_u64(const unsigned char *buffer)
+{
+    unsigned long long value = 0;
+    memcpy(&value, buffer, sizeof(value));
+    return value;
+}
+
+
+// Finds slot of the string in the table of strings
+static PKCS11_LOGGER_DECODER_STRING* pkcs11_logger_decoder_find_string(unsigned int pid, unsigned long long id)
+{
+    size_t i = 0;
+
+    if (0 == pkcs11_logger_decoder_strings_size)
+        return NULL;
+
+    i = (size_t)(((id >> 3) ^ pid) % pkcs11_logger_decoder_strings_size);
+
+    // Note: Table always has at least one free slot
+    while (NULL != pkcs11_logger_decoder_strings[i].string)
+    {
+        if ((pid == pkcs11_logger_decoder_strings[i].pid) && (id == pkcs11_logger_decoder_strings[i].id))
+            break;
+
+        i = (i + 1) % pkcs11_logger_decoder_strings_size;
+    }
+
+    return &pkcs11_logger_decoder_strings[i];
+}
+
+
+// Adds string into the table of strings (ownership of the string is taken)
+static int pkcs11_logger_decoder_add_string(unsigned int pid, unsigned long long id, char *string)
+{
+    PKCS11_LOGGER_DECODER_STRING *slot = NULL;
+
+    if ((pkcs11_logger_decoder_strings_count + 1) * 2 > pkcs11_logger_decoder_strings_size)
+    {
+        PKCS11_LOGGER_DECODER_STRING *old_strings = pkcs11_logger_decoder_strings;
+        size_t old_size = pkcs11_logger_decoder_strings_size;
+        size_t i = 0;
+
+        pkcs11_logger_decoder_strings_size = (0 == old_size) ? 1024 : old_size * 2;
+        pkcs11_logger_decoder_strings = (PKCS11_LOGGER_DECODER_STRING*) calloc(pkcs11_logger_decoder_strings_size, sizeof(PKCS11_LOGGER_DECODER_STRING));
+        if (NULL == pkcs11_logger_decoder_strings)
+            return PKCS11_LOGGER_RV_ERROR;
+
+        for (i = 0; i < old_size; i++)
+        {
+            if (NULL != old_strings[i].string)
+                *pkcs11_logger_decoder_find_string(old_strings[i].pid, old_strings[i].id) = old_strings[i];
+        }
+
+        CALL_N_CLEAR(free, old_strings);
+    }
+
+    slot = pkcs11_logger_decoder_find_string(pid, id);
+    if (NULL == slot->string)
+        pkcs11_logger_decoder_strings_count++;
+    else
+        CALL_N_CLEAR(free, slot->string);
+
+    slot->pid = pid;
+    slot->id = id;
+    slot->string = string;
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Writes timestamp in the same format as text log
+static void pkcs11_logger_decoder_write_timestamp(FILE *output, unsigned long long timestamp)
+{
+    unsigned long long realtime = pkcs11_logger_decoder_realtime;
+    char time_string[27];
+    struct tm tm;
+    time_t seconds = 0;
+
+    if (timestamp >= pkcs11_logger_decoder_monotonic_time)
+        realtime += (timestamp - pkcs11_logger_decoder_monotonic_time) / 1000;
+    else
+        realtime -= (pkcs11_logger_decoder_monotonic_time - timestamp) / 1000;
+
+    seconds = (time_t)(realtime / 1000000);
+    memset(time_string, 0, sizeof(time_string));
+
+#ifdef _WIN32
+    if (0 == localtime_s(&tm, &seconds))
+#else
+    if (NULL != localtime_r(&seconds, &tm))
+#endif
+        strftime(time_string, sizeof(time_string), "%Y-%m-%d %H:%M:%S", &tm);
+
+    fprintf(output, "%s.%06u - ", time_string, (unsigned int)(realtime % 1000000));
+}
+
+
+// Writes message with arguments stored in binary log
+static void pkcs11_logger_decoder_write_message(FILE *output, const char *message, const unsigned char *args, size_t args_len)
+{
+    const char *hex = "0123456789ABCDEF";
+    const char *p = NULL;
+    char spec[32];
+    size_t spec_len = 0;
+    size_t offset = 0;
+
+    for (p = message; '\0' != *p; p++)
+    {
+        if ('%' != *p)
+        {
+            fputc(*p, output);
+            continue;
+        }
+
+        p++;
+        if ('%' == *p)
+        {
+            fputc('%', output);
+            continue;
+        }
+
+        // Copy flags and width but drop precision and length modifiers
+        spec[0] = '%';
+        spec_len = 1;
+        while (('\0' != *p) && (NULL != strchr("-+ #0123456789", *p)) && (spec_len < sizeof(spec) - 4))
+            spec[spec_len++] = *p++;
+        if ('.' == *p)
+        {
+            p++;
+            while (('0' <= *p) && ('9' >= *p))
+                p++;
+        }
+        while (('l' == *p) || ('h' == *p))
+            p++;
+
+        if ('\0' == *p)
+            break;
+
+        if ((NULL != strchr("diuxXocp", *p)) && (offset + 8 <= args_len))
+        {
+            unsigned long long value = pkcs11_logger_decoder_get_u64(args + offset);
+            offset += 8;
+
+            if (('d' == *p) || ('i' == *p))
+            {
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = *p;
+                spec[spec_len] = '\0';
+                fprintf(output, spec, (long long)value);
+            }
+            else if ('c' == *p)
+            {
+                spec[spec_len++] = *p;
+                spec[spec_len] = '\0';
+                fprintf(output, spec, (int)value);
+            }
+            else if ('p' == *p)
+            {
+                spec[spec_len++] = *p;
+                spec[spec_len] = '\0';
+                fprintf(output, spec, (void*)(size_t)value);
+            }
+            else
+            {
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = *p;
+                spec[spec_len] = '\0';
+                fprintf(output, spec, value);
+            }
+        }
+        else if ((('s' == *p) || (PKCS11_LOGGER_BINARY_CONVERSION_BYTES == *p)) && (offset + 4 <= args_len))
+        {
+            size_t len = pkcs11_logger_decoder_get_u32(args + offset);
+            offset += 4;
+
+            if (offset + len > args_len)
+                break;
+
+            if ('s' == *p)
+            {
+                spec[spec_len++] = '.';
+                spec[spec_len++] = '*';
+                spec[spec_len++] = 's';
+                spec[spec_len] = '\0';
+                fprintf(output, spec, (int)len, (const char*)(args + offset));
+            }
+            else
+            {
+                size_t i = 0;
+                for (i = 0; i < len; i++)
+                {
+                    fputc(hex[args[offset + i] >> 4], output);
+                    fputc(hex[args[offset + i] & 0x0F], output);
+                }
+            }
+
+            offset += len;
+        }
+        else
+        {
+            fprintf(output, "*** cannot be displayed ***");
+        }
+    }
+
+    fputc('\n', output);
+}
+
+
+// Decodes one entry of binary log
+static int pkcs11_logger_decoder_decode_entry(FILE *output, unsigned char type, unsigned char flags, const unsigned char *body, size_t body_len)
+{
+    PKCS11_LOGGER_DECODER_STRING *slot = NULL;
+    unsigned int pid = 0;
+    unsigned long long id = 0;
+    unsigned long long tid = 0;
+    size_t offset = 0;
+    char *string = NULL;
+
+    switch (type)
+    {
+        case PKCS11_LOGGER_BINARY_ENTRY_STRING:
+
+            if (body_len < 12)
+                return PKCS11_LOGGER_RV_ERROR;
+
+            string = (char*) malloc(body_len - 12 + 1);
+            if (NULL == string)
+                return PKCS11_LOGGER_RV_ERROR;
+
+            memcpy(string, body + 12, body_len - 12);
+            string[body_len - 12] = '\0';
+
+            return pkcs11_logger_decoder_add_string(pkcs11_logger_decoder_get_u32(body), pkcs11_logger_decoder_get_u64(body + 4), string);
+
+        case PKCS11_LOGGER_BINARY_ENTRY_CLOCK:
+
+            if (body_len < 20)
+                return PKCS11_LOGGER_RV_ERROR;
+
+            pkcs11_logger_decoder_realtime = pkcs11_logger_decoder_get_u64(body + 4);
+            pkcs11_logger_decoder_monotonic_time = pkcs11_logger_decoder_get_u64(body + 12);
+
+            return PKCS11_LOGGER_RV_SUCCESS;
+
+        case PKCS11_LOGGER_BINARY_ENTRY_MESSAGE:
+
+            if (body_len < (size_t)(20 + ((flags & PKCS11_LOGGER_BINARY_FLAG_TIMESTAMP) ? 8 : 0)))
+                return PKCS11_LOGGER_RV_ERROR;
+
+            id = pkcs11_logger_decoder_get_u64(body);
+            pid = pkcs11_logger_decoder_get_u32(body + 8);
+            tid = pkcs11_logger_decoder_get_u64(body + 12);
+            offset = 20;
+
+            if (flags & PKCS11_LOGGER_BINARY_FLAG_PROCESS_ID)
+                fprintf(output, "%0#10x : ", pid);
+            if (flags & PKCS11_LOGGER_BINARY_FLAG_THREAD_ID)
+                fprintf(output, "%0#18llx : ", tid);
+            if (flags & PKCS11_LOGGER_BINARY_FLAG_TIMESTAMP)
+            {
+                pkcs11_logger_decoder_write_timestamp(output, pkcs11_logger_decoder_get_u64(body + offset));
+                offset += 8;
+            }
+
+            slot = pkcs11_logger_decoder_find_string(pid, id);
+            if ((NULL == slot) || (NULL == slot->string))
+                fprintf(output, "*** message %0#18llx is not defined ***\n", id);
+            else
+                pkcs11_logger_decoder_write_message(output, slot->string, body + offset, body_len - offset);
+
+            return PKCS11_LOGGER_RV_SUCCESS;
+
+        default:
+
+            // Note: Unknown entries are skipped
+            return PKCS11_LOGGER_RV_SUCCESS;
+    }
+}
+
+
+// Decodes whole binary log
+static int pkcs11_logger_decoder_decode(FILE *input, FILE *output)
+{
+    unsigned char file_header[sizeof(PKCS11_LOGGER_BINARY_MAGIC) + 8];
+    unsigned char entry_header[PKCS11_LOGGER_BINARY_ENTRY_HEADER_SIZE];
+    unsigned char *body = NULL;
+    size_t body_size = 0;
+    size_t body_len = 0;
+    int rv = PKCS11_LOGGER_RV_ERROR;
+
+    if (sizeof(file_header) != fread(file_header, 1, sizeof(file_header), input))
+    {
+        fprintf(stderr, "Unable to read file header\n");
+        goto err;
+    }
+
+    if ((0 != memcmp(file_header, PKCS11_LOGGER_BINARY_MAGIC, sizeof(PKCS11_LOGGER_BINARY_MAGIC))) ||
+        (PKCS11_LOGGER_BINARY_VERSION != pkcs11_logger_decoder_get_u32(file_header + sizeof(PKCS11_LOGGER_BINARY_MAGIC))))
+    {
+        fprintf(stderr, "Unsupported file format\n");
+        goto err;
+    }
+
+    if (PKCS11_LOGGER_BINARY_BYTE_ORDER != pkcs11_logger_decoder_get_u32(file_header + sizeof(PKCS11_LOGGER_BINARY_MAGIC) + 4))
+    {
+        fprintf(stderr, "File was created on platform with different byte order\n");
+        goto err;
+    }
+
+    while (sizeof(entry_header) == fread(entry_header, 1, sizeof(entry_header), input))
+    {
+        size_t entry_len = pkcs11_logger_decoder_get_u32(entry_header);
+
+        if (entry_len < sizeof(entry_header))
+        {
+            fprintf(stderr, "Invalid entry length\n");
+            goto err;
+        }
+
+        body_len = entry_len - sizeof(entry_header);
+        if (body_len > body_size)
+        {
+            unsigned char *new_body = (unsigned char*) realloc(body, body_len);
+            if (NULL == new_body)
+            {
+                fprintf(stderr, "Unable to allocate memory\n");
+                goto err;
+            }
+
+            body = new_body;
+            body_size = body_len;
+        }
+
+        if (body_len != fread(body, 1, body_len, input))
+        {
+            fprintf(stderr, "Truncated entry\n");
+            goto err;
+        }
+
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_decoder_decode_entry(output, entry_header[4], entry_header[5], body, body_len))
+        {
+            fprintf(stderr, "Invalid entry\n");
+            goto err;
+        }
+    }
+
+    rv = PKCS11_LOGGER_RV_SUCCESS;
+
+err:
+
+    CALL_N_CLEAR(free, body);
+
+    return rv;
+}
+
+
+int main(int argc, char *argv[])
+{
+    FILE *input = NULL;
+    FILE *output = NULL;
+    int rv = 1;
+
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable: 4996)
+#endif
+
+    if ((argc != 2) && (argc != 3))
+    {
+        fprintf(stderr, "Usage: %s <binary-log-file> [<text-log-file>]\n", argv[0]);
+        goto err;
+    }
+
+    input = fopen(argv[1], "rb");
+    if (NULL == input)
+    {
+        fprintf(stderr, "Unable to open %s\n", argv[1]);
+        goto err;
+    }
+
+    output = (argc == 3) ? fopen(argv[2], "w") : stdout;
+    if (NULL == output)
+    {
+        fprintf(stderr, "Unable to open %s\n", argv[2]);
+        goto err;
+    }
+
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+    if (PKCS11_LOGGER_RV_SUCCESS == pkcs11_logger_decoder_decode(input, output))
+        rv = 0;
+
+err:
+
+    if (NULL != pkcs11_logger_decoder_strings)
+    {
+        size_t i = 0;
+        for (i = 0; i < pkcs11_logger_decoder_strings_size; i++)
+            CALL_N_CLEAR(free, pkcs11_logger_decoder_strings[i].string);
+        CALL_N_CLEAR(free, pkcs11_logger_decoder_strings);
+    }
+
+    CALL_N_CLEAR(fclose, input);
+    if (stdout != output)
+        CALL_N_CLEAR(fclose, output);
+
+    return rv;
+}
@@ -0,0 +1,320 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PKCS11_LOGGER_HEX_X86
+#include <immintrin.h>
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PKCS11_LOGGER_HEX_NEON
+#include <arm_neon.h>
+#endif
+
+// Compilers that need explicit enabling of instruction sets for each function
+#if defined(PKCS11_LOGGER_HEX_X86) && (defined(__GNUC__) || defined(__clang__))
+#define PKCS11_LOGGER_HEX_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PKCS11_LOGGER_HEX_TARGET(isa)
+#endif
+
+
+// Structure that describes one implementation of the hex encoder
+typedef struct
+{
+    // Name of the implementation
+    const char *name;
+    // Function that encodes the bytes
+    PKCS11_LOGGER_HEX_ENCODER encoder;
+    // Function that checks whether the implementation is supported by the CPU
+    CK_BBOOL (*is_supported)(void);
+}
+PKCS11_LOGGER_HEX_IMPLEMENTATION;
+
+
+// Characters used for encoding of nibbles
+static const char pkcs11_logger_hex_digits[] = "0123456789ABCDEF";
+
+
+// Encodes bytes one at a time
+static void pkcs11_logger_hex_encode_scalar(const CK_BYTE *bytes, CK_ULONG length, char *output)
+{
+    CK_ULONG i = 0;
+
+    for (i = 0; i < length; i++)
+    {
+        output[i * 2] = pkcs11_logger_hex_digits[bytes[i] >> 4];
+        output[i * 2 + 1] = pkcs11_logger_hex_digits[bytes[i] & 0x0F];
+    }
+}
+
+
+// Scalar implementation is supported everywhere
+static CK_BBOOL pkcs11_logger_hex_is_supported_scalar(void)
+{
+    return CK_TRUE;
+}
+
+
+#ifdef PKCS11_LOGGER_HEX_X86
+
+#ifdef _WIN32
+
+// Checks CPUID feature bits and whether the OS saves the register state specified by the mask
+static CK_BBOOL pkcs11_logger_hex_cpu_supports(int leaf7_ebx_bits, unsigned long long xcr0_mask)
+{
+    int info[4] = { 0, 0, 0, 0 };
+
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return CK_FALSE;
+
+    // Note: OSXSAVE bit indicates that XGETBV can be used
+    __cpuid(info, 1);
+    if (0 == (info[2] & (1 << 27)))
+        return CK_FALSE;
+
+    if ((_xgetbv(0) & xcr0_mask) != xcr0_mask)
+        return CK_FALSE;
+
+    __cpuidex(info, 7, 0);
+
+    return ((info[1] & leaf7_ebx_bits) == leaf7_ebx_bits) ? CK_TRUE : CK_FALSE;
+}
+
+#endif
+
+
+// Encodes 16 bytes at a time with SSE2 instructions
+PKCS11_LOGGER_HEX_TARGET("sse2")
+static void pkcs11_logger_hex_encode_sse2(const CK_BYTE *bytes, CK_ULONG length, char *output)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i letter = _mm_set1_epi8('A' - '0' - 10);
+    CK_ULONG i = 0;
+
+    for (i = 0; i + 16 <= length; i += 16)
+    {
+        __m128i input = _mm_loadu_si128((const __m128i *)(bytes + i));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(input, 4), mask);
+        __m128i lo = _mm_and_si128(input, mask);
+
+        // Note: SSE2 has no byte shuffle so digits above 9 are shifted into letters
+        hi = _mm_add_epi8(_mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), letter));
+        lo = _mm_add_epi8(_mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), letter));
+
+        _mm_storeu_si128((__m128i *)(output + i * 2), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(output + i * 2 + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+
+    pkcs11_logger_hex_encode_scalar(bytes + i, length - i, output + i * 2);
+}
+
+
+// Checks whether SSE2 instructions are supported by the CPU
+static CK_BBOOL pkcs11_logger_hex_is_supported_sse2(void)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return CK_TRUE;
+#elif defined(_WIN32)
+    return IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) ? CK_TRUE : CK_FALSE;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2") ? CK_TRUE : CK_FALSE;
+#endif
+}
+
+
+// Encodes 32 bytes at a time with AVX2 instructions
+PKCS11_LOGGER_HEX_TARGET("avx2")
+static void pkcs11_logger_hex_encode_avx2(const CK_BYTE *bytes, CK_ULONG length, char *output)
+{
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    const __m256i digits = _mm256_setr_epi8(
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F');
+    CK_ULONG i = 0;
+
+    for (i = 0; i + 32 <= length; i += 32)
+    {
+        __m256i input = _mm256_loadu_si256((const __m256i *)(bytes + i));
+        __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(input, 4), mask));
+        __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(input, mask));
+
+        // Note: Unpacking works within 128-bit lanes so the halves need to be put back in order
+        __m256i first = _mm256_unpacklo_epi8(hi, lo);
+        __m256i second = _mm256_unpackhi_epi8(hi, lo);
+
+        _mm256_storeu_si256((__m256i *)(output + i * 2), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i *)(output + i * 2 + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+
+    pkcs11_logger_hex_encode_sse2(bytes + i, length - i, output + i * 2);
+}
+
+
+// Checks whether AVX2 instructions are supported by the CPU and the OS
+static CK_BBOOL pkcs11_logger_hex_is_supported_avx2(void)
+{
+#ifdef _WIN32
+    return pkcs11_logger_hex_cpu_supports(1 << 5, 0x06);
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? CK_TRUE : CK_FALSE;
+#endif
+}
+
+
+// Encodes 64 bytes at a time with AVX-512 instructions
+PKCS11_LOGGER_HEX_TARGET("avx512f,avx512bw")
+static void pkcs11_logger_hex_encode_avx512(const CK_BYTE *bytes, CK_ULONG length, char *output)
+{
+    const __m512i mask = _mm512_set1_epi8(0x0F);
+    const __m512i digits = _mm512_broadcast_i32x4(_mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'));
+    const __m512i first_lanes = _mm512_set_epi64(11, 10, 3, 2, 9, 8, 1, 0);
+    const __m512i second_lanes = _mm512_set_epi64(15, 14, 7, 6, 13, 12, 5, 4);
+    CK_ULONG i = 0;
+
+    for (i = 0; i + 64 <= length; i += 64)
+    {
+        __m512i input = _mm512_loadu_si512((const void *)(bytes + i));
+        __m512i hi = _mm512_shuffle_epi8(digits, _mm512_and_si512(_mm512_srli_epi16(input, 4), mask));
+        __m512i lo = _mm512_shuffle_epi8(digits, _mm512_and_si512(input, mask));
+
+        // Note: Unpacking works within 128-bit lanes so the lanes need to be put back in order
+        __m512i first = _mm512_unpacklo_epi8(hi, lo);
+        __m512i second = _mm512_unpackhi_epi8(hi, lo);
+
+        _mm512_storeu_si512((void *)(output + i * 2), _mm512_permutex2var_epi64(first, first_lanes, second));
+        _mm512_storeu_si512((void *)(output + i * 2 + 64), _mm512_permutex2var_epi64(first, second_lanes, second));
+    }
+
+    pkcs11_logger_hex_encode_avx2(bytes + i, length - i, output + i * 2);
+}
+
+
+// Checks whether AVX-512 instructions are supported by the CPU and the OS
+static CK_BBOOL pkcs11_logger_hex_is_supported_avx512(void)
+{
+#ifdef _WIN32
+    return pkcs11_logger_hex_cpu_supports((1 << 5) | (1 << 16) | (1 << 30), 0xE6);
+#else
+    __builtin_cpu_init();
+    return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) ? CK_TRUE : CK_FALSE;
+#endif
+}
+
+#endif
+
+
+#ifdef PKCS11_LOGGER_HEX_NEON
+
+// Encodes 16 bytes at a time with NEON instructions
+static void pkcs11_logger_hex_encode_neon(const CK_BYTE *bytes, CK_ULONG length, char *output)
+{
+    const uint8x16_t mask = vdupq_n_u8(0x0F);
+    const uint8x16_t digits = vld1q_u8((const uint8_t *)pkcs11_logger_hex_digits);
+    CK_ULONG i = 0;
+
+    for (i = 0; i + 16 <= length; i += 16)
+    {
+        uint8x16_t input = vld1q_u8(bytes + i);
+        uint8x16x2_t encoded;
+
+        encoded.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(input, 4));
+        encoded.val[1] = vqtbl1q_u8(digits, vandq_u8(input, mask));
+
+        // Note: Interleaving store puts high and low nibble of each byte next to each other
+        vst2q_u8((uint8_t *)(output + i * 2), encoded);
+    }
+
+    pkcs11_logger_hex_encode_scalar(bytes + i, length - i, output + i * 2);
+}
+
+
+// NEON instructions are mandatory on 64-bit ARM
+static CK_BBOOL pkcs11_logger_hex_is_supported_neon(void)
+{
+    return CK_TRUE;
+}
+
+#endif
+
+
+// Implementations of the hex encoder ordered from the slowest to the fastest
+static const PKCS11_LOGGER_HEX_IMPLEMENTATION pkcs11_logger_hex_implementations[] =
+{
+    { "scalar", pkcs11_logger_hex_encode_scalar, pkcs11_logger_hex_is_supported_scalar },
+#ifdef PKCS11_LOGGER_HEX_X86
+    { "sse2", pkcs11_logger_hex_encode_sse2, pkcs11_logger_hex_is_supported_sse2 },
+    { "avx2", pkcs11_logger_hex_encode_avx2, pkcs11_logger_hex_is_supported_avx2 },
+    { "avx512", pkcs11_logger_hex_encode_avx512, pkcs11_logger_hex_is_supported_avx512 },
+#endif
+#ifdef PKCS11_LOGGER_HEX_NEON
+    { "neon", pkcs11_logger_hex_encode_neon, pkcs11_logger_hex_is_supported_neon },
+#endif
+};
+
+// Number of implementations of the hex encoder
+#define PKCS11_LOGGER_HEX_IMPLEMENTATION_COUNT (sizeof(pkcs11_logger_hex_implementations) / sizeof(PKCS11_LOGGER_HEX_IMPLEMENTATION))
+
+// Index of the fastest supported implementation increased by one (zero when not selected yet)
+static CK_ULONG pkcs11_logger_hex_selected = 0;
+
+
+// Encodes bytes into uppercase hex characters (output must have space for 2 * length characters and is not terminated)
+void pkcs11_logger_hex_encode(const CK_BYTE *bytes, CK_ULONG length, char *output)
+{
+    CK_ULONG selected = PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_hex_selected);
+
+    // Note: Concurrent threads can select the implementation simultaneously but they always select the same one
+    if (0 == selected)
+    {
+        for (selected = PKCS11_LOGGER_HEX_IMPLEMENTATION_COUNT; selected > 1; selected--)
+        {
+            if (CK_TRUE == pkcs11_logger_hex_implementations[selected - 1].is_supported())
+                break;
+        }
+
+        PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_hex_selected, selected);
+    }
+
+    pkcs11_logger_hex_implementations[selected - 1].encoder(bytes, length, output);
+}
+
+
+// Returns name of the implementation with the specified index and its encoder (NULL when not supported by the CPU) or NULL when index is out of range
+const char* pkcs11_logger_hex_get_implementation(CK_ULONG index, PKCS11_LOGGER_HEX_ENCODER *encoder)
+{
+    if (index >= PKCS11_LOGGER_HEX_IMPLEMENTATION_COUNT)
+        return NULL;
+
+    if (NULL != encoder)
+        *encoder = (CK_TRUE == pkcs11_logger_hex_implementations[index].is_supported()) ? pkcs11_logger_hex_implementations[index].encoder : NULL;
+
+    return pkcs11_logger_hex_implementations[index].name;
+}
@@ -36,6 +36,11 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
 
     if ((DLL_PROCESS_ATTACH == ul_reason_for_call) || (DLL_PROCESS_DETACH == ul_reason_for_call))
         pkcs11_logger_init_globals();
+    else if (DLL_THREAD_DETACH == ul_reason_for_call)
+    {
+        pkcs11_logger_arena_release();
+        pkcs11_logger_stats_release();
+    }
 
     return TRUE;
 }
@@ -65,11 +70,85 @@ void pkcs11_logger_init_globals(void)
     pkcs11_logger_globals.orig_lib_handle = NULL;
     pkcs11_logger_globals.orig_lib_functions = NULL;
     // Note: There is no need to modify pkcs11_logger_globals.logger_functions
+    // Note: Records queued for the background writer thread need to be written before the log file is closed
+    pkcs11_logger_queue_stop(CK_FALSE);
+    pkcs11_logger_mmap_stop();
+    pkcs11_logger_rotate_stop(CK_FALSE);
+    pkcs11_logger_stats_stop();
+    pkcs11_logger_sink_stop();
+    pkcs11_logger_arena_stop();
+    pkcs11_logger_sample_stop();
+    pkcs11_logger_limit_stop();
+    pkcs11_logger_cache_stop();
+    pkcs11_logger_pool_stop();
+    pkcs11_logger_coalesce_stop();
     pkcs11_logger_globals.env_vars_read = CK_FALSE;
     CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_library_path);
     CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_log_file_path);
     CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_flags);
     pkcs11_logger_globals.flags = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_queue_size);
+    pkcs11_logger_globals.queue_size = PKCS11_LOGGER_QUEUE_SIZE_DEFAULT;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_queue_policy);
+    pkcs11_logger_globals.queue_policy = PKCS11_LOGGER_QUEUE_POLICY_BLOCK;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_mmap_segment_size);
+    pkcs11_logger_globals.mmap_segment_size = PKCS11_LOGGER_MMAP_SEGMENT_SIZE_DEFAULT;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_rotate_size);
+    pkcs11_logger_globals.rotate_size = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_rotate_interval);
+    pkcs11_logger_globals.rotate_interval = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_rotate_count);
+    pkcs11_logger_globals.rotate_count = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_rotate_compression);
+    pkcs11_logger_globals.rotate_compression = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_durability);
+    pkcs11_logger_globals.durability = PKCS11_LOGGER_DURABILITY_LINE;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_flush_records);
+    pkcs11_logger_globals.flush_records = PKCS11_LOGGER_FLUSH_RECORDS_DEFAULT;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_flush_interval);
+    pkcs11_logger_globals.flush_interval = PKCS11_LOGGER_FLUSH_INTERVAL_DEFAULT;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_control_file);
+    pkcs11_logger_globals.control_file_checked = 0;
+    pkcs11_logger_globals.control_file_exists = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_include_functions);
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_exclude_functions);
+    memset(pkcs11_logger_globals.skipped_functions, 0, sizeof(pkcs11_logger_globals.skipped_functions));
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_stats_interval);
+    pkcs11_logger_globals.stats_interval = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_stats_signal);
+    pkcs11_logger_globals.stats_signal = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_timestamp);
+    pkcs11_logger_globals.timestamp = PKCS11_LOGGER_TIMESTAMP_REALTIME;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_socket);
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_ring_file_path);
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_ring_size);
+    pkcs11_logger_globals.ring_size = PKCS11_LOGGER_RING_SIZE_DEFAULT;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_arena_size);
+    pkcs11_logger_globals.arena_size = PKCS11_LOGGER_ARENA_SIZE_DEFAULT;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_byte_array_head);
+    pkcs11_logger_globals.byte_array_head = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_byte_array_tail);
+    pkcs11_logger_globals.byte_array_tail = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_sample_rates);
+    memset(pkcs11_logger_globals.sample_rates, 0, sizeof(pkcs11_logger_globals.sample_rates));
+    memset(pkcs11_logger_globals.sample_random, 0, sizeof(pkcs11_logger_globals.sample_random));
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_limit_records);
+    pkcs11_logger_globals.limit_records = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_limit_bytes);
+    pkcs11_logger_globals.limit_bytes = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_limit_calls);
+    memset(pkcs11_logger_globals.limit_calls, 0, sizeof(pkcs11_logger_globals.limit_calls));
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_cache_ttl);
+    pkcs11_logger_globals.cache_ttl = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_pool_size);
+    pkcs11_logger_globals.pool_size = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_pool_idle_timeout);
+    pkcs11_logger_globals.pool_idle_timeout = PKCS11_LOGGER_POOL_IDLE_TIMEOUT_DEFAULT;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_coalesce_size);
+    pkcs11_logger_globals.coalesce_size = 0;
+    CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_coalesce_mechanisms);
+    memset(pkcs11_logger_globals.coalesce_mechanisms, 0, sizeof(pkcs11_logger_globals.coalesce_mechanisms));
+    pkcs11_logger_globals.coalesce_mechanisms_count = 0;
     CALL_N_CLEAR(fclose, pkcs11_logger_globals.log_file_handle);
 }
 
@@ -96,6 +175,37 @@ int pkcs11_logger_init_orig_lib(void)
 
     pkcs11_logger_globals.env_vars_read = CK_TRUE;
 
+    // Prepare outputs other than the log file
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_sink_start())
+    {
+        pkcs11_logger_log("Unable to prepare outputs specified by %s and %s environment variables", PKCS11_LOGGER_SOCKET, PKCS11_LOGGER_RING_FILE_PATH);
+        return PKCS11_LOGGER_RV_ERROR;
+    }
+
+    // Prepare release of arenas of exiting threads
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_arena_start())
+    {
+        pkcs11_logger_log("Unable to prepare arenas for temporary strings");
+        return PKCS11_LOGGER_RV_ERROR;
+    }
+
+    // Start background writer thread
+    if ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_ASYNC) == PKCS11_LOGGER_FLAG_ENABLE_ASYNC)
+    {
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_queue_start())
+            return PKCS11_LOGGER_RV_ERROR;
+    }
+
+    // Install signal handler that requests dump of latency statistics
+    if ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_STATS) == PKCS11_LOGGER_FLAG_ENABLE_STATS)
+    {
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_stats_start())
+        {
+            pkcs11_logger_log("Unable to install handler of signal specified by %s environment variable", PKCS11_LOGGER_STATS_SIGNAL);
+            return PKCS11_LOGGER_RV_ERROR;
+        }
+    }
+
     // Log informational header
     pkcs11_logger_log_separator();
     pkcs11_logger_log("%s %s", PKCS11_LOGGER_NAME, PKCS11_LOGGER_VERSION);
@@ -183,6 +293,399 @@ int pkcs11_logger_init_parse_env_vars(void)
         }
     }
 
+    // Read PKCS11_LOGGER_QUEUE_SIZE environment variable
+    pkcs11_logger_globals.env_var_queue_size = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_QUEUE_SIZE);
+    if (NULL != pkcs11_logger_globals.env_var_queue_size)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_queue_size, &(pkcs11_logger_globals.queue_size))) || (0 == pkcs11_logger_globals.queue_size))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_QUEUE_SIZE);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_QUEUE_POLICY environment variable
+    pkcs11_logger_globals.env_var_queue_policy = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_QUEUE_POLICY);
+    if (NULL != pkcs11_logger_globals.env_var_queue_policy)
+    {
+        if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case((const char *)pkcs11_logger_globals.env_var_queue_policy, "block"))
+        {
+            pkcs11_logger_globals.queue_policy = PKCS11_LOGGER_QUEUE_POLICY_BLOCK;
+        }
+        else if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case((const char *)pkcs11_logger_globals.env_var_queue_policy, "drop"))
+        {
+            pkcs11_logger_globals.queue_policy = PKCS11_LOGGER_QUEUE_POLICY_DROP;
+        }
+        else if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case((const char *)pkcs11_logger_globals.env_var_queue_policy, "spill"))
+        {
+            pkcs11_logger_globals.queue_policy = PKCS11_LOGGER_QUEUE_POLICY_SPILL;
+        }
+        else
+        {
+            pkcs11_logger_log("Value of %s environment variable needs to be one of: block, drop, spill", PKCS11_LOGGER_QUEUE_POLICY);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_MMAP_SEGMENT_SIZE environment variable
+    pkcs11_logger_globals.env_var_mmap_segment_size = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_MMAP_SEGMENT_SIZE);
+    if (NULL != pkcs11_logger_globals.env_var_mmap_segment_size)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_mmap_segment_size, &(pkcs11_logger_globals.mmap_segment_size))) || (0 == pkcs11_logger_globals.mmap_segment_size))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_MMAP_SEGMENT_SIZE);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_ROTATE_SIZE environment variable
+    pkcs11_logger_globals.env_var_rotate_size = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_ROTATE_SIZE);
+    if (NULL != pkcs11_logger_globals.env_var_rotate_size)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_rotate_size, &(pkcs11_logger_globals.rotate_size))) || (0 == pkcs11_logger_globals.rotate_size))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_ROTATE_SIZE);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_ROTATE_INTERVAL environment variable
+    pkcs11_logger_globals.env_var_rotate_interval = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_ROTATE_INTERVAL);
+    if (NULL != pkcs11_logger_globals.env_var_rotate_interval)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_rotate_interval, &(pkcs11_logger_globals.rotate_interval))) || (0 == pkcs11_logger_globals.rotate_interval))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_ROTATE_INTERVAL);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_ROTATE_COUNT environment variable
+    pkcs11_logger_globals.env_var_rotate_count = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_ROTATE_COUNT);
+    if (NULL != pkcs11_logger_globals.env_var_rotate_count)
+    {
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_rotate_count, &(pkcs11_logger_globals.rotate_count)))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a number", PKCS11_LOGGER_ROTATE_COUNT);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_ROTATE_COMPRESSION environment variable
+    pkcs11_logger_globals.env_var_rotate_compression = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_ROTATE_COMPRESSION);
+    if (NULL != pkcs11_logger_globals.env_var_rotate_compression)
+    {
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_rotate_find_compressor((const char *)pkcs11_logger_globals.env_var_rotate_compression, &(pkcs11_logger_globals.rotate_compression)))
+        {
+            pkcs11_logger_log("Compression specified by %s environment variable is not supported by this build", PKCS11_LOGGER_ROTATE_COMPRESSION);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_DURABILITY environment variable
+    pkcs11_logger_globals.env_var_durability = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_DURABILITY);
+    if (NULL != pkcs11_logger_globals.env_var_durability)
+    {
+        if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case((const char *)pkcs11_logger_globals.env_var_durability, "line"))
+        {
+            pkcs11_logger_globals.durability = PKCS11_LOGGER_DURABILITY_LINE;
+        }
+        else if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case((const char *)pkcs11_logger_globals.env_var_durability, "none"))
+        {
+            pkcs11_logger_globals.durability = PKCS11_LOGGER_DURABILITY_NONE;
+        }
+        else if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case((const char *)pkcs11_logger_globals.env_var_durability, "batch"))
+        {
+            pkcs11_logger_globals.durability = PKCS11_LOGGER_DURABILITY_BATCH;
+        }
+        else if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case((const char *)pkcs11_logger_globals.env_var_durability, "exit"))
+        {
+            pkcs11_logger_globals.durability = PKCS11_LOGGER_DURABILITY_EXIT;
+        }
+        else if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case((const char *)pkcs11_logger_globals.env_var_durability, "sync"))
+        {
+            pkcs11_logger_globals.durability = PKCS11_LOGGER_DURABILITY_SYNC;
+        }
+        else
+        {
+            pkcs11_logger_log("Value of %s environment variable needs to be one of: line, none, batch, exit, sync", PKCS11_LOGGER_DURABILITY);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_FLUSH_RECORDS environment variable
+    pkcs11_logger_globals.env_var_flush_records = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_FLUSH_RECORDS);
+    if (NULL != pkcs11_logger_globals.env_var_flush_records)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_flush_records, &(pkcs11_logger_globals.flush_records))) || (0 == pkcs11_logger_globals.flush_records))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_FLUSH_RECORDS);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_FLUSH_INTERVAL environment variable
+    pkcs11_logger_globals.env_var_flush_interval = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_FLUSH_INTERVAL);
+    if (NULL != pkcs11_logger_globals.env_var_flush_interval)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_flush_interval, &(pkcs11_logger_globals.flush_interval))) || (0 == pkcs11_logger_globals.flush_interval))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_FLUSH_INTERVAL);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_CONTROL_FILE environment variable
+    pkcs11_logger_globals.env_var_control_file = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_CONTROL_FILE);
+    if (NULL != pkcs11_logger_globals.env_var_control_file)
+    {
+        if (('"' == pkcs11_logger_globals.env_var_control_file[0]) || ('\'' == pkcs11_logger_globals.env_var_control_file[0]))
+        {
+            pkcs11_logger_log("Value of %s environment variable needs to be provided without enclosing quotes", PKCS11_LOGGER_CONTROL_FILE);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_INCLUDE_FUNCTIONS environment variable
+    pkcs11_logger_globals.env_var_include_functions = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_INCLUDE_FUNCTIONS);
+    if (NULL != pkcs11_logger_globals.env_var_include_functions)
+    {
+        // Note: Only the listed functions are logged
+        memset(pkcs11_logger_globals.skipped_functions, 0xFF, sizeof(pkcs11_logger_globals.skipped_functions));
+
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_init_parse_function_list((const char *)pkcs11_logger_globals.env_var_include_functions, CK_FALSE))
+        {
+            pkcs11_logger_log("Value of %s environment variable needs to be a comma separated list of PKCS#11 function names", PKCS11_LOGGER_INCLUDE_FUNCTIONS);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_EXCLUDE_FUNCTIONS environment variable
+    pkcs11_logger_globals.env_var_exclude_functions = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_EXCLUDE_FUNCTIONS);
+    if (NULL != pkcs11_logger_globals.env_var_exclude_functions)
+    {
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_init_parse_function_list((const char *)pkcs11_logger_globals.env_var_exclude_functions, CK_TRUE))
+        {
+            pkcs11_logger_log("Value of %s environment variable needs to be a comma separated list of PKCS#11 function names", PKCS11_LOGGER_EXCLUDE_FUNCTIONS);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_STATS_INTERVAL environment variable
+    pkcs11_logger_globals.env_var_stats_interval = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_STATS_INTERVAL);
+    if (NULL != pkcs11_logger_globals.env_var_stats_interval)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_stats_interval, &(pkcs11_logger_globals.stats_interval))) || (0 == pkcs11_logger_globals.stats_interval))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_STATS_INTERVAL);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_STATS_SIGNAL environment variable
+    pkcs11_logger_globals.env_var_stats_signal = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_STATS_SIGNAL);
+    if (NULL != pkcs11_logger_globals.env_var_stats_signal)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_stats_signal, &(pkcs11_logger_globals.stats_signal))) || (0 == pkcs11_logger_globals.stats_signal))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_STATS_SIGNAL);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_TIMESTAMP environment variable
+    pkcs11_logger_globals.env_var_timestamp = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_TIMESTAMP);
+    if (NULL != pkcs11_logger_globals.env_var_timestamp)
+    {
+        if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case((const char *)pkcs11_logger_globals.env_var_timestamp, "realtime"))
+        {
+            pkcs11_logger_globals.timestamp = PKCS11_LOGGER_TIMESTAMP_REALTIME;
+        }
+        else if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case((const char *)pkcs11_logger_globals.env_var_timestamp, "coarse"))
+        {
+            pkcs11_logger_globals.timestamp = PKCS11_LOGGER_TIMESTAMP_COARSE;
+        }
+        else if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case((const char *)pkcs11_logger_globals.env_var_timestamp, "monotonic"))
+        {
+            pkcs11_logger_globals.timestamp = PKCS11_LOGGER_TIMESTAMP_MONOTONIC;
+        }
+        else
+        {
+            pkcs11_logger_log("Value of %s environment variable needs to be one of: realtime, coarse, monotonic", PKCS11_LOGGER_TIMESTAMP);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_SOCKET environment variable
+    pkcs11_logger_globals.env_var_socket = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_SOCKET);
+    if (NULL != pkcs11_logger_globals.env_var_socket)
+    {
+#ifdef _WIN32
+        pkcs11_logger_log("Environment variable %s is not supported on this platform", PKCS11_LOGGER_SOCKET);
+        goto err;
+#else
+        if (NULL == strrchr((const char *)pkcs11_logger_globals.env_var_socket, ':'))
+        {
+            pkcs11_logger_log("Value of %s environment variable needs to be in host:port format", PKCS11_LOGGER_SOCKET);
+            goto err;
+        }
+#endif
+    }
+
+    // Read PKCS11_LOGGER_RING_FILE_PATH environment variable
+    pkcs11_logger_globals.env_var_ring_file_path = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_RING_FILE_PATH);
+    if (NULL != pkcs11_logger_globals.env_var_ring_file_path)
+    {
+        if (('"' == pkcs11_logger_globals.env_var_ring_file_path[0]) || ('\'' == pkcs11_logger_globals.env_var_ring_file_path[0]))
+        {
+            pkcs11_logger_log("Value of %s environment variable needs to be provided without enclosing quotes", PKCS11_LOGGER_RING_FILE_PATH);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_RING_SIZE environment variable
+    pkcs11_logger_globals.env_var_ring_size = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_RING_SIZE);
+    if (NULL != pkcs11_logger_globals.env_var_ring_size)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_ring_size, &(pkcs11_logger_globals.ring_size))) || (0 == pkcs11_logger_globals.ring_size))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_RING_SIZE);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_ARENA_SIZE environment variable
+    pkcs11_logger_globals.env_var_arena_size = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_ARENA_SIZE);
+    if (NULL != pkcs11_logger_globals.env_var_arena_size)
+    {
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_arena_size, &(pkcs11_logger_globals.arena_size)))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a number", PKCS11_LOGGER_ARENA_SIZE);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_BYTE_ARRAY_HEAD environment variable
+    pkcs11_logger_globals.env_var_byte_array_head = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_BYTE_ARRAY_HEAD);
+    if (NULL != pkcs11_logger_globals.env_var_byte_array_head)
+    {
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_byte_array_head, &(pkcs11_logger_globals.byte_array_head)))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a number", PKCS11_LOGGER_BYTE_ARRAY_HEAD);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_BYTE_ARRAY_TAIL environment variable
+    pkcs11_logger_globals.env_var_byte_array_tail = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_BYTE_ARRAY_TAIL);
+    if (NULL != pkcs11_logger_globals.env_var_byte_array_tail)
+    {
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_byte_array_tail, &(pkcs11_logger_globals.byte_array_tail)))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a number", PKCS11_LOGGER_BYTE_ARRAY_TAIL);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_SAMPLE_RATES environment variable
+    pkcs11_logger_globals.env_var_sample_rates = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_SAMPLE_RATES);
+    if (NULL != pkcs11_logger_globals.env_var_sample_rates)
+    {
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_sample_parse_rates((const char *)pkcs11_logger_globals.env_var_sample_rates))
+        {
+            pkcs11_logger_log("Value of %s environment variable needs to be a comma separated list of PKCS#11 function or class names with positive sampling rates", PKCS11_LOGGER_SAMPLE_RATES);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_LIMIT_RECORDS environment variable
+    pkcs11_logger_globals.env_var_limit_records = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_LIMIT_RECORDS);
+    if (NULL != pkcs11_logger_globals.env_var_limit_records)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_limit_records, &(pkcs11_logger_globals.limit_records))) || (0 == pkcs11_logger_globals.limit_records))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_LIMIT_RECORDS);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_LIMIT_BYTES environment variable
+    pkcs11_logger_globals.env_var_limit_bytes = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_LIMIT_BYTES);
+    if (NULL != pkcs11_logger_globals.env_var_limit_bytes)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_limit_bytes, &(pkcs11_logger_globals.limit_bytes))) || (0 == pkcs11_logger_globals.limit_bytes))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_LIMIT_BYTES);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_LIMIT_CALLS environment variable
+    pkcs11_logger_globals.env_var_limit_calls = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_LIMIT_CALLS);
+    if (NULL != pkcs11_logger_globals.env_var_limit_calls)
+    {
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_limit_parse_calls((const char *)pkcs11_logger_globals.env_var_limit_calls))
+        {
+            pkcs11_logger_log("Value of %s environment variable needs to be a comma separated list of PKCS#11 function or class names with numbers of calls per second", PKCS11_LOGGER_LIMIT_CALLS);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_CACHE_TTL environment variable
+    pkcs11_logger_globals.env_var_cache_ttl = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_CACHE_TTL);
+    if (NULL != pkcs11_logger_globals.env_var_cache_ttl)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_cache_ttl, &(pkcs11_logger_globals.cache_ttl))) || (0 == pkcs11_logger_globals.cache_ttl))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_CACHE_TTL);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_POOL_SIZE environment variable
+    pkcs11_logger_globals.env_var_pool_size = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_POOL_SIZE);
+    if (NULL != pkcs11_logger_globals.env_var_pool_size)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_pool_size, &(pkcs11_logger_globals.pool_size))) || (0 == pkcs11_logger_globals.pool_size))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_POOL_SIZE);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_POOL_IDLE_TIMEOUT environment variable
+    pkcs11_logger_globals.env_var_pool_idle_timeout = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_POOL_IDLE_TIMEOUT);
+    if (NULL != pkcs11_logger_globals.env_var_pool_idle_timeout)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_pool_idle_timeout, &(pkcs11_logger_globals.pool_idle_timeout))) || (0 == pkcs11_logger_globals.pool_idle_timeout))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_POOL_IDLE_TIMEOUT);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_COALESCE_SIZE environment variable
+    pkcs11_logger_globals.env_var_coalesce_size = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_COALESCE_SIZE);
+    if (NULL != pkcs11_logger_globals.env_var_coalesce_size)
+    {
+        if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long((const char *)pkcs11_logger_globals.env_var_coalesce_size, &(pkcs11_logger_globals.coalesce_size))) || (0 == pkcs11_logger_globals.coalesce_size))
+        {
+            pkcs11_logger_log("Unable to read the value of %s environment variable as a positive number", PKCS11_LOGGER_COALESCE_SIZE);
+            goto err;
+        }
+    }
+
+    // Read PKCS11_LOGGER_COALESCE_MECHANISMS environment variable
+    pkcs11_logger_globals.env_var_coalesce_mechanisms = pkcs11_logger_init_read_env_var(PKCS11_LOGGER_COALESCE_MECHANISMS);
+    if (NULL != pkcs11_logger_globals.env_var_coalesce_mechanisms)
+    {
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_coalesce_parse_mechanisms((const char *)pkcs11_logger_globals.env_var_coalesce_mechanisms))
+        {
+            pkcs11_logger_log("Value of %s environment variable needs to be a comma separated list of at most %d mechanism names or decimal numbers", PKCS11_LOGGER_COALESCE_MECHANISMS, PKCS11_LOGGER_COALESCE_MECHANISMS_MAX);
+            goto err;
+        }
+    }
+
     rv = PKCS11_LOGGER_RV_SUCCESS;
 
 err:
@@ -192,6 +695,43 @@ err:
         CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_library_path);
         CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_log_file_path);
         CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_flags);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_queue_size);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_queue_policy);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_mmap_segment_size);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_rotate_size);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_rotate_interval);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_rotate_count);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_rotate_compression);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_durability);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_flush_records);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_flush_interval);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_control_file);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_include_functions);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_exclude_functions);
+        memset(pkcs11_logger_globals.skipped_functions, 0, sizeof(pkcs11_logger_globals.skipped_functions));
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_stats_interval);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_stats_signal);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_timestamp);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_socket);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_ring_file_path);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_ring_size);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_arena_size);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_byte_array_head);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_byte_array_tail);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_sample_rates);
+        memset(pkcs11_logger_globals.sample_rates, 0, sizeof(pkcs11_logger_globals.sample_rates));
+        memset(pkcs11_logger_globals.sample_random, 0, sizeof(pkcs11_logger_globals.sample_random));
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_limit_records);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_limit_bytes);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_limit_calls);
+        memset(pkcs11_logger_globals.limit_calls, 0, sizeof(pkcs11_logger_globals.limit_calls));
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_cache_ttl);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_pool_size);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_pool_idle_timeout);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_coalesce_size);
+        CALL_N_CLEAR(free, pkcs11_logger_globals.env_var_coalesce_mechanisms);
+        memset(pkcs11_logger_globals.coalesce_mechanisms, 0, sizeof(pkcs11_logger_globals.coalesce_mechanisms));
+        pkcs11_logger_globals.coalesce_mechanisms_count = 0;
     }
 
     return rv;
@@ -262,3 +802,30 @@ err:
 #endif
 }
 
+
+// Marks PKCS#11 function from the list as skipped or logged
+static int pkcs11_logger_init_parse_function(char *name, char *value, void *context)
+{
+    CK_BBOOL skipped = *((CK_BBOOL *)context);
+    CK_ULONG id = 0;
+
+    if (NULL != value)
+        return PKCS11_LOGGER_RV_ERROR;
+
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_translate_string_to_function_id(name, &id))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    if (CK_TRUE == skipped)
+        pkcs11_logger_globals.skipped_functions[id / 8] |= (CK_BYTE)(1 << (id % 8));
+    else
+        pkcs11_logger_globals.skipped_functions[id / 8] &= (CK_BYTE)~(1 << (id % 8));
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Marks PKCS#11 functions from comma separated list as skipped or logged
+int pkcs11_logger_init_parse_function_list(const char *list, CK_BBOOL skipped)
+{
+    return pkcs11_logger_utils_parse_list(list, pkcs11_logger_init_parse_function, &skipped);
+}
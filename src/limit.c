@@ -0,0 +1,248 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Structure that holds token bucket refilled with the configured rate per second
+typedef struct
+{
+    // Number of available tokens (negative after consumption of amount larger than the available tokens)
+    double tokens;
+    // Monotonic time of the last refill in nanoseconds (zero when the bucket has not been used yet)
+    unsigned long long refilled;
+}
+PKCS11_LOGGER_LIMIT_BUCKET;
+
+
+// Bucket limiting number of logged records per second (protected by the lock)
+static PKCS11_LOGGER_LIMIT_BUCKET pkcs11_logger_limit_records_bucket = { 0, 0 };
+// Bucket limiting number of logged bytes per second (protected by the lock)
+static PKCS11_LOGGER_LIMIT_BUCKET pkcs11_logger_limit_bytes_bucket = { 0, 0 };
+// Buckets limiting number of logged calls of each PKCS#11 function per second (protected by the lock)
+static PKCS11_LOGGER_LIMIT_BUCKET pkcs11_logger_limit_calls_buckets[PKCS11_LOGGER_FUNCTION_COUNT];
+// Number of records suppressed since the last notice (protected by the lock)
+static CK_ULONG pkcs11_logger_limit_suppressed_records = 0;
+// Number of bytes suppressed since the last notice (protected by the lock)
+static CK_ULONG pkcs11_logger_limit_suppressed_bytes = 0;
+// Number of calls of each PKCS#11 function suppressed since the last notice (protected by the lock)
+static CK_ULONG pkcs11_logger_limit_suppressed_calls[PKCS11_LOGGER_FUNCTION_COUNT];
+// Flag indicating whether there are suppressed records or calls without notice
+static CK_ULONG pkcs11_logger_limit_pending = 0;
+
+
+// Refills the bucket and takes the amount of tokens from it when they are available
+static CK_BBOOL pkcs11_logger_limit_take(PKCS11_LOGGER_LIMIT_BUCKET *bucket, CK_ULONG rate, unsigned long long now, CK_ULONG amount)
+{
+    // Note: Full bucket holds tokens for one second so bursts are limited too
+    if (0 == bucket->refilled)
+        bucket->tokens = (double)rate;
+    else if (now > bucket->refilled)
+        bucket->tokens += (double)(now - bucket->refilled) * (double)rate / 1000000000.0;
+
+    if (bucket->tokens > (double)rate)
+        bucket->tokens = (double)rate;
+
+    bucket->refilled = now;
+
+    // Note: Amount larger than the full bucket is taken only from the full bucket and its debt is repaid by the refills
+    if ((bucket->tokens < (double)amount) && (bucket->tokens < (double)rate))
+        return CK_FALSE;
+
+    bucket->tokens -= (double)amount;
+
+    return CK_TRUE;
+}
+
+
+// Determines whether the record with the specified length fits into the limits of logged records and bytes per second
+CK_BBOOL pkcs11_logger_limit_record(size_t len)
+{
+    unsigned long long now = pkcs11_logger_utils_get_monotonic_time();
+    CK_BBOOL allowed = CK_TRUE;
+
+    pkcs11_logger_lock_acquire();
+
+    // Note: Tokens are taken only when both limits allow the record
+    if ((0 != pkcs11_logger_globals.limit_records) && (0 != pkcs11_logger_globals.limit_bytes))
+    {
+        allowed = pkcs11_logger_limit_take(&pkcs11_logger_limit_records_bucket, pkcs11_logger_globals.limit_records, now, 1);
+        if (CK_TRUE == allowed)
+        {
+            allowed = pkcs11_logger_limit_take(&pkcs11_logger_limit_bytes_bucket, pkcs11_logger_globals.limit_bytes, now, (CK_ULONG)len);
+            if (CK_TRUE != allowed)
+                pkcs11_logger_limit_records_bucket.tokens += 1;
+        }
+    }
+    else if (0 != pkcs11_logger_globals.limit_records)
+    {
+        allowed = pkcs11_logger_limit_take(&pkcs11_logger_limit_records_bucket, pkcs11_logger_globals.limit_records, now, 1);
+    }
+    else if (0 != pkcs11_logger_globals.limit_bytes)
+    {
+        allowed = pkcs11_logger_limit_take(&pkcs11_logger_limit_bytes_bucket, pkcs11_logger_globals.limit_bytes, now, (CK_ULONG)len);
+    }
+
+    if (CK_TRUE != allowed)
+    {
+        pkcs11_logger_limit_suppressed_records++;
+        pkcs11_logger_limit_suppressed_bytes += (CK_ULONG)len;
+        PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_limit_pending, 1);
+    }
+
+    pkcs11_logger_lock_release();
+
+    return allowed;
+}
+
+
+// Determines whether the call of PKCS#11 function fits into the limit of its logged calls per second
+CK_BBOOL pkcs11_logger_limit_call(CK_ULONG function)
+{
+    unsigned long long now = pkcs11_logger_utils_get_monotonic_time();
+    CK_BBOOL allowed = CK_TRUE;
+
+    pkcs11_logger_lock_acquire();
+
+    allowed = pkcs11_logger_limit_take(&pkcs11_logger_limit_calls_buckets[function], pkcs11_logger_globals.limit_calls[function], now, 1);
+    if (CK_TRUE != allowed)
+    {
+        pkcs11_logger_limit_suppressed_calls[function]++;
+        PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_limit_pending, 1);
+    }
+
+    pkcs11_logger_lock_release();
+
+    return allowed;
+}
+
+
+// Sets limit of logged calls per second of PKCS#11 functions specified by function or class name
+static int pkcs11_logger_limit_set_calls(const char *name, CK_ULONG rate)
+{
+    CK_BYTE functions[PKCS11_LOGGER_FUNCTION_BITMAP_SIZE];
+    CK_ULONG id = 0;
+
+    memset(functions, 0, sizeof(functions));
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_translate_string_to_function_set(name, functions))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    for (id = 0; id < PKCS11_LOGGER_FUNCTION_COUNT; id++)
+    {
+        if (0 != (functions[id / 8] & (1 << (id % 8))))
+            pkcs11_logger_globals.limit_calls[id] = rate;
+    }
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Sets limit of the entry of the list in "<function or class>=<calls per second>" format
+static int pkcs11_logger_limit_parse_call(char *name, char *value, void *context)
+{
+    CK_ULONG rate = 0;
+
+    IGNORE_ARG(context);
+
+    // Note: Zero removes the limit so a class can be followed by exceptions for its functions
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long(value, &rate))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    return pkcs11_logger_limit_set_calls(name, rate);
+}
+
+
+// Parses comma separated list of limits in "<function or class>=<calls per second>" format
+int pkcs11_logger_limit_parse_calls(const char *list)
+{
+    return pkcs11_logger_utils_parse_list(list, pkcs11_logger_limit_parse_call, NULL);
+}
+
+
+// Creates records with numbers of records and calls suppressed since the last notice (NULL when nothing was suppressed)
+PKCS11_LOGGER_RECORD* pkcs11_logger_limit_create_notices(void)
+{
+    CK_ULONG suppressed_calls[PKCS11_LOGGER_FUNCTION_COUNT];
+    CK_ULONG suppressed_records = 0;
+    CK_ULONG suppressed_bytes = 0;
+    PKCS11_LOGGER_RECORD *records = NULL;
+    PKCS11_LOGGER_RECORD *record = NULL;
+    CK_ULONG function = 0;
+
+    if (0 == PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_limit_pending))
+        return NULL;
+
+    // Note: Counters are taken under the lock but the notices are formatted without it
+    pkcs11_logger_lock_acquire();
+
+    PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_limit_pending, 0);
+    suppressed_records = pkcs11_logger_limit_suppressed_records;
+    suppressed_bytes = pkcs11_logger_limit_suppressed_bytes;
+    memcpy(suppressed_calls, pkcs11_logger_limit_suppressed_calls, sizeof(suppressed_calls));
+    pkcs11_logger_limit_suppressed_records = 0;
+    pkcs11_logger_limit_suppressed_bytes = 0;
+    memset(pkcs11_logger_limit_suppressed_calls, 0, sizeof(pkcs11_logger_limit_suppressed_calls));
+
+    pkcs11_logger_lock_release();
+
+    // Note: Notices are created in reverse order because each one is prepended to the list
+    for (function = PKCS11_LOGGER_FUNCTION_COUNT; function > 0; function--)
+    {
+        if (0 == suppressed_calls[function - 1])
+            continue;
+
+        record = pkcs11_logger_log_create_record_va("*** %lu calls of %s were suppressed by the rate limit ***", suppressed_calls[function - 1], pkcs11_logger_translate_function_id(function - 1));
+        if (NULL == record)
+            continue;
+
+        record->next = records;
+        records = record;
+    }
+
+    if (0 != suppressed_records)
+    {
+        record = pkcs11_logger_log_create_record_va("*** %lu log records (%lu bytes) were suppressed by the rate limit ***", suppressed_records, suppressed_bytes);
+        if (NULL != record)
+        {
+            record->next = records;
+            records = record;
+        }
+    }
+
+    return records;
+}
+
+
+// Resets buckets and numbers of suppressed records and calls
+void pkcs11_logger_limit_stop(void)
+{
+    memset(&pkcs11_logger_limit_records_bucket, 0, sizeof(pkcs11_logger_limit_records_bucket));
+    memset(&pkcs11_logger_limit_bytes_bucket, 0, sizeof(pkcs11_logger_limit_bytes_bucket));
+    memset(pkcs11_logger_limit_calls_buckets, 0, sizeof(pkcs11_logger_limit_calls_buckets));
+    memset(pkcs11_logger_limit_suppressed_calls, 0, sizeof(pkcs11_logger_limit_suppressed_calls));
+    pkcs11_logger_limit_suppressed_records = 0;
+    pkcs11_logger_limit_suppressed_bytes = 0;
+    pkcs11_logger_limit_pending = 0;
+}
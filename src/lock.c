@@ -89,6 +89,27 @@ void pkcs11_logger_lock_acquire(void)
 }
 
 
+// Acquires lock for log file access synchronization only if it is not held by another thread
+int pkcs11_logger_lock_try_acquire(void)
+{
+#ifdef _WIN32
+
+    DWORD rv = 0;
+
+    if (NULL == pkcs11_logger_lock)
+        return PKCS11_LOGGER_RV_SUCCESS;
+
+    rv = WaitForSingleObject(pkcs11_logger_lock, 0);
+    return ((WAIT_OBJECT_0 == rv) || (WAIT_ABANDONED == rv)) ? PKCS11_LOGGER_RV_SUCCESS : PKCS11_LOGGER_RV_ERROR;
+
+#else
+
+    return (0 == pthread_mutex_trylock(&pkcs11_logger_lock)) ? PKCS11_LOGGER_RV_SUCCESS : PKCS11_LOGGER_RV_ERROR;
+
+#endif
+}
+
+
 // Releases lock for log file access synchronization
 void pkcs11_logger_lock_release(void)
 {
@@ -26,124 +26,818 @@
 extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
 
 
-// Logs message
-void pkcs11_logger_log(const char* message, ...)
+static void pkcs11_logger_log_end_call_record(void);
+
+
+// Structure that holds records of one thread waiting to be written by the thread that holds the lock
+typedef struct PKCS11_LOGGER_LOG_BATCH
 {
-    va_list ap;
+    // Next batch in the list
+    struct PKCS11_LOGGER_LOG_BATCH *next;
+    // Records written to other outputs
+    PKCS11_LOGGER_RECORD *records;
+    // First of the records that is also written to the log file (NULL when none of them is)
+    PKCS11_LOGGER_RECORD *file_records;
+    // Flag indicating whether the records have been written (set by the thread that wrote them)
+    CK_ULONG written;
+}
+PKCS11_LOGGER_LOG_BATCH;
 
-    unsigned long disable_log_file = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE) == PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE);
-    unsigned long disable_process_id = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_DISABLE_PROCESS_ID) == PKCS11_LOGGER_FLAG_DISABLE_PROCESS_ID);
-    unsigned long disable_thread_id = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_DISABLE_THREAD_ID) == PKCS11_LOGGER_FLAG_DISABLE_THREAD_ID);
-    unsigned long enable_stdout = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_STDOUT) == PKCS11_LOGGER_FLAG_ENABLE_STDOUT);
-    unsigned long enable_stderr = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_STDERR) == PKCS11_LOGGER_FLAG_ENABLE_STDERR);
-    unsigned long enable_fclose = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_FCLOSE) == PKCS11_LOGGER_FLAG_ENABLE_FCLOSE);
 
-    // Acquire exclusive access to the file
-    pkcs11_logger_lock_acquire();
+// Buffer used by each thread for formatting of log records that also serves as a record written directly to all outputs
+static PKCS11_LOGGER_THREAD_LOCAL union
+{
+    PKCS11_LOGGER_RECORD record;
+    char bytes[sizeof(PKCS11_LOGGER_RECORD) + PKCS11_LOGGER_LOG_BUFFER_SIZE];
+}
+pkcs11_logger_log_buffer;
+
+// Record collecting all messages logged by the current function call of each thread
+static PKCS11_LOGGER_THREAD_LOCAL PKCS11_LOGGER_RECORD *pkcs11_logger_log_call_record = NULL;
+// Number of bytes available for data of the call record
+static PKCS11_LOGGER_THREAD_LOCAL size_t pkcs11_logger_log_call_record_capacity = 0;
+
+// Number of records written into the log file since it was last flushed (protected by the lock)
+static CK_ULONG pkcs11_logger_log_unflushed = 0;
+// Monotonic time in nanoseconds when the log file was last flushed (protected by the lock)
+static unsigned long long pkcs11_logger_log_last_flush = 0;
+// Batches waiting to be written by the thread that holds the lock (lock-free stack with the newest batch on top)
+static PKCS11_LOGGER_LOG_BATCH *pkcs11_logger_log_pending = NULL;
+
+
+// Opens log file if needed (lock must be held by the caller)
+static void pkcs11_logger_log_open_file(void)
+{
+    unsigned long disable_log_file = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE) == PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE);
+    unsigned long enable_binary = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_BINARY) == PKCS11_LOGGER_FLAG_ENABLE_BINARY);
 
 #ifdef _WIN32
 #pragma warning(push)
 #pragma warning(disable: 4996)
 #endif
 
-    // Open log file
     if ((!disable_log_file) && (NULL != pkcs11_logger_globals.env_var_log_file_path) && (NULL == pkcs11_logger_globals.log_file_handle))
     {
-        pkcs11_logger_globals.log_file_handle = fopen((const char *)pkcs11_logger_globals.env_var_log_file_path, "a");
+        pkcs11_logger_globals.log_file_handle = fopen((const char *)pkcs11_logger_globals.env_var_log_file_path, (enable_binary) ? "ab" : "a");
+
+        if ((enable_binary) && (NULL != pkcs11_logger_globals.log_file_handle))
+            pkcs11_logger_binary_open_file(pkcs11_logger_globals.log_file_handle);
     }
 
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
+}
+
+
+// Writes buffered contents of the log file to the disk (lock must be held by the caller)
+static void pkcs11_logger_log_sync_file(void)
+{
+    if (NULL == pkcs11_logger_globals.log_file_handle)
+        return;
+
+    fflush(pkcs11_logger_globals.log_file_handle);
+
+#ifdef _WIN32
+    _commit(_fileno(pkcs11_logger_globals.log_file_handle));
+#elif defined(__APPLE__)
+    fsync(fileno(pkcs11_logger_globals.log_file_handle));
+#else
+    fdatasync(fileno(pkcs11_logger_globals.log_file_handle));
+#endif
+}
+
+
+// Flushes or closes log file according to durability mode (lock must be held by the caller)
+static void pkcs11_logger_log_close_file(CK_ULONG written)
+{
+    unsigned long enable_fclose = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_FCLOSE) == PKCS11_LOGGER_FLAG_ENABLE_FCLOSE);
+    unsigned long long now = 0;
+
+    // Note: Log file that needs to be rotated gets closed here and reopened by the next write
+    pkcs11_logger_rotate_check();
+
+    if (NULL == pkcs11_logger_globals.log_file_handle)
+        return;
 
-    // Log to file
-    if ((!disable_log_file) && (NULL != pkcs11_logger_globals.log_file_handle))
+    if (enable_fclose)
     {
-        va_start(ap, message);
+        // Note: Closed file cannot be synchronized when the function returns
+        if (PKCS11_LOGGER_DURABILITY_SYNC == pkcs11_logger_globals.durability)
+            pkcs11_logger_log_sync_file();
 
-        if (!disable_process_id)
-            fprintf(pkcs11_logger_globals.log_file_handle, "%0#10x : ", pkcs11_logger_utils_get_process_id());
-        if (!disable_thread_id)
-            fprintf(pkcs11_logger_globals.log_file_handle, "%0#18lx : ", pkcs11_logger_utils_get_thread_id());
-        vfprintf(pkcs11_logger_globals.log_file_handle, message, ap);
-        fprintf(pkcs11_logger_globals.log_file_handle, "\n");
+        CALL_N_CLEAR(fclose, pkcs11_logger_globals.log_file_handle);
+    }
+    else if (PKCS11_LOGGER_DURABILITY_LINE == pkcs11_logger_globals.durability)
+    {
+        fflush(pkcs11_logger_globals.log_file_handle);
+    }
+    else if (PKCS11_LOGGER_DURABILITY_BATCH == pkcs11_logger_globals.durability)
+    {
+        pkcs11_logger_log_unflushed += written;
+        now = pkcs11_logger_utils_get_monotonic_time();
 
-        va_end(ap);
+        if ((pkcs11_logger_log_unflushed >= pkcs11_logger_globals.flush_records) || (now - pkcs11_logger_log_last_flush >= (unsigned long long)pkcs11_logger_globals.flush_interval * 1000000))
+        {
+            fflush(pkcs11_logger_globals.log_file_handle);
+            pkcs11_logger_log_unflushed = 0;
+            pkcs11_logger_log_last_flush = now;
+        }
     }
+}
+
 
-    // Log to stdout
-    if (enable_stdout)
+// Formats message with prepended process and thread ID and optional timestamp into the buffer and returns its length
+static int pkcs11_logger_log_format(char *buffer, size_t buffer_size, const char *time_string, const char* message, va_list ap)
+{
+    const char *prefix = NULL;
+    int prefix_len = 0;
+    int time_len = 0;
+    int message_len = 0;
+
+    // Note: Buffer is always large enough for the prefix cached by the current thread and the timestamp
+    prefix = pkcs11_logger_utils_get_ids_prefix(&prefix_len);
+    memcpy(buffer, prefix, prefix_len);
+
+    if (NULL != time_string)
     {
-        va_start(ap, message);
+        time_len = (int)strlen(time_string);
+        memcpy(buffer + prefix_len, time_string, time_len);
+        memcpy(buffer + prefix_len + time_len, " - ", 3);
+        prefix_len += time_len + 3;
+    }
+
+    message_len = vsnprintf(buffer + prefix_len, buffer_size - prefix_len, message, ap);
+    if (message_len < 0)
+        return -1;
+
+    return prefix_len + message_len;
+}
+
+
+// Makes sure the call record has space for at least the specified number of bytes
+static int pkcs11_logger_log_reserve_call_record(size_t len)
+{
+    PKCS11_LOGGER_RECORD *record = NULL;
+    size_t capacity = 0;
+
+    if (pkcs11_logger_log_call_record_capacity - pkcs11_logger_log_call_record->data_len >= len)
+        return PKCS11_LOGGER_RV_SUCCESS;
+
+    capacity = pkcs11_logger_log_call_record_capacity * 2;
+    if (capacity < pkcs11_logger_log_call_record->data_len + len)
+        capacity = pkcs11_logger_log_call_record->data_len + len;
 
-        if (!disable_process_id)
-            fprintf(stdout, "%0#10x : ", pkcs11_logger_utils_get_process_id());
-        if (!disable_thread_id)
-            fprintf(stdout, "%0#18lx : ", pkcs11_logger_utils_get_thread_id());
-        vfprintf(stdout, message, ap);
-        fprintf(stdout, "\n");
+    record = (PKCS11_LOGGER_RECORD*) realloc(pkcs11_logger_log_call_record, sizeof(PKCS11_LOGGER_RECORD) + capacity);
+    if (NULL == record)
+        return PKCS11_LOGGER_RV_ERROR;
+
+    pkcs11_logger_log_call_record = record;
+    pkcs11_logger_log_call_record_capacity = capacity;
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Appends message with prepended process and thread ID and optional timestamp to the call record
+static int pkcs11_logger_log_append_to_call_record(const char *time_string, const char* message, va_list ap)
+{
+    size_t free_space = 0;
+    int len = 0;
+    va_list ap_copy;
+
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_log_reserve_call_record(PKCS11_LOGGER_LOG_BUFFER_SIZE))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    free_space = pkcs11_logger_log_call_record_capacity - pkcs11_logger_log_call_record->data_len;
+
+    va_copy(ap_copy, ap);
+    len = pkcs11_logger_log_format(pkcs11_logger_log_call_record->data + pkcs11_logger_log_call_record->data_len, free_space, time_string, message, ap_copy);
+    va_end(ap_copy);
+
+    if (len < 0)
+        return PKCS11_LOGGER_RV_ERROR;
+
+    if ((size_t)len + 1 > free_space)
+    {
+        // Note: Message did not fit into the record so it is formatted again after the record is enlarged
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_log_reserve_call_record(len + 1))
+            return PKCS11_LOGGER_RV_ERROR;
 
-        va_end(ap);
+        pkcs11_logger_log_format(pkcs11_logger_log_call_record->data + pkcs11_logger_log_call_record->data_len, len + 1, time_string, message, ap);
     }
 
-    // Log to stderr
-    if (enable_stderr || CK_FALSE == pkcs11_logger_globals.env_vars_read)
+    pkcs11_logger_log_call_record->data[pkcs11_logger_log_call_record->data_len + len] = '\n';
+    pkcs11_logger_log_call_record->data_len += len + 1;
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Starts collecting of messages logged by the current function call into one record
+static void pkcs11_logger_log_begin_call_record(void)
+{
+    unsigned long enable_call_records = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_CALL_RECORDS) == PKCS11_LOGGER_FLAG_ENABLE_CALL_RECORDS);
+
+    if (!enable_call_records)
+        return;
+
+    // Note: Record left behind by the previous function call should never exist but it must not be lost
+    pkcs11_logger_log_end_call_record();
+
+    pkcs11_logger_log_call_record = (PKCS11_LOGGER_RECORD*) malloc(sizeof(PKCS11_LOGGER_RECORD) + PKCS11_LOGGER_LOG_BUFFER_SIZE);
+    if (NULL == pkcs11_logger_log_call_record)
+        return;
+
+    pkcs11_logger_log_call_record->next = NULL;
+    pkcs11_logger_log_call_record->data_len = 0;
+    pkcs11_logger_log_call_record_capacity = PKCS11_LOGGER_LOG_BUFFER_SIZE;
+}
+
+
+// Writes notices about records and calls suppressed by the rate limits
+static void pkcs11_logger_log_write_notices(void)
+{
+    PKCS11_LOGGER_RECORD *records = pkcs11_logger_limit_create_notices();
+    PKCS11_LOGGER_RECORD *record = NULL;
+
+    while (NULL != records)
     {
-        va_start(ap, message);
+        record = records;
+        records = record->next;
+        record->next = NULL;
 
-        if (!disable_process_id)
-            fprintf(stderr, "%0#10x : ", pkcs11_logger_utils_get_process_id());
-        if (!disable_thread_id)
-            fprintf(stderr, "%0#18lx : ", pkcs11_logger_utils_get_thread_id());
-        vfprintf(stderr, message, ap);
-        fprintf(stderr, "\n");
+        if ((CK_TRUE == pkcs11_logger_queue_is_running()) && (PKCS11_LOGGER_RV_SUCCESS == pkcs11_logger_queue_push(record)))
+            continue;
 
-        va_end(ap);
+        pkcs11_logger_log_write_records(record);
+        CALL_N_CLEAR(free, record);
     }
+}
 
-    // Cleanup
-    if (enable_fclose)
+
+// Determines whether the record is suppressed by the limits of logged records and bytes per second
+static CK_BBOOL pkcs11_logger_log_is_suppressed(PKCS11_LOGGER_RECORD **record)
+{
+    PKCS11_LOGGER_RECORD *copy = NULL;
+
+    if ((0 == pkcs11_logger_globals.limit_records) && (0 == pkcs11_logger_globals.limit_bytes))
+        return CK_FALSE;
+
+    if (CK_TRUE != pkcs11_logger_limit_record((*record)->data_len))
+        return CK_TRUE;
+
+    // Note: Notices are formatted into the buffer owned by the calling thread so the record held by it is moved into the arena first
+    if (&(pkcs11_logger_log_buffer.record) == *record)
     {
-        CALL_N_CLEAR(fclose, pkcs11_logger_globals.log_file_handle);
+        copy = (PKCS11_LOGGER_RECORD*) pkcs11_logger_arena_alloc(sizeof(PKCS11_LOGGER_RECORD) + (*record)->data_len);
+        if (NULL == copy)
+            return CK_FALSE;
+
+        copy->next = NULL;
+        copy->data_len = (*record)->data_len;
+        memcpy(copy->data, (*record)->data, (*record)->data_len);
+        *record = copy;
     }
-    else
+
+    // Note: Notice about the suppressed records is written just before the first record that fits into the limits
+    pkcs11_logger_log_write_notices();
+
+    return CK_FALSE;
+}
+
+
+// Appends the record to the call record or writes it (the record is always consumed)
+static void pkcs11_logger_log_emit_record(PKCS11_LOGGER_RECORD *record)
+{
+    if (NULL != pkcs11_logger_log_call_record)
     {
-        if (NULL != pkcs11_logger_globals.log_file_handle)
-            fflush(pkcs11_logger_globals.log_file_handle);
+        if (PKCS11_LOGGER_RV_SUCCESS == pkcs11_logger_log_reserve_call_record(record->data_len))
+        {
+            memcpy(pkcs11_logger_log_call_record->data + pkcs11_logger_log_call_record->data_len, record->data, record->data_len);
+            pkcs11_logger_log_call_record->data_len += record->data_len;
+            CALL_N_CLEAR(free, record);
+            return;
+        }
+
+        // Note: Messages collected so far are written first to keep the order of messages
+        pkcs11_logger_log_end_call_record();
     }
-    
-    // Release exclusive access to the file
-    pkcs11_logger_lock_release();
+
+    // Note: Records of function calls are suppressed whole because they are collected before they leave the calling thread
+    if (CK_TRUE == pkcs11_logger_log_is_suppressed(&record))
+    {
+        CALL_N_CLEAR(free, record);
+        return;
+    }
+
+    if (CK_TRUE == pkcs11_logger_queue_is_running())
+    {
+        if (PKCS11_LOGGER_RV_SUCCESS == pkcs11_logger_queue_push(record))
+            return;
+    }
+
+    pkcs11_logger_log_write_records(record);
+    CALL_N_CLEAR(free, record);
 }
 
 
-// Logs message with prepended timestamp
-void pkcs11_logger_log_with_timestamp(const char* message, ...)
+// Writes all messages collected for the current function call at once
+static void pkcs11_logger_log_end_call_record(void)
 {
-    char* message_string = NULL;
-    int message_string_len = 0;
+    PKCS11_LOGGER_RECORD *record = pkcs11_logger_log_call_record;
+
+    if (NULL == record)
+        return;
+
+    pkcs11_logger_log_call_record = NULL;
+    pkcs11_logger_log_call_record_capacity = 0;
+
+    if (0 == record->data_len)
+    {
+        CALL_N_CLEAR(free, record);
+        return;
+    }
+
+    pkcs11_logger_log_emit_record(record);
+}
+
 
+// Formats message with prepended process and thread ID into the buffer and returns its length
+static int pkcs11_logger_log_format_va(char *buffer, size_t buffer_size, const char* message, ...)
+{
+    int len = 0;
     va_list ap;
+
     va_start(ap, message);
-    message_string_len = vsnprintf(NULL, 0, message, ap);
+    len = pkcs11_logger_log_format(buffer, buffer_size, NULL, message, ap);
     va_end(ap);
-    
-    message_string = (char*) malloc(message_string_len + 1);
-    if (NULL == message_string)
+
+    return len;
+}
+
+
+// Logs byte array encoded as hex directly into the call record or into a new record
+static int pkcs11_logger_log_hex(const char *name, CK_BYTE_PTR byte_array, CK_ULONG byte_array_len)
+{
+    PKCS11_LOGGER_RECORD *record = NULL;
+    char *data = NULL;
+    size_t data_len = 0;
+    int prefix_len = 0;
+    CK_BBOOL temporary = CK_FALSE;
+
+    // Note: Prefix is formatted into the buffer owned by the calling thread
+    prefix_len = pkcs11_logger_log_format_va(pkcs11_logger_log_buffer.record.data, PKCS11_LOGGER_LOG_BUFFER_SIZE, "%s: HEX(", name);
+    if ((prefix_len < 0) || (prefix_len >= PKCS11_LOGGER_LOG_BUFFER_SIZE))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    // Note: Message holds the prefix, two characters per byte, closing parenthesis and new line
+    data_len = prefix_len + (size_t)byte_array_len * 2 + 2;
+
+    if ((NULL != pkcs11_logger_log_call_record) && (PKCS11_LOGGER_RV_SUCCESS == pkcs11_logger_log_reserve_call_record(data_len)))
+    {
+        data = pkcs11_logger_log_call_record->data + pkcs11_logger_log_call_record->data_len;
+    }
+    else
+    {
+        // Note: Record written by the calling thread is allocated from its arena while queued record is freed by the writer thread
+        if ((NULL == pkcs11_logger_log_call_record) && (CK_TRUE != pkcs11_logger_queue_is_running()))
+        {
+            temporary = CK_TRUE;
+            record = (PKCS11_LOGGER_RECORD*) pkcs11_logger_arena_alloc(sizeof(PKCS11_LOGGER_RECORD) + data_len);
+        }
+        else
+        {
+            record = (PKCS11_LOGGER_RECORD*) malloc(sizeof(PKCS11_LOGGER_RECORD) + data_len);
+        }
+
+        if (NULL == record)
+            return PKCS11_LOGGER_RV_ERROR;
+
+        record->next = NULL;
+        record->data_len = data_len;
+        data = record->data;
+    }
+
+    memcpy(data, pkcs11_logger_log_buffer.record.data, prefix_len);
+    pkcs11_logger_hex_encode(byte_array, byte_array_len, data + prefix_len);
+    data[data_len - 2] = ')';
+    data[data_len - 1] = '\n';
+
+    if (CK_TRUE == temporary)
+    {
+        if (CK_TRUE != pkcs11_logger_log_is_suppressed(&record))
+            pkcs11_logger_log_write_records(record);
+    }
+    else if (NULL != record)
+        pkcs11_logger_log_emit_record(record);
+    else
+        pkcs11_logger_log_call_record->data_len += data_len;
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Logs message with optional timestamp
+static void pkcs11_logger_log_message(CK_BBOOL timestamp, const char* message, va_list ap)
+{
+    PKCS11_LOGGER_RECORD *record = NULL;
+    char time_buffer[PKCS11_LOGGER_TIME_STR_SIZE];
+    const char *time_string = NULL;
+    int len = 0;
+    va_list ap_copy;
+
+    unsigned long enable_binary = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_BINARY) == PKCS11_LOGGER_FLAG_ENABLE_BINARY);
+
+    // Store the message with raw arguments and optional monotonic timestamp in binary format
+    if (enable_binary)
+    {
+        va_copy(ap_copy, ap);
+        record = pkcs11_logger_binary_create_record(timestamp, message, ap_copy);
+        va_end(ap_copy);
+
+        if (NULL != record)
+            pkcs11_logger_log_emit_record(record);
+
         return;
+    }
+
+    // Note: Timestamp is rendered into the stack buffer and copied into the message by the same formatting pass
+    if (CK_TRUE == timestamp)
+    {
+        pkcs11_logger_utils_get_current_time_str(time_buffer, sizeof(time_buffer));
+        time_string = time_buffer;
+    }
+
+    // Append the message to the record of the current function call
+    if (NULL != pkcs11_logger_log_call_record)
+    {
+        int rv = PKCS11_LOGGER_RV_ERROR;
+
+        va_copy(ap_copy, ap);
+        rv = pkcs11_logger_log_append_to_call_record(time_string, message, ap_copy);
+        va_end(ap_copy);
+
+        if (PKCS11_LOGGER_RV_SUCCESS == rv)
+            return;
+
+        // Note: Messages collected so far are written first to keep the order of messages
+        pkcs11_logger_log_end_call_record();
+    }
+
+    // Hand the message over to the background writer thread
+    if (CK_TRUE == pkcs11_logger_queue_is_running())
+    {
+        va_copy(ap_copy, ap);
+        record = pkcs11_logger_log_create_record(time_string, message, ap_copy);
+        va_end(ap_copy);
+
+        if (NULL != record)
+        {
+            if (CK_TRUE == pkcs11_logger_log_is_suppressed(&record))
+            {
+                CALL_N_CLEAR(free, record);
+                return;
+            }
+
+            if (PKCS11_LOGGER_RV_SUCCESS == pkcs11_logger_queue_push(record))
+                return;
+
+            // Note: Writer thread is being stopped so the record needs to be written synchronously
+            pkcs11_logger_log_write_records(record);
+            CALL_N_CLEAR(free, record);
+            return;
+        }
+    }
+
+    // Note: Message is formatted only once into the record owned by the calling thread and the same bytes are written to all outputs
+    record = &(pkcs11_logger_log_buffer.record);
 
-    memset(message_string, 0, message_string_len + 1);
+    va_copy(ap_copy, ap);
+    len = pkcs11_logger_log_format(record->data, PKCS11_LOGGER_LOG_BUFFER_SIZE, time_string, message, ap_copy);
+    va_end(ap_copy);
+
+    if ((len >= 0) && (len < PKCS11_LOGGER_LOG_BUFFER_SIZE))
+    {
+        record->next = NULL;
+        record->data_len = len + 1;
+        record->data[len] = '\n';
+    }
+    else
+    {
+        if (len < 0)
+            return;
+
+        // Note: Message did not fit into the buffer so it is formatted again into the record allocated from the arena
+        record = (PKCS11_LOGGER_RECORD*) pkcs11_logger_arena_alloc(sizeof(PKCS11_LOGGER_RECORD) + len + 1);
+        if (NULL == record)
+            return;
+
+        record->next = NULL;
+        record->data_len = len + 1;
+        pkcs11_logger_log_format(record->data, len + 1, time_string, message, ap);
+        record->data[len] = '\n';
+    }
+
+    if (CK_TRUE == pkcs11_logger_log_is_suppressed(&record))
+        return;
+
+    pkcs11_logger_log_write_records(record);
+}
+
+
+// Logs message
+void pkcs11_logger_log(const char* message, ...)
+{
+    va_list ap;
+
+    va_start(ap, message);
+    pkcs11_logger_log_message(CK_FALSE, message, ap);
+    va_end(ap);
+}
+
+
+// Formats message with prepended process and thread ID and optional timestamp into the record
+PKCS11_LOGGER_RECORD* pkcs11_logger_log_create_record(const char *time_string, const char* message, va_list ap)
+{
+    PKCS11_LOGGER_RECORD *record = NULL;
+    int len = 0;
+    va_list ap_copy;
+
+    // Note: Message is formatted into the buffer owned by the calling thread so no lock is needed
+    va_copy(ap_copy, ap);
+    len = pkcs11_logger_log_format(pkcs11_logger_log_buffer.record.data, PKCS11_LOGGER_LOG_BUFFER_SIZE, time_string, message, ap_copy);
+    va_end(ap_copy);
+
+    if (len < 0)
+        return NULL;
+
+    record = (PKCS11_LOGGER_RECORD*) malloc(sizeof(PKCS11_LOGGER_RECORD) + len + 1);
+    if (NULL == record)
+        return NULL;
+
+    record->next = NULL;
+    record->data_len = len + 1;
+
+    if (len < PKCS11_LOGGER_LOG_BUFFER_SIZE)
+    {
+        memcpy(record->data, pkcs11_logger_log_buffer.record.data, len);
+    }
+    else
+    {
+        // Note: Message did not fit into the buffer so it is formatted again directly into the record
+        pkcs11_logger_log_format(record->data, len + 1, time_string, message, ap);
+    }
+
+    record->data[len] = '\n';
+
+    return record;
+}
+
+
+// Formats message with prepended process and thread ID into the record
+PKCS11_LOGGER_RECORD* pkcs11_logger_log_create_record_va(const char* message, ...)
+{
+    PKCS11_LOGGER_RECORD *record = NULL;
+    va_list ap;
+
+    unsigned long enable_binary = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_BINARY) == PKCS11_LOGGER_FLAG_ENABLE_BINARY);
 
     va_start(ap, message);
-    vsnprintf(message_string, message_string_len + 1, message, ap);
+    if (enable_binary)
+        record = pkcs11_logger_binary_create_record(CK_FALSE, message, ap);
+    else
+        record = pkcs11_logger_log_create_record(NULL, message, ap);
     va_end(ap);
 
-    char time_string[27];
-    pkcs11_logger_utils_get_current_time_str(time_string, sizeof(time_string));
+    return record;
+}
+
+
+// Writes records of one batch to the log file and other outputs and returns the number of records written into the log file (lock must be held by the caller)
+static CK_ULONG pkcs11_logger_log_write_batch(PKCS11_LOGGER_LOG_BATCH *batch)
+{
+    PKCS11_LOGGER_RECORD *record = NULL;
+    PKCS11_LOGGER_RECORD *records = batch->records;
+    CK_BBOOL write_file = (batch->records == batch->file_records) ? CK_TRUE : CK_FALSE;
+    CK_ULONG written = 0;
+
+    unsigned long disable_log_file = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE) == PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE);
+    unsigned long enable_binary = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_BINARY) == PKCS11_LOGGER_FLAG_ENABLE_BINARY);
+
+    // Open log file
+    if (NULL != batch->file_records)
+        pkcs11_logger_log_open_file();
+
+    // Note: Binary format is written only to the log file
+    if (enable_binary)
+    {
+        if (!disable_log_file)
+            pkcs11_logger_binary_write_records(pkcs11_logger_globals.log_file_handle, records);
+
+        for (record = records; NULL != record; record = record->next)
+            written++;
+
+        records = NULL;
+    }
+
+    for (record = records; NULL != record; record = record->next)
+    {
+        if (record == batch->file_records)
+            write_file = CK_TRUE;
+
+        // Log to file
+        if ((CK_TRUE == write_file) && (!disable_log_file) && (NULL != pkcs11_logger_globals.log_file_handle))
+        {
+            fwrite(record->data, 1, record->data_len, pkcs11_logger_globals.log_file_handle);
+            written++;
+        }
+
+        // Log to other outputs
+        pkcs11_logger_sink_write(record->data, record->data_len);
+    }
+
+    return written;
+}
+
+
+// Writes all pending batches in the order they were added (lock must be held by the caller)
+static void pkcs11_logger_log_write_pending(void)
+{
+    PKCS11_LOGGER_LOG_BATCH *stack = NULL;
+    PKCS11_LOGGER_LOG_BATCH *batches = NULL;
+    PKCS11_LOGGER_LOG_BATCH *batch = NULL;
+    CK_ULONG written = 0;
+
+    stack = (PKCS11_LOGGER_LOG_BATCH*) PKCS11_LOGGER_ATOMIC_XCHG_PTR(&pkcs11_logger_log_pending, NULL);
+
+    // Note: Stack holds the newest batch on top so it needs to be reversed
+    while (NULL != stack)
+    {
+        batch = stack;
+        stack = stack->next;
+        batch->next = batches;
+        batches = batch;
+    }
+
+    if (NULL == batches)
+        return;
+
+    for (batch = batches; NULL != batch; batch = batch->next)
+        written += pkcs11_logger_log_write_batch(batch);
+
+    // Cleanup
+    pkcs11_logger_log_close_file(written);
+
+    // Note: Batch is owned by the waiting thread and may disappear as soon as it is marked as written
+    while (NULL != batches)
+    {
+        batch = batches;
+        batches = batches->next;
+        PKCS11_LOGGER_ATOMIC_XCHG(&batch->written, 1);
+    }
+}
+
+
+// Writes formatted records to all enabled outputs
+void pkcs11_logger_log_write_records(PKCS11_LOGGER_RECORD *records)
+{
+    PKCS11_LOGGER_LOG_BATCH batch;
+    PKCS11_LOGGER_LOG_BATCH *head = NULL;
+    PKCS11_LOGGER_LOG_BATCH *prev_head = NULL;
+    CK_ULONG spin = 0;
+
+    unsigned long disable_log_file = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE) == PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE);
+    unsigned long enable_binary = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_BINARY) == PKCS11_LOGGER_FLAG_ENABLE_BINARY);
+    unsigned long enable_mmap = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_MMAP) == PKCS11_LOGGER_FLAG_ENABLE_MMAP);
+
+    batch.next = NULL;
+    batch.records = records;
+    batch.file_records = records;
+    batch.written = 0;
+
+    // Log to memory mapped file without taking the lock
+    if ((enable_mmap) && (!enable_binary) && (!disable_log_file) && (NULL != pkcs11_logger_globals.env_var_log_file_path))
+    {
+        // Note: Records that cannot be written into memory mapped file are written into regular log file
+        for (batch.file_records = records; NULL != batch.file_records; batch.file_records = batch.file_records->next)
+        {
+            if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_mmap_write(batch.file_records->data, batch.file_records->data_len))
+                break;
+        }
+
+        if ((NULL == batch.file_records) && (CK_TRUE != pkcs11_logger_sink_has_output()))
+            return;
+    }
+
+    // Publish the batch without taking any lock
+    head = (PKCS11_LOGGER_LOG_BATCH*) PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_log_pending, NULL, NULL);
+    do
+    {
+        batch.next = head;
+        prev_head = head;
+        head = (PKCS11_LOGGER_LOG_BATCH*) PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_log_pending, prev_head, &batch);
+    }
+    while (head != prev_head);
+
+    // Note: Thread that acquires the lock writes batches of all waiting threads so the others usually do not need to wait for the lock
+    for (spin = 0; spin < PKCS11_LOGGER_LOG_SPIN_COUNT; spin++)
+    {
+        if (0 != PKCS11_LOGGER_ATOMIC_LOAD(&batch.written))
+            return;
+
+        if (PKCS11_LOGGER_RV_SUCCESS == pkcs11_logger_lock_try_acquire())
+        {
+            pkcs11_logger_log_write_pending();
+            pkcs11_logger_lock_release();
+            return;
+        }
+    }
+
+    // Note: Lock is held for longer time (e.g. by synchronization of the log file with the disk) so the thread blocks instead of spinning
+    pkcs11_logger_lock_acquire();
+    if (0 == PKCS11_LOGGER_ATOMIC_LOAD(&batch.written))
+        pkcs11_logger_log_write_pending();
+    pkcs11_logger_lock_release();
+}
+
+
+// Writes all pending messages into the log file and optionally synchronizes it with the disk
+void pkcs11_logger_log_flush(CK_BBOOL sync)
+{
+    unsigned long enable_binary = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_BINARY) == PKCS11_LOGGER_FLAG_ENABLE_BINARY);
+    unsigned long enable_mmap = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_MMAP) == PKCS11_LOGGER_FLAG_ENABLE_MMAP);
+
+    // Note: Notices about suppressed records and calls are not postponed until the next logged record
+    pkcs11_logger_log_write_notices();
+
+    // Note: Records queued for the background writer thread need to reach the log file first
+    pkcs11_logger_queue_flush();
+
+    if ((CK_TRUE == sync) && (enable_mmap) && (!enable_binary))
+        pkcs11_logger_mmap_sync();
+
+    // Acquire exclusive access to the file
+    pkcs11_logger_lock_acquire();
+
+    if (CK_TRUE == sync)
+        pkcs11_logger_log_sync_file();
+    else if (NULL != pkcs11_logger_globals.log_file_handle)
+        fflush(pkcs11_logger_globals.log_file_handle);
+
+    pkcs11_logger_sink_flush();
+
+    pkcs11_logger_log_unflushed = 0;
+    pkcs11_logger_log_last_flush = pkcs11_logger_utils_get_monotonic_time();
 
-    pkcs11_logger_log("%s - %s", time_string, message_string);
+    // Release exclusive access to the file
+    pkcs11_logger_lock_release();
+}
+
+
+// Determines whether logged messages can reach any output
+CK_BBOOL pkcs11_logger_log_has_output(void)
+{
+    unsigned long disable_log_file = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE) == PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE);
+
+    if ((!disable_log_file) && (NULL != pkcs11_logger_globals.env_var_log_file_path))
+        return CK_TRUE;
+
+    return pkcs11_logger_sink_has_output();
+}
+
+
+// Determines whether PKCS#11 function calls should be logged
+CK_BBOOL pkcs11_logger_log_is_enabled(void)
+{
+    CK_ULONG now = 0;
+
+    if (CK_TRUE != pkcs11_logger_log_has_output())
+        return CK_FALSE;
+
+    if (NULL == pkcs11_logger_globals.env_var_control_file)
+        return CK_TRUE;
+
+    // Note: Existence of the control file is checked at most once per second
+    now = (CK_ULONG) time(NULL);
+    if (now != PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_globals.control_file_checked))
+    {
+        PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_globals.control_file_checked, now);
+        PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_globals.control_file_exists, pkcs11_logger_utils_file_exists((const char *)pkcs11_logger_globals.env_var_control_file));
+    }
 
-    CALL_N_CLEAR(free, message_string);
+    return (CK_TRUE == PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_globals.control_file_exists)) ? CK_TRUE : CK_FALSE;
+}
+
+
+// Logs message with prepended timestamp
+void pkcs11_logger_log_with_timestamp(const char* message, ...)
+{
+    va_list ap;
+
+    va_start(ap, message);
+    pkcs11_logger_log_message(CK_TRUE, message, ap);
+    va_end(ap);
 }
 
 
@@ -157,6 +851,7 @@ void pkcs11_logger_log_separator(void)
 // Logs entry into logger function
 void pkcs11_logger_log_function_enter(const char *function)
 {
+    pkcs11_logger_log_begin_call_record();
     pkcs11_logger_log_separator();
     pkcs11_logger_log_with_timestamp("Entered %s", function);
 }
@@ -166,6 +861,15 @@ void pkcs11_logger_log_function_enter(const char *function)
 void pkcs11_logger_log_function_exit(CK_RV rv)
 {
     pkcs11_logger_log_with_timestamp("Returning %lu (%s)", rv, pkcs11_logger_translate_ck_rv(rv));
+    pkcs11_logger_log_end_call_record();
+
+    // Note: Temporary strings of the function call are no longer needed
+    pkcs11_logger_arena_reset();
+
+    if (PKCS11_LOGGER_DURABILITY_EXIT == pkcs11_logger_globals.durability)
+        pkcs11_logger_log_flush(CK_FALSE);
+    else if (PKCS11_LOGGER_DURABILITY_SYNC == pkcs11_logger_globals.durability)
+        pkcs11_logger_log_flush(CK_TRUE);
 }
 
 
@@ -213,13 +917,12 @@ void pkcs11_logger_log_nonzero_string(const char *name, const CK_UTF8CHAR_PTR no
     if (NULL != nonzero_string)
     {
         unsigned char *zero_string = NULL;
-        zero_string = (unsigned char*) malloc(nonzero_string_len + 1);
+        zero_string = (unsigned char*) pkcs11_logger_arena_alloc(nonzero_string_len + 1);
         if (NULL != zero_string)
         {
-            memset(zero_string, 0, nonzero_string_len + 1);
             memcpy(zero_string, nonzero_string, nonzero_string_len);
+            zero_string[nonzero_string_len] = 0;
             pkcs11_logger_log("%s: %s", name, zero_string);
-            CALL_N_CLEAR(free, zero_string);
         }
         else
         {
@@ -229,23 +932,82 @@ void pkcs11_logger_log_nonzero_string(const char *name, const CK_UTF8CHAR_PTR no
 }
 
 
-// Logs byte array
-void pkcs11_logger_log_byte_array(const char *name, CK_BYTE_PTR byte_array, CK_ULONG byte_array_len)
+// Logs content of byte array or its leading and trailing bytes and checksum when it exceeds the configured limits
+static void pkcs11_logger_log_bytes(const char *name, CK_BYTE_PTR byte_array, CK_ULONG byte_array_len)
 {
-    if (NULL != byte_array)
+    CK_ULONG head = pkcs11_logger_globals.byte_array_head;
+    CK_ULONG tail = pkcs11_logger_globals.byte_array_tail;
+    CK_BBOOL truncate = CK_FALSE;
+    CK_ULONG crc = 0;
+    char *hex = NULL;
+
+    unsigned long enable_binary = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_BINARY) == PKCS11_LOGGER_FLAG_ENABLE_BINARY);
+    unsigned long enable_crc32c = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_CRC32C) == PKCS11_LOGGER_FLAG_ENABLE_CRC32C);
+
+    // Note: Limits are applied only when at least one of them is configured
+    if ((NULL != pkcs11_logger_globals.env_var_byte_array_head) || (NULL != pkcs11_logger_globals.env_var_byte_array_tail))
+        truncate = ((byte_array_len > head) && (byte_array_len - head > tail)) ? CK_TRUE : CK_FALSE;
+
+    if ((CK_TRUE != truncate) && (!enable_crc32c))
     {
-        char *array = NULL;
-        array = pkcs11_logger_translate_ck_byte_ptr(byte_array, byte_array_len);
-        if (NULL != array)
+        // Note: Binary format stores byte array without translation
+        if (enable_binary)
         {
-            pkcs11_logger_log("%s: HEX(%s)", name, array);
-            CALL_N_CLEAR(free, array);
+            pkcs11_logger_log("%s: HEX(%B)", name, byte_array, byte_array_len);
+            return;
         }
-        else
-        {
+
+        // Note: Bytes are encoded directly into the record without intermediate string
+        if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_log_hex(name, byte_array, byte_array_len))
             pkcs11_logger_log("%s: *** cannot be displayed ***", name);
-        }
+
+        return;
     }
+
+    // Note: Checksum covers the whole byte array so the log can tell whether two truncated byte arrays match
+    if (enable_crc32c)
+        crc = pkcs11_logger_crc32c_compute(byte_array, byte_array_len);
+
+    if (CK_TRUE != truncate)
+    {
+        pkcs11_logger_log("%s: CRC32C(%08lX) (%lu bytes)", name, crc, byte_array_len);
+        return;
+    }
+
+    if (enable_binary)
+    {
+        if (enable_crc32c)
+            pkcs11_logger_log("%s: HEX(%B...%B) CRC32C(%08lX) (%lu bytes)", name, byte_array, head, byte_array + byte_array_len - tail, tail, crc, byte_array_len);
+        else
+            pkcs11_logger_log("%s: HEX(%B...%B) (%lu bytes)", name, byte_array, head, byte_array + byte_array_len - tail, tail, byte_array_len);
+        return;
+    }
+
+    hex = (char *) pkcs11_logger_arena_alloc((size_t)head * 2 + (size_t)tail * 2 + 2);
+    if (NULL == hex)
+    {
+        pkcs11_logger_log("%s: *** cannot be displayed ***", name);
+        return;
+    }
+
+    // Note: Leading and trailing bytes are encoded as two strings separated by terminating zero
+    pkcs11_logger_hex_encode(byte_array, head, hex);
+    hex[head * 2] = '\0';
+    pkcs11_logger_hex_encode(byte_array + byte_array_len - tail, tail, hex + head * 2 + 1);
+    hex[head * 2 + 1 + tail * 2] = '\0';
+
+    if (enable_crc32c)
+        pkcs11_logger_log("%s: HEX(%s...%s) CRC32C(%08lX) (%lu bytes)", name, hex, hex + head * 2 + 1, crc, byte_array_len);
+    else
+        pkcs11_logger_log("%s: HEX(%s...%s) (%lu bytes)", name, hex, hex + head * 2 + 1, byte_array_len);
+}
+
+
+// Logs byte array
+void pkcs11_logger_log_byte_array(const char *name, CK_BYTE_PTR byte_array, CK_ULONG byte_array_len)
+{
+    if (NULL != byte_array)
+        pkcs11_logger_log_bytes(name, byte_array, byte_array_len);
 }
 
 
@@ -268,8 +1030,6 @@ void pkcs11_logger_log_attribute_template(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG u
 
         if ((-1 != (CK_LONG) pTemplate[i].ulValueLen) && (NULL != pTemplate[i].pValue))
         {
-            char *value = NULL;
-
             if ((pTemplate[i].type & CKF_ARRAY_ATTRIBUTE) == CKF_ARRAY_ATTRIBUTE)
             {
                 if (0 == (pTemplate[i].ulValueLen % sizeof(CK_ATTRIBUTE)))
@@ -279,16 +1039,7 @@ void pkcs11_logger_log_attribute_template(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG u
                 }
             }
 
-            value = pkcs11_logger_translate_ck_byte_ptr(pTemplate[i].pValue, pTemplate[i].ulValueLen);
-            if (NULL != value)
-            {
-                pkcs11_logger_log("   *pValue: HEX(%s)", value);
-                CALL_N_CLEAR(free, value);
-            }
-            else
-            {
-                pkcs11_logger_log("   *pValue: *** cannot be displayed ***");
-            }
+            pkcs11_logger_log_bytes("   *pValue", pTemplate[i].pValue, pTemplate[i].ulValueLen);
         }
     }
 
@@ -0,0 +1,435 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Structure that holds preallocated and memory mapped log file segment
+typedef struct PKCS11_LOGGER_MMAP_SEGMENT
+{
+    // Next retired segment
+    struct PKCS11_LOGGER_MMAP_SEGMENT *next;
+    // Mapped contents of the segment
+    char *data;
+    // Size of the segment
+    CK_ULONG size;
+    // Offset where the next record will be written (may grow beyond the size of full segment)
+    CK_ULONG cursor;
+    // Number of threads currently writing into the segment
+    CK_ULONG writers;
+    // Number of bytes actually used when the segment is full
+    CK_ULONG used;
+#ifdef _WIN32
+    // Handle to the segment file
+    HANDLE file;
+    // Handle to the file mapping
+    HANDLE mapping;
+#else
+    // Descriptor of the segment file
+    int fd;
+#endif
+}
+PKCS11_LOGGER_MMAP_SEGMENT;
+
+
+// Segment currently used for writing
+static PKCS11_LOGGER_MMAP_SEGMENT *pkcs11_logger_mmap_segment = NULL;
+// Sequence number of the next segment
+static CK_ULONG pkcs11_logger_mmap_sequence = 0;
+// Number of threads currently using any segment obtained from pkcs11_logger_mmap_segment
+static CK_ULONG pkcs11_logger_mmap_callers = 0;
+// Closed segments whose structures may still be referenced by other threads
+static PKCS11_LOGGER_MMAP_SEGMENT *pkcs11_logger_mmap_retired = NULL;
+#ifndef _WIN32
+// Flag indicating whether fork handler has been registered
+static CK_BBOOL pkcs11_logger_mmap_atfork_registered = CK_FALSE;
+#endif
+
+
+// Creates preallocated segment file and maps it into memory
+static PKCS11_LOGGER_MMAP_SEGMENT* pkcs11_logger_mmap_create_segment(CK_ULONG size)
+{
+    PKCS11_LOGGER_MMAP_SEGMENT *segment = NULL;
+    char *path = NULL;
+    size_t path_len = 0;
+
+    if (NULL == pkcs11_logger_globals.env_var_log_file_path)
+        return NULL;
+
+    // Note: Each process writes its own sequence of segments named <log file path>.<process id>.<sequence>
+    path_len = strlen((const char *)pkcs11_logger_globals.env_var_log_file_path) + 32;
+    path = (char*) malloc(path_len);
+    if (NULL == path)
+        goto err;
+
+    snprintf(path, path_len, "%s.%d.%lu", pkcs11_logger_globals.env_var_log_file_path, pkcs11_logger_utils_get_process_id(), pkcs11_logger_mmap_sequence);
+
+    segment = (PKCS11_LOGGER_MMAP_SEGMENT*) malloc(sizeof(PKCS11_LOGGER_MMAP_SEGMENT));
+    if (NULL == segment)
+        goto err;
+
+    memset(segment, 0, sizeof(PKCS11_LOGGER_MMAP_SEGMENT));
+    segment->size = size;
+    segment->used = size;
+#ifndef _WIN32
+    segment->fd = -1;
+#endif
+
+#ifdef _WIN32
+
+    segment->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == segment->file)
+    {
+        segment->file = NULL;
+        goto err;
+    }
+
+    // Note: Mapping of the requested size extends the file
+    segment->mapping = CreateFileMappingA(segment->file, NULL, PAGE_READWRITE, 0, (DWORD)size, NULL);
+    if (NULL == segment->mapping)
+        goto err;
+
+    segment->data = (char*) MapViewOfFile(segment->mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (NULL == segment->data)
+        goto err;
+
+#else
+
+    segment->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (segment->fd < 0)
+        goto err;
+
+#ifdef __linux__
+    // Note: Blocks are allocated upfront so writes into the mapping cannot fail with SIGBUS when the disk is full
+    if (0 != posix_fallocate(segment->fd, 0, size))
+        goto err;
+#else
+    if (0 != ftruncate(segment->fd, size))
+        goto err;
+#endif
+
+    segment->data = (char*) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+    if (MAP_FAILED == segment->data)
+    {
+        segment->data = NULL;
+        goto err;
+    }
+
+#endif
+
+    pkcs11_logger_mmap_sequence++;
+    CALL_N_CLEAR(free, path);
+
+    return segment;
+
+err:
+
+    if (NULL != segment)
+    {
+#ifdef _WIN32
+        CALL_N_CLEAR(CloseHandle, segment->mapping);
+        CALL_N_CLEAR(CloseHandle, segment->file);
+#else
+        if (segment->fd >= 0)
+            close(segment->fd);
+#endif
+        CALL_N_CLEAR(free, segment);
+    }
+
+    CALL_N_CLEAR(free, path);
+
+    return NULL;
+}
+
+
+// Unmaps the segment and optionally truncates its file to the used size without freeing its structure
+static void pkcs11_logger_mmap_close_segment(PKCS11_LOGGER_MMAP_SEGMENT *segment, CK_BBOOL truncate)
+{
+    CK_ULONG used = 0;
+
+    if (NULL == segment)
+        return;
+
+    // Note: Threads that reserved space in the segment need to finish their writes first
+    while (0 != PKCS11_LOGGER_ATOMIC_LOAD(&segment->writers))
+    {
+#ifdef _WIN32
+        SwitchToThread();
+#else
+        sched_yield();
+#endif
+    }
+
+    used = PKCS11_LOGGER_ATOMIC_LOAD(&segment->cursor);
+    if (used > segment->size)
+        used = segment->used;
+
+#ifdef _WIN32
+
+    UnmapViewOfFile(segment->data);
+    CALL_N_CLEAR(CloseHandle, segment->mapping);
+
+    if (CK_TRUE == truncate)
+    {
+        LARGE_INTEGER offset;
+        offset.QuadPart = used;
+        if (SetFilePointerEx(segment->file, offset, NULL, FILE_BEGIN))
+            SetEndOfFile(segment->file);
+    }
+
+    CALL_N_CLEAR(CloseHandle, segment->file);
+
+#else
+
+    munmap(segment->data, segment->size);
+
+    // Note: Failure is not logged because logging could end up in this function again
+    if ((CK_TRUE == truncate) && (0 != ftruncate(segment->fd, used)))
+        used = 0;
+
+    close(segment->fd);
+
+#endif
+}
+
+
+// Frees structures of retired segments
+static void pkcs11_logger_mmap_free_retired(void)
+{
+    PKCS11_LOGGER_MMAP_SEGMENT *segment = NULL;
+
+    while (NULL != pkcs11_logger_mmap_retired)
+    {
+        segment = pkcs11_logger_mmap_retired;
+        pkcs11_logger_mmap_retired = segment->next;
+        CALL_N_CLEAR(free, segment);
+    }
+}
+
+
+// Closes the segment that is no longer published in pkcs11_logger_mmap_segment and frees its structure once no other thread can reference it
+static void pkcs11_logger_mmap_retire_segment(PKCS11_LOGGER_MMAP_SEGMENT *segment, CK_ULONG callers)
+{
+    if (NULL != segment)
+    {
+        pkcs11_logger_mmap_close_segment(segment, CK_TRUE);
+
+        segment->next = pkcs11_logger_mmap_retired;
+        pkcs11_logger_mmap_retired = segment;
+    }
+
+    // Note: Full barrier orders unpublishing of the segment before reading the number of callers
+    (void) PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_mmap_segment, NULL, NULL);
+
+    // Note: Thread registers itself as a caller before it reads the segment pointer so no caller left means nobody holds a retired segment
+    if (callers == PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_mmap_callers))
+        pkcs11_logger_mmap_free_retired();
+}
+
+
+#ifndef _WIN32
+
+// Forgets the segment inherited from the parent process without modifying its file
+static void pkcs11_logger_mmap_atfork_child(void)
+{
+    PKCS11_LOGGER_MMAP_SEGMENT *segment = pkcs11_logger_mmap_segment;
+
+    pkcs11_logger_mmap_segment = NULL;
+    pkcs11_logger_mmap_sequence = 0;
+
+    // Note: Threads of the parent process do not exist in the child process
+    pkcs11_logger_mmap_callers = 0;
+    pkcs11_logger_mmap_free_retired();
+
+    if (NULL != segment)
+    {
+        segment->writers = 0;
+        pkcs11_logger_mmap_close_segment(segment, CK_FALSE);
+        CALL_N_CLEAR(free, segment);
+    }
+}
+
+#endif
+
+
+// Replaces full segment with a new one large enough for the record
+static int pkcs11_logger_mmap_rollover(PKCS11_LOGGER_MMAP_SEGMENT *full_segment, size_t len)
+{
+    PKCS11_LOGGER_MMAP_SEGMENT *segment = NULL;
+    CK_ULONG size = pkcs11_logger_globals.mmap_segment_size;
+    int rv = PKCS11_LOGGER_RV_SUCCESS;
+
+    pkcs11_logger_lock_acquire();
+
+#ifndef _WIN32
+    if (CK_FALSE == pkcs11_logger_mmap_atfork_registered)
+    {
+        if (0 == pthread_atfork(NULL, NULL, pkcs11_logger_mmap_atfork_child))
+            pkcs11_logger_mmap_atfork_registered = CK_TRUE;
+    }
+#endif
+
+    // Note: Another thread may have already replaced the full segment
+    if (full_segment == PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_mmap_segment, NULL, NULL))
+    {
+        // Note: Record larger than configured size gets its own segment
+        if (size < len)
+            size = (CK_ULONG)len;
+
+        segment = pkcs11_logger_mmap_create_segment(size);
+        if (NULL == segment)
+        {
+            rv = PKCS11_LOGGER_RV_ERROR;
+        }
+        else
+        {
+            full_segment = (PKCS11_LOGGER_MMAP_SEGMENT*) PKCS11_LOGGER_ATOMIC_XCHG_PTR(&pkcs11_logger_mmap_segment, segment);
+            // Note: Calling thread is the only caller that may be left
+            pkcs11_logger_mmap_retire_segment(full_segment, 1);
+        }
+    }
+
+    pkcs11_logger_lock_release();
+
+    return rv;
+}
+
+
+// Appends data to memory mapped log file without taking the lock
+int pkcs11_logger_mmap_write(const char *data, size_t len)
+{
+    PKCS11_LOGGER_MMAP_SEGMENT *segment = NULL;
+    CK_ULONG end = 0;
+    CK_ULONG start = 0;
+    int rv = PKCS11_LOGGER_RV_SUCCESS;
+
+    // Note: Structure of a segment is not freed while any caller might still hold a pointer to it
+    PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_mmap_callers, 1);
+
+    for (;;)
+    {
+        segment = (PKCS11_LOGGER_MMAP_SEGMENT*) PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_mmap_segment, NULL, NULL);
+        if (NULL == segment)
+        {
+            rv = pkcs11_logger_mmap_rollover(NULL, len);
+            if (PKCS11_LOGGER_RV_SUCCESS != rv)
+                break;
+            continue;
+        }
+
+        // Note: Segment cannot be unmapped while it has registered writers
+        PKCS11_LOGGER_ATOMIC_ADD(&segment->writers, 1);
+        if (segment != PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_mmap_segment, NULL, NULL))
+        {
+            PKCS11_LOGGER_ATOMIC_SUB(&segment->writers, 1);
+            continue;
+        }
+
+        end = PKCS11_LOGGER_ATOMIC_ADD(&segment->cursor, len);
+        start = end - (CK_ULONG)len;
+
+        if (end <= segment->size)
+        {
+            memcpy(segment->data + start, data, len);
+            PKCS11_LOGGER_ATOMIC_SUB(&segment->writers, 1);
+            break;
+        }
+
+        // Note: Only one thread can reserve space that crosses the end of the segment
+        if (start < segment->size)
+            segment->used = start;
+
+        PKCS11_LOGGER_ATOMIC_SUB(&segment->writers, 1);
+
+        rv = pkcs11_logger_mmap_rollover(segment, len);
+        if (PKCS11_LOGGER_RV_SUCCESS != rv)
+            break;
+    }
+
+    PKCS11_LOGGER_ATOMIC_SUB(&pkcs11_logger_mmap_callers, 1);
+
+    return rv;
+}
+
+
+// Writes modified contents of current segment to the disk
+void pkcs11_logger_mmap_sync(void)
+{
+    PKCS11_LOGGER_MMAP_SEGMENT *segment = NULL;
+    CK_ULONG used = 0;
+
+    // Note: Structure of a segment is not freed while any caller might still hold a pointer to it
+    PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_mmap_callers, 1);
+
+    for (;;)
+    {
+        segment = (PKCS11_LOGGER_MMAP_SEGMENT*) PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_mmap_segment, NULL, NULL);
+        if (NULL == segment)
+        {
+            PKCS11_LOGGER_ATOMIC_SUB(&pkcs11_logger_mmap_callers, 1);
+            return;
+        }
+
+        // Note: Segment cannot be unmapped while it has registered writers
+        PKCS11_LOGGER_ATOMIC_ADD(&segment->writers, 1);
+        if (segment == PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_mmap_segment, NULL, NULL))
+            break;
+
+        PKCS11_LOGGER_ATOMIC_SUB(&segment->writers, 1);
+    }
+
+    used = PKCS11_LOGGER_ATOMIC_LOAD(&segment->cursor);
+    if (used > segment->size)
+        used = segment->size;
+
+#ifdef _WIN32
+    if (FlushViewOfFile(segment->data, used))
+        FlushFileBuffers(segment->file);
+#else
+    msync(segment->data, used, MS_SYNC);
+#endif
+
+    PKCS11_LOGGER_ATOMIC_SUB(&segment->writers, 1);
+    PKCS11_LOGGER_ATOMIC_SUB(&pkcs11_logger_mmap_callers, 1);
+}
+
+
+// Unmaps current segment, truncates its file to the used size and frees retired segments
+void pkcs11_logger_mmap_stop(void)
+{
+    PKCS11_LOGGER_MMAP_SEGMENT *segment = (PKCS11_LOGGER_MMAP_SEGMENT*) PKCS11_LOGGER_ATOMIC_XCHG_PTR(&pkcs11_logger_mmap_segment, NULL);
+
+    // Note: Lock held by a thread that did not finish its write when the library is being unloaded is not waited for
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_lock_try_acquire())
+    {
+        pkcs11_logger_mmap_close_segment(segment, CK_TRUE);
+        return;
+    }
+
+    // Note: Retired segments still referenced by threads that did not leave yet are never freed
+    pkcs11_logger_mmap_retire_segment(segment, 0);
+
+    pkcs11_logger_lock_release();
+}
@@ -104,6 +104,68 @@ PKCS11_LOGGER_GLOBALS pkcs11_logger_globals =
     NULL,       // env_var_log_file_path
     NULL,       // env_var_flags
     0,          // flags
+    NULL,       // env_var_queue_size
+    0,          // queue_size
+    NULL,       // env_var_queue_policy
+    0,          // queue_policy
+    NULL,       // env_var_mmap_segment_size
+    0,          // mmap_segment_size
+    NULL,       // env_var_rotate_size
+    0,          // rotate_size
+    NULL,       // env_var_rotate_interval
+    0,          // rotate_interval
+    NULL,       // env_var_rotate_count
+    0,          // rotate_count
+    NULL,       // env_var_rotate_compression
+    0,          // rotate_compression
+    NULL,       // env_var_durability
+    0,          // durability
+    NULL,       // env_var_flush_records
+    0,          // flush_records
+    NULL,       // env_var_flush_interval
+    0,          // flush_interval
+    NULL,       // env_var_control_file
+    0,          // control_file_checked
+    0,          // control_file_exists
+    NULL,       // env_var_include_functions
+    NULL,       // env_var_exclude_functions
+    { 0 },      // skipped_functions
+    NULL,       // env_var_stats_interval
+    0,          // stats_interval
+    NULL,       // env_var_stats_signal
+    0,          // stats_signal
+    NULL,       // env_var_timestamp
+    0,          // timestamp
+    NULL,       // env_var_socket
+    NULL,       // env_var_ring_file_path
+    NULL,       // env_var_ring_size
+    0,          // ring_size
+    NULL,       // env_var_arena_size
+    0,          // arena_size
+    NULL,       // env_var_byte_array_head
+    0,          // byte_array_head
+    NULL,       // env_var_byte_array_tail
+    0,          // byte_array_tail
+    NULL,       // env_var_sample_rates
+    { 0 },      // sample_rates
+    { 0 },      // sample_random
+    NULL,       // env_var_limit_records
+    0,          // limit_records
+    NULL,       // env_var_limit_bytes
+    0,          // limit_bytes
+    NULL,       // env_var_limit_calls
+    { 0 },      // limit_calls
+    NULL,       // env_var_cache_ttl
+    0,          // cache_ttl
+    NULL,       // env_var_pool_size
+    0,          // pool_size
+    NULL,       // env_var_pool_idle_timeout
+    0,          // pool_idle_timeout
+    NULL,       // env_var_coalesce_size
+    0,          // coalesce_size
+    NULL,       // env_var_coalesce_mechanisms
+    { 0 },      // coalesce_mechanisms
+    0,          // coalesce_mechanisms_count
     NULL        // log_file_handle
 };
 
@@ -113,6 +175,12 @@ CK_DEFINE_FUNCTION(CK_RV, C_Initialize)(CK_VOID_PTR pInitArgs)
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+
+    // Note: Background writer thread stopped by the previous C_Finalize is started again
+    if ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_ASYNC) == PKCS11_LOGGER_FLAG_ENABLE_ASYNC)
+        (void) pkcs11_logger_queue_start();
+
+    CALL_ORIG_IF_LOGGING_DISABLED(C_Initialize, (pInitArgs));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
 
@@ -131,7 +199,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Initialize)(CK_VOID_PTR pInitArgs)
     }
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_Initialize(pInitArgs);
+    rv = CALL_ORIG(C_Initialize, (pInitArgs));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
 
     pkcs11_logger_log_function_exit(rv);
@@ -144,16 +212,40 @@ CK_DEFINE_FUNCTION(CK_RV, C_Finalize)(CK_VOID_PTR pReserved)
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+
+    if (PKCS11_LOGGER_FUNCTION_IS_SKIPPED(PKCS11_LOGGER_FUNCTION_C_Finalize) || (CK_TRUE != pkcs11_logger_log_is_enabled()) || PKCS11_LOGGER_FUNCTION_IS_SAMPLED_OUT(PKCS11_LOGGER_FUNCTION_C_Finalize) || PKCS11_LOGGER_FUNCTION_IS_RATE_LIMITED(PKCS11_LOGGER_FUNCTION_C_Finalize))
+    {
+        rv = pkcs11_logger_coalesce_finalize(pReserved);
+
+        // Make sure messages logged before the logging was disabled are written
+        pkcs11_logger_stats_dump(__FUNCTION__);
+        pkcs11_logger_queue_stop(CK_TRUE);
+        pkcs11_logger_log_flush(CK_FALSE);
+        pkcs11_logger_sink_dump();
+        pkcs11_logger_rotate_stop(CK_TRUE);
+
+        return rv;
+    }
+
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
     pkcs11_logger_log(" pReserved: %p", pReserved);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_Finalize(pReserved);
+    rv = pkcs11_logger_coalesce_finalize(pReserved);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
+
+    // Make sure all records queued for the background writer thread or buffered in the log file are written
+    // Note: Background writer and rotation threads are joined here because waiting for it is not allowed when the library is unloaded
+    pkcs11_logger_stats_dump(__FUNCTION__);
+    pkcs11_logger_queue_stop(CK_TRUE);
+    pkcs11_logger_log_flush(CK_FALSE);
+    pkcs11_logger_sink_dump();
+    pkcs11_logger_rotate_stop(CK_TRUE);
+
     return rv;
 }
 
@@ -163,13 +255,14 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetInfo)(CK_INFO_PTR pInfo)
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_ORIG_IF_LOGGING_DISABLED(C_GetInfo, (pInfo));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
     pkcs11_logger_log(" pInfo: %p", pInfo);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GetInfo(pInfo);
+    rv = CALL_ORIG(C_GetInfo, (pInfo));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -201,6 +294,20 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetFunctionList)(CK_FUNCTION_LIST_PTR_PTR ppFunction
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+
+    // Note: Application calls original library directly when logged messages could never reach any output and no other feature needs the logger
+    if ((CK_TRUE != pkcs11_logger_log_has_output()) && (PKCS11_LOGGER_FLAG_ENABLE_STATS != (pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_STATS)) && (0 == pkcs11_logger_globals.cache_ttl) && (0 == pkcs11_logger_globals.pool_size) && (0 == pkcs11_logger_globals.coalesce_size))
+    {
+        *ppFunctionList = pkcs11_logger_globals.orig_lib_functions;
+        return CKR_OK;
+    }
+
+    if (PKCS11_LOGGER_FUNCTION_IS_SKIPPED(PKCS11_LOGGER_FUNCTION_C_GetFunctionList) || (CK_TRUE != pkcs11_logger_log_is_enabled()))
+    {
+        *ppFunctionList = &(pkcs11_logger_globals.logger_functions);
+        return CKR_OK;
+    }
+
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -222,8 +329,10 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetSlotList)(CK_BBOOL tokenPresent, CK_SLOT_ID_PTR p
 {
     CK_RV rv = CKR_OK;
     CK_ULONG i = 0;
+    CK_BBOOL cached = CK_FALSE;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_GetSlotList, pkcs11_logger_cache_get_slot_list(tokenPresent, pSlotList, pulCount, NULL));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -234,9 +343,12 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetSlotList)(CK_BBOOL tokenPresent, CK_SLOT_ID_PTR p
         pkcs11_logger_log(" *pulCount: %lu", *pulCount);
 
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GetSlotList(tokenPresent, pSlotList, pulCount);
+    rv = pkcs11_logger_cache_get_slot_list(tokenPresent, pSlotList, pulCount, &cached);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
 
+    if (CK_TRUE == cached)
+        pkcs11_logger_log(" Note: Response was returned from the cache");
+
     if (CKR_OK == rv)
     {
         pkcs11_logger_log_output_params();
@@ -263,8 +375,10 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetSlotList)(CK_BBOOL tokenPresent, CK_SLOT_ID_PTR p
 CK_DEFINE_FUNCTION(CK_RV, C_GetSlotInfo)(CK_SLOT_ID slotID, CK_SLOT_INFO_PTR pInfo)
 {
     CK_RV rv = CKR_OK;
+    CK_BBOOL cached = CK_FALSE;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_GetSlotInfo, pkcs11_logger_cache_get_slot_info(slotID, pInfo, NULL));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -272,8 +386,11 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetSlotInfo)(CK_SLOT_ID slotID, CK_SLOT_INFO_PTR pIn
     pkcs11_logger_log(" pInfo: %p", pInfo);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GetSlotInfo(slotID, pInfo);
+    rv = pkcs11_logger_cache_get_slot_info(slotID, pInfo, &cached);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
+
+    if (CK_TRUE == cached)
+        pkcs11_logger_log(" Note: Response was returned from the cache");
     
     if (CKR_OK == rv)
     {
@@ -305,8 +422,10 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetSlotInfo)(CK_SLOT_ID slotID, CK_SLOT_INFO_PTR pIn
 CK_DEFINE_FUNCTION(CK_RV, C_GetTokenInfo)(CK_SLOT_ID slotID, CK_TOKEN_INFO_PTR pInfo)
 {
     CK_RV rv = CKR_OK;
+    CK_BBOOL cached = CK_FALSE;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_GetTokenInfo, pkcs11_logger_cache_get_token_info(slotID, pInfo, NULL));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -314,8 +433,11 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetTokenInfo)(CK_SLOT_ID slotID, CK_TOKEN_INFO_PTR p
     pkcs11_logger_log(" pInfo: %p", pInfo);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GetTokenInfo(slotID, pInfo);
+    rv = pkcs11_logger_cache_get_token_info(slotID, pInfo, &cached);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
+
+    if (CK_TRUE == cached)
+        pkcs11_logger_log(" Note: Response was returned from the cache");
     
     if (CKR_OK == rv)
     {
@@ -376,8 +498,10 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetMechanismList)(CK_SLOT_ID slotID, CK_MECHANISM_TY
 {
     CK_RV rv = CKR_OK;
     CK_ULONG i = 0;
+    CK_BBOOL cached = CK_FALSE;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_GetMechanismList, pkcs11_logger_cache_get_mechanism_list(slotID, pMechanismList, pulCount, NULL));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
 
@@ -388,9 +512,12 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetMechanismList)(CK_SLOT_ID slotID, CK_MECHANISM_TY
         pkcs11_logger_log(" *pulCount: %lu", *pulCount);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GetMechanismList(slotID, pMechanismList, pulCount);
+    rv = pkcs11_logger_cache_get_mechanism_list(slotID, pMechanismList, pulCount, &cached);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
 
+    if (CK_TRUE == cached)
+        pkcs11_logger_log(" Note: Response was returned from the cache");
+
     if (CKR_OK == rv)
     {
         pkcs11_logger_log_output_params();
@@ -417,8 +544,10 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetMechanismList)(CK_SLOT_ID slotID, CK_MECHANISM_TY
 CK_DEFINE_FUNCTION(CK_RV, C_GetMechanismInfo)(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_MECHANISM_INFO_PTR pInfo)
 {
     CK_RV rv = CKR_OK;
+    CK_BBOOL cached = CK_FALSE;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_GetMechanismInfo, pkcs11_logger_cache_get_mechanism_info(slotID, type, pInfo, NULL));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -427,8 +556,11 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetMechanismInfo)(CK_SLOT_ID slotID, CK_MECHANISM_TY
     pkcs11_logger_log(" pInfo: %p", pInfo);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GetMechanismInfo(slotID, type, pInfo);
+    rv = pkcs11_logger_cache_get_mechanism_info(slotID, type, pInfo, &cached);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
+
+    if (CK_TRUE == cached)
+        pkcs11_logger_log(" Note: Response was returned from the cache");
     
     if (CKR_OK == rv)
     {
@@ -473,6 +605,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_InitToken)(CK_SLOT_ID slotID, CK_UTF8CHAR_PTR pPin,
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_InitToken, CALL_ORIG_N_INVALIDATE(C_InitToken, (slotID, pPin, ulPinLen, pLabel)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -488,7 +621,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_InitToken)(CK_SLOT_ID slotID, CK_UTF8CHAR_PTR pPin,
         pkcs11_logger_log(" *pLabel: %.32s", pLabel);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_InitToken(slotID, pPin, ulPinLen, pLabel);
+    rv = CALL_ORIG_N_INVALIDATE(C_InitToken, (slotID, pPin, ulPinLen, pLabel));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -501,6 +634,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_InitPIN)(CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_InitPIN, CALL_ORIG_N_INVALIDATE(C_InitPIN, (hSession, pPin, ulPinLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -513,7 +647,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_InitPIN)(CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR
     pkcs11_logger_log(" ulPinLen: %lu", ulPinLen);
 
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_InitPIN(hSession, pPin, ulPinLen);
+    rv = CALL_ORIG_N_INVALIDATE(C_InitPIN, (hSession, pPin, ulPinLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -526,6 +660,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SetPIN)(CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_SetPIN, CALL_ORIG_N_INVALIDATE(C_SetPIN, (hSession, pOldPin, ulOldLen, pNewPin, ulNewLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -544,7 +679,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SetPIN)(CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR
     pkcs11_logger_log(" ulNewLen: %lu", ulNewLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_SetPIN(hSession, pOldPin, ulOldLen, pNewPin, ulNewLen);
+    rv = CALL_ORIG_N_INVALIDATE(C_SetPIN, (hSession, pOldPin, ulOldLen, pNewPin, ulNewLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -555,8 +690,10 @@ CK_DEFINE_FUNCTION(CK_RV, C_SetPIN)(CK_SESSION_HANDLE hSession, CK_UTF8CHAR_PTR
 CK_DEFINE_FUNCTION(CK_RV, C_OpenSession)(CK_SLOT_ID slotID, CK_FLAGS flags, CK_VOID_PTR pApplication, CK_NOTIFY Notify, CK_SESSION_HANDLE_PTR phSession)
 {
     CK_RV rv = CKR_OK;
+    CK_BBOOL pooled = CK_FALSE;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_OpenSession, pkcs11_logger_coalesce_open_session(slotID, flags, pApplication, Notify, phSession, NULL));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();    
     
@@ -571,8 +708,11 @@ CK_DEFINE_FUNCTION(CK_RV, C_OpenSession)(CK_SLOT_ID slotID, CK_FLAGS flags, CK_V
         pkcs11_logger_log(" *phSession: %lu", phSession);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_OpenSession(slotID, flags, pApplication, Notify, phSession);
+    rv = pkcs11_logger_coalesce_open_session(slotID, flags, pApplication, Notify, phSession, &pooled);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
+
+    if (CK_TRUE == pooled)
+        pkcs11_logger_log(" Note: Session was leased from the pool");
     
     if (CKR_OK == rv)
     {
@@ -591,16 +731,25 @@ CK_DEFINE_FUNCTION(CK_RV, C_OpenSession)(CK_SLOT_ID slotID, CK_FLAGS flags, CK_V
 CK_DEFINE_FUNCTION(CK_RV, C_CloseSession)(CK_SESSION_HANDLE hSession)
 {
     CK_RV rv = CKR_OK;
+    CK_BBOOL pooled = CK_FALSE;
+    CK_ULONG updates = 0;
+    CK_ULONG calls = 0;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_CloseSession, pkcs11_logger_coalesce_close_session(hSession, NULL, NULL, NULL));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();    
     
     pkcs11_logger_log(" hSession: %lu", hSession);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_CloseSession(hSession);
+    rv = pkcs11_logger_coalesce_close_session(hSession, &pooled, &updates, &calls);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
+
+    if (CK_TRUE == pooled)
+        pkcs11_logger_log(" Note: Session was returned to the pool");
+    if (0 != updates)
+        pkcs11_logger_log(" Note: %lu updates of the session were passed to the original library in %lu calls", updates, calls);
     
     pkcs11_logger_log_function_exit(rv);
     return rv;
@@ -612,13 +761,14 @@ CK_DEFINE_FUNCTION(CK_RV, C_CloseAllSessions)(CK_SLOT_ID slotID)
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_CloseAllSessions, pkcs11_logger_coalesce_close_all_sessions(slotID));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();    
     
     pkcs11_logger_log(" slotID: %lu", slotID);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_CloseAllSessions(slotID);
+    rv = pkcs11_logger_coalesce_close_all_sessions(slotID);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -631,6 +781,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetSessionInfo)(CK_SESSION_HANDLE hSession, CK_SESSI
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_ORIG_IF_LOGGING_DISABLED(C_GetSessionInfo, (hSession, pInfo));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();    
     
@@ -638,7 +789,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetSessionInfo)(CK_SESSION_HANDLE hSession, CK_SESSI
     pkcs11_logger_log(" pInfo: %p", pInfo);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GetSessionInfo(hSession, pInfo);
+    rv = CALL_ORIG(C_GetSessionInfo, (hSession, pInfo));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -667,6 +818,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetOperationState)(CK_SESSION_HANDLE hSession, CK_BY
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_GetOperationState, CALL_ORIG_N_FLUSH(C_GetOperationState, hSession, PKCS11_LOGGER_COALESCE_STATES, (hSession, pOperationState, pulOperationStateLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();    
     
@@ -677,7 +829,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetOperationState)(CK_SESSION_HANDLE hSession, CK_BY
         pkcs11_logger_log(" *pulOperationStateLen: %lu", *pulOperationStateLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GetOperationState(hSession, pOperationState, pulOperationStateLen);
+    rv = CALL_ORIG_N_FLUSH(C_GetOperationState, hSession, PKCS11_LOGGER_COALESCE_STATES, (hSession, pOperationState, pulOperationStateLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -702,6 +854,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SetOperationState)(CK_SESSION_HANDLE hSession, CK_BY
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_SetOperationState, pkcs11_logger_coalesce_finish(hSession, PKCS11_LOGGER_COALESCE_STATES, CK_TRUE, CALL_ORIG_N_START(C_SetOperationState, hSession, PKCS11_LOGGER_POOL_STATE_RESTORED, (hSession, pOperationState, ulOperationStateLen, hEncryptionKey, hAuthenticationKey))));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();    
     
@@ -713,7 +866,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SetOperationState)(CK_SESSION_HANDLE hSession, CK_BY
     pkcs11_logger_log(" hAuthenticationKey: %lu", hAuthenticationKey);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_SetOperationState(hSession, pOperationState, ulOperationStateLen, hEncryptionKey, hAuthenticationKey);
+    rv = pkcs11_logger_coalesce_finish(hSession, PKCS11_LOGGER_COALESCE_STATES, CK_TRUE, CALL_ORIG_N_START(C_SetOperationState, hSession, PKCS11_LOGGER_POOL_STATE_RESTORED, (hSession, pOperationState, ulOperationStateLen, hEncryptionKey, hAuthenticationKey)));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -726,6 +879,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Login)(CK_SESSION_HANDLE hSession, CK_USER_TYPE user
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_Login, pkcs11_logger_pool_login(hSession, userType, pPin, ulPinLen));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -739,7 +893,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Login)(CK_SESSION_HANDLE hSession, CK_USER_TYPE user
     pkcs11_logger_log(" ulPinLen: %lu", ulPinLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_Login(hSession, userType, pPin, ulPinLen);
+    rv = pkcs11_logger_pool_login(hSession, userType, pPin, ulPinLen);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -752,13 +906,14 @@ CK_DEFINE_FUNCTION(CK_RV, C_Logout)(CK_SESSION_HANDLE hSession)
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_Logout, CALL_ORIG_N_INVALIDATE(C_Logout, (hSession)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
     pkcs11_logger_log(" hSession: %lu", hSession);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_Logout(hSession);
+    rv = CALL_ORIG_N_INVALIDATE(C_Logout, (hSession));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -771,6 +926,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_CreateObject)(CK_SESSION_HANDLE hSession, CK_ATTRIBU
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_CreateObject, CALL_ORIG_N_CREATE(C_CreateObject, hSession, (hSession, pTemplate, ulCount, phObject)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -783,7 +939,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_CreateObject)(CK_SESSION_HANDLE hSession, CK_ATTRIBU
         pkcs11_logger_log(" *phObject: %lu", *phObject);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_CreateObject(hSession, pTemplate, ulCount, phObject);
+    rv = CALL_ORIG_N_CREATE(C_CreateObject, hSession, (hSession, pTemplate, ulCount, phObject));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -805,6 +961,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_CopyObject)(CK_SESSION_HANDLE hSession, CK_OBJECT_HA
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_CopyObject, CALL_ORIG_N_CREATE(C_CopyObject, hSession, (hSession, hObject, pTemplate, ulCount, phNewObject)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -818,7 +975,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_CopyObject)(CK_SESSION_HANDLE hSession, CK_OBJECT_HA
         pkcs11_logger_log(" *phNewObject: %lu", *phNewObject);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_CopyObject(hSession, hObject, pTemplate, ulCount, phNewObject);
+    rv = CALL_ORIG_N_CREATE(C_CopyObject, hSession, (hSession, hObject, pTemplate, ulCount, phNewObject));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -840,6 +997,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DestroyObject)(CK_SESSION_HANDLE hSession, CK_OBJECT
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_DestroyObject, pkcs11_logger_cache_destroy_object(hSession, hObject));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -847,7 +1005,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DestroyObject)(CK_SESSION_HANDLE hSession, CK_OBJECT
     pkcs11_logger_log(" hObject: %lu", hObject);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_DestroyObject(hSession, hObject);
+    rv = pkcs11_logger_cache_destroy_object(hSession, hObject);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -860,6 +1018,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetObjectSize)(CK_SESSION_HANDLE hSession, CK_OBJECT
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_ORIG_IF_LOGGING_DISABLED(C_GetObjectSize, (hSession, hObject, pulSize));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -870,7 +1029,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetObjectSize)(CK_SESSION_HANDLE hSession, CK_OBJECT
         pkcs11_logger_log(" *pulSize: %lu", *pulSize);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GetObjectSize(hSession, hObject, pulSize);
+    rv = CALL_ORIG(C_GetObjectSize, (hSession, hObject, pulSize));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -890,8 +1049,10 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetObjectSize)(CK_SESSION_HANDLE hSession, CK_OBJECT
 CK_DEFINE_FUNCTION(CK_RV, C_GetAttributeValue)(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount)
 {
     CK_RV rv = CKR_OK;
+    CK_BBOOL cached = CK_FALSE;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_GetAttributeValue, pkcs11_logger_cache_get_attribute_value(hSession, hObject, pTemplate, ulCount, NULL));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -902,8 +1063,11 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetAttributeValue)(CK_SESSION_HANDLE hSession, CK_OB
     pkcs11_logger_log_attribute_template(pTemplate, ulCount);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GetAttributeValue(hSession, hObject, pTemplate, ulCount);
+    rv = pkcs11_logger_cache_get_attribute_value(hSession, hObject, pTemplate, ulCount, &cached);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
+
+    if (CK_TRUE == cached)
+        pkcs11_logger_log(" Note: Response was returned from the cache");
     
     if ((CKR_OK == rv) || (CKR_ATTRIBUTE_SENSITIVE == rv) || (CKR_ATTRIBUTE_TYPE_INVALID == rv) || (CKR_BUFFER_TOO_SMALL == rv))
     {
@@ -924,6 +1088,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SetAttributeValue)(CK_SESSION_HANDLE hSession, CK_OB
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_SetAttributeValue, pkcs11_logger_cache_set_attribute_value(hSession, hObject, pTemplate, ulCount));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -934,7 +1099,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SetAttributeValue)(CK_SESSION_HANDLE hSession, CK_OB
     pkcs11_logger_log_attribute_template(pTemplate, ulCount);    
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_SetAttributeValue(hSession, hObject, pTemplate, ulCount);
+    rv = pkcs11_logger_cache_set_attribute_value(hSession, hObject, pTemplate, ulCount);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -945,8 +1110,10 @@ CK_DEFINE_FUNCTION(CK_RV, C_SetAttributeValue)(CK_SESSION_HANDLE hSession, CK_OB
 CK_DEFINE_FUNCTION(CK_RV, C_FindObjectsInit)(CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount)
 {
     CK_RV rv = CKR_OK;
+    CK_BBOOL cached = CK_FALSE;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_FindObjectsInit, pkcs11_logger_pool_start(hSession, PKCS11_LOGGER_POOL_STATE_FIND, pkcs11_logger_cache_find_objects_init(hSession, pTemplate, ulCount, NULL)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -956,8 +1123,11 @@ CK_DEFINE_FUNCTION(CK_RV, C_FindObjectsInit)(CK_SESSION_HANDLE hSession, CK_ATTR
     pkcs11_logger_log_attribute_template(pTemplate, ulCount);        
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_FindObjectsInit(hSession, pTemplate, ulCount);
+    rv = pkcs11_logger_pool_start(hSession, PKCS11_LOGGER_POOL_STATE_FIND, pkcs11_logger_cache_find_objects_init(hSession, pTemplate, ulCount, &cached));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
+
+    if (CK_TRUE == cached)
+        pkcs11_logger_log(" Note: Response was returned from the cache");
     
     pkcs11_logger_log_function_exit(rv);
     return rv;
@@ -967,9 +1137,11 @@ CK_DEFINE_FUNCTION(CK_RV, C_FindObjectsInit)(CK_SESSION_HANDLE hSession, CK_ATTR
 CK_DEFINE_FUNCTION(CK_RV, C_FindObjects)(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE_PTR phObject, CK_ULONG ulMaxObjectCount, CK_ULONG_PTR pulObjectCount)
 {
     CK_RV rv = CKR_OK;
+    CK_BBOOL cached = CK_FALSE;
     CK_ULONG i = 0;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_FindObjects, pkcs11_logger_cache_find_objects(hSession, phObject, ulMaxObjectCount, pulObjectCount, NULL));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -989,8 +1161,11 @@ CK_DEFINE_FUNCTION(CK_RV, C_FindObjects)(CK_SESSION_HANDLE hSession, CK_OBJECT_H
     }
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_FindObjects(hSession, phObject, ulMaxObjectCount, pulObjectCount);
+    rv = pkcs11_logger_cache_find_objects(hSession, phObject, ulMaxObjectCount, pulObjectCount, &cached);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
+
+    if (CK_TRUE == cached)
+        pkcs11_logger_log(" Note: Response was returned from the cache");
     
     if (CKR_OK == rv)
     {
@@ -1019,16 +1194,21 @@ CK_DEFINE_FUNCTION(CK_RV, C_FindObjects)(CK_SESSION_HANDLE hSession, CK_OBJECT_H
 CK_DEFINE_FUNCTION(CK_RV, C_FindObjectsFinal)(CK_SESSION_HANDLE hSession)
 {
     CK_RV rv = CKR_OK;
+    CK_BBOOL cached = CK_FALSE;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_FindObjectsFinal, pkcs11_logger_pool_finish(hSession, PKCS11_LOGGER_POOL_STATE_FIND, CK_TRUE, pkcs11_logger_cache_find_objects_final(hSession, NULL)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
     pkcs11_logger_log(" hSession: %lu", hSession);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_FindObjectsFinal(hSession);
+    rv = pkcs11_logger_pool_finish(hSession, PKCS11_LOGGER_POOL_STATE_FIND, CK_TRUE, pkcs11_logger_cache_find_objects_final(hSession, &cached));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
+
+    if (CK_TRUE == cached)
+        pkcs11_logger_log(" Note: Response was returned from the cache");
     
     pkcs11_logger_log_function_exit(rv);
     return rv;
@@ -1040,6 +1220,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_EncryptInit)(CK_SESSION_HANDLE hSession, CK_MECHANIS
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_EncryptInit, CALL_ORIG_N_START(C_EncryptInit, hSession, PKCS11_LOGGER_POOL_STATE_ENCRYPT, (hSession, pMechanism, hKey)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1055,7 +1236,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_EncryptInit)(CK_SESSION_HANDLE hSession, CK_MECHANIS
     pkcs11_logger_log(" hKey: %lu", hKey);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_EncryptInit(hSession, pMechanism, hKey);
+    rv = CALL_ORIG_N_START(C_EncryptInit, hSession, PKCS11_LOGGER_POOL_STATE_ENCRYPT, (hSession, pMechanism, hKey));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -1068,6 +1249,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Encrypt)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDa
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_Encrypt, CALL_ORIG_N_FINISH(C_Encrypt, hSession, PKCS11_LOGGER_POOL_STATE_ENCRYPT, (NULL != pEncryptedData), (hSession, pData, ulDataLen, pEncryptedData, pulEncryptedDataLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1081,7 +1263,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Encrypt)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDa
         pkcs11_logger_log(" *pulEncryptedDataLen: %lu", *pulEncryptedDataLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_Encrypt(hSession, pData, ulDataLen, pEncryptedData, pulEncryptedDataLen);
+    rv = CALL_ORIG_N_FINISH(C_Encrypt, hSession, PKCS11_LOGGER_POOL_STATE_ENCRYPT, (NULL != pEncryptedData), (hSession, pData, ulDataLen, pEncryptedData, pulEncryptedDataLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1106,6 +1288,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_EncryptUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_P
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_ORIG_IF_LOGGING_DISABLED(C_EncryptUpdate, (hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1119,7 +1302,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_EncryptUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_P
         pkcs11_logger_log(" *pulEncryptedPartLen: %lu", *pulEncryptedPartLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_EncryptUpdate(hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen);
+    rv = CALL_ORIG(C_EncryptUpdate, (hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1144,6 +1327,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_EncryptFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PT
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_EncryptFinal, CALL_ORIG_N_FINISH(C_EncryptFinal, hSession, PKCS11_LOGGER_POOL_STATE_ENCRYPT, (NULL != pLastEncryptedPart), (hSession, pLastEncryptedPart, pulLastEncryptedPartLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1154,7 +1338,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_EncryptFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PT
         pkcs11_logger_log(" *pulLastEncryptedPartLen: %lu", *pulLastEncryptedPartLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_EncryptFinal(hSession, pLastEncryptedPart, pulLastEncryptedPartLen);
+    rv = CALL_ORIG_N_FINISH(C_EncryptFinal, hSession, PKCS11_LOGGER_POOL_STATE_ENCRYPT, (NULL != pLastEncryptedPart), (hSession, pLastEncryptedPart, pulLastEncryptedPartLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1179,6 +1363,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DecryptInit)(CK_SESSION_HANDLE hSession, CK_MECHANIS
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_DecryptInit, CALL_ORIG_N_START(C_DecryptInit, hSession, PKCS11_LOGGER_POOL_STATE_DECRYPT, (hSession, pMechanism, hKey)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1195,7 +1380,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DecryptInit)(CK_SESSION_HANDLE hSession, CK_MECHANIS
     pkcs11_logger_log(" hKey: %lu", hKey);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_DecryptInit(hSession, pMechanism, hKey);
+    rv = CALL_ORIG_N_START(C_DecryptInit, hSession, PKCS11_LOGGER_POOL_STATE_DECRYPT, (hSession, pMechanism, hKey));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -1208,6 +1393,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Decrypt)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEn
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_Decrypt, CALL_ORIG_N_FINISH(C_Decrypt, hSession, PKCS11_LOGGER_POOL_STATE_DECRYPT, (NULL != pData), (hSession, pEncryptedData, ulEncryptedDataLen, pData, pulDataLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1221,7 +1407,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Decrypt)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pEn
         pkcs11_logger_log(" *pulDataLen: %lu", *pulDataLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_Decrypt(hSession, pEncryptedData, ulEncryptedDataLen, pData, pulDataLen);
+    rv = CALL_ORIG_N_FINISH(C_Decrypt, hSession, PKCS11_LOGGER_POOL_STATE_DECRYPT, (NULL != pData), (hSession, pEncryptedData, ulEncryptedDataLen, pData, pulDataLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1246,6 +1432,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DecryptUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_P
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_ORIG_IF_LOGGING_DISABLED(C_DecryptUpdate, (hSession, pEncryptedPart, ulEncryptedPartLen, pPart, pulPartLen));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1259,7 +1446,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DecryptUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_P
         pkcs11_logger_log(" *pulPartLen: %lu", *pulPartLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_DecryptUpdate(hSession, pEncryptedPart, ulEncryptedPartLen, pPart, pulPartLen);
+    rv = CALL_ORIG(C_DecryptUpdate, (hSession, pEncryptedPart, ulEncryptedPartLen, pPart, pulPartLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1284,6 +1471,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DecryptFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PT
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_DecryptFinal, CALL_ORIG_N_FINISH(C_DecryptFinal, hSession, PKCS11_LOGGER_POOL_STATE_DECRYPT, (NULL != pLastPart), (hSession, pLastPart, pulLastPartLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1294,7 +1482,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DecryptFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PT
         pkcs11_logger_log(" *pulLastPartLen: %lu", *pulLastPartLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_DecryptFinal(hSession, pLastPart, pulLastPartLen);
+    rv = CALL_ORIG_N_FINISH(C_DecryptFinal, hSession, PKCS11_LOGGER_POOL_STATE_DECRYPT, (NULL != pLastPart), (hSession, pLastPart, pulLastPartLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1319,6 +1507,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DigestInit)(CK_SESSION_HANDLE hSession, CK_MECHANISM
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_DigestInit, CALL_ORIG_N_COALESCE(C_DigestInit, hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, pMechanism, (hSession, pMechanism)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1333,7 +1522,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DigestInit)(CK_SESSION_HANDLE hSession, CK_MECHANISM
     }
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_DigestInit(hSession, pMechanism);
+    rv = CALL_ORIG_N_COALESCE(C_DigestInit, hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, pMechanism, (hSession, pMechanism));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -1346,6 +1535,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Digest)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDat
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_Digest, CALL_ORIG_N_FINISH(C_Digest, hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, (NULL != pDigest), (hSession, pData, ulDataLen, pDigest, pulDigestLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1359,7 +1549,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Digest)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDat
         pkcs11_logger_log(" *pulDigestLen: %lu", *pulDigestLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_Digest(hSession, pData, ulDataLen, pDigest, pulDigestLen);
+    rv = CALL_ORIG_N_FINISH(C_Digest, hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, (NULL != pDigest), (hSession, pData, ulDataLen, pDigest, pulDigestLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1382,8 +1572,10 @@ CK_DEFINE_FUNCTION(CK_RV, C_Digest)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDat
 CK_DEFINE_FUNCTION(CK_RV, C_DigestUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen)
 {
     CK_RV rv = CKR_OK;
+    CK_BBOOL buffered = CK_FALSE;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_DigestUpdate, pkcs11_logger_coalesce_update(hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, pPart, ulPartLen, NULL));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1393,8 +1585,11 @@ CK_DEFINE_FUNCTION(CK_RV, C_DigestUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_PT
     pkcs11_logger_log(" ulPartLen: %lu", ulPartLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_DigestUpdate(hSession, pPart, ulPartLen);
+    rv = pkcs11_logger_coalesce_update(hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, pPart, ulPartLen, &buffered);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
+
+    if (CK_TRUE == buffered)
+        pkcs11_logger_log(" Note: Part was buffered by the logger");
     
     pkcs11_logger_log_function_exit(rv);
     return rv;
@@ -1406,6 +1601,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DigestKey)(CK_SESSION_HANDLE hSession, CK_OBJECT_HAN
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_DigestKey, CALL_ORIG_N_FLUSH(C_DigestKey, hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, (hSession, hKey)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1413,7 +1609,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DigestKey)(CK_SESSION_HANDLE hSession, CK_OBJECT_HAN
     pkcs11_logger_log(" hKey: %lu", hKey);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_DigestKey(hSession, hKey);
+    rv = CALL_ORIG_N_FLUSH(C_DigestKey, hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, (hSession, hKey));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -1426,6 +1622,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DigestFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_DigestFinal, CALL_ORIG_N_FINISH(C_DigestFinal, hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, (NULL != pDigest), (hSession, pDigest, pulDigestLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1436,7 +1633,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DigestFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR
         pkcs11_logger_log(" *pulDigestLen: %lu", *pulDigestLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_DigestFinal(hSession, pDigest, pulDigestLen);
+    rv = CALL_ORIG_N_FINISH(C_DigestFinal, hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, (NULL != pDigest), (hSession, pDigest, pulDigestLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1461,6 +1658,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SignInit)(CK_SESSION_HANDLE hSession, CK_MECHANISM_P
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_SignInit, CALL_ORIG_N_COALESCE(C_SignInit, hSession, PKCS11_LOGGER_POOL_STATE_SIGN, pMechanism, (hSession, pMechanism, hKey)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1476,7 +1674,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SignInit)(CK_SESSION_HANDLE hSession, CK_MECHANISM_P
     pkcs11_logger_log(" hKey: %lu", hKey);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_SignInit(hSession, pMechanism, hKey);
+    rv = CALL_ORIG_N_COALESCE(C_SignInit, hSession, PKCS11_LOGGER_POOL_STATE_SIGN, pMechanism, (hSession, pMechanism, hKey));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -1489,6 +1687,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Sign)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData,
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_Sign, CALL_ORIG_N_FINISH(C_Sign, hSession, PKCS11_LOGGER_POOL_STATE_SIGN, (NULL != pSignature), (hSession, pData, ulDataLen, pSignature, pulSignatureLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1502,7 +1701,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Sign)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData,
         pkcs11_logger_log(" *pulSignatureLen: %lu", *pulSignatureLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_Sign(hSession, pData, ulDataLen, pSignature, pulSignatureLen);
+    rv = CALL_ORIG_N_FINISH(C_Sign, hSession, PKCS11_LOGGER_POOL_STATE_SIGN, (NULL != pSignature), (hSession, pData, ulDataLen, pSignature, pulSignatureLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1525,8 +1724,10 @@ CK_DEFINE_FUNCTION(CK_RV, C_Sign)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pData,
 CK_DEFINE_FUNCTION(CK_RV, C_SignUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen)
 {
     CK_RV rv = CKR_OK;
+    CK_BBOOL buffered = CK_FALSE;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_SignUpdate, pkcs11_logger_coalesce_update(hSession, PKCS11_LOGGER_POOL_STATE_SIGN, pPart, ulPartLen, NULL));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1536,8 +1737,11 @@ CK_DEFINE_FUNCTION(CK_RV, C_SignUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR
     pkcs11_logger_log(" ulPartLen: %lu", ulPartLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_SignUpdate(hSession, pPart, ulPartLen);
+    rv = pkcs11_logger_coalesce_update(hSession, PKCS11_LOGGER_POOL_STATE_SIGN, pPart, ulPartLen, &buffered);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
+
+    if (CK_TRUE == buffered)
+        pkcs11_logger_log(" Note: Part was buffered by the logger");
     
     pkcs11_logger_log_function_exit(rv);
     return rv;
@@ -1549,6 +1753,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SignFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR p
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_SignFinal, CALL_ORIG_N_FINISH(C_SignFinal, hSession, PKCS11_LOGGER_POOL_STATE_SIGN, (NULL != pSignature), (hSession, pSignature, pulSignatureLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1559,7 +1764,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SignFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR p
         pkcs11_logger_log(" *pulSignatureLen: %lu", *pulSignatureLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_SignFinal(hSession, pSignature, pulSignatureLen);
+    rv = CALL_ORIG_N_FINISH(C_SignFinal, hSession, PKCS11_LOGGER_POOL_STATE_SIGN, (NULL != pSignature), (hSession, pSignature, pulSignatureLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1584,6 +1789,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SignRecoverInit)(CK_SESSION_HANDLE hSession, CK_MECH
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_SignRecoverInit, CALL_ORIG_N_START(C_SignRecoverInit, hSession, PKCS11_LOGGER_POOL_STATE_SIGN_RECOVER, (hSession, pMechanism, hKey)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1599,7 +1805,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SignRecoverInit)(CK_SESSION_HANDLE hSession, CK_MECH
     pkcs11_logger_log(" hKey: %lu", hKey);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_SignRecoverInit(hSession, pMechanism, hKey);
+    rv = CALL_ORIG_N_START(C_SignRecoverInit, hSession, PKCS11_LOGGER_POOL_STATE_SIGN_RECOVER, (hSession, pMechanism, hKey));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -1612,6 +1818,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SignRecover)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_SignRecover, CALL_ORIG_N_FINISH(C_SignRecover, hSession, PKCS11_LOGGER_POOL_STATE_SIGN_RECOVER, (NULL != pSignature), (hSession, pData, ulDataLen, pSignature, pulSignatureLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1625,7 +1832,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SignRecover)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR
         pkcs11_logger_log(" *pulSignatureLen: %lu", *pulSignatureLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_SignRecover(hSession, pData, ulDataLen, pSignature, pulSignatureLen);
+    rv = CALL_ORIG_N_FINISH(C_SignRecover, hSession, PKCS11_LOGGER_POOL_STATE_SIGN_RECOVER, (NULL != pSignature), (hSession, pData, ulDataLen, pSignature, pulSignatureLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1650,6 +1857,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_VerifyInit)(CK_SESSION_HANDLE hSession, CK_MECHANISM
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_VerifyInit, CALL_ORIG_N_COALESCE(C_VerifyInit, hSession, PKCS11_LOGGER_POOL_STATE_VERIFY, pMechanism, (hSession, pMechanism, hKey)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1665,7 +1873,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_VerifyInit)(CK_SESSION_HANDLE hSession, CK_MECHANISM
     pkcs11_logger_log(" hKey: %lu", hKey);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_VerifyInit(hSession, pMechanism, hKey);
+    rv = CALL_ORIG_N_COALESCE(C_VerifyInit, hSession, PKCS11_LOGGER_POOL_STATE_VERIFY, pMechanism, (hSession, pMechanism, hKey));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -1678,6 +1886,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Verify)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDat
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_Verify, CALL_ORIG_N_FINISH(C_Verify, hSession, PKCS11_LOGGER_POOL_STATE_VERIFY, CK_TRUE, (hSession, pData, ulDataLen, pSignature, ulSignatureLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1690,7 +1899,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_Verify)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDat
     pkcs11_logger_log(" ulSignatureLen: %lu", ulSignatureLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_Verify(hSession, pData, ulDataLen, pSignature, ulSignatureLen);
+    rv = CALL_ORIG_N_FINISH(C_Verify, hSession, PKCS11_LOGGER_POOL_STATE_VERIFY, CK_TRUE, (hSession, pData, ulDataLen, pSignature, ulSignatureLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -1701,8 +1910,10 @@ CK_DEFINE_FUNCTION(CK_RV, C_Verify)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pDat
 CK_DEFINE_FUNCTION(CK_RV, C_VerifyUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR pPart, CK_ULONG ulPartLen)
 {
     CK_RV rv = CKR_OK;
+    CK_BBOOL buffered = CK_FALSE;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_VerifyUpdate, pkcs11_logger_coalesce_update(hSession, PKCS11_LOGGER_POOL_STATE_VERIFY, pPart, ulPartLen, NULL));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1712,8 +1923,11 @@ CK_DEFINE_FUNCTION(CK_RV, C_VerifyUpdate)(CK_SESSION_HANDLE hSession, CK_BYTE_PT
     pkcs11_logger_log(" ulPartLen: %lu", ulPartLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_VerifyUpdate(hSession, pPart, ulPartLen);
+    rv = pkcs11_logger_coalesce_update(hSession, PKCS11_LOGGER_POOL_STATE_VERIFY, pPart, ulPartLen, &buffered);
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
+
+    if (CK_TRUE == buffered)
+        pkcs11_logger_log(" Note: Part was buffered by the logger");
     
     pkcs11_logger_log_function_exit(rv);
     return rv;
@@ -1725,6 +1939,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_VerifyFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_VerifyFinal, CALL_ORIG_N_FINISH(C_VerifyFinal, hSession, PKCS11_LOGGER_POOL_STATE_VERIFY, CK_TRUE, (hSession, pSignature, ulSignatureLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1734,7 +1949,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_VerifyFinal)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR
     pkcs11_logger_log(" ulSignatureLen: %lu", ulSignatureLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_VerifyFinal(hSession, pSignature, ulSignatureLen);
+    rv = CALL_ORIG_N_FINISH(C_VerifyFinal, hSession, PKCS11_LOGGER_POOL_STATE_VERIFY, CK_TRUE, (hSession, pSignature, ulSignatureLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -1747,6 +1962,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_VerifyRecoverInit)(CK_SESSION_HANDLE hSession, CK_ME
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_VerifyRecoverInit, CALL_ORIG_N_START(C_VerifyRecoverInit, hSession, PKCS11_LOGGER_POOL_STATE_VERIFY_RECOVER, (hSession, pMechanism, hKey)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1762,7 +1978,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_VerifyRecoverInit)(CK_SESSION_HANDLE hSession, CK_ME
     pkcs11_logger_log(" hKey: %lu", hKey);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_VerifyRecoverInit(hSession, pMechanism, hKey);
+    rv = CALL_ORIG_N_START(C_VerifyRecoverInit, hSession, PKCS11_LOGGER_POOL_STATE_VERIFY_RECOVER, (hSession, pMechanism, hKey));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -1775,6 +1991,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_VerifyRecover)(CK_SESSION_HANDLE hSession, CK_BYTE_P
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_VerifyRecover, CALL_ORIG_N_FINISH(C_VerifyRecover, hSession, PKCS11_LOGGER_POOL_STATE_VERIFY_RECOVER, (NULL != pData), (hSession, pSignature, ulSignatureLen, pData, pulDataLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1788,7 +2005,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_VerifyRecover)(CK_SESSION_HANDLE hSession, CK_BYTE_P
         pkcs11_logger_log(" *pulDataLen: %lu", *pulDataLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_VerifyRecover(hSession, pSignature, ulSignatureLen, pData, pulDataLen);
+    rv = CALL_ORIG_N_FINISH(C_VerifyRecover, hSession, PKCS11_LOGGER_POOL_STATE_VERIFY_RECOVER, (NULL != pData), (hSession, pSignature, ulSignatureLen, pData, pulDataLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1813,6 +2030,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DigestEncryptUpdate)(CK_SESSION_HANDLE hSession, CK_
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_DigestEncryptUpdate, CALL_ORIG_N_FLUSH(C_DigestEncryptUpdate, hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, (hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1826,7 +2044,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DigestEncryptUpdate)(CK_SESSION_HANDLE hSession, CK_
         pkcs11_logger_log(" *pulEncryptedPartLen: %lu", *pulEncryptedPartLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_DigestEncryptUpdate(hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen);
+    rv = CALL_ORIG_N_FLUSH(C_DigestEncryptUpdate, hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, (hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1851,6 +2069,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DecryptDigestUpdate)(CK_SESSION_HANDLE hSession, CK_
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_DecryptDigestUpdate, CALL_ORIG_N_FLUSH(C_DecryptDigestUpdate, hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, (hSession, pEncryptedPart, ulEncryptedPartLen, pPart, pulPartLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1864,7 +2083,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DecryptDigestUpdate)(CK_SESSION_HANDLE hSession, CK_
         pkcs11_logger_log(" *pulPartLen: %lu", *pulPartLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_DecryptDigestUpdate(hSession, pEncryptedPart, ulEncryptedPartLen, pPart, pulPartLen);
+    rv = CALL_ORIG_N_FLUSH(C_DecryptDigestUpdate, hSession, PKCS11_LOGGER_POOL_STATE_DIGEST, (hSession, pEncryptedPart, ulEncryptedPartLen, pPart, pulPartLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1889,6 +2108,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SignEncryptUpdate)(CK_SESSION_HANDLE hSession, CK_BY
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_SignEncryptUpdate, CALL_ORIG_N_FLUSH(C_SignEncryptUpdate, hSession, PKCS11_LOGGER_POOL_STATE_SIGN, (hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1902,7 +2122,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SignEncryptUpdate)(CK_SESSION_HANDLE hSession, CK_BY
         pkcs11_logger_log(" *pulEncryptedPartLen: %lu", *pulEncryptedPartLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_SignEncryptUpdate(hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen);
+    rv = CALL_ORIG_N_FLUSH(C_SignEncryptUpdate, hSession, PKCS11_LOGGER_POOL_STATE_SIGN, (hSession, pPart, ulPartLen, pEncryptedPart, pulEncryptedPartLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1927,6 +2147,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DecryptVerifyUpdate)(CK_SESSION_HANDLE hSession, CK_
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_DecryptVerifyUpdate, CALL_ORIG_N_FLUSH(C_DecryptVerifyUpdate, hSession, PKCS11_LOGGER_POOL_STATE_VERIFY, (hSession, pEncryptedPart, ulEncryptedPartLen, pPart, pulPartLen)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1940,7 +2161,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DecryptVerifyUpdate)(CK_SESSION_HANDLE hSession, CK_
         pkcs11_logger_log(" *pulPartLen: %lu", *pulPartLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_DecryptVerifyUpdate(hSession, pEncryptedPart, ulEncryptedPartLen, pPart, pulPartLen);
+    rv = CALL_ORIG_N_FLUSH(C_DecryptVerifyUpdate, hSession, PKCS11_LOGGER_POOL_STATE_VERIFY, (hSession, pEncryptedPart, ulEncryptedPartLen, pPart, pulPartLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -1965,6 +2186,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_GenerateKey)(CK_SESSION_HANDLE hSession, CK_MECHANIS
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_GenerateKey, CALL_ORIG_N_CREATE(C_GenerateKey, hSession, (hSession, pMechanism, pTemplate, ulCount, phKey)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -1985,7 +2207,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_GenerateKey)(CK_SESSION_HANDLE hSession, CK_MECHANIS
         pkcs11_logger_log(" *phKey: %lu", *phKey);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GenerateKey(hSession, pMechanism, pTemplate, ulCount, phKey);
+    rv = CALL_ORIG_N_CREATE(C_GenerateKey, hSession, (hSession, pMechanism, pTemplate, ulCount, phKey));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -2007,6 +2229,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_GenerateKeyPair)(CK_SESSION_HANDLE hSession, CK_MECH
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_GenerateKeyPair, CALL_ORIG_N_CREATE(C_GenerateKeyPair, hSession, (hSession, pMechanism, pPublicKeyTemplate, ulPublicKeyAttributeCount, pPrivateKeyTemplate, ulPrivateKeyAttributeCount, phPublicKey, phPrivateKey)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -2033,7 +2256,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_GenerateKeyPair)(CK_SESSION_HANDLE hSession, CK_MECH
         pkcs11_logger_log(" *phPrivateKey: %lu", *phPrivateKey);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GenerateKeyPair(hSession, pMechanism, pPublicKeyTemplate, ulPublicKeyAttributeCount, pPrivateKeyTemplate, ulPrivateKeyAttributeCount, phPublicKey, phPrivateKey);
+    rv = CALL_ORIG_N_CREATE(C_GenerateKeyPair, hSession, (hSession, pMechanism, pPublicKeyTemplate, ulPublicKeyAttributeCount, pPrivateKeyTemplate, ulPrivateKeyAttributeCount, phPublicKey, phPrivateKey));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -2058,6 +2281,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_WrapKey)(CK_SESSION_HANDLE hSession, CK_MECHANISM_PT
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_ORIG_IF_LOGGING_DISABLED(C_WrapKey, (hSession, pMechanism, hWrappingKey, hKey, pWrappedKey, pulWrappedKeyLen));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -2077,7 +2301,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_WrapKey)(CK_SESSION_HANDLE hSession, CK_MECHANISM_PT
         pkcs11_logger_log(" *pulWrappedKeyLen: %lu", *pulWrappedKeyLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_WrapKey(hSession, pMechanism, hWrappingKey, hKey, pWrappedKey, pulWrappedKeyLen);
+    rv = CALL_ORIG(C_WrapKey, (hSession, pMechanism, hWrappingKey, hKey, pWrappedKey, pulWrappedKeyLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -2102,6 +2326,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_UnwrapKey)(CK_SESSION_HANDLE hSession, CK_MECHANISM_
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_UnwrapKey, CALL_ORIG_N_CREATE(C_UnwrapKey, hSession, (hSession, pMechanism, hUnwrappingKey, pWrappedKey, ulWrappedKeyLen, pTemplate, ulAttributeCount, phKey)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -2126,7 +2351,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_UnwrapKey)(CK_SESSION_HANDLE hSession, CK_MECHANISM_
         pkcs11_logger_log(" *phKey: %lu", *phKey);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_UnwrapKey(hSession, pMechanism, hUnwrappingKey, pWrappedKey, ulWrappedKeyLen, pTemplate, ulAttributeCount, phKey);
+    rv = CALL_ORIG_N_CREATE(C_UnwrapKey, hSession, (hSession, pMechanism, hUnwrappingKey, pWrappedKey, ulWrappedKeyLen, pTemplate, ulAttributeCount, phKey));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -2148,6 +2373,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DeriveKey)(CK_SESSION_HANDLE hSession, CK_MECHANISM_
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_DeriveKey, CALL_ORIG_N_CREATE(C_DeriveKey, hSession, (hSession, pMechanism, hBaseKey, pTemplate, ulAttributeCount, phKey)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -2169,7 +2395,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_DeriveKey)(CK_SESSION_HANDLE hSession, CK_MECHANISM_
         pkcs11_logger_log(" *phKey: %lu", *phKey);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_DeriveKey(hSession, pMechanism, hBaseKey, pTemplate, ulAttributeCount, phKey);
+    rv = CALL_ORIG_N_CREATE(C_DeriveKey, hSession, (hSession, pMechanism, hBaseKey, pTemplate, ulAttributeCount, phKey));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -2191,6 +2417,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SeedRandom)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_ORIG_IF_LOGGING_DISABLED(C_SeedRandom, (hSession, pSeed, ulSeedLen));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -2200,7 +2427,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_SeedRandom)(CK_SESSION_HANDLE hSession, CK_BYTE_PTR
     pkcs11_logger_log(" ulSeedLen: %lu",  ulSeedLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_SeedRandom(hSession, pSeed, ulSeedLen);
+    rv = CALL_ORIG(C_SeedRandom, (hSession, pSeed, ulSeedLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -2213,6 +2440,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_GenerateRandom)(CK_SESSION_HANDLE hSession, CK_BYTE_
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_ORIG_IF_LOGGING_DISABLED(C_GenerateRandom, (hSession, RandomData, ulRandomLen));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -2222,7 +2450,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_GenerateRandom)(CK_SESSION_HANDLE hSession, CK_BYTE_
     pkcs11_logger_log(" ulRandomLen: %lu", ulRandomLen);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GenerateRandom(hSession, RandomData, ulRandomLen);
+    rv = CALL_ORIG(C_GenerateRandom, (hSession, RandomData, ulRandomLen));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -2244,13 +2472,14 @@ CK_DEFINE_FUNCTION(CK_RV, C_GetFunctionStatus)(CK_SESSION_HANDLE hSession)
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_ORIG_IF_LOGGING_DISABLED(C_GetFunctionStatus, (hSession));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
     pkcs11_logger_log(" hSession: %lu", hSession);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_GetFunctionStatus(hSession);
+    rv = CALL_ORIG(C_GetFunctionStatus, (hSession));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -2263,13 +2492,14 @@ CK_DEFINE_FUNCTION(CK_RV, C_CancelFunction)(CK_SESSION_HANDLE hSession)
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_ORIG_IF_LOGGING_DISABLED(C_CancelFunction, (hSession));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
     pkcs11_logger_log(" hSession: %lu", hSession);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_CancelFunction(hSession);
+    rv = CALL_ORIG(C_CancelFunction, (hSession));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     pkcs11_logger_log_function_exit(rv);
@@ -2282,6 +2512,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_WaitForSlotEvent)(CK_FLAGS flags, CK_SLOT_ID_PTR pSl
     CK_RV rv = CKR_OK;
 
     SAFELY_INIT_ORIG_LIB_OR_FAIL();
+    CALL_IF_LOGGING_DISABLED(C_WaitForSlotEvent, CALL_ORIG_N_INVALIDATE(C_WaitForSlotEvent, (flags, pSlot, pReserved)));
     pkcs11_logger_log_function_enter(__FUNCTION__);
     pkcs11_logger_log_input_params();
     
@@ -2291,7 +2522,7 @@ CK_DEFINE_FUNCTION(CK_RV, C_WaitForSlotEvent)(CK_FLAGS flags, CK_SLOT_ID_PTR pSl
     pkcs11_logger_log(" pReserved: %p", pReserved);
     
     pkcs11_logger_log_orig_function_enter(__FUNCTION__);
-    rv = pkcs11_logger_globals.orig_lib_functions->C_WaitForSlotEvent(flags, pSlot, pReserved);
+    rv = CALL_ORIG_N_INVALIDATE(C_WaitForSlotEvent, (flags, pSlot, pReserved));
     pkcs11_logger_log_orig_function_exit(__FUNCTION__);
     
     if (CKR_OK == rv)
@@ -32,6 +32,7 @@
 
 #include <windows.h>
 #include <process.h>
+#include <io.h>
 
 // PKCS#11 related stuff
 #pragma pack(push, cryptoki, 1)
@@ -63,6 +64,17 @@
 // Platform dependend type for dynamically loaded library handle
 typedef HMODULE DLHANDLE;
 
+// Platform dependend storage class for thread-local variables
+#define PKCS11_LOGGER_THREAD_LOCAL __declspec(thread)
+
+// Platform dependend atomic operations
+#define PKCS11_LOGGER_ATOMIC_LOAD(ptr) ((CK_ULONG) InterlockedCompareExchange((volatile LONG*)(ptr), 0, 0))
+#define PKCS11_LOGGER_ATOMIC_ADD(ptr, value) ((CK_ULONG) InterlockedExchangeAdd((volatile LONG*)(ptr), (LONG)(value)) + (CK_ULONG)(value))
+#define PKCS11_LOGGER_ATOMIC_SUB(ptr, value) ((CK_ULONG) InterlockedExchangeAdd((volatile LONG*)(ptr), -(LONG)(value)) - (CK_ULONG)(value))
+#define PKCS11_LOGGER_ATOMIC_XCHG(ptr, value) ((CK_ULONG) InterlockedExchange((volatile LONG*)(ptr), (LONG)(value)))
+#define PKCS11_LOGGER_ATOMIC_XCHG_PTR(ptr, value) InterlockedExchangePointer((PVOID volatile*)(ptr), (value))
+#define PKCS11_LOGGER_ATOMIC_CAS_PTR(ptr, expected, value) InterlockedCompareExchangePointer((PVOID volatile*)(ptr), (value), (expected))
+
 
 #else // #ifdef _WIN32
 
@@ -73,6 +85,16 @@ typedef HMODULE DLHANDLE;
 #include <unistd.h>
 #include <strings.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <poll.h>
+#include <syslog.h>
 
 // PKCS#11 related stuff
 #define CK_PTR *
@@ -90,10 +112,123 @@ typedef HMODULE DLHANDLE;
 // Platform dependend type for dynamically loaded library handle
 typedef void* DLHANDLE;
 
+// Platform dependend storage class for thread-local variables
+#define PKCS11_LOGGER_THREAD_LOCAL __thread
+
+// Platform dependend atomic operations
+#define PKCS11_LOGGER_ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define PKCS11_LOGGER_ATOMIC_ADD(ptr, value) __atomic_add_fetch((ptr), (value), __ATOMIC_ACQ_REL)
+#define PKCS11_LOGGER_ATOMIC_SUB(ptr, value) __atomic_sub_fetch((ptr), (value), __ATOMIC_ACQ_REL)
+#define PKCS11_LOGGER_ATOMIC_XCHG(ptr, value) __atomic_exchange_n((ptr), (value), __ATOMIC_ACQ_REL)
+#define PKCS11_LOGGER_ATOMIC_XCHG_PTR(ptr, value) __atomic_exchange_n((ptr), (value), __ATOMIC_ACQ_REL)
+#define PKCS11_LOGGER_ATOMIC_CAS_PTR(ptr, expected, value) __sync_val_compare_and_swap((ptr), (expected), (value))
+
 
 #endif // #ifdef _WIN32
 
 
+// Structure that holds formatted log record
+typedef struct PKCS11_LOGGER_RECORD
+{
+    // Next record in the list
+    struct PKCS11_LOGGER_RECORD *next;
+    // Length of the formatted record
+    size_t data_len;
+    // Formatted record (allocated together with the structure)
+    char data[1];
+}
+PKCS11_LOGGER_RECORD;
+
+
+// Function that encodes bytes into hex characters
+typedef void (*PKCS11_LOGGER_HEX_ENCODER)(const CK_BYTE *bytes, CK_ULONG length, char *output);
+
+
+// Function that computes CRC32C checksum of bytes
+typedef CK_ULONG (*PKCS11_LOGGER_CRC32C_FUNCTION)(const CK_BYTE *bytes, CK_ULONG length);
+
+
+// Function that processes one entry of the list parsed by pkcs11_logger_utils_parse_list (value is NULL for entries without equals sign)
+typedef int (*PKCS11_LOGGER_LIST_CALLBACK)(char *name, char *value, void *context);
+
+
+// Identifiers of PKCS#11 functions (in the order of CK_FUNCTION_LIST members)
+#define PKCS11_LOGGER_FUNCTION_C_Initialize 0
+#define PKCS11_LOGGER_FUNCTION_C_Finalize 1
+#define PKCS11_LOGGER_FUNCTION_C_GetInfo 2
+#define PKCS11_LOGGER_FUNCTION_C_GetFunctionList 3
+#define PKCS11_LOGGER_FUNCTION_C_GetSlotList 4
+#define PKCS11_LOGGER_FUNCTION_C_GetSlotInfo 5
+#define PKCS11_LOGGER_FUNCTION_C_GetTokenInfo 6
+#define PKCS11_LOGGER_FUNCTION_C_GetMechanismList 7
+#define PKCS11_LOGGER_FUNCTION_C_GetMechanismInfo 8
+#define PKCS11_LOGGER_FUNCTION_C_InitToken 9
+#define PKCS11_LOGGER_FUNCTION_C_InitPIN 10
+#define PKCS11_LOGGER_FUNCTION_C_SetPIN 11
+#define PKCS11_LOGGER_FUNCTION_C_OpenSession 12
+#define PKCS11_LOGGER_FUNCTION_C_CloseSession 13
+#define PKCS11_LOGGER_FUNCTION_C_CloseAllSessions 14
+#define PKCS11_LOGGER_FUNCTION_C_GetSessionInfo 15
+#define PKCS11_LOGGER_FUNCTION_C_GetOperationState 16
+#define PKCS11_LOGGER_FUNCTION_C_SetOperationState 17
+#define PKCS11_LOGGER_FUNCTION_C_Login 18
+#define PKCS11_LOGGER_FUNCTION_C_Logout 19
+#define PKCS11_LOGGER_FUNCTION_C_CreateObject 20
+#define PKCS11_LOGGER_FUNCTION_C_CopyObject 21
+#define PKCS11_LOGGER_FUNCTION_C_DestroyObject 22
+#define PKCS11_LOGGER_FUNCTION_C_GetObjectSize 23
+#define PKCS11_LOGGER_FUNCTION_C_GetAttributeValue 24
+#define PKCS11_LOGGER_FUNCTION_C_SetAttributeValue 25
+#define PKCS11_LOGGER_FUNCTION_C_FindObjectsInit 26
+#define PKCS11_LOGGER_FUNCTION_C_FindObjects 27
+#define PKCS11_LOGGER_FUNCTION_C_FindObjectsFinal 28
+#define PKCS11_LOGGER_FUNCTION_C_EncryptInit 29
+#define PKCS11_LOGGER_FUNCTION_C_Encrypt 30
+#define PKCS11_LOGGER_FUNCTION_C_EncryptUpdate 31
+#define PKCS11_LOGGER_FUNCTION_C_EncryptFinal 32
+#define PKCS11_LOGGER_FUNCTION_C_DecryptInit 33
+#define PKCS11_LOGGER_FUNCTION_C_Decrypt 34
+#define PKCS11_LOGGER_FUNCTION_C_DecryptUpdate 35
+#define PKCS11_LOGGER_FUNCTION_C_DecryptFinal 36
+#define PKCS11_LOGGER_FUNCTION_C_DigestInit 37
+#define PKCS11_LOGGER_FUNCTION_C_Digest 38
+#define PKCS11_LOGGER_FUNCTION_C_DigestUpdate 39
+#define PKCS11_LOGGER_FUNCTION_C_DigestKey 40
+#define PKCS11_LOGGER_FUNCTION_C_DigestFinal 41
+#define PKCS11_LOGGER_FUNCTION_C_SignInit 42
+#define PKCS11_LOGGER_FUNCTION_C_Sign 43
+#define PKCS11_LOGGER_FUNCTION_C_SignUpdate 44
+#define PKCS11_LOGGER_FUNCTION_C_SignFinal 45
+#define PKCS11_LOGGER_FUNCTION_C_SignRecoverInit 46
+#define PKCS11_LOGGER_FUNCTION_C_SignRecover 47
+#define PKCS11_LOGGER_FUNCTION_C_VerifyInit 48
+#define PKCS11_LOGGER_FUNCTION_C_Verify 49
+#define PKCS11_LOGGER_FUNCTION_C_VerifyUpdate 50
+#define PKCS11_LOGGER_FUNCTION_C_VerifyFinal 51
+#define PKCS11_LOGGER_FUNCTION_C_VerifyRecoverInit 52
+#define PKCS11_LOGGER_FUNCTION_C_VerifyRecover 53
+#define PKCS11_LOGGER_FUNCTION_C_DigestEncryptUpdate 54
+#define PKCS11_LOGGER_FUNCTION_C_DecryptDigestUpdate 55
+#define PKCS11_LOGGER_FUNCTION_C_SignEncryptUpdate 56
+#define PKCS11_LOGGER_FUNCTION_C_DecryptVerifyUpdate 57
+#define PKCS11_LOGGER_FUNCTION_C_GenerateKey 58
+#define PKCS11_LOGGER_FUNCTION_C_GenerateKeyPair 59
+#define PKCS11_LOGGER_FUNCTION_C_WrapKey 60
+#define PKCS11_LOGGER_FUNCTION_C_UnwrapKey 61
+#define PKCS11_LOGGER_FUNCTION_C_DeriveKey 62
+#define PKCS11_LOGGER_FUNCTION_C_SeedRandom 63
+#define PKCS11_LOGGER_FUNCTION_C_GenerateRandom 64
+#define PKCS11_LOGGER_FUNCTION_C_GetFunctionStatus 65
+#define PKCS11_LOGGER_FUNCTION_C_CancelFunction 66
+#define PKCS11_LOGGER_FUNCTION_C_WaitForSlotEvent 67
+// Number of PKCS#11 functions
+#define PKCS11_LOGGER_FUNCTION_COUNT 68
+// Size of the bitmap with one bit for each PKCS#11 function
+#define PKCS11_LOGGER_FUNCTION_BITMAP_SIZE ((PKCS11_LOGGER_FUNCTION_COUNT + 7) / 8)
+// Maximal number of mechanisms in PKCS11_LOGGER_COALESCE_MECHANISMS environment variable
+#define PKCS11_LOGGER_COALESCE_MECHANISMS_MAX 64
+
+
 // Structure that holds global variables
 typedef struct
 {
@@ -113,6 +248,130 @@ typedef struct
     CK_CHAR_PTR env_var_flags;
     // Value of PKCS11_LOGGER_FLAGS environment variable
     CK_ULONG flags;
+    // Value of PKCS11_LOGGER_QUEUE_SIZE environment variable
+    CK_CHAR_PTR env_var_queue_size;
+    // Value of PKCS11_LOGGER_QUEUE_SIZE environment variable
+    CK_ULONG queue_size;
+    // Value of PKCS11_LOGGER_QUEUE_POLICY environment variable
+    CK_CHAR_PTR env_var_queue_policy;
+    // Value of PKCS11_LOGGER_QUEUE_POLICY environment variable
+    CK_ULONG queue_policy;
+    // Value of PKCS11_LOGGER_MMAP_SEGMENT_SIZE environment variable
+    CK_CHAR_PTR env_var_mmap_segment_size;
+    // Value of PKCS11_LOGGER_MMAP_SEGMENT_SIZE environment variable
+    CK_ULONG mmap_segment_size;
+    // Value of PKCS11_LOGGER_ROTATE_SIZE environment variable
+    CK_CHAR_PTR env_var_rotate_size;
+    // Value of PKCS11_LOGGER_ROTATE_SIZE environment variable
+    CK_ULONG rotate_size;
+    // Value of PKCS11_LOGGER_ROTATE_INTERVAL environment variable
+    CK_CHAR_PTR env_var_rotate_interval;
+    // Value of PKCS11_LOGGER_ROTATE_INTERVAL environment variable
+    CK_ULONG rotate_interval;
+    // Value of PKCS11_LOGGER_ROTATE_COUNT environment variable
+    CK_CHAR_PTR env_var_rotate_count;
+    // Value of PKCS11_LOGGER_ROTATE_COUNT environment variable
+    CK_ULONG rotate_count;
+    // Value of PKCS11_LOGGER_ROTATE_COMPRESSION environment variable
+    CK_CHAR_PTR env_var_rotate_compression;
+    // Index of compression specified by PKCS11_LOGGER_ROTATE_COMPRESSION environment variable
+    CK_ULONG rotate_compression;
+    // Value of PKCS11_LOGGER_DURABILITY environment variable
+    CK_CHAR_PTR env_var_durability;
+    // Value of PKCS11_LOGGER_DURABILITY environment variable
+    CK_ULONG durability;
+    // Value of PKCS11_LOGGER_FLUSH_RECORDS environment variable
+    CK_CHAR_PTR env_var_flush_records;
+    // Value of PKCS11_LOGGER_FLUSH_RECORDS environment variable
+    CK_ULONG flush_records;
+    // Value of PKCS11_LOGGER_FLUSH_INTERVAL environment variable
+    CK_CHAR_PTR env_var_flush_interval;
+    // Value of PKCS11_LOGGER_FLUSH_INTERVAL environment variable
+    CK_ULONG flush_interval;
+    // Value of PKCS11_LOGGER_CONTROL_FILE environment variable
+    CK_CHAR_PTR env_var_control_file;
+    // Time in seconds when existence of the control file was last checked
+    CK_ULONG control_file_checked;
+    // Flag indicating whether the control file existed when it was last checked
+    CK_ULONG control_file_exists;
+    // Value of PKCS11_LOGGER_INCLUDE_FUNCTIONS environment variable
+    CK_CHAR_PTR env_var_include_functions;
+    // Value of PKCS11_LOGGER_EXCLUDE_FUNCTIONS environment variable
+    CK_CHAR_PTR env_var_exclude_functions;
+    // Bitmap of PKCS#11 functions whose calls are not logged
+    CK_BYTE skipped_functions[PKCS11_LOGGER_FUNCTION_BITMAP_SIZE];
+    // Value of PKCS11_LOGGER_STATS_INTERVAL environment variable
+    CK_CHAR_PTR env_var_stats_interval;
+    // Value of PKCS11_LOGGER_STATS_INTERVAL environment variable
+    CK_ULONG stats_interval;
+    // Value of PKCS11_LOGGER_STATS_SIGNAL environment variable
+    CK_CHAR_PTR env_var_stats_signal;
+    // Value of PKCS11_LOGGER_STATS_SIGNAL environment variable
+    CK_ULONG stats_signal;
+    // Value of PKCS11_LOGGER_TIMESTAMP environment variable
+    CK_CHAR_PTR env_var_timestamp;
+    // Value of PKCS11_LOGGER_TIMESTAMP environment variable
+    CK_ULONG timestamp;
+    // Value of PKCS11_LOGGER_SOCKET environment variable
+    CK_CHAR_PTR env_var_socket;
+    // Value of PKCS11_LOGGER_RING_FILE_PATH environment variable
+    CK_CHAR_PTR env_var_ring_file_path;
+    // Value of PKCS11_LOGGER_RING_SIZE environment variable
+    CK_CHAR_PTR env_var_ring_size;
+    // Value of PKCS11_LOGGER_RING_SIZE environment variable
+    CK_ULONG ring_size;
+    // Value of PKCS11_LOGGER_ARENA_SIZE environment variable
+    CK_CHAR_PTR env_var_arena_size;
+    // Value of PKCS11_LOGGER_ARENA_SIZE environment variable
+    CK_ULONG arena_size;
+    // Value of PKCS11_LOGGER_BYTE_ARRAY_HEAD environment variable
+    CK_CHAR_PTR env_var_byte_array_head;
+    // Value of PKCS11_LOGGER_BYTE_ARRAY_HEAD environment variable
+    CK_ULONG byte_array_head;
+    // Value of PKCS11_LOGGER_BYTE_ARRAY_TAIL environment variable
+    CK_CHAR_PTR env_var_byte_array_tail;
+    // Value of PKCS11_LOGGER_BYTE_ARRAY_TAIL environment variable
+    CK_ULONG byte_array_tail;
+    // Value of PKCS11_LOGGER_SAMPLE_RATES environment variable
+    CK_CHAR_PTR env_var_sample_rates;
+    // Number N for each PKCS#11 function whose only 1 in N calls is logged (0 or 1 when all calls are logged)
+    CK_ULONG sample_rates[PKCS11_LOGGER_FUNCTION_COUNT];
+    // Bitmap of PKCS#11 functions whose calls are sampled randomly instead of deterministically
+    CK_BYTE sample_random[PKCS11_LOGGER_FUNCTION_BITMAP_SIZE];
+    // Value of PKCS11_LOGGER_LIMIT_RECORDS environment variable
+    CK_CHAR_PTR env_var_limit_records;
+    // Value of PKCS11_LOGGER_LIMIT_RECORDS environment variable
+    CK_ULONG limit_records;
+    // Value of PKCS11_LOGGER_LIMIT_BYTES environment variable
+    CK_CHAR_PTR env_var_limit_bytes;
+    // Value of PKCS11_LOGGER_LIMIT_BYTES environment variable
+    CK_ULONG limit_bytes;
+    // Value of PKCS11_LOGGER_LIMIT_CALLS environment variable
+    CK_CHAR_PTR env_var_limit_calls;
+    // Maximal number of logged calls per second of each PKCS#11 function (0 when not limited)
+    CK_ULONG limit_calls[PKCS11_LOGGER_FUNCTION_COUNT];
+    // Value of PKCS11_LOGGER_CACHE_TTL environment variable
+    CK_CHAR_PTR env_var_cache_ttl;
+    // Value of PKCS11_LOGGER_CACHE_TTL environment variable (0 when the cache is disabled)
+    CK_ULONG cache_ttl;
+    // Value of PKCS11_LOGGER_POOL_SIZE environment variable
+    CK_CHAR_PTR env_var_pool_size;
+    // Value of PKCS11_LOGGER_POOL_SIZE environment variable (0 when the pool of sessions is disabled)
+    CK_ULONG pool_size;
+    // Value of PKCS11_LOGGER_POOL_IDLE_TIMEOUT environment variable
+    CK_CHAR_PTR env_var_pool_idle_timeout;
+    // Value of PKCS11_LOGGER_POOL_IDLE_TIMEOUT environment variable
+    CK_ULONG pool_idle_timeout;
+    // Value of PKCS11_LOGGER_COALESCE_SIZE environment variable
+    CK_CHAR_PTR env_var_coalesce_size;
+    // Value of PKCS11_LOGGER_COALESCE_SIZE environment variable (0 when coalescing of updates is disabled)
+    CK_ULONG coalesce_size;
+    // Value of PKCS11_LOGGER_COALESCE_MECHANISMS environment variable
+    CK_CHAR_PTR env_var_coalesce_mechanisms;
+    // Mechanisms whose updates are coalesced when PKCS11_LOGGER_COALESCE_MECHANISMS environment variable is set
+    CK_MECHANISM_TYPE coalesce_mechanisms[PKCS11_LOGGER_COALESCE_MECHANISMS_MAX];
+    // Number of mechanisms in coalesce_mechanisms
+    CK_ULONG coalesce_mechanisms_count;
     // Handle to log file
     FILE *log_file_handle;
 }
@@ -125,6 +384,68 @@ PKCS11_LOGGER_GLOBALS;
 #define PKCS11_LOGGER_LOG_FILE_PATH "PKCS11_LOGGER_LOG_FILE_PATH"
 // Environment variable that specifies pkcs11-logger flags
 #define PKCS11_LOGGER_FLAGS "PKCS11_LOGGER_FLAGS"
+// Environment variable that specifies maximal number of records in asynchronous log queue
+#define PKCS11_LOGGER_QUEUE_SIZE "PKCS11_LOGGER_QUEUE_SIZE"
+// Environment variable that specifies behavior of full asynchronous log queue
+#define PKCS11_LOGGER_QUEUE_POLICY "PKCS11_LOGGER_QUEUE_POLICY"
+// Environment variable that specifies size of memory mapped log file segment
+#define PKCS11_LOGGER_MMAP_SEGMENT_SIZE "PKCS11_LOGGER_MMAP_SEGMENT_SIZE"
+// Environment variable that specifies size of the log file that triggers rotation
+#define PKCS11_LOGGER_ROTATE_SIZE "PKCS11_LOGGER_ROTATE_SIZE"
+// Environment variable that specifies number of seconds after which the log file is rotated
+#define PKCS11_LOGGER_ROTATE_INTERVAL "PKCS11_LOGGER_ROTATE_INTERVAL"
+// Environment variable that specifies number of retained rotated log files
+#define PKCS11_LOGGER_ROTATE_COUNT "PKCS11_LOGGER_ROTATE_COUNT"
+// Environment variable that specifies compression of rotated log files
+#define PKCS11_LOGGER_ROTATE_COMPRESSION "PKCS11_LOGGER_ROTATE_COMPRESSION"
+// Environment variable that specifies when are the logged messages flushed to the log file
+#define PKCS11_LOGGER_DURABILITY "PKCS11_LOGGER_DURABILITY"
+// Environment variable that specifies number of records after which the log file is flushed in batch durability mode
+#define PKCS11_LOGGER_FLUSH_RECORDS "PKCS11_LOGGER_FLUSH_RECORDS"
+// Environment variable that specifies number of milliseconds after which the log file is flushed in batch durability mode
+#define PKCS11_LOGGER_FLUSH_INTERVAL "PKCS11_LOGGER_FLUSH_INTERVAL"
+// Environment variable that specifies path to the file whose existence enables logging
+#define PKCS11_LOGGER_CONTROL_FILE "PKCS11_LOGGER_CONTROL_FILE"
+// Environment variable that specifies comma separated list of the only PKCS#11 functions that are logged
+#define PKCS11_LOGGER_INCLUDE_FUNCTIONS "PKCS11_LOGGER_INCLUDE_FUNCTIONS"
+// Environment variable that specifies comma separated list of PKCS#11 functions that are not logged
+#define PKCS11_LOGGER_EXCLUDE_FUNCTIONS "PKCS11_LOGGER_EXCLUDE_FUNCTIONS"
+// Environment variable that specifies number of seconds after which latency statistics are periodically dumped
+#define PKCS11_LOGGER_STATS_INTERVAL "PKCS11_LOGGER_STATS_INTERVAL"
+// Environment variable that specifies number of signal that requests dump of latency statistics
+#define PKCS11_LOGGER_STATS_SIGNAL "PKCS11_LOGGER_STATS_SIGNAL"
+// Environment variable that specifies clock used for timestamps of logged messages
+#define PKCS11_LOGGER_TIMESTAMP "PKCS11_LOGGER_TIMESTAMP"
+// Environment variable that specifies host and port of TCP socket that receives logged messages
+#define PKCS11_LOGGER_SOCKET "PKCS11_LOGGER_SOCKET"
+// Environment variable that specifies path to the file where memory ring with the most recent messages is written
+#define PKCS11_LOGGER_RING_FILE_PATH "PKCS11_LOGGER_RING_FILE_PATH"
+// Environment variable that specifies size of memory ring with the most recent messages
+#define PKCS11_LOGGER_RING_SIZE "PKCS11_LOGGER_RING_SIZE"
+// Environment variable that specifies size of the arena used by each thread for temporary strings
+#define PKCS11_LOGGER_ARENA_SIZE "PKCS11_LOGGER_ARENA_SIZE"
+// Environment variable that specifies number of leading bytes logged from truncated byte arrays
+#define PKCS11_LOGGER_BYTE_ARRAY_HEAD "PKCS11_LOGGER_BYTE_ARRAY_HEAD"
+// Environment variable that specifies number of trailing bytes logged from truncated byte arrays
+#define PKCS11_LOGGER_BYTE_ARRAY_TAIL "PKCS11_LOGGER_BYTE_ARRAY_TAIL"
+// Environment variable that specifies comma separated list of sampling rates of PKCS#11 functions or their classes
+#define PKCS11_LOGGER_SAMPLE_RATES "PKCS11_LOGGER_SAMPLE_RATES"
+// Environment variable that specifies maximal number of log records written per second
+#define PKCS11_LOGGER_LIMIT_RECORDS "PKCS11_LOGGER_LIMIT_RECORDS"
+// Environment variable that specifies maximal number of bytes of log records written per second
+#define PKCS11_LOGGER_LIMIT_BYTES "PKCS11_LOGGER_LIMIT_BYTES"
+// Environment variable that specifies comma separated list of maximal numbers of logged calls per second of PKCS#11 functions or their classes
+#define PKCS11_LOGGER_LIMIT_CALLS "PKCS11_LOGGER_LIMIT_CALLS"
+// Environment variable that specifies number of seconds for which slot, token and mechanism information is cached
+#define PKCS11_LOGGER_CACHE_TTL "PKCS11_LOGGER_CACHE_TTL"
+// Environment variable that specifies maximal number of idle sessions kept open for each slot and combination of session flags
+#define PKCS11_LOGGER_POOL_SIZE "PKCS11_LOGGER_POOL_SIZE"
+// Environment variable that specifies number of seconds for which idle sessions are kept open
+#define PKCS11_LOGGER_POOL_IDLE_TIMEOUT "PKCS11_LOGGER_POOL_IDLE_TIMEOUT"
+// Environment variable that specifies size of the buffer for updates of digest, signature and verification operations of each session
+#define PKCS11_LOGGER_COALESCE_SIZE "PKCS11_LOGGER_COALESCE_SIZE"
+// Environment variable that specifies comma separated list of mechanisms whose updates are coalesced
+#define PKCS11_LOGGER_COALESCE_MECHANISMS "PKCS11_LOGGER_COALESCE_MECHANISMS"
 
 // Flag that disables logging into the log file
 #define PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE     0x00000001
@@ -140,6 +461,133 @@ PKCS11_LOGGER_GLOBALS;
 #define PKCS11_LOGGER_FLAG_ENABLE_STDERR        0x00000020
 // Flag that enables reopening of log file
 #define PKCS11_LOGGER_FLAG_ENABLE_FCLOSE        0x00000040
+// Flag that enables logging via background writer thread
+#define PKCS11_LOGGER_FLAG_ENABLE_ASYNC         0x00000080
+// Flag that enables writing of all messages logged by one function call at once
+#define PKCS11_LOGGER_FLAG_ENABLE_CALL_RECORDS  0x00000100
+// Flag that enables logging in compact binary format
+#define PKCS11_LOGGER_FLAG_ENABLE_BINARY        0x00000200
+// Flag that enables logging into preallocated memory mapped log file segments
+#define PKCS11_LOGGER_FLAG_ENABLE_MMAP          0x00000400
+// Flag that enables collection of latency statistics of original library
+#define PKCS11_LOGGER_FLAG_ENABLE_STATS         0x00000800
+// Flag that enables logging to the system logger
+#define PKCS11_LOGGER_FLAG_ENABLE_SYSLOG        0x00001000
+// Flag that enables logging of CRC32C checksum instead of the omitted content of byte arrays
+#define PKCS11_LOGGER_FLAG_ENABLE_CRC32C        0x00002000
+// Flag that enables caching of immutable object attributes
+#define PKCS11_LOGGER_FLAG_ENABLE_ATTR_CACHE    0x00004000
+// Flag that enables caching of results of searches of objects
+#define PKCS11_LOGGER_FLAG_ENABLE_FIND_CACHE    0x00008000
+
+// Size of the buffer used by each thread for formatting of log records
+#define PKCS11_LOGGER_LOG_BUFFER_SIZE 4096
+// Number of attempts to take the lock without blocking before the thread waits for its records to be written
+#define PKCS11_LOGGER_LOG_SPIN_COUNT 64
+// Default maximal number of records in asynchronous log queue
+#define PKCS11_LOGGER_QUEUE_SIZE_DEFAULT 4096
+// Full asynchronous log queue blocks the calling thread
+#define PKCS11_LOGGER_QUEUE_POLICY_BLOCK 0
+// Full asynchronous log queue drops new records and counts them
+#define PKCS11_LOGGER_QUEUE_POLICY_DROP 1
+// Full asynchronous log queue is written by the calling thread
+#define PKCS11_LOGGER_QUEUE_POLICY_SPILL 2
+// Default size of memory mapped log file segment
+#define PKCS11_LOGGER_MMAP_SEGMENT_SIZE_DEFAULT 67108864
+// Log file is flushed after every write
+#define PKCS11_LOGGER_DURABILITY_LINE 0
+// Log file is flushed only when the buffer is full or the file is closed
+#define PKCS11_LOGGER_DURABILITY_NONE 1
+// Log file is flushed after the specified number of records or milliseconds
+#define PKCS11_LOGGER_DURABILITY_BATCH 2
+// Log file is flushed when PKCS#11 function returns
+#define PKCS11_LOGGER_DURABILITY_EXIT 3
+// Log file is flushed and synchronized with the disk when PKCS#11 function returns
+#define PKCS11_LOGGER_DURABILITY_SYNC 4
+// Default number of records after which the log file is flushed in batch durability mode
+#define PKCS11_LOGGER_FLUSH_RECORDS_DEFAULT 256
+// Default number of milliseconds after which the log file is flushed in batch durability mode
+#define PKCS11_LOGGER_FLUSH_INTERVAL_DEFAULT 1000
+// Number of bits that select linear sub-bucket within each power of two in latency histogram
+#define PKCS11_LOGGER_STATS_SUB_BUCKET_BITS 3
+// Number of linear sub-buckets within each power of two in latency histogram
+#define PKCS11_LOGGER_STATS_SUB_BUCKETS (1 << PKCS11_LOGGER_STATS_SUB_BUCKET_BITS)
+// Number of buckets in latency histogram covering all 64-bit latencies
+#define PKCS11_LOGGER_STATS_BUCKETS ((64 - PKCS11_LOGGER_STATS_SUB_BUCKET_BITS + 1) * PKCS11_LOGGER_STATS_SUB_BUCKETS)
+// Number of CK_RV values with separate latency histogram for each function and thread
+#define PKCS11_LOGGER_STATS_RV_SLOTS 4
+// Number of CK_RV values with separate latency histogram for each function in the dump
+#define PKCS11_LOGGER_STATS_MERGED_SLOTS 16
+// Timestamps contain precise local time
+#define PKCS11_LOGGER_TIMESTAMP_REALTIME 0
+// Timestamps contain local time read from the faster clock with lower resolution
+#define PKCS11_LOGGER_TIMESTAMP_COARSE 1
+// Timestamps contain seconds and nanoseconds of monotonic clock
+#define PKCS11_LOGGER_TIMESTAMP_MONOTONIC 2
+// Size of the buffer for timestamp including terminating zero
+#define PKCS11_LOGGER_TIME_STR_SIZE 27
+// Length of "YYYY-MM-DD HH:MM:" prefix of timestamp cached by each thread
+#define PKCS11_LOGGER_TIME_PREFIX_LEN 17
+// Size of the buffer for "process ID : thread ID : " prefix of logged messages cached by each thread
+#define PKCS11_LOGGER_IDS_PREFIX_SIZE 48
+// Default size of memory ring with the most recent messages
+#define PKCS11_LOGGER_RING_SIZE_DEFAULT 1048576
+// Default size of the arena used by each thread for temporary strings
+#define PKCS11_LOGGER_ARENA_SIZE_DEFAULT 65536
+// Alignment of memory allocated from the arena
+#define PKCS11_LOGGER_ARENA_ALIGNMENT 16
+// Default number of seconds for which idle sessions are kept open
+#define PKCS11_LOGGER_POOL_IDLE_TIMEOUT_DEFAULT 60
+
+// State of the session with a find operation that might be active
+#define PKCS11_LOGGER_POOL_STATE_FIND           0x00000001
+// State of the session with an encryption operation that might be active
+#define PKCS11_LOGGER_POOL_STATE_ENCRYPT        0x00000002
+// State of the session with a decryption operation that might be active
+#define PKCS11_LOGGER_POOL_STATE_DECRYPT        0x00000004
+// State of the session with a digest operation that might be active
+#define PKCS11_LOGGER_POOL_STATE_DIGEST         0x00000008
+// State of the session with a signature operation that might be active
+#define PKCS11_LOGGER_POOL_STATE_SIGN           0x00000010
+// State of the session with a signature operation with data recovery that might be active
+#define PKCS11_LOGGER_POOL_STATE_SIGN_RECOVER   0x00000020
+// State of the session with a verification operation that might be active
+#define PKCS11_LOGGER_POOL_STATE_VERIFY         0x00000040
+// State of the session with a verification operation with data recovery that might be active
+#define PKCS11_LOGGER_POOL_STATE_VERIFY_RECOVER 0x00000080
+// State of the session that might own session objects
+#define PKCS11_LOGGER_POOL_STATE_OBJECTS        0x00000100
+// State of the session with restored operation state
+#define PKCS11_LOGGER_POOL_STATE_RESTORED       0x00000200
+// State of the session with notification callback
+#define PKCS11_LOGGER_POOL_STATE_NOTIFY         0x00000400
+// States of the session with operations whose updates can be coalesced because they produce no output
+#define PKCS11_LOGGER_COALESCE_STATES (PKCS11_LOGGER_POOL_STATE_DIGEST | PKCS11_LOGGER_POOL_STATE_SIGN | PKCS11_LOGGER_POOL_STATE_VERIFY)
+
+// Magic value at the beginning of binary log file (including terminating zero)
+#define PKCS11_LOGGER_BINARY_MAGIC "PKCS11LOGGERBIN"
+// Version of binary log file format
+#define PKCS11_LOGGER_BINARY_VERSION 1
+// Value that allows detection of byte order used in binary log file
+#define PKCS11_LOGGER_BINARY_BYTE_ORDER 0x01020304
+// Size of common header of each entry in binary log file
+#define PKCS11_LOGGER_BINARY_ENTRY_HEADER_SIZE 8
+// Binary log entry that defines string referenced by messages of one process
+#define PKCS11_LOGGER_BINARY_ENTRY_STRING 1
+// Binary log entry that holds one message
+#define PKCS11_LOGGER_BINARY_ENTRY_MESSAGE 2
+// Binary log entry that pairs system time with monotonic clock
+#define PKCS11_LOGGER_BINARY_ENTRY_CLOCK 3
+// Binary log message should be displayed with process ID
+#define PKCS11_LOGGER_BINARY_FLAG_PROCESS_ID 0x01
+// Binary log message should be displayed with thread ID
+#define PKCS11_LOGGER_BINARY_FLAG_THREAD_ID 0x02
+// Binary log message holds timestamp
+#define PKCS11_LOGGER_BINARY_FLAG_TIMESTAMP 0x04
+// Conversion that stores byte array (CK_BYTE_PTR and CK_ULONG arguments) without translation in binary log
+#define PKCS11_LOGGER_BINARY_CONVERSION_BYTES 'B'
+// Number of strings remembered as already written into binary log file
+#define PKCS11_LOGGER_BINARY_STRINGS_SIZE 2048
 
 // Library name
 #define PKCS11_LOGGER_NAME "PKCS11-LOGGER"
@@ -157,14 +605,96 @@ PKCS11_LOGGER_GLOBALS;
 #define CALL_N_CLEAR(function, pointer) if (NULL != pointer) { function(pointer); pointer = NULL; }
 // Macro for safe initialization of original PKCS#11 library
 #define SAFELY_INIT_ORIG_LIB_OR_FAIL() if (pkcs11_logger_init_orig_lib() != PKCS11_LOGGER_RV_SUCCESS) return CKR_GENERAL_ERROR;
+// Macro that checks whether calls of PKCS#11 function with the specified identifier are not logged
+#define PKCS11_LOGGER_FUNCTION_IS_SKIPPED(id) (0 != (pkcs11_logger_globals.skipped_functions[(id) / 8] & (1 << ((id) % 8))))
+// Macro that checks whether the call of sampled PKCS#11 function with the specified identifier is not logged
+#define PKCS11_LOGGER_FUNCTION_IS_SAMPLED_OUT(id) ((pkcs11_logger_globals.sample_rates[(id)] > 1) && (CK_TRUE != pkcs11_logger_sample_call(id)))
+// Macro that checks whether the call of PKCS#11 function with the specified identifier exceeds the limit of its logged calls per second
+#define PKCS11_LOGGER_FUNCTION_IS_RATE_LIMITED(id) ((0 != pkcs11_logger_globals.limit_calls[(id)]) && (CK_TRUE != pkcs11_logger_limit_call(id)))
+// Macro that calls original function and measures its latency when statistics are enabled
+#define CALL_ORIG(function, args) ((PKCS11_LOGGER_FLAG_ENABLE_STATS != (pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_STATS)) ? pkcs11_logger_globals.orig_lib_functions->function args : (pkcs11_logger_stats_begin(), pkcs11_logger_stats_end(PKCS11_LOGGER_FUNCTION_##function, pkcs11_logger_globals.orig_lib_functions->function args)))
+// Macro that calls original function and invalidates cached slot, token and mechanism information that might have been changed by the call
+#define CALL_ORIG_N_INVALIDATE(function, args) pkcs11_logger_cache_invalidate(CALL_ORIG(function, args))
+// Macro that calls original function and invalidates cached searches of objects in the slot of the session that might have been changed by the call
+#define CALL_ORIG_N_INVALIDATE_SEARCHES(function, hSession, args) pkcs11_logger_cache_invalidate_searches(hSession, CALL_ORIG(function, args))
+// Macro that calls original function which creates objects and updates the caches and the pool of sessions
+#define CALL_ORIG_N_CREATE(function, hSession, args) pkcs11_logger_pool_start(hSession, PKCS11_LOGGER_POOL_STATE_OBJECTS, CALL_ORIG_N_INVALIDATE_SEARCHES(function, hSession, args))
+// Macro that calls original function which starts an operation or changes the state of the session that prevents its return to the pool
+#define CALL_ORIG_N_START(function, hSession, state, args) pkcs11_logger_pool_start(hSession, state, CALL_ORIG(function, args))
+// Macro that calls original function which initializes an operation whose updates are coalesced when its mechanism allows it
+#define CALL_ORIG_N_COALESCE(function, hSession, state, pMechanism, args) pkcs11_logger_coalesce_start(hSession, state, pMechanism, CALL_ORIG_N_START(function, hSession, state, args))
+// Macro that calls original function after buffered updates of the operations have been passed to the original library
+#define CALL_ORIG_N_FLUSH(function, hSession, state, args) ((CKR_OK == pkcs11_logger_coalesce_flush(hSession, state)) ? CALL_ORIG(function, args) : pkcs11_logger_coalesce_error(hSession))
+// Macro that calls original function which finishes an operation when it succeeds with the specified condition
+#define CALL_ORIG_N_FINISH(function, hSession, state, condition, args) pkcs11_logger_pool_finish(hSession, state, condition, pkcs11_logger_coalesce_finish(hSession, state, condition, CALL_ORIG_N_FLUSH(function, hSession, state, args)))
+// Macro that returns result of the call without any logging when calls of PKCS#11 function are not logged or logged messages would not reach any output
+#define CALL_IF_LOGGING_DISABLED(function, call) if (PKCS11_LOGGER_FUNCTION_IS_SKIPPED(PKCS11_LOGGER_FUNCTION_##function) || (CK_TRUE != pkcs11_logger_log_is_enabled()) || PKCS11_LOGGER_FUNCTION_IS_SAMPLED_OUT(PKCS11_LOGGER_FUNCTION_##function) || PKCS11_LOGGER_FUNCTION_IS_RATE_LIMITED(PKCS11_LOGGER_FUNCTION_##function)) return (call);
+// Macro that calls original function without any logging when its calls are not logged or logged messages would not reach any output
+#define CALL_ORIG_IF_LOGGING_DISABLED(function, args) CALL_IF_LOGGING_DISABLED(function, CALL_ORIG(function, args))
 // Macro that removes unused argument warning
 #define IGNORE_ARG(P) (void)(P)
 
+// arena.c - declaration of functions
+int pkcs11_logger_arena_start(void);
+void* pkcs11_logger_arena_alloc(size_t size);
+void pkcs11_logger_arena_reset(void);
+void pkcs11_logger_arena_release(void);
+void pkcs11_logger_arena_dump(const char *reason);
+void pkcs11_logger_arena_stop(void);
+
+// binary.c - declaration of functions
+PKCS11_LOGGER_RECORD* pkcs11_logger_binary_create_record(CK_BBOOL timestamp, const char* message, va_list ap);
+void pkcs11_logger_binary_open_file(FILE *file);
+void pkcs11_logger_binary_write_records(FILE *file, PKCS11_LOGGER_RECORD *records);
+
+// cache.c - declaration of functions
+CK_RV pkcs11_logger_cache_get_slot_list(CK_BBOOL tokenPresent, CK_SLOT_ID_PTR pSlotList, CK_ULONG_PTR pulCount, CK_BBOOL *cached);
+CK_RV pkcs11_logger_cache_get_slot_info(CK_SLOT_ID slotID, CK_SLOT_INFO_PTR pInfo, CK_BBOOL *cached);
+CK_RV pkcs11_logger_cache_get_token_info(CK_SLOT_ID slotID, CK_TOKEN_INFO_PTR pInfo, CK_BBOOL *cached);
+CK_RV pkcs11_logger_cache_get_mechanism_list(CK_SLOT_ID slotID, CK_MECHANISM_TYPE_PTR pMechanismList, CK_ULONG_PTR pulCount, CK_BBOOL *cached);
+CK_RV pkcs11_logger_cache_get_mechanism_info(CK_SLOT_ID slotID, CK_MECHANISM_TYPE type, CK_MECHANISM_INFO_PTR pInfo, CK_BBOOL *cached);
+CK_RV pkcs11_logger_cache_open_session(CK_SLOT_ID slotID, CK_FLAGS flags, CK_VOID_PTR pApplication, CK_NOTIFY Notify, CK_SESSION_HANDLE_PTR phSession);
+CK_RV pkcs11_logger_cache_close_session(CK_SESSION_HANDLE hSession);
+CK_RV pkcs11_logger_cache_close_all_sessions(CK_SLOT_ID slotID);
+CK_RV pkcs11_logger_cache_get_attribute_value(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, CK_BBOOL *cached);
+CK_RV pkcs11_logger_cache_set_attribute_value(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount);
+CK_RV pkcs11_logger_cache_destroy_object(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE hObject);
+CK_RV pkcs11_logger_cache_find_objects_init(CK_SESSION_HANDLE hSession, CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount, CK_BBOOL *cached);
+CK_RV pkcs11_logger_cache_find_objects(CK_SESSION_HANDLE hSession, CK_OBJECT_HANDLE_PTR phObject, CK_ULONG ulMaxObjectCount, CK_ULONG_PTR pulObjectCount, CK_BBOOL *cached);
+CK_RV pkcs11_logger_cache_find_objects_final(CK_SESSION_HANDLE hSession, CK_BBOOL *cached);
+CK_RV pkcs11_logger_cache_finalize(CK_VOID_PTR pReserved);
+CK_RV pkcs11_logger_cache_invalidate(CK_RV rv);
+CK_RV pkcs11_logger_cache_invalidate_searches(CK_SESSION_HANDLE hSession, CK_RV rv);
+void pkcs11_logger_cache_dump(const char *reason);
+void pkcs11_logger_cache_stop(void);
+
+// coalesce.c - declaration of functions
+int pkcs11_logger_coalesce_parse_mechanisms(const char *list);
+CK_RV pkcs11_logger_coalesce_open_session(CK_SLOT_ID slotID, CK_FLAGS flags, CK_VOID_PTR pApplication, CK_NOTIFY Notify, CK_SESSION_HANDLE_PTR phSession, CK_BBOOL *pooled);
+CK_RV pkcs11_logger_coalesce_close_session(CK_SESSION_HANDLE hSession, CK_BBOOL *pooled, CK_ULONG_PTR pulUpdates, CK_ULONG_PTR pulCalls);
+CK_RV pkcs11_logger_coalesce_close_all_sessions(CK_SLOT_ID slotID);
+CK_RV pkcs11_logger_coalesce_finalize(CK_VOID_PTR pReserved);
+CK_RV pkcs11_logger_coalesce_start(CK_SESSION_HANDLE hSession, CK_ULONG state, CK_MECHANISM_PTR pMechanism, CK_RV rv);
+CK_RV pkcs11_logger_coalesce_update(CK_SESSION_HANDLE hSession, CK_ULONG state, CK_BYTE_PTR pPart, CK_ULONG ulPartLen, CK_BBOOL *buffered);
+CK_RV pkcs11_logger_coalesce_flush(CK_SESSION_HANDLE hSession, CK_ULONG state);
+CK_RV pkcs11_logger_coalesce_error(CK_SESSION_HANDLE hSession);
+CK_RV pkcs11_logger_coalesce_finish(CK_SESSION_HANDLE hSession, CK_ULONG state, CK_BBOOL condition, CK_RV rv);
+void pkcs11_logger_coalesce_dump(const char *reason);
+void pkcs11_logger_coalesce_stop(void);
+
+// crc32c.c - declaration of functions
+CK_ULONG pkcs11_logger_crc32c_compute(const CK_BYTE *bytes, CK_ULONG length);
+const char* pkcs11_logger_crc32c_get_implementation(CK_ULONG index, PKCS11_LOGGER_CRC32C_FUNCTION *function);
+
 // dl.c - declaration of functions
 DLHANDLE pkcs11_logger_dl_open(const char* library);
 void* pkcs11_logger_dl_sym(DLHANDLE library, const char* function);
 int pkcs11_logger_dl_close(DLHANDLE library);
 
+// hex.c - declaration of functions
+void pkcs11_logger_hex_encode(const CK_BYTE *bytes, CK_ULONG length, char *output);
+const char* pkcs11_logger_hex_get_implementation(CK_ULONG index, PKCS11_LOGGER_HEX_ENCODER *encoder);
+
 // init.c - declaration of functions
 #ifdef _WIN32
 BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserved);
@@ -176,10 +706,19 @@ void pkcs11_logger_init_globals(void);
 int pkcs11_logger_init_orig_lib(void);
 int pkcs11_logger_init_parse_env_vars(void);
 CK_CHAR_PTR pkcs11_logger_init_read_env_var(const char *env_var_name);
+int pkcs11_logger_init_parse_function_list(const char *list, CK_BBOOL skipped);
+
+// limit.c - declaration of functions
+CK_BBOOL pkcs11_logger_limit_record(size_t len);
+CK_BBOOL pkcs11_logger_limit_call(CK_ULONG function);
+int pkcs11_logger_limit_parse_calls(const char *list);
+PKCS11_LOGGER_RECORD* pkcs11_logger_limit_create_notices(void);
+void pkcs11_logger_limit_stop(void);
 
 // lock.c - declaration of functions
 int pkcs11_logger_lock_create(void);
 void pkcs11_logger_lock_acquire(void);
+int pkcs11_logger_lock_try_acquire(void);
 void pkcs11_logger_lock_release(void);
 void pkcs11_logger_lock_destroy(void);
 
@@ -197,18 +736,87 @@ void pkcs11_logger_log_flag(CK_ULONG flags, CK_ULONG flag_value, const char *fla
 void pkcs11_logger_log_nonzero_string(const char *name, const CK_UTF8CHAR_PTR nonzero_string, CK_ULONG nonzero_string_len);
 void pkcs11_logger_log_byte_array(const char *name, CK_BYTE_PTR byte_array, CK_ULONG byte_array_len);
 void pkcs11_logger_log_attribute_template(CK_ATTRIBUTE_PTR pTemplate, CK_ULONG ulCount);
+PKCS11_LOGGER_RECORD* pkcs11_logger_log_create_record(const char *time_string, const char* message, va_list ap);
+PKCS11_LOGGER_RECORD* pkcs11_logger_log_create_record_va(const char* message, ...);
+void pkcs11_logger_log_write_records(PKCS11_LOGGER_RECORD *records);
+void pkcs11_logger_log_flush(CK_BBOOL sync);
+CK_BBOOL pkcs11_logger_log_has_output(void);
+CK_BBOOL pkcs11_logger_log_is_enabled(void);
+
+// mmap.c - declaration of functions
+int pkcs11_logger_mmap_write(const char *data, size_t len);
+void pkcs11_logger_mmap_sync(void);
+void pkcs11_logger_mmap_stop(void);
+
+// pool.c - declaration of functions
+CK_RV pkcs11_logger_pool_open_session(CK_SLOT_ID slotID, CK_FLAGS flags, CK_VOID_PTR pApplication, CK_NOTIFY Notify, CK_SESSION_HANDLE_PTR phSession, CK_BBOOL *pooled);
+CK_RV pkcs11_logger_pool_close_session(CK_SESSION_HANDLE hSession, CK_BBOOL *pooled);
+CK_RV pkcs11_logger_pool_close_all_sessions(CK_SLOT_ID slotID);
+CK_RV pkcs11_logger_pool_login(CK_SESSION_HANDLE hSession, CK_USER_TYPE userType, CK_UTF8CHAR_PTR pPin, CK_ULONG ulPinLen);
+CK_RV pkcs11_logger_pool_finalize(CK_VOID_PTR pReserved);
+CK_RV pkcs11_logger_pool_start(CK_SESSION_HANDLE hSession, CK_ULONG state, CK_RV rv);
+CK_RV pkcs11_logger_pool_finish(CK_SESSION_HANDLE hSession, CK_ULONG state, CK_BBOOL condition, CK_RV rv);
+void pkcs11_logger_pool_dump(const char *reason);
+void pkcs11_logger_pool_stop(void);
+
+// queue.c - declaration of functions
+int pkcs11_logger_queue_start(void);
+CK_BBOOL pkcs11_logger_queue_is_running(void);
+int pkcs11_logger_queue_push(PKCS11_LOGGER_RECORD *record);
+void pkcs11_logger_queue_flush(void);
+void pkcs11_logger_queue_stop(CK_BBOOL join);
+
+// rotate.c - declaration of functions
+int pkcs11_logger_rotate_find_compressor(const char *name, CK_ULONG *index);
+void pkcs11_logger_rotate_check(void);
+void pkcs11_logger_rotate_stop(CK_BBOOL join);
+
+// sample.c - declaration of functions
+int pkcs11_logger_sample_parse_rates(const char *list);
+CK_BBOOL pkcs11_logger_sample_call(CK_ULONG function);
+void pkcs11_logger_sample_dump(const char *reason);
+void pkcs11_logger_sample_stop(void);
+
+// sink.c - declaration of functions
+int pkcs11_logger_sink_start(void);
+CK_BBOOL pkcs11_logger_sink_has_output(void);
+void pkcs11_logger_sink_write(const char *data, size_t len);
+void pkcs11_logger_sink_flush(void);
+void pkcs11_logger_sink_dump(void);
+void pkcs11_logger_sink_stop(void);
+
+// stats.c - declaration of functions
+int pkcs11_logger_stats_start(void);
+void pkcs11_logger_stats_begin(void);
+CK_RV pkcs11_logger_stats_end(CK_ULONG function, CK_RV rv);
+void pkcs11_logger_stats_release(void);
+void pkcs11_logger_stats_dump(const char *reason);
+void pkcs11_logger_stats_stop(void);
 
 // translate.c - declaration of functions
 const char* pkcs11_logger_translate_ck_rv(CK_RV rv);
+int pkcs11_logger_translate_string_to_ck_rv(const char *name, CK_RV *rv);
 const char* pkcs11_logger_translate_ck_mechanism_type(CK_MECHANISM_TYPE type);
+int pkcs11_logger_translate_string_to_ck_mechanism_type(const char *name, CK_MECHANISM_TYPE *type);
 const char* pkcs11_logger_translate_ck_user_type(CK_USER_TYPE type);
 const char* pkcs11_logger_translate_ck_state(CK_STATE state);
-char* pkcs11_logger_translate_ck_byte_ptr(CK_BYTE_PTR bytes, CK_ULONG length);
+const char* pkcs11_logger_translate_function_id(CK_ULONG id);
+int pkcs11_logger_translate_string_to_function_id(const char *name, CK_ULONG *id);
+int pkcs11_logger_translate_string_to_function_set(const char *name, CK_BYTE *functions);
 const char* pkcs11_logger_translate_ck_attribute(CK_ATTRIBUTE_TYPE type);
+int pkcs11_logger_translate_string_to_ck_attribute(const char *name, CK_ATTRIBUTE_TYPE *type);
 
 // utils.c - declaration of functions
 int pkcs11_logger_utils_str_to_long(const char *str, unsigned long *val);
-void pkcs11_logger_utils_get_current_time_str(char* buff, int buff_len);
+CK_BBOOL pkcs11_logger_utils_str_equals_ignore_case(const char *str1, const char *str2);
+int pkcs11_logger_utils_parse_list(const char *list, PKCS11_LOGGER_LIST_CALLBACK callback, void *context);
+int pkcs11_logger_utils_get_current_time_str(char* buff, int buff_len);
+unsigned long long pkcs11_logger_utils_get_realtime(void);
+unsigned long long pkcs11_logger_utils_get_monotonic_time(void);
 unsigned long pkcs11_logger_utils_get_thread_id(void);
 int pkcs11_logger_utils_get_process_id(void);
+const char* pkcs11_logger_utils_get_ids_prefix(int *len);
+unsigned long pkcs11_logger_utils_get_cached_thread_id(void);
+int pkcs11_logger_utils_get_cached_process_id(void);
 CK_BBOOL pkcs11_logger_utils_path_is_absolute(const char* path);
+CK_BBOOL pkcs11_logger_utils_file_exists(const char* path);
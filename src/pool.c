@@ -0,0 +1,536 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Number of buckets of the hash table with sessions used by the application
+#define PKCS11_LOGGER_POOL_BUCKETS 256
+
+
+// Structure that holds one session opened in the original library while the pool is enabled
+typedef struct PKCS11_LOGGER_POOL_SESSION
+{
+    // Next session in the same bucket or in the list of idle sessions
+    struct PKCS11_LOGGER_POOL_SESSION *next;
+    // Handle of the session
+    CK_SESSION_HANDLE session;
+    // Slot of the session
+    CK_SLOT_ID slot;
+    // Flags the session was opened with
+    CK_FLAGS flags;
+    // Combination of PKCS11_LOGGER_POOL_STATE_* values that prevent return of the session to the pool
+    CK_ULONG state;
+    // Monotonic time in nanoseconds when the session was returned to the pool
+    unsigned long long released;
+}
+PKCS11_LOGGER_POOL_SESSION;
+
+
+// Hash table with sessions used by the application (protected by the lock)
+static PKCS11_LOGGER_POOL_SESSION *pkcs11_logger_pool_sessions[PKCS11_LOGGER_POOL_BUCKETS];
+// List of idle sessions with the most recently returned session first (protected by the lock)
+static PKCS11_LOGGER_POOL_SESSION *pkcs11_logger_pool_idle = NULL;
+// Number of calls of C_OpenSession answered with idle session from the pool
+static CK_ULONG pkcs11_logger_pool_hits = 0;
+// Number of calls of C_OpenSession passed to the original library
+static CK_ULONG pkcs11_logger_pool_misses = 0;
+// Number of sessions returned to the pool by C_CloseSession
+static CK_ULONG pkcs11_logger_pool_returned = 0;
+// Number of sessions closed by C_CloseSession because they could not be returned to the pool
+static CK_ULONG pkcs11_logger_pool_rejected = 0;
+// Number of idle sessions closed after the idle timeout or when the token could not open another session
+static CK_ULONG pkcs11_logger_pool_expired = 0;
+
+#ifdef _WIN32
+// Lock that protects sessions used by the application and idle sessions
+static SRWLOCK pkcs11_logger_pool_lock = SRWLOCK_INIT;
+#define POOL_LOCK() AcquireSRWLockExclusive(&pkcs11_logger_pool_lock)
+#define POOL_UNLOCK() ReleaseSRWLockExclusive(&pkcs11_logger_pool_lock)
+#else
+// Lock that protects sessions used by the application and idle sessions
+static pthread_mutex_t pkcs11_logger_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+#define POOL_LOCK() pthread_mutex_lock(&pkcs11_logger_pool_lock)
+#define POOL_UNLOCK() pthread_mutex_unlock(&pkcs11_logger_pool_lock)
+#endif
+
+
+// Returns session used by the application and optionally removes it from the hash table (the lock needs to be held)
+static PKCS11_LOGGER_POOL_SESSION* pkcs11_logger_pool_find(CK_SESSION_HANDLE hSession, CK_BBOOL remove)
+{
+    PKCS11_LOGGER_POOL_SESSION **link = NULL;
+    PKCS11_LOGGER_POOL_SESSION *session = NULL;
+
+    for (link = &pkcs11_logger_pool_sessions[hSession % PKCS11_LOGGER_POOL_BUCKETS]; NULL != *link; link = &((*link)->next))
+    {
+        if ((*link)->session == hSession)
+        {
+            session = *link;
+            if (CK_TRUE == remove)
+                *link = session->next;
+            return session;
+        }
+    }
+
+    return NULL;
+}
+
+
+// Adds session used by the application to the hash table (the lock needs to be held)
+static void pkcs11_logger_pool_insert(PKCS11_LOGGER_POOL_SESSION *session)
+{
+    CK_ULONG bucket = session->session % PKCS11_LOGGER_POOL_BUCKETS;
+
+    session->next = pkcs11_logger_pool_sessions[bucket];
+    pkcs11_logger_pool_sessions[bucket] = session;
+}
+
+
+// Takes idle sessions matching the condition away from the pool (the lock needs to be held)
+static PKCS11_LOGGER_POOL_SESSION* pkcs11_logger_pool_take_idle(CK_SLOT_ID slotID, CK_BBOOL read_only, unsigned long long expired)
+{
+    PKCS11_LOGGER_POOL_SESSION **link = &pkcs11_logger_pool_idle;
+    PKCS11_LOGGER_POOL_SESSION *taken = NULL;
+    PKCS11_LOGGER_POOL_SESSION *next = NULL;
+
+    while (NULL != *link)
+    {
+        // Note: Any slot is matched by CK_UNAVAILABLE_INFORMATION and expiration is checked only when the time is provided
+        if (((CK_UNAVAILABLE_INFORMATION == slotID) || ((*link)->slot == slotID)) &&
+            ((CK_TRUE != read_only) || (CKF_RW_SESSION != ((*link)->flags & CKF_RW_SESSION))) &&
+            ((0 == expired) || ((*link)->released < expired)))
+        {
+            next = (*link)->next;
+            (*link)->next = taken;
+            taken = *link;
+            *link = next;
+        }
+        else
+        {
+            link = &((*link)->next);
+        }
+    }
+
+    return taken;
+}
+
+
+// Closes sessions taken away from the pool in the original library and returns their number
+static CK_ULONG pkcs11_logger_pool_close(PKCS11_LOGGER_POOL_SESSION *sessions)
+{
+    PKCS11_LOGGER_POOL_SESSION *next = NULL;
+    CK_ULONG count = 0;
+
+    while (NULL != sessions)
+    {
+        next = sessions->next;
+        (void)pkcs11_logger_cache_close_session(sessions->session);
+        CALL_N_CLEAR(free, sessions);
+        sessions = next;
+        count++;
+    }
+
+    return count;
+}
+
+
+// Closes idle sessions that exceeded the idle timeout
+static void pkcs11_logger_pool_expire(void)
+{
+    PKCS11_LOGGER_POOL_SESSION *expired = NULL;
+    unsigned long long now = pkcs11_logger_utils_get_monotonic_time();
+    unsigned long long timeout = (unsigned long long)pkcs11_logger_globals.pool_idle_timeout * 1000000000ULL;
+
+    if (now <= timeout)
+        return;
+
+    POOL_LOCK();
+    expired = pkcs11_logger_pool_take_idle(CK_UNAVAILABLE_INFORMATION, CK_FALSE, now - timeout);
+    POOL_UNLOCK();
+
+    if (NULL != expired)
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_pool_expired, pkcs11_logger_pool_close(expired));
+}
+
+
+// Forgets sessions of the slot that are no longer open in the original library (any slot is matched by CK_UNAVAILABLE_INFORMATION)
+static void pkcs11_logger_pool_forget(CK_SLOT_ID slotID)
+{
+    PKCS11_LOGGER_POOL_SESSION **link = NULL;
+    PKCS11_LOGGER_POOL_SESSION *removed = NULL;
+    PKCS11_LOGGER_POOL_SESSION *next = NULL;
+    CK_ULONG i = 0;
+
+    POOL_LOCK();
+
+    removed = pkcs11_logger_pool_take_idle(slotID, CK_FALSE, 0);
+
+    for (i = 0; i < PKCS11_LOGGER_POOL_BUCKETS; i++)
+    {
+        link = &pkcs11_logger_pool_sessions[i];
+        while (NULL != *link)
+        {
+            if ((CK_UNAVAILABLE_INFORMATION == slotID) || ((*link)->slot == slotID))
+            {
+                next = (*link)->next;
+                (*link)->next = removed;
+                removed = *link;
+                *link = next;
+            }
+            else
+            {
+                link = &((*link)->next);
+            }
+        }
+    }
+
+    POOL_UNLOCK();
+
+    while (NULL != removed)
+    {
+        next = removed->next;
+        CALL_N_CLEAR(free, removed);
+        removed = next;
+    }
+}
+
+
+// Calls C_OpenSession or leases idle session with the same slot and flags from the pool
+CK_RV pkcs11_logger_pool_open_session(CK_SLOT_ID slotID, CK_FLAGS flags, CK_VOID_PTR pApplication, CK_NOTIFY Notify, CK_SESSION_HANDLE_PTR phSession, CK_BBOOL *pooled)
+{
+    CK_RV rv = CKR_OK;
+    PKCS11_LOGGER_POOL_SESSION **link = NULL;
+    PKCS11_LOGGER_POOL_SESSION *session = NULL;
+    PKCS11_LOGGER_POOL_SESSION *idle = NULL;
+
+    if (NULL != pooled)
+        *pooled = CK_FALSE;
+
+    if (0 == pkcs11_logger_globals.pool_size)
+        return pkcs11_logger_cache_open_session(slotID, flags, pApplication, Notify, phSession);
+
+    pkcs11_logger_pool_expire();
+
+    // Note: Notifications are delivered to the callback of the application that opened the session so such sessions are never shared
+    if ((NULL == Notify) && (NULL != phSession))
+    {
+        POOL_LOCK();
+
+        for (link = &pkcs11_logger_pool_idle; NULL != *link; link = &((*link)->next))
+        {
+            if (((*link)->slot == slotID) && ((*link)->flags == flags))
+            {
+                session = *link;
+                *link = session->next;
+                pkcs11_logger_pool_insert(session);
+                *phSession = session->session;
+                break;
+            }
+        }
+
+        POOL_UNLOCK();
+
+        if (NULL != session)
+        {
+            PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_pool_hits, 1);
+
+            if (NULL != pooled)
+                *pooled = CK_TRUE;
+
+            return CKR_OK;
+        }
+
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_pool_misses, 1);
+    }
+
+    rv = pkcs11_logger_cache_open_session(slotID, flags, pApplication, Notify, phSession);
+
+    // Note: Idle sessions count towards the limit of sessions of the token so they are closed when the limit is reached
+    if (CKR_SESSION_COUNT == rv)
+    {
+        POOL_LOCK();
+        idle = pkcs11_logger_pool_take_idle(slotID, CK_FALSE, 0);
+        POOL_UNLOCK();
+
+        if (NULL != idle)
+        {
+            PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_pool_expired, pkcs11_logger_pool_close(idle));
+            rv = pkcs11_logger_cache_open_session(slotID, flags, pApplication, Notify, phSession);
+        }
+    }
+
+    if (CKR_OK != rv)
+        return rv;
+
+    session = (PKCS11_LOGGER_POOL_SESSION*) malloc(sizeof(PKCS11_LOGGER_POOL_SESSION));
+    if (NULL == session)
+        return rv;
+
+    session->session = *phSession;
+    session->slot = slotID;
+    session->flags = flags;
+    session->state = (NULL == Notify) ? 0 : PKCS11_LOGGER_POOL_STATE_NOTIFY;
+    session->released = 0;
+
+    POOL_LOCK();
+    pkcs11_logger_pool_insert(session);
+    POOL_UNLOCK();
+
+    return rv;
+}
+
+
+// Returns the session to the pool or calls C_CloseSession when the session cannot be reused
+CK_RV pkcs11_logger_pool_close_session(CK_SESSION_HANDLE hSession, CK_BBOOL *pooled)
+{
+    CK_RV rv = CKR_OK;
+    PKCS11_LOGGER_POOL_SESSION *session = NULL;
+    PKCS11_LOGGER_POOL_SESSION *other = NULL;
+    CK_BBOOL idle = CK_FALSE;
+    CK_BBOOL last = CK_TRUE;
+    CK_ULONG count = 0;
+    CK_ULONG i = 0;
+
+    if (NULL != pooled)
+        *pooled = CK_FALSE;
+
+    if (0 == pkcs11_logger_globals.pool_size)
+        return pkcs11_logger_cache_close_session(hSession);
+
+    pkcs11_logger_pool_expire();
+
+    POOL_LOCK();
+
+    session = pkcs11_logger_pool_find(hSession, CK_TRUE);
+    if (NULL == session)
+    {
+        // Note: Idle session has already been closed by the application
+        for (other = pkcs11_logger_pool_idle; NULL != other; other = other->next)
+        {
+            if (other->session == hSession)
+                idle = CK_TRUE;
+        }
+    }
+    else
+    {
+        for (i = 0; (i < PKCS11_LOGGER_POOL_BUCKETS) && (CK_TRUE == last); i++)
+        {
+            for (other = pkcs11_logger_pool_sessions[i]; NULL != other; other = other->next)
+            {
+                if (other->slot == session->slot)
+                {
+                    last = CK_FALSE;
+                    break;
+                }
+            }
+        }
+
+        for (other = pkcs11_logger_pool_idle; NULL != other; other = other->next)
+        {
+            if ((other->slot == session->slot) && (other->flags == session->flags))
+                count++;
+        }
+    }
+
+    POOL_UNLOCK();
+
+    if (CK_TRUE == idle)
+        return CKR_SESSION_HANDLE_INVALID;
+
+    if (NULL == session)
+        return pkcs11_logger_cache_close_session(hSession);
+
+    // Note: Session with operation that might be active, session objects or full pool is closed in the original library
+    if ((0 != session->state) || (count >= pkcs11_logger_globals.pool_size))
+    {
+        rv = pkcs11_logger_cache_close_session(hSession);
+        if (CKR_OK != rv)
+        {
+            POOL_LOCK();
+            pkcs11_logger_pool_insert(session);
+            POOL_UNLOCK();
+            return rv;
+        }
+
+        CALL_N_CLEAR(free, session);
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_pool_rejected, 1);
+        return rv;
+    }
+
+    // Note: Closing of the last session of the application logs the user out so the pool does the same
+    //       (login made by another thread between the return of the last session and the logout is lost as it would be with real close)
+    if (CK_TRUE == last)
+    {
+        rv = CALL_ORIG_N_INVALIDATE(C_Logout, (hSession));
+        if ((CKR_OK != rv) && (CKR_USER_NOT_LOGGED_IN != rv))
+        {
+            (void)pkcs11_logger_pool_close(session);
+            PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_pool_rejected, 1);
+            return CKR_OK;
+        }
+    }
+
+    session->released = pkcs11_logger_utils_get_monotonic_time();
+
+    POOL_LOCK();
+    session->next = pkcs11_logger_pool_idle;
+    pkcs11_logger_pool_idle = session;
+    POOL_UNLOCK();
+
+    PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_pool_returned, 1);
+
+    if (NULL != pooled)
+        *pooled = CK_TRUE;
+
+    return CKR_OK;
+}
+
+
+// Calls C_CloseAllSessions and forgets all sessions of the slot
+CK_RV pkcs11_logger_pool_close_all_sessions(CK_SLOT_ID slotID)
+{
+    CK_RV rv = pkcs11_logger_cache_close_all_sessions(slotID);
+
+    if ((0 != pkcs11_logger_globals.pool_size) && (CKR_OK == rv))
+        pkcs11_logger_pool_forget(slotID);
+
+    return rv;
+}
+
+
+// Calls C_Login and closes idle read-only sessions of the slot when they prevent the login of security officer
+CK_RV pkcs11_logger_pool_login(CK_SESSION_HANDLE hSession, CK_USER_TYPE userType, CK_UTF8CHAR_PTR pPin, CK_ULONG ulPinLen)
+{
+    CK_RV rv = CALL_ORIG_N_INVALIDATE(C_Login, (hSession, userType, pPin, ulPinLen));
+    PKCS11_LOGGER_POOL_SESSION *session = NULL;
+    PKCS11_LOGGER_POOL_SESSION *read_only = NULL;
+
+    if ((0 == pkcs11_logger_globals.pool_size) || (CKR_SESSION_READ_ONLY_EXISTS != rv))
+        return rv;
+
+    POOL_LOCK();
+    session = pkcs11_logger_pool_find(hSession, CK_FALSE);
+    if (NULL != session)
+        read_only = pkcs11_logger_pool_take_idle(session->slot, CK_TRUE, 0);
+    POOL_UNLOCK();
+
+    if (NULL == read_only)
+        return rv;
+
+    (void)pkcs11_logger_pool_close(read_only);
+
+    return CALL_ORIG_N_INVALIDATE(C_Login, (hSession, userType, pPin, ulPinLen));
+}
+
+
+// Calls C_Finalize and forgets all sessions
+CK_RV pkcs11_logger_pool_finalize(CK_VOID_PTR pReserved)
+{
+    CK_RV rv = pkcs11_logger_cache_finalize(pReserved);
+
+    if ((0 != pkcs11_logger_globals.pool_size) && (CKR_OK == rv))
+        pkcs11_logger_pool_forget(CK_UNAVAILABLE_INFORMATION);
+
+    return rv;
+}
+
+
+// Marks the session with the state that prevents its return to the pool and returns the value returned by the call
+CK_RV pkcs11_logger_pool_start(CK_SESSION_HANDLE hSession, CK_ULONG state, CK_RV rv)
+{
+    PKCS11_LOGGER_POOL_SESSION *session = NULL;
+
+    // Note: Operation that is already active might not be known to the pool and restoring of the state might fail halfway
+    if ((0 == pkcs11_logger_globals.pool_size) || ((CKR_OK != rv) && (CKR_OPERATION_ACTIVE != rv) && (PKCS11_LOGGER_POOL_STATE_RESTORED != state)))
+        return rv;
+
+    POOL_LOCK();
+    session = pkcs11_logger_pool_find(hSession, CK_FALSE);
+    if (NULL != session)
+        session->state |= state;
+    POOL_UNLOCK();
+
+    return rv;
+}
+
+
+// Clears the state of the session when the call finished the operation successfully and returns the value returned by the call
+CK_RV pkcs11_logger_pool_finish(CK_SESSION_HANDLE hSession, CK_ULONG state, CK_BBOOL condition, CK_RV rv)
+{
+    PKCS11_LOGGER_POOL_SESSION *session = NULL;
+
+    // Note: Operations that failed are treated as possibly active even though PKCS#11 terminates most of them
+    if ((0 == pkcs11_logger_globals.pool_size) || (CKR_OK != rv) || (CK_TRUE != condition))
+        return rv;
+
+    POOL_LOCK();
+    session = pkcs11_logger_pool_find(hSession, CK_FALSE);
+    if (NULL != session)
+        session->state &= ~state;
+    POOL_UNLOCK();
+
+    return rv;
+}
+
+
+// Logs numbers of sessions leased from and returned to the pool
+void pkcs11_logger_pool_dump(const char *reason)
+{
+    PKCS11_LOGGER_POOL_SESSION *session = NULL;
+    CK_ULONG idle = 0;
+
+    if (0 == pkcs11_logger_globals.pool_size)
+        return;
+
+    POOL_LOCK();
+    for (session = pkcs11_logger_pool_idle; NULL != session; session = session->next)
+        idle++;
+    POOL_UNLOCK();
+
+    pkcs11_logger_log("Pool of sessions (dumped on %s)", reason);
+    pkcs11_logger_log(" Size: %lu idle sessions per slot and flags", pkcs11_logger_globals.pool_size);
+    pkcs11_logger_log(" Idle timeout: %lu seconds", pkcs11_logger_globals.pool_idle_timeout);
+    pkcs11_logger_log(" Idle sessions: %lu", idle);
+    pkcs11_logger_log(" Leased from the pool: %lu", PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_pool_hits));
+    pkcs11_logger_log(" Opened in the original library: %lu", PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_pool_misses));
+    pkcs11_logger_log(" Returned to the pool: %lu", PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_pool_returned));
+    pkcs11_logger_log(" Closed because they could not be returned: %lu", PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_pool_rejected));
+    pkcs11_logger_log(" Closed while idle: %lu", PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_pool_expired));
+    pkcs11_logger_log_separator();
+}
+
+
+// Forgets all sessions without closing them and resets statistics
+void pkcs11_logger_pool_stop(void)
+{
+    // Note: Sessions are closed by C_Finalize or by unloading of the original library
+    pkcs11_logger_pool_forget(CK_UNAVAILABLE_INFORMATION);
+
+    pkcs11_logger_pool_hits = 0;
+    pkcs11_logger_pool_misses = 0;
+    pkcs11_logger_pool_returned = 0;
+    pkcs11_logger_pool_rejected = 0;
+    pkcs11_logger_pool_expired = 0;
+}
@@ -0,0 +1,511 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Records waiting for the background writer thread (lock-free stack with the newest record on top)
+static PKCS11_LOGGER_RECORD *pkcs11_logger_queue_head = NULL;
+// Number of records waiting for the background writer thread
+static CK_ULONG pkcs11_logger_queue_len = 0;
+// Number of records dropped because the queue was full
+static CK_ULONG pkcs11_logger_queue_dropped = 0;
+// Number of threads waiting for free space in the queue
+static CK_ULONG pkcs11_logger_queue_waiters = 0;
+// Flag indicating whether the background writer thread is running
+static CK_ULONG pkcs11_logger_queue_running = 0;
+// Flag indicating whether the background writer thread should exit
+static CK_ULONG pkcs11_logger_queue_stopping = 0;
+// Number of threads that are adding records into the queue or writing them
+static CK_ULONG pkcs11_logger_queue_producers = 0;
+
+#ifdef _WIN32
+// Lock used only for sleeping and waking up of threads
+static CRITICAL_SECTION pkcs11_logger_queue_lock;
+// Lock held while records are taken from the queue and written, so they are never reordered
+static CRITICAL_SECTION pkcs11_logger_queue_drain_lock;
+// Signaled when records are added to the empty queue
+static CONDITION_VARIABLE pkcs11_logger_queue_not_empty;
+// Signaled when records are removed from the queue
+static CONDITION_VARIABLE pkcs11_logger_queue_not_full;
+// Handle of the background writer thread
+static HANDLE pkcs11_logger_queue_thread = NULL;
+#else
+// Lock used only for sleeping and waking up of threads
+static pthread_mutex_t pkcs11_logger_queue_lock;
+// Lock held while records are taken from the queue and written, so they are never reordered
+static pthread_mutex_t pkcs11_logger_queue_drain_lock;
+// Signaled when records are added to the empty queue
+static pthread_cond_t pkcs11_logger_queue_not_empty;
+// Signaled when records are removed from the queue
+static pthread_cond_t pkcs11_logger_queue_not_full;
+// Handle of the background writer thread
+static pthread_t pkcs11_logger_queue_thread;
+#endif
+
+
+// Maximal time in milliseconds a thread blocked by the full queue sleeps before checking the queue again
+#define QUEUE_WAIT_TIMEOUT 10
+
+#ifdef _WIN32
+#define QUEUE_LOCK(lock) EnterCriticalSection(&(lock))
+#define QUEUE_UNLOCK(lock) LeaveCriticalSection(&(lock))
+#define QUEUE_WAIT(cond, lock) SleepConditionVariableCS(&(cond), &(lock), INFINITE)
+#define QUEUE_SIGNAL(cond) WakeConditionVariable(&(cond))
+#define QUEUE_BROADCAST(cond) WakeAllConditionVariable(&(cond))
+#else
+#define QUEUE_LOCK(lock) pthread_mutex_lock(&(lock))
+#define QUEUE_UNLOCK(lock) pthread_mutex_unlock(&(lock))
+#define QUEUE_WAIT(cond, lock) pthread_cond_wait(&(cond), &(lock))
+#define QUEUE_SIGNAL(cond) pthread_cond_signal(&(cond))
+#define QUEUE_BROADCAST(cond) pthread_cond_broadcast(&(cond))
+#endif
+
+
+// Waits for the condition at most QUEUE_WAIT_TIMEOUT milliseconds (lock must be held by the caller)
+#ifdef _WIN32
+static void pkcs11_logger_queue_wait_timed(CONDITION_VARIABLE *cond, CRITICAL_SECTION *lock)
+{
+    SleepConditionVariableCS(cond, lock, QUEUE_WAIT_TIMEOUT);
+}
+#else
+static void pkcs11_logger_queue_wait_timed(pthread_cond_t *cond, pthread_mutex_t *lock)
+{
+    struct timeval now;
+    struct timespec timeout;
+
+    gettimeofday(&now, NULL);
+    timeout.tv_sec = now.tv_sec;
+    timeout.tv_nsec = (now.tv_usec + QUEUE_WAIT_TIMEOUT * 1000) * 1000;
+    if (timeout.tv_nsec >= 1000000000)
+    {
+        timeout.tv_sec++;
+        timeout.tv_nsec -= 1000000000;
+    }
+
+    pthread_cond_timedwait(cond, lock, &timeout);
+}
+#endif
+
+
+// Takes all records from the queue in the order they were added
+static PKCS11_LOGGER_RECORD* pkcs11_logger_queue_take_all(CK_ULONG *dropped)
+{
+    PKCS11_LOGGER_RECORD *stack = NULL;
+    PKCS11_LOGGER_RECORD *records = NULL;
+    PKCS11_LOGGER_RECORD *record = NULL;
+    CK_ULONG records_count = 0;
+
+    stack = (PKCS11_LOGGER_RECORD*) PKCS11_LOGGER_ATOMIC_XCHG_PTR(&pkcs11_logger_queue_head, NULL);
+
+    // Note: Stack holds the newest record on top so it needs to be reversed
+    while (NULL != stack)
+    {
+        record = stack;
+        stack = stack->next;
+        record->next = records;
+        records = record;
+        records_count++;
+    }
+
+    if (0 != records_count)
+        PKCS11_LOGGER_ATOMIC_SUB(&pkcs11_logger_queue_len, records_count);
+
+    *dropped = PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_dropped);
+    if (0 != *dropped)
+        PKCS11_LOGGER_ATOMIC_SUB(&pkcs11_logger_queue_dropped, *dropped);
+
+    if (0 != PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_waiters))
+    {
+        QUEUE_LOCK(pkcs11_logger_queue_lock);
+        QUEUE_BROADCAST(pkcs11_logger_queue_not_full);
+        QUEUE_UNLOCK(pkcs11_logger_queue_lock);
+    }
+
+    return records;
+}
+
+
+// Writes records and the number of dropped records to the log (drain lock must be held by the caller)
+static void pkcs11_logger_queue_write(PKCS11_LOGGER_RECORD *records, CK_ULONG dropped)
+{
+    PKCS11_LOGGER_RECORD *record = NULL;
+
+    if (0 != dropped)
+    {
+        record = pkcs11_logger_log_create_record_va("*** %lu log records were dropped because the log queue was full ***", dropped);
+        if (NULL != record)
+        {
+            record->next = records;
+            records = record;
+        }
+    }
+
+    if (NULL != records)
+        pkcs11_logger_log_write_records(records);
+
+    while (NULL != records)
+    {
+        record = records;
+        records = records->next;
+        free(record);
+    }
+}
+
+
+// Takes all records from the queue and writes them
+static void pkcs11_logger_queue_drain(PKCS11_LOGGER_RECORD *own_record)
+{
+    PKCS11_LOGGER_RECORD *records = NULL;
+    PKCS11_LOGGER_RECORD *last = NULL;
+    CK_ULONG dropped = 0;
+
+    QUEUE_LOCK(pkcs11_logger_queue_drain_lock);
+
+    records = pkcs11_logger_queue_take_all(&dropped);
+
+    if (NULL != own_record)
+    {
+        if (NULL == records)
+        {
+            records = own_record;
+        }
+        else
+        {
+            for (last = records; NULL != last->next; last = last->next);
+            last->next = own_record;
+        }
+    }
+
+    pkcs11_logger_queue_write(records, dropped);
+
+    QUEUE_UNLOCK(pkcs11_logger_queue_drain_lock);
+}
+
+
+// Body of the background writer thread
+#ifdef _WIN32
+static DWORD WINAPI pkcs11_logger_queue_thread_proc(LPVOID arg)
+#else
+static void* pkcs11_logger_queue_thread_proc(void *arg)
+#endif
+{
+    CK_BBOOL stopping = CK_FALSE;
+
+    IGNORE_ARG(arg);
+
+    while (CK_TRUE != stopping)
+    {
+        QUEUE_LOCK(pkcs11_logger_queue_lock);
+
+        while ((NULL == PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_queue_head, NULL, NULL)) && (0 == PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_dropped)) && (0 == PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_stopping)))
+            QUEUE_WAIT(pkcs11_logger_queue_not_empty, pkcs11_logger_queue_lock);
+
+        stopping = (0 != PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_stopping)) ? CK_TRUE : CK_FALSE;
+
+        QUEUE_UNLOCK(pkcs11_logger_queue_lock);
+
+        pkcs11_logger_queue_drain(NULL);
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+
+// Starts the background writer thread
+int pkcs11_logger_queue_start(void)
+{
+    if (0 != PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_running))
+        return PKCS11_LOGGER_RV_SUCCESS;
+
+    pkcs11_logger_queue_head = NULL;
+    pkcs11_logger_queue_len = 0;
+    pkcs11_logger_queue_dropped = 0;
+    pkcs11_logger_queue_waiters = 0;
+    pkcs11_logger_queue_stopping = 0;
+    pkcs11_logger_queue_producers = 0;
+
+#ifdef _WIN32
+
+    InitializeCriticalSection(&pkcs11_logger_queue_lock);
+    InitializeCriticalSection(&pkcs11_logger_queue_drain_lock);
+    InitializeConditionVariable(&pkcs11_logger_queue_not_empty);
+    InitializeConditionVariable(&pkcs11_logger_queue_not_full);
+
+    pkcs11_logger_queue_thread = CreateThread(NULL, 0, pkcs11_logger_queue_thread_proc, NULL, 0, NULL);
+    if (NULL == pkcs11_logger_queue_thread)
+    {
+        DeleteCriticalSection(&pkcs11_logger_queue_drain_lock);
+        DeleteCriticalSection(&pkcs11_logger_queue_lock);
+        pkcs11_logger_log("Unable to create log writer thread");
+        return PKCS11_LOGGER_RV_ERROR;
+    }
+
+#else
+
+    if (0 != pthread_mutex_init(&pkcs11_logger_queue_lock, NULL))
+    {
+        pkcs11_logger_log("Unable to create log queue lock");
+        return PKCS11_LOGGER_RV_ERROR;
+    }
+
+    if (0 != pthread_mutex_init(&pkcs11_logger_queue_drain_lock, NULL))
+    {
+        pthread_mutex_destroy(&pkcs11_logger_queue_lock);
+        pkcs11_logger_log("Unable to create log queue lock");
+        return PKCS11_LOGGER_RV_ERROR;
+    }
+
+    if ((0 != pthread_cond_init(&pkcs11_logger_queue_not_empty, NULL)) || (0 != pthread_cond_init(&pkcs11_logger_queue_not_full, NULL)))
+    {
+        pthread_mutex_destroy(&pkcs11_logger_queue_drain_lock);
+        pthread_mutex_destroy(&pkcs11_logger_queue_lock);
+        pkcs11_logger_log("Unable to create log queue condition");
+        return PKCS11_LOGGER_RV_ERROR;
+    }
+
+    if (0 != pthread_create(&pkcs11_logger_queue_thread, NULL, pkcs11_logger_queue_thread_proc, NULL))
+    {
+        pthread_cond_destroy(&pkcs11_logger_queue_not_full);
+        pthread_cond_destroy(&pkcs11_logger_queue_not_empty);
+        pthread_mutex_destroy(&pkcs11_logger_queue_drain_lock);
+        pthread_mutex_destroy(&pkcs11_logger_queue_lock);
+        pkcs11_logger_log("Unable to create log writer thread");
+        return PKCS11_LOGGER_RV_ERROR;
+    }
+
+#endif
+
+    (void) PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_queue_running, 1);
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Determines whether records are written by the background writer thread
+CK_BBOOL pkcs11_logger_queue_is_running(void)
+{
+    return (0 != PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_running)) ? CK_TRUE : CK_FALSE;
+}
+
+
+// Registers the calling thread as a user of the queue unless the queue is not running or is being stopped
+static CK_BBOOL pkcs11_logger_queue_enter(void)
+{
+    // Note: Thread is counted before the flags are checked so the queue cannot be stopped after it has passed the check
+    PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_queue_producers, 1);
+
+    if ((0 != PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_running)) && (0 == PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_stopping)))
+        return CK_TRUE;
+
+    PKCS11_LOGGER_ATOMIC_SUB(&pkcs11_logger_queue_producers, 1);
+
+    return CK_FALSE;
+}
+
+
+// Unregisters the calling thread as a user of the queue
+static void pkcs11_logger_queue_leave(void)
+{
+    PKCS11_LOGGER_ATOMIC_SUB(&pkcs11_logger_queue_producers, 1);
+}
+
+
+// Adds the record into the queue (caller must be registered as a user of the queue)
+static int pkcs11_logger_queue_add(PKCS11_LOGGER_RECORD *record)
+{
+    PKCS11_LOGGER_RECORD *head = NULL;
+    PKCS11_LOGGER_RECORD *prev_head = NULL;
+
+    // Reserve space in the queue
+    while (PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_queue_len, 1) > pkcs11_logger_globals.queue_size)
+    {
+        PKCS11_LOGGER_ATOMIC_SUB(&pkcs11_logger_queue_len, 1);
+
+        switch (pkcs11_logger_globals.queue_policy)
+        {
+            case PKCS11_LOGGER_QUEUE_POLICY_DROP:
+
+                PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_queue_dropped, 1);
+                free(record);
+                return PKCS11_LOGGER_RV_SUCCESS;
+
+            case PKCS11_LOGGER_QUEUE_POLICY_SPILL:
+
+                // Note: Calling thread writes the queued records together with its own record
+                pkcs11_logger_queue_drain(record);
+                return PKCS11_LOGGER_RV_SUCCESS;
+
+            default:
+
+                QUEUE_LOCK(pkcs11_logger_queue_lock);
+                PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_queue_waiters, 1);
+
+                if ((PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_len) >= pkcs11_logger_globals.queue_size) && (0 == PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_stopping)))
+                    pkcs11_logger_queue_wait_timed(&pkcs11_logger_queue_not_full, &pkcs11_logger_queue_lock);
+
+                PKCS11_LOGGER_ATOMIC_SUB(&pkcs11_logger_queue_waiters, 1);
+                QUEUE_UNLOCK(pkcs11_logger_queue_lock);
+
+                if (0 != PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_stopping))
+                    return PKCS11_LOGGER_RV_ERROR;
+
+                break;
+        }
+    }
+
+    // Publish the record without taking any lock
+    head = (PKCS11_LOGGER_RECORD*) PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_queue_head, NULL, NULL);
+    do
+    {
+        record->next = head;
+        prev_head = head;
+        head = (PKCS11_LOGGER_RECORD*) PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_queue_head, prev_head, record);
+    }
+    while (head != prev_head);
+
+    // Only the record added to the empty queue needs to wake up the writer thread
+    if (NULL == prev_head)
+    {
+        QUEUE_LOCK(pkcs11_logger_queue_lock);
+        QUEUE_SIGNAL(pkcs11_logger_queue_not_empty);
+        QUEUE_UNLOCK(pkcs11_logger_queue_lock);
+    }
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Hands the record over to the background writer thread
+int pkcs11_logger_queue_push(PKCS11_LOGGER_RECORD *record)
+{
+    int rv = PKCS11_LOGGER_RV_ERROR;
+
+    if (NULL == record)
+        return PKCS11_LOGGER_RV_ERROR;
+
+    if (CK_TRUE != pkcs11_logger_queue_enter())
+        return PKCS11_LOGGER_RV_ERROR;
+
+    rv = pkcs11_logger_queue_add(record);
+
+    pkcs11_logger_queue_leave();
+
+    return rv;
+}
+
+
+// Writes all queued records before returning
+void pkcs11_logger_queue_flush(void)
+{
+    if (CK_TRUE != pkcs11_logger_queue_enter())
+        return;
+
+    // Note: Drain lock is owned by the writer thread until the batch it is writing hits the sinks
+    pkcs11_logger_queue_drain(NULL);
+
+    pkcs11_logger_queue_leave();
+}
+
+
+// Writes all queued records and stops the background writer thread (which is waited for only when join is CK_TRUE)
+void pkcs11_logger_queue_stop(CK_BBOOL join)
+{
+    PKCS11_LOGGER_RECORD *records = NULL;
+    CK_ULONG dropped = 0;
+
+    if (0 == PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_running))
+        return;
+
+    QUEUE_LOCK(pkcs11_logger_queue_lock);
+    (void) PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_queue_stopping, 1);
+    QUEUE_BROADCAST(pkcs11_logger_queue_not_empty);
+    QUEUE_BROADCAST(pkcs11_logger_queue_not_full);
+    QUEUE_UNLOCK(pkcs11_logger_queue_lock);
+
+#ifdef _WIN32
+
+    if (CK_TRUE == join)
+    {
+        WaitForSingleObject(pkcs11_logger_queue_thread, INFINITE);
+        CALL_N_CLEAR(CloseHandle, pkcs11_logger_queue_thread);
+
+        // Note: Threads that have passed the check of the flags may still be adding records, spilling or flushing
+        while (0 != PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_producers))
+            SwitchToThread();
+
+        EnterCriticalSection(&pkcs11_logger_queue_drain_lock);
+        records = pkcs11_logger_queue_take_all(&dropped);
+        pkcs11_logger_queue_write(records, dropped);
+        LeaveCriticalSection(&pkcs11_logger_queue_drain_lock);
+
+        DeleteCriticalSection(&pkcs11_logger_queue_drain_lock);
+        DeleteCriticalSection(&pkcs11_logger_queue_lock);
+    }
+    else
+    {
+        // Note: Waiting for a thread in DllMain() can cause a deadlock and during process termination
+        //       the writer thread may have been terminated while holding the drain lock.
+        //       Writer thread is therefore joined by C_Finalize and it can be left running here
+        //       only when the library is unloaded without being finalized.
+        //       See "Dynamic-Link Library Best Practices" article on MSDN for more details.
+        if (TryEnterCriticalSection(&pkcs11_logger_queue_drain_lock))
+        {
+            records = pkcs11_logger_queue_take_all(&dropped);
+            pkcs11_logger_queue_write(records, dropped);
+            LeaveCriticalSection(&pkcs11_logger_queue_drain_lock);
+        }
+
+        CALL_N_CLEAR(CloseHandle, pkcs11_logger_queue_thread);
+    }
+
+#else
+
+    IGNORE_ARG(join);
+
+    pthread_join(pkcs11_logger_queue_thread, NULL);
+
+    // Note: Threads that have passed the check of the flags may still be adding records, spilling or flushing
+    while (0 != PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_queue_producers))
+        sched_yield();
+
+    QUEUE_LOCK(pkcs11_logger_queue_drain_lock);
+    records = pkcs11_logger_queue_take_all(&dropped);
+    pkcs11_logger_queue_write(records, dropped);
+    QUEUE_UNLOCK(pkcs11_logger_queue_drain_lock);
+
+    pthread_cond_destroy(&pkcs11_logger_queue_not_full);
+    pthread_cond_destroy(&pkcs11_logger_queue_not_empty);
+    pthread_mutex_destroy(&pkcs11_logger_queue_drain_lock);
+    pthread_mutex_destroy(&pkcs11_logger_queue_lock);
+
+#endif
+
+    (void) PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_queue_running, 0);
+}
@@ -0,0 +1,753 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+#ifdef PKCS11_LOGGER_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef PKCS11_LOGGER_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Structure that holds closed log file waiting for the background rotation thread
+typedef struct PKCS11_LOGGER_ROTATE_JOB
+{
+    // Next job in the list
+    struct PKCS11_LOGGER_ROTATE_JOB *next;
+    // Time when the log file was closed
+    time_t closed;
+    // Path of the closed log file (allocated together with the structure)
+    char path[1];
+}
+PKCS11_LOGGER_ROTATE_JOB;
+
+
+// Structure that describes compression of rotated log files
+typedef struct
+{
+    // Name used in PKCS11_LOGGER_ROTATE_COMPRESSION environment variable
+    const char *name;
+    // Extension appended to the name of compressed file
+    const char *extension;
+    // Function that compresses source file into destination file (NULL when no compression is used)
+    int (*compress)(const char *source, const char *destination);
+}
+PKCS11_LOGGER_COMPRESSOR;
+
+
+#ifdef PKCS11_LOGGER_WITH_ZLIB
+
+// Compresses file with gzip
+static int pkcs11_logger_rotate_compress_gzip(const char *source, const char *destination)
+{
+    int rv = PKCS11_LOGGER_RV_ERROR;
+    FILE *input = NULL;
+    gzFile output = NULL;
+    char buffer[65536];
+    size_t len = 0;
+
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable: 4996)
+#endif
+
+    input = fopen(source, "rb");
+    if (NULL == input)
+        goto err;
+
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+    output = gzopen(destination, "wb");
+    if (NULL == output)
+        goto err;
+
+    while (0 != (len = fread(buffer, 1, sizeof(buffer), input)))
+    {
+        if ((int)len != gzwrite(output, buffer, (unsigned int)len))
+            goto err;
+    }
+
+    if (ferror(input))
+        goto err;
+
+    rv = PKCS11_LOGGER_RV_SUCCESS;
+
+err:
+
+    if ((NULL != output) && (Z_OK != gzclose(output)))
+        rv = PKCS11_LOGGER_RV_ERROR;
+
+    CALL_N_CLEAR(fclose, input);
+
+    if (PKCS11_LOGGER_RV_SUCCESS != rv)
+        remove(destination);
+
+    return rv;
+}
+
+#endif
+
+
+#ifdef PKCS11_LOGGER_WITH_ZSTD
+
+// Compresses file with zstd
+static int pkcs11_logger_rotate_compress_zstd(const char *source, const char *destination)
+{
+    int rv = PKCS11_LOGGER_RV_ERROR;
+    FILE *input = NULL;
+    FILE *output = NULL;
+    ZSTD_CCtx *context = NULL;
+    ZSTD_inBuffer in_buffer;
+    ZSTD_outBuffer out_buffer;
+    ZSTD_EndDirective directive = ZSTD_e_continue;
+    char *buffer = NULL;
+    size_t buffer_len = ZSTD_CStreamOutSize();
+    size_t remaining = 0;
+    char data[65536];
+    size_t len = 0;
+
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable: 4996)
+#endif
+
+    input = fopen(source, "rb");
+    if (NULL == input)
+        goto err;
+
+    output = fopen(destination, "wb");
+    if (NULL == output)
+        goto err;
+
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+    buffer = (char*) malloc(buffer_len);
+    if (NULL == buffer)
+        goto err;
+
+    context = ZSTD_createCCtx();
+    if (NULL == context)
+        goto err;
+
+    do
+    {
+        len = fread(data, 1, sizeof(data), input);
+        if (ferror(input))
+            goto err;
+
+        // Note: Frame is finished together with the last block of the file
+        directive = (len < sizeof(data)) ? ZSTD_e_end : ZSTD_e_continue;
+
+        in_buffer.src = data;
+        in_buffer.size = len;
+        in_buffer.pos = 0;
+
+        do
+        {
+            out_buffer.dst = buffer;
+            out_buffer.size = buffer_len;
+            out_buffer.pos = 0;
+
+            remaining = ZSTD_compressStream2(context, &out_buffer, &in_buffer, directive);
+            if (ZSTD_isError(remaining))
+                goto err;
+
+            if (out_buffer.pos != fwrite(buffer, 1, out_buffer.pos, output))
+                goto err;
+        }
+        while ((ZSTD_e_end == directive) ? (0 != remaining) : (in_buffer.pos != in_buffer.size));
+    }
+    while (ZSTD_e_end != directive);
+
+    rv = PKCS11_LOGGER_RV_SUCCESS;
+
+err:
+
+    if ((NULL != output) && (0 != fclose(output)))
+        rv = PKCS11_LOGGER_RV_ERROR;
+
+    if (NULL != context)
+        ZSTD_freeCCtx(context);
+
+    CALL_N_CLEAR(free, buffer);
+    CALL_N_CLEAR(fclose, input);
+
+    if (PKCS11_LOGGER_RV_SUCCESS != rv)
+        remove(destination);
+
+    return rv;
+}
+
+#endif
+
+
+// Available compressions of rotated log files
+static const PKCS11_LOGGER_COMPRESSOR pkcs11_logger_rotate_compressors[] =
+{
+    { "none", "", NULL },
+#ifdef PKCS11_LOGGER_WITH_ZLIB
+    { "gzip", ".gz", pkcs11_logger_rotate_compress_gzip },
+#endif
+#ifdef PKCS11_LOGGER_WITH_ZSTD
+    { "zstd", ".zst", pkcs11_logger_rotate_compress_zstd },
+#endif
+};
+
+
+// Jobs waiting for the background rotation thread
+static PKCS11_LOGGER_ROTATE_JOB *pkcs11_logger_rotate_jobs_head = NULL;
+// Last job waiting for the background rotation thread
+static PKCS11_LOGGER_ROTATE_JOB *pkcs11_logger_rotate_jobs_tail = NULL;
+// Time when the current log file was started
+static time_t pkcs11_logger_rotate_period_start = 0;
+// Time when the log file was last checked for rotation by another process
+static time_t pkcs11_logger_rotate_last_check = 0;
+// Sequence number of the next closed log file
+static CK_ULONG pkcs11_logger_rotate_sequence = 0;
+// Flag indicating whether the background rotation thread is running
+static CK_BBOOL pkcs11_logger_rotate_running = CK_FALSE;
+// Flag indicating whether the background rotation thread should exit
+static CK_BBOOL pkcs11_logger_rotate_stopping = CK_FALSE;
+
+// Number of seconds after closing of the log file during which other processes can still write into it
+#define ROTATE_DELAY 2
+
+#ifdef _WIN32
+// Lock that protects the list of jobs
+static CRITICAL_SECTION pkcs11_logger_rotate_lock;
+// Signaled when a job is added to the list
+static CONDITION_VARIABLE pkcs11_logger_rotate_not_empty;
+// Handle of the background rotation thread
+static HANDLE pkcs11_logger_rotate_thread = NULL;
+#else
+// Lock that protects the list of jobs
+static pthread_mutex_t pkcs11_logger_rotate_lock;
+// Signaled when a job is added to the list
+static pthread_cond_t pkcs11_logger_rotate_not_empty;
+// Handle of the background rotation thread
+static pthread_t pkcs11_logger_rotate_thread;
+#endif
+
+
+#ifdef _WIN32
+#define ROTATE_LOCK() EnterCriticalSection(&pkcs11_logger_rotate_lock)
+#define ROTATE_UNLOCK() LeaveCriticalSection(&pkcs11_logger_rotate_lock)
+#define ROTATE_WAIT() SleepConditionVariableCS(&pkcs11_logger_rotate_not_empty, &pkcs11_logger_rotate_lock, INFINITE)
+#define ROTATE_SIGNAL() WakeConditionVariable(&pkcs11_logger_rotate_not_empty)
+#define ROTATE_FILE_LOCK HANDLE
+#define ROTATE_NO_FILE_LOCK INVALID_HANDLE_VALUE
+#else
+#define ROTATE_LOCK() pthread_mutex_lock(&pkcs11_logger_rotate_lock)
+#define ROTATE_UNLOCK() pthread_mutex_unlock(&pkcs11_logger_rotate_lock)
+#define ROTATE_WAIT() pthread_cond_wait(&pkcs11_logger_rotate_not_empty, &pkcs11_logger_rotate_lock)
+#define ROTATE_SIGNAL() pthread_cond_signal(&pkcs11_logger_rotate_not_empty)
+#define ROTATE_FILE_LOCK int
+#define ROTATE_NO_FILE_LOCK -1
+#endif
+
+
+// Waits at most one second for a job to be added to the list (lock must be held by the caller)
+static void pkcs11_logger_rotate_wait_timed(void)
+{
+#ifdef _WIN32
+    SleepConditionVariableCS(&pkcs11_logger_rotate_not_empty, &pkcs11_logger_rotate_lock, 1000);
+#else
+    struct timeval now;
+    struct timespec timeout;
+
+    gettimeofday(&now, NULL);
+    timeout.tv_sec = now.tv_sec + 1;
+    timeout.tv_nsec = now.tv_usec * 1000;
+
+    pthread_cond_timedwait(&pkcs11_logger_rotate_not_empty, &pkcs11_logger_rotate_lock, &timeout);
+#endif
+}
+
+
+// Takes the lock of the log file shared by all processes that rotate it (returns ROTATE_NO_FILE_LOCK on failure)
+static ROTATE_FILE_LOCK pkcs11_logger_rotate_lock_file(void)
+{
+    ROTATE_FILE_LOCK file_lock = ROTATE_NO_FILE_LOCK;
+    size_t path_len = strlen((const char *)pkcs11_logger_globals.env_var_log_file_path) + 8;
+    char *path = NULL;
+#ifdef _WIN32
+    OVERLAPPED overlapped;
+#endif
+
+    path = (char*) malloc(path_len);
+    if (NULL == path)
+        return ROTATE_NO_FILE_LOCK;
+
+    // Note: Lock is held on a separate file because the log file itself is renamed
+    snprintf(path, path_len, "%s.lock", pkcs11_logger_globals.env_var_log_file_path);
+
+#ifdef _WIN32
+
+    file_lock = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE != file_lock)
+    {
+        memset(&overlapped, 0, sizeof(overlapped));
+        if (!LockFileEx(file_lock, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped))
+        {
+            CloseHandle(file_lock);
+            file_lock = INVALID_HANDLE_VALUE;
+        }
+    }
+
+#else
+
+    file_lock = open(path, O_RDWR | O_CREAT, 0644);
+    if (-1 != file_lock)
+    {
+        while (0 != flock(file_lock, LOCK_EX))
+        {
+            if (EINTR != errno)
+            {
+                close(file_lock);
+                file_lock = -1;
+                break;
+            }
+        }
+    }
+
+#endif
+
+    CALL_N_CLEAR(free, path);
+
+    return file_lock;
+}
+
+
+// Releases the lock of the log file shared by all processes that rotate it
+static void pkcs11_logger_rotate_unlock_file(ROTATE_FILE_LOCK file_lock)
+{
+    if (ROTATE_NO_FILE_LOCK == file_lock)
+        return;
+
+#ifdef _WIN32
+    CloseHandle(file_lock);
+#else
+    close(file_lock);
+#endif
+}
+
+
+// Determines whether the opened log file is still the one at the log file path (it may have been rotated by another process)
+static CK_BBOOL pkcs11_logger_rotate_is_current_file(void)
+{
+#ifdef _WIN32
+
+    BY_HANDLE_FILE_INFORMATION opened;
+    BY_HANDLE_FILE_INFORMATION current;
+    HANDLE file = INVALID_HANDLE_VALUE;
+    CK_BBOOL result = CK_FALSE;
+
+    file = CreateFileA((const char *)pkcs11_logger_globals.env_var_log_file_path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == file)
+        return CK_FALSE;
+
+    if (GetFileInformationByHandle((HANDLE)_get_osfhandle(_fileno(pkcs11_logger_globals.log_file_handle)), &opened) && GetFileInformationByHandle(file, &current))
+    {
+        if ((opened.dwVolumeSerialNumber == current.dwVolumeSerialNumber) && (opened.nFileIndexHigh == current.nFileIndexHigh) && (opened.nFileIndexLow == current.nFileIndexLow))
+            result = CK_TRUE;
+    }
+
+    CloseHandle(file);
+
+    return result;
+
+#else
+
+    struct stat opened;
+    struct stat current;
+
+    if ((0 != fstat(fileno(pkcs11_logger_globals.log_file_handle), &opened)) || (0 != stat((const char *)pkcs11_logger_globals.env_var_log_file_path, &current)))
+        return CK_FALSE;
+
+    return ((opened.st_dev == current.st_dev) && (opened.st_ino == current.st_ino)) ? CK_TRUE : CK_FALSE;
+
+#endif
+}
+
+
+// Finds compression by its name
+int pkcs11_logger_rotate_find_compressor(const char *name, CK_ULONG *index)
+{
+    CK_ULONG i = 0;
+
+    for (i = 0; i < sizeof(pkcs11_logger_rotate_compressors) / sizeof(PKCS11_LOGGER_COMPRESSOR); i++)
+    {
+        if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case(name, pkcs11_logger_rotate_compressors[i].name))
+        {
+            *index = i;
+            return PKCS11_LOGGER_RV_SUCCESS;
+        }
+    }
+
+    return PKCS11_LOGGER_RV_ERROR;
+}
+
+
+// Formats path of rotated log file with the specified index
+static void pkcs11_logger_rotate_get_path(char *buffer, size_t buffer_len, CK_ULONG index, const char *extension)
+{
+    snprintf(buffer, buffer_len, "%s.%lu%s", pkcs11_logger_globals.env_var_log_file_path, index, extension);
+}
+
+
+// Compresses closed log file, shifts rotated log files, removes the ones exceeding retention count and stores closed log file as the newest one
+static void pkcs11_logger_rotate_process(const char *closed_path)
+{
+    const PKCS11_LOGGER_COMPRESSOR *compressor = &pkcs11_logger_rotate_compressors[pkcs11_logger_globals.rotate_compression];
+    size_t path_len = strlen((const char *)pkcs11_logger_globals.env_var_log_file_path) + 32;
+    size_t compressed_path_len = strlen(closed_path) + strlen(compressor->extension) + 1;
+    ROTATE_FILE_LOCK file_lock = ROTATE_NO_FILE_LOCK;
+    const char *rotated_path = closed_path;
+    const char *extension = "";
+    char *compressed_path = NULL;
+    char *old_path = NULL;
+    char *new_path = NULL;
+    CK_ULONG last = 0;
+    CK_ULONG i = 0;
+
+    old_path = (char*) malloc(path_len);
+    new_path = (char*) malloc(path_len);
+    compressed_path = (char*) malloc(compressed_path_len);
+    if ((NULL == old_path) || (NULL == new_path) || (NULL == compressed_path))
+        goto end;
+
+    // Note: File is compressed before the lock is taken so other processes do not wait for the compression
+    snprintf(compressed_path, compressed_path_len, "%s%s", closed_path, compressor->extension);
+    if ((NULL != compressor->compress) && (PKCS11_LOGGER_RV_SUCCESS == compressor->compress(closed_path, compressed_path)))
+    {
+        remove(closed_path);
+        rotated_path = compressed_path;
+        extension = compressor->extension;
+    }
+
+    // Note: Rotated files of the log file shared by several processes are shifted by one process at a time
+    file_lock = pkcs11_logger_rotate_lock_file();
+
+    // Note: Rotated files are named <log file path>.1 (the newest) to <log file path>.<retention count> (the oldest)
+    if (0 != pkcs11_logger_globals.rotate_count)
+    {
+        pkcs11_logger_rotate_get_path(old_path, path_len, pkcs11_logger_globals.rotate_count, compressor->extension);
+        remove(old_path);
+        last = pkcs11_logger_globals.rotate_count - 1;
+    }
+    else
+    {
+        do
+        {
+            last++;
+            pkcs11_logger_rotate_get_path(old_path, path_len, last, compressor->extension);
+        }
+        while (CK_TRUE == pkcs11_logger_utils_file_exists(old_path));
+
+        last--;
+    }
+
+    for (i = last; i >= 1; i--)
+    {
+        pkcs11_logger_rotate_get_path(old_path, path_len, i, compressor->extension);
+        pkcs11_logger_rotate_get_path(new_path, path_len, i + 1, compressor->extension);
+        rename(old_path, new_path);
+    }
+
+    // Note: File that cannot be compressed is kept uncompressed
+    pkcs11_logger_rotate_get_path(new_path, path_len, 1, extension);
+    remove(new_path);
+    rename(rotated_path, new_path);
+
+    pkcs11_logger_rotate_unlock_file(file_lock);
+
+end:
+
+    CALL_N_CLEAR(free, old_path);
+    CALL_N_CLEAR(free, new_path);
+    CALL_N_CLEAR(free, compressed_path);
+}
+
+
+// Background rotation thread
+#ifdef _WIN32
+static DWORD WINAPI pkcs11_logger_rotate_thread_proc(LPVOID param)
+#else
+static void* pkcs11_logger_rotate_thread_proc(void *param)
+#endif
+{
+    PKCS11_LOGGER_ROTATE_JOB *job = NULL;
+
+    IGNORE_ARG(param);
+
+    for (;;)
+    {
+        ROTATE_LOCK();
+
+        while ((NULL == pkcs11_logger_rotate_jobs_head) && (CK_TRUE != pkcs11_logger_rotate_stopping))
+            ROTATE_WAIT();
+
+        // Note: Other processes sharing the log file notice its rotation within a second so it is processed after they stop writing into it
+        while ((NULL != pkcs11_logger_rotate_jobs_head) && (CK_TRUE != pkcs11_logger_rotate_stopping) && (time(NULL) - pkcs11_logger_rotate_jobs_head->closed < ROTATE_DELAY))
+            pkcs11_logger_rotate_wait_timed();
+
+        job = pkcs11_logger_rotate_jobs_head;
+        if (NULL != job)
+        {
+            pkcs11_logger_rotate_jobs_head = job->next;
+            if (NULL == pkcs11_logger_rotate_jobs_head)
+                pkcs11_logger_rotate_jobs_tail = NULL;
+        }
+
+        ROTATE_UNLOCK();
+
+        // Note: Remaining jobs are finished before the thread exits
+        if (NULL == job)
+            break;
+
+        pkcs11_logger_rotate_process(job->path);
+        CALL_N_CLEAR(free, job);
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+
+// Starts background rotation thread
+static int pkcs11_logger_rotate_start(void)
+{
+    if (CK_TRUE == pkcs11_logger_rotate_running)
+        return PKCS11_LOGGER_RV_SUCCESS;
+
+    pkcs11_logger_rotate_jobs_head = NULL;
+    pkcs11_logger_rotate_jobs_tail = NULL;
+    pkcs11_logger_rotate_stopping = CK_FALSE;
+
+#ifdef _WIN32
+
+    InitializeCriticalSection(&pkcs11_logger_rotate_lock);
+    InitializeConditionVariable(&pkcs11_logger_rotate_not_empty);
+
+    pkcs11_logger_rotate_thread = CreateThread(NULL, 0, pkcs11_logger_rotate_thread_proc, NULL, 0, NULL);
+    if (NULL == pkcs11_logger_rotate_thread)
+    {
+        DeleteCriticalSection(&pkcs11_logger_rotate_lock);
+        return PKCS11_LOGGER_RV_ERROR;
+    }
+
+#else
+
+    if (0 != pthread_mutex_init(&pkcs11_logger_rotate_lock, NULL))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    if (0 != pthread_cond_init(&pkcs11_logger_rotate_not_empty, NULL))
+    {
+        pthread_mutex_destroy(&pkcs11_logger_rotate_lock);
+        return PKCS11_LOGGER_RV_ERROR;
+    }
+
+    if (0 != pthread_create(&pkcs11_logger_rotate_thread, NULL, pkcs11_logger_rotate_thread_proc, NULL))
+    {
+        pthread_cond_destroy(&pkcs11_logger_rotate_not_empty);
+        pthread_mutex_destroy(&pkcs11_logger_rotate_lock);
+        return PKCS11_LOGGER_RV_ERROR;
+    }
+
+#endif
+
+    pkcs11_logger_rotate_running = CK_TRUE;
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Closes log file and hands it over to the background rotation thread if it exceeds configured size or age (lock must be held by the caller)
+void pkcs11_logger_rotate_check(void)
+{
+    PKCS11_LOGGER_ROTATE_JOB *job = NULL;
+    ROTATE_FILE_LOCK file_lock = ROTATE_NO_FILE_LOCK;
+    CK_BBOOL rotate = CK_FALSE;
+    time_t now = 0;
+    long size = 0;
+    size_t path_len = 0;
+
+    if ((0 == pkcs11_logger_globals.rotate_size) && (0 == pkcs11_logger_globals.rotate_interval))
+        return;
+
+    if ((NULL == pkcs11_logger_globals.log_file_handle) || (NULL == pkcs11_logger_globals.env_var_log_file_path))
+        return;
+
+    now = time(NULL);
+    if (0 == pkcs11_logger_rotate_period_start)
+        pkcs11_logger_rotate_period_start = now;
+
+    // Note: Log file shared by several processes can be rotated by any of them so the others start writing into the new file
+    if (now != pkcs11_logger_rotate_last_check)
+    {
+        pkcs11_logger_rotate_last_check = now;
+
+        if (CK_TRUE != pkcs11_logger_rotate_is_current_file())
+        {
+            CALL_N_CLEAR(fclose, pkcs11_logger_globals.log_file_handle);
+            pkcs11_logger_rotate_period_start = now;
+            return;
+        }
+    }
+
+    size = ftell(pkcs11_logger_globals.log_file_handle);
+
+    if ((0 != pkcs11_logger_globals.rotate_size) && (size >= (long)pkcs11_logger_globals.rotate_size))
+        rotate = CK_TRUE;
+
+    if ((0 != pkcs11_logger_globals.rotate_interval) && (now - pkcs11_logger_rotate_period_start >= (time_t)pkcs11_logger_globals.rotate_interval))
+        rotate = CK_TRUE;
+
+    if ((CK_TRUE != rotate) || (size <= 0))
+        return;
+
+    // Note: Calling thread only closes and renames the file, everything else happens in the background
+    path_len = strlen((const char *)pkcs11_logger_globals.env_var_log_file_path) + 64;
+    job = (PKCS11_LOGGER_ROTATE_JOB*) malloc(sizeof(PKCS11_LOGGER_ROTATE_JOB) + path_len);
+    if (NULL == job)
+        return;
+
+    job->next = NULL;
+    job->closed = now;
+    snprintf(job->path, path_len, "%s.rotating.%d.%lu", pkcs11_logger_globals.env_var_log_file_path, pkcs11_logger_utils_get_process_id(), pkcs11_logger_rotate_sequence);
+
+    // Note: Only one of the processes sharing the log file renames it
+    file_lock = pkcs11_logger_rotate_lock_file();
+
+    if (CK_TRUE != pkcs11_logger_rotate_is_current_file())
+    {
+        // Note: Log file has just been rotated by another process so this process only starts writing into the new file
+        pkcs11_logger_rotate_unlock_file(file_lock);
+        CALL_N_CLEAR(fclose, pkcs11_logger_globals.log_file_handle);
+        CALL_N_CLEAR(free, job);
+        pkcs11_logger_rotate_period_start = now;
+        return;
+    }
+
+    CALL_N_CLEAR(fclose, pkcs11_logger_globals.log_file_handle);
+
+    if (0 != rename((const char *)pkcs11_logger_globals.env_var_log_file_path, job->path))
+    {
+        pkcs11_logger_rotate_unlock_file(file_lock);
+        CALL_N_CLEAR(free, job);
+        return;
+    }
+
+    pkcs11_logger_rotate_unlock_file(file_lock);
+
+    pkcs11_logger_rotate_sequence++;
+    pkcs11_logger_rotate_period_start = now;
+
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_rotate_start())
+    {
+        // Note: Closed file is processed by the calling thread when the background thread cannot be started
+        pkcs11_logger_rotate_process(job->path);
+        CALL_N_CLEAR(free, job);
+        return;
+    }
+
+    ROTATE_LOCK();
+
+    if (NULL == pkcs11_logger_rotate_jobs_tail)
+        pkcs11_logger_rotate_jobs_head = job;
+    else
+        pkcs11_logger_rotate_jobs_tail->next = job;
+    pkcs11_logger_rotate_jobs_tail = job;
+
+    ROTATE_SIGNAL();
+    ROTATE_UNLOCK();
+}
+
+
+// Stops background rotation thread after all closed log files are processed (the thread is waited for only when join is CK_TRUE)
+void pkcs11_logger_rotate_stop(CK_BBOOL join)
+{
+    // Note: Age of the log file is measured across C_Finalize and C_Initialize calls
+    if (CK_TRUE != join)
+    {
+        pkcs11_logger_rotate_period_start = 0;
+        pkcs11_logger_rotate_last_check = 0;
+    }
+
+    // Note: Rotation thread is started by the thread that holds the lock
+    if (CK_TRUE == join)
+        pkcs11_logger_lock_acquire();
+
+    if (CK_TRUE != pkcs11_logger_rotate_running)
+        goto end;
+
+    ROTATE_LOCK();
+    pkcs11_logger_rotate_stopping = CK_TRUE;
+    ROTATE_SIGNAL();
+    ROTATE_UNLOCK();
+
+#ifdef _WIN32
+
+    if (CK_TRUE == join)
+    {
+        WaitForSingleObject(pkcs11_logger_rotate_thread, INFINITE);
+        CALL_N_CLEAR(CloseHandle, pkcs11_logger_rotate_thread);
+        DeleteCriticalSection(&pkcs11_logger_rotate_lock);
+    }
+    else
+    {
+        // Note: Waiting for a thread in DllMain() can cause a deadlock so the rotation thread
+        //       is joined by C_Finalize and it can be left running here only when the library
+        //       is unloaded without being finalized.
+        //       See "Dynamic-Link Library Best Practices" article on MSDN for more details.
+        CALL_N_CLEAR(CloseHandle, pkcs11_logger_rotate_thread);
+    }
+
+#else
+
+    pthread_join(pkcs11_logger_rotate_thread, NULL);
+
+    pthread_cond_destroy(&pkcs11_logger_rotate_not_empty);
+    pthread_mutex_destroy(&pkcs11_logger_rotate_lock);
+
+#endif
+
+    pkcs11_logger_rotate_running = CK_FALSE;
+
+end:
+
+    if (CK_TRUE == join)
+        pkcs11_logger_lock_release();
+}
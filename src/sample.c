@@ -0,0 +1,167 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Number of sampled calls of each PKCS#11 function
+static CK_ULONG pkcs11_logger_sample_calls[PKCS11_LOGGER_FUNCTION_COUNT];
+// Number of logged calls of each sampled PKCS#11 function
+static CK_ULONG pkcs11_logger_sample_logged[PKCS11_LOGGER_FUNCTION_COUNT];
+
+// State of pseudo random generator of the current thread (zero when not seeded yet)
+static PKCS11_LOGGER_THREAD_LOCAL unsigned long long pkcs11_logger_sample_random_state = 0;
+
+
+// Returns next value of xorshift64* pseudo random generator of the current thread
+static unsigned long long pkcs11_logger_sample_random(void)
+{
+    unsigned long long x = pkcs11_logger_sample_random_state;
+
+    // Note: Threads started at the same time get different sequences thanks to their IDs
+    if (0 == x)
+        x = (pkcs11_logger_utils_get_monotonic_time() ^ ((unsigned long long)pkcs11_logger_utils_get_thread_id() * 0x9E3779B97F4A7C15ULL)) | 1;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    pkcs11_logger_sample_random_state = x;
+
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+
+// Sets sampling rate of PKCS#11 functions specified by function or class name
+static int pkcs11_logger_sample_set_rate(const char *name, CK_ULONG rate, CK_BBOOL random)
+{
+    CK_BYTE functions[PKCS11_LOGGER_FUNCTION_BITMAP_SIZE];
+    CK_ULONG id = 0;
+
+    memset(functions, 0, sizeof(functions));
+    if (PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_translate_string_to_function_set(name, functions))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    for (id = 0; id < PKCS11_LOGGER_FUNCTION_COUNT; id++)
+    {
+        if (0 == (functions[id / 8] & (1 << (id % 8))))
+            continue;
+
+        pkcs11_logger_globals.sample_rates[id] = rate;
+        if (CK_TRUE == random)
+            pkcs11_logger_globals.sample_random[id / 8] |= (CK_BYTE)(1 << (id % 8));
+        else
+            pkcs11_logger_globals.sample_random[id / 8] &= (CK_BYTE)~(1 << (id % 8));
+    }
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Sets sampling rate of the entry of the list in "<function or class>=<rate>" format
+static int pkcs11_logger_sample_parse_rate(char *name, char *value, void *context)
+{
+    CK_ULONG rate = 0;
+    CK_BBOOL random = CK_FALSE;
+
+    IGNORE_ARG(context);
+
+    if (NULL == value)
+        return PKCS11_LOGGER_RV_ERROR;
+
+    random = ('~' == *value) ? CK_TRUE : CK_FALSE;
+    if (CK_TRUE == random)
+        value++;
+
+    if ((PKCS11_LOGGER_RV_SUCCESS != pkcs11_logger_utils_str_to_long(value, &rate)) || (0 == rate))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    // Note: Later entries override earlier ones so a class can be followed by exceptions for its functions
+    return pkcs11_logger_sample_set_rate(name, rate, random);
+}
+
+
+// Parses comma separated list of sampling rates in "<function or class>=<N>" (1 in N calls) or "<function or class>=~<N>" (random with probability 1/N) format
+int pkcs11_logger_sample_parse_rates(const char *list)
+{
+    return pkcs11_logger_utils_parse_list(list, pkcs11_logger_sample_parse_rate, NULL);
+}
+
+
+// Counts the call of PKCS#11 function and decides whether it is logged
+CK_BBOOL pkcs11_logger_sample_call(CK_ULONG function)
+{
+    CK_ULONG rate = pkcs11_logger_globals.sample_rates[function];
+    CK_ULONG calls = PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_sample_calls[function], 1);
+    CK_BBOOL logged = CK_FALSE;
+
+    // Note: Deterministic sampling logs the first call and then every N-th call of the function across all threads
+    if (0 != (pkcs11_logger_globals.sample_random[function / 8] & (1 << (function % 8))))
+        logged = (0 == pkcs11_logger_sample_random() % rate) ? CK_TRUE : CK_FALSE;
+    else
+        logged = (0 == (calls - 1) % rate) ? CK_TRUE : CK_FALSE;
+
+    if (CK_TRUE == logged)
+        PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_sample_logged[function], 1);
+
+    return logged;
+}
+
+
+// Logs numbers of calls and logged calls of sampled PKCS#11 functions that have been called
+void pkcs11_logger_sample_dump(const char *reason)
+{
+    CK_ULONG function = 0;
+    CK_BBOOL header = CK_FALSE;
+
+    for (function = 0; function < PKCS11_LOGGER_FUNCTION_COUNT; function++)
+    {
+        if ((pkcs11_logger_globals.sample_rates[function] < 2) || (0 == PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_sample_calls[function])))
+            continue;
+
+        if (CK_TRUE != header)
+        {
+            pkcs11_logger_log("Sampling of logged calls (dumped on %s)", reason);
+            header = CK_TRUE;
+        }
+
+        pkcs11_logger_log(" %s sampled %s 1 in %lu: %lu calls, %lu logged",
+            pkcs11_logger_translate_function_id(function),
+            (0 != (pkcs11_logger_globals.sample_random[function / 8] & (1 << (function % 8)))) ? "randomly" : "deterministically",
+            pkcs11_logger_globals.sample_rates[function],
+            PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_sample_calls[function]),
+            PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_sample_logged[function]));
+    }
+
+    if (CK_TRUE == header)
+        pkcs11_logger_log_separator();
+}
+
+
+// Resets numbers of calls of sampled PKCS#11 functions
+void pkcs11_logger_sample_stop(void)
+{
+    memset(pkcs11_logger_sample_calls, 0, sizeof(pkcs11_logger_sample_calls));
+    memset(pkcs11_logger_sample_logged, 0, sizeof(pkcs11_logger_sample_logged));
+}
@@ -0,0 +1,657 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Structure that describes one output of formatted log records other than the log file
+typedef struct
+{
+    // Name of the output
+    const char *name;
+    // Function that checks whether the output is enabled
+    CK_BBOOL (*is_enabled)(void);
+    // Function that writes formatted log record into the output (lock is held by the caller)
+    void (*write)(const char *data, size_t len);
+    // Function that writes buffered data of the output (lock is held by the caller)
+    void (*flush)(void);
+    // Function that releases resources of the output
+    void (*stop)(void);
+}
+PKCS11_LOGGER_SINK;
+
+
+#ifndef _WIN32
+// Flag indicating whether connection to the system logger has been opened
+static CK_BBOOL pkcs11_logger_sink_syslog_opened = CK_FALSE;
+// Addresses resolved from PKCS11_LOGGER_SOCKET environment variable
+static struct addrinfo *pkcs11_logger_sink_socket_addresses = NULL;
+// Address used by the last connection attempt
+static struct addrinfo *pkcs11_logger_sink_socket_address = NULL;
+// Socket (-1 when not connected)
+static int pkcs11_logger_sink_socket_fd = -1;
+// Flag indicating whether the connection of the socket is still being established
+static CK_BBOOL pkcs11_logger_sink_socket_connecting = CK_FALSE;
+// Time in seconds when the connection was last attempted
+static time_t pkcs11_logger_sink_socket_attempted = 0;
+// Unsent end of the last partially sent record
+static char *pkcs11_logger_sink_socket_pending = NULL;
+// Length of the unsent end of the last partially sent record
+static size_t pkcs11_logger_sink_socket_pending_len = 0;
+// Number of records dropped because they could not be sent without blocking
+static CK_ULONG pkcs11_logger_sink_socket_dropped = 0;
+#endif
+// Memory ring holding the most recent log records
+static char *pkcs11_logger_sink_ring = NULL;
+// Total number of bytes written into the memory ring
+static unsigned long long pkcs11_logger_sink_ring_written = 0;
+
+
+// Maximal time in seconds a connection of the socket is being established before it is attempted again
+#define SOCKET_CONNECT_TIMEOUT 5
+
+
+// Checks whether logging to stdout is enabled
+static CK_BBOOL pkcs11_logger_sink_stdout_is_enabled(void)
+{
+    unsigned long enable_stdout = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_STDOUT) == PKCS11_LOGGER_FLAG_ENABLE_STDOUT);
+
+    return (enable_stdout) ? CK_TRUE : CK_FALSE;
+}
+
+
+// Writes log record to stdout
+static void pkcs11_logger_sink_stdout_write(const char *data, size_t len)
+{
+    fwrite(data, 1, len, stdout);
+}
+
+
+// Writes buffered data of stdout
+static void pkcs11_logger_sink_stdout_flush(void)
+{
+    fflush(stdout);
+}
+
+
+// Checks whether logging to stderr is enabled
+static CK_BBOOL pkcs11_logger_sink_stderr_is_enabled(void)
+{
+    unsigned long enable_stderr = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_STDERR) == PKCS11_LOGGER_FLAG_ENABLE_STDERR);
+
+    // Note: Errors that occur before environment variables are read can be logged only to stderr
+    return (enable_stderr || (CK_FALSE == pkcs11_logger_globals.env_vars_read)) ? CK_TRUE : CK_FALSE;
+}
+
+
+// Writes log record to stderr
+static void pkcs11_logger_sink_stderr_write(const char *data, size_t len)
+{
+    fwrite(data, 1, len, stderr);
+}
+
+
+// Checks whether logging to the system logger is enabled
+static CK_BBOOL pkcs11_logger_sink_syslog_is_enabled(void)
+{
+#ifdef _WIN32
+    return CK_FALSE;
+#else
+    unsigned long enable_syslog = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_SYSLOG) == PKCS11_LOGGER_FLAG_ENABLE_SYSLOG);
+
+    return (enable_syslog) ? CK_TRUE : CK_FALSE;
+#endif
+}
+
+
+// Writes each line of log record to the system logger
+static void pkcs11_logger_sink_syslog_write(const char *data, size_t len)
+{
+#ifdef _WIN32
+    IGNORE_ARG(data);
+    IGNORE_ARG(len);
+#else
+    size_t line_len = 0;
+
+    if (CK_TRUE != pkcs11_logger_sink_syslog_opened)
+    {
+        openlog(PKCS11_LOGGER_NAME, LOG_NDELAY, LOG_USER);
+        pkcs11_logger_sink_syslog_opened = CK_TRUE;
+    }
+
+    // Note: Record of the function call contains multiple lines
+    while (len > 0)
+    {
+        for (line_len = 0; (line_len < len) && ('\n' != data[line_len]); line_len++);
+
+        syslog(LOG_INFO, "%.*s", (int)line_len, data);
+
+        if (line_len < len)
+            line_len++;
+
+        data += line_len;
+        len -= line_len;
+    }
+#endif
+}
+
+
+// Closes connection to the system logger
+static void pkcs11_logger_sink_syslog_stop(void)
+{
+#ifndef _WIN32
+    if (CK_TRUE == pkcs11_logger_sink_syslog_opened)
+    {
+        closelog();
+        pkcs11_logger_sink_syslog_opened = CK_FALSE;
+    }
+#endif
+}
+
+
+// Checks whether logging to the socket is enabled
+static CK_BBOOL pkcs11_logger_sink_socket_is_enabled(void)
+{
+#ifdef _WIN32
+    return CK_FALSE;
+#else
+    return (NULL != pkcs11_logger_sink_socket_addresses) ? CK_TRUE : CK_FALSE;
+#endif
+}
+
+
+#ifndef _WIN32
+
+// Closes the socket and discards the unsent end of the last partially sent record
+static void pkcs11_logger_sink_socket_close(void)
+{
+    if (-1 != pkcs11_logger_sink_socket_fd)
+    {
+        close(pkcs11_logger_sink_socket_fd);
+        pkcs11_logger_sink_socket_fd = -1;
+    }
+
+    pkcs11_logger_sink_socket_connecting = CK_FALSE;
+    CALL_N_CLEAR(free, pkcs11_logger_sink_socket_pending);
+    pkcs11_logger_sink_socket_pending_len = 0;
+}
+
+
+// Starts non-blocking connection to the next address resolved from PKCS11_LOGGER_SOCKET environment variable
+static void pkcs11_logger_sink_socket_connect(void)
+{
+    struct addrinfo *address = NULL;
+    time_t now = time(NULL);
+    int fd = -1;
+    int flags = 0;
+
+    // Note: Connection is attempted at most once per second and each attempt uses the next resolved address
+    if (now == pkcs11_logger_sink_socket_attempted)
+        return;
+
+    pkcs11_logger_sink_socket_attempted = now;
+
+    address = pkcs11_logger_sink_socket_address;
+    address = ((NULL == address) || (NULL == address->ai_next)) ? pkcs11_logger_sink_socket_addresses : address->ai_next;
+    pkcs11_logger_sink_socket_address = address;
+
+    fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (-1 == fd)
+        return;
+
+    flags = fcntl(fd, F_GETFL, 0);
+    if ((-1 == flags) || (-1 == fcntl(fd, F_SETFL, flags | O_NONBLOCK)))
+    {
+        close(fd);
+        return;
+    }
+
+#ifdef SO_NOSIGPIPE
+    flags = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &flags, sizeof(flags));
+#endif
+
+    if (0 == connect(fd, address->ai_addr, address->ai_addrlen))
+    {
+        pkcs11_logger_sink_socket_fd = fd;
+        pkcs11_logger_sink_socket_connecting = CK_FALSE;
+    }
+    else if (EINPROGRESS == errno)
+    {
+        pkcs11_logger_sink_socket_fd = fd;
+        pkcs11_logger_sink_socket_connecting = CK_TRUE;
+    }
+    else
+    {
+        close(fd);
+    }
+}
+
+
+// Checks without blocking whether the socket is connected
+static CK_BBOOL pkcs11_logger_sink_socket_is_connected(void)
+{
+    struct pollfd poll_fd;
+    int error = 0;
+    socklen_t error_len = sizeof(error);
+
+    if (-1 == pkcs11_logger_sink_socket_fd)
+        return CK_FALSE;
+
+    if (CK_TRUE != pkcs11_logger_sink_socket_connecting)
+        return CK_TRUE;
+
+    poll_fd.fd = pkcs11_logger_sink_socket_fd;
+    poll_fd.events = POLLOUT;
+    poll_fd.revents = 0;
+
+    if (poll(&poll_fd, 1, 0) <= 0)
+    {
+        // Note: Connection that is not established in time is attempted again with the next address
+        if (time(NULL) - pkcs11_logger_sink_socket_attempted >= SOCKET_CONNECT_TIMEOUT)
+            pkcs11_logger_sink_socket_close();
+
+        return CK_FALSE;
+    }
+
+    if ((0 != getsockopt(pkcs11_logger_sink_socket_fd, SOL_SOCKET, SO_ERROR, &error, &error_len)) || (0 != error))
+    {
+        pkcs11_logger_sink_socket_close();
+        return CK_FALSE;
+    }
+
+    pkcs11_logger_sink_socket_connecting = CK_FALSE;
+
+    return CK_TRUE;
+}
+
+
+// Sends as much data as the socket accepts without blocking and returns the number of sent bytes
+static size_t pkcs11_logger_sink_socket_send(const char *data, size_t len)
+{
+    ssize_t sent = 0;
+    size_t total = 0;
+    int flags = 0;
+
+#ifdef MSG_NOSIGNAL
+    flags = MSG_NOSIGNAL;
+#endif
+
+    while (total < len)
+    {
+        sent = send(pkcs11_logger_sink_socket_fd, data + total, len - total, flags);
+        if (sent < 0)
+        {
+            if (EINTR == errno)
+                continue;
+
+            // Note: Records are lost until the connection is reestablished
+            if ((EAGAIN != errno) && (EWOULDBLOCK != errno))
+                pkcs11_logger_sink_socket_close();
+
+            break;
+        }
+
+        total += (size_t)sent;
+    }
+
+    return total;
+}
+
+
+// Sends log record without blocking and returns CK_FALSE when the record has been dropped
+static CK_BBOOL pkcs11_logger_sink_socket_send_record(const char *data, size_t len)
+{
+    size_t sent = 0;
+
+    // Note: Record is never sent before the end of the previous partially sent record
+    if (0 != pkcs11_logger_sink_socket_pending_len)
+    {
+        sent = pkcs11_logger_sink_socket_send(pkcs11_logger_sink_socket_pending, pkcs11_logger_sink_socket_pending_len);
+        if (-1 == pkcs11_logger_sink_socket_fd)
+            return CK_FALSE;
+
+        pkcs11_logger_sink_socket_pending_len -= sent;
+        if (0 != pkcs11_logger_sink_socket_pending_len)
+        {
+            memmove(pkcs11_logger_sink_socket_pending, pkcs11_logger_sink_socket_pending + sent, pkcs11_logger_sink_socket_pending_len);
+            return CK_FALSE;
+        }
+
+        CALL_N_CLEAR(free, pkcs11_logger_sink_socket_pending);
+    }
+
+    sent = pkcs11_logger_sink_socket_send(data, len);
+    if ((-1 == pkcs11_logger_sink_socket_fd) || (0 == sent))
+        return CK_FALSE;
+
+    if (sent < len)
+    {
+        pkcs11_logger_sink_socket_pending = (char *) malloc(len - sent);
+        if (NULL == pkcs11_logger_sink_socket_pending)
+        {
+            // Note: Connection is reestablished so the peer does not receive partial record followed by another one
+            pkcs11_logger_sink_socket_close();
+            return CK_FALSE;
+        }
+
+        memcpy(pkcs11_logger_sink_socket_pending, data + sent, len - sent);
+        pkcs11_logger_sink_socket_pending_len = len - sent;
+    }
+
+    return CK_TRUE;
+}
+
+#endif
+
+
+// Writes log record to the socket
+static void pkcs11_logger_sink_socket_write(const char *data, size_t len)
+{
+#ifdef _WIN32
+    IGNORE_ARG(data);
+    IGNORE_ARG(len);
+#else
+    char notice[128];
+    int notice_len = 0;
+
+    if (-1 == pkcs11_logger_sink_socket_fd)
+        pkcs11_logger_sink_socket_connect();
+
+    // Note: Records are dropped while the connection is not established or the peer does not accept more data
+    if (CK_TRUE != pkcs11_logger_sink_socket_is_connected())
+    {
+        pkcs11_logger_sink_socket_dropped++;
+        return;
+    }
+
+    if (0 != pkcs11_logger_sink_socket_dropped)
+    {
+        notice_len = snprintf(notice, sizeof(notice), "*** %lu log records were dropped because they could not be sent to the socket ***\n", pkcs11_logger_sink_socket_dropped);
+        if ((notice_len <= 0) || (CK_TRUE != pkcs11_logger_sink_socket_send_record(notice, (size_t)notice_len)))
+        {
+            pkcs11_logger_sink_socket_dropped++;
+            return;
+        }
+
+        pkcs11_logger_sink_socket_dropped = 0;
+    }
+
+    if (CK_TRUE != pkcs11_logger_sink_socket_send_record(data, len))
+        pkcs11_logger_sink_socket_dropped++;
+#endif
+}
+
+
+// Closes the socket
+static void pkcs11_logger_sink_socket_stop(void)
+{
+#ifndef _WIN32
+    pkcs11_logger_sink_socket_close();
+
+    if (NULL != pkcs11_logger_sink_socket_addresses)
+    {
+        freeaddrinfo(pkcs11_logger_sink_socket_addresses);
+        pkcs11_logger_sink_socket_addresses = NULL;
+    }
+
+    pkcs11_logger_sink_socket_address = NULL;
+    pkcs11_logger_sink_socket_attempted = 0;
+    pkcs11_logger_sink_socket_dropped = 0;
+#endif
+}
+
+
+// Checks whether logging to the memory ring is enabled
+static CK_BBOOL pkcs11_logger_sink_ring_is_enabled(void)
+{
+    return (NULL != pkcs11_logger_sink_ring) ? CK_TRUE : CK_FALSE;
+}
+
+
+// Writes log record to the memory ring overwriting the oldest records
+static void pkcs11_logger_sink_ring_write(const char *data, size_t len)
+{
+    size_t size = (size_t)pkcs11_logger_globals.ring_size;
+    size_t offset = 0;
+    size_t part = 0;
+
+    // Note: Only the end of the record that is larger than the whole ring is kept
+    if (len > size)
+    {
+        pkcs11_logger_sink_ring_written += len - size;
+        data += len - size;
+        len = size;
+    }
+
+    offset = (size_t)(pkcs11_logger_sink_ring_written % size);
+    part = (len < size - offset) ? len : size - offset;
+
+    memcpy(pkcs11_logger_sink_ring + offset, data, part);
+    memcpy(pkcs11_logger_sink_ring, data + part, len - part);
+
+    pkcs11_logger_sink_ring_written += len;
+}
+
+
+// Writes contents of the memory ring into the file specified by PKCS11_LOGGER_RING_FILE_PATH environment variable
+static void pkcs11_logger_sink_ring_dump(void)
+{
+    size_t size = (size_t)pkcs11_logger_globals.ring_size;
+    size_t offset = 0;
+    size_t len = 0;
+    FILE *file = NULL;
+
+    if (NULL == pkcs11_logger_sink_ring)
+        return;
+
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable: 4996)
+#endif
+
+    file = fopen((const char *)pkcs11_logger_globals.env_var_ring_file_path, "wb");
+    if (NULL == file)
+        return;
+
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+    if (pkcs11_logger_sink_ring_written <= size)
+    {
+        fwrite(pkcs11_logger_sink_ring, 1, (size_t)pkcs11_logger_sink_ring_written, file);
+    }
+    else
+    {
+        // Note: The oldest record was partially overwritten so the ring is written from the next line
+        offset = (size_t)(pkcs11_logger_sink_ring_written % size);
+        for (len = 0; (len < size) && ('\n' != pkcs11_logger_sink_ring[(offset + len) % size]); len++);
+        offset = (offset + len + 1) % size;
+        len = size - len - 1;
+
+        if (offset + len <= size)
+        {
+            fwrite(pkcs11_logger_sink_ring + offset, 1, len, file);
+        }
+        else
+        {
+            fwrite(pkcs11_logger_sink_ring + offset, 1, size - offset, file);
+            fwrite(pkcs11_logger_sink_ring, 1, len - (size - offset), file);
+        }
+    }
+
+    fclose(file);
+}
+
+
+// Writes contents of the memory ring into the file and frees the ring
+static void pkcs11_logger_sink_ring_stop(void)
+{
+    pkcs11_logger_sink_ring_dump();
+    CALL_N_CLEAR(free, pkcs11_logger_sink_ring);
+    pkcs11_logger_sink_ring_written = 0;
+}
+
+
+// Outputs of formatted log records other than the log file
+static const PKCS11_LOGGER_SINK pkcs11_logger_sinks[] =
+{
+    { "stdout", pkcs11_logger_sink_stdout_is_enabled, pkcs11_logger_sink_stdout_write, pkcs11_logger_sink_stdout_flush, NULL },
+    { "stderr", pkcs11_logger_sink_stderr_is_enabled, pkcs11_logger_sink_stderr_write, NULL, NULL },
+    { "syslog", pkcs11_logger_sink_syslog_is_enabled, pkcs11_logger_sink_syslog_write, NULL, pkcs11_logger_sink_syslog_stop },
+    { "socket", pkcs11_logger_sink_socket_is_enabled, pkcs11_logger_sink_socket_write, NULL, pkcs11_logger_sink_socket_stop },
+    { "ring", pkcs11_logger_sink_ring_is_enabled, pkcs11_logger_sink_ring_write, NULL, pkcs11_logger_sink_ring_stop },
+};
+
+// Number of outputs of formatted log records other than the log file
+#define PKCS11_LOGGER_SINK_COUNT (sizeof(pkcs11_logger_sinks) / sizeof(PKCS11_LOGGER_SINK))
+
+
+// Prepares outputs configured by environment variables
+int pkcs11_logger_sink_start(void)
+{
+#ifndef _WIN32
+    const char *address = (const char *)pkcs11_logger_globals.env_var_socket;
+    const char *separator = NULL;
+    size_t host_len = 0;
+    char *host = NULL;
+    struct addrinfo hints;
+#endif
+
+    if (NULL != pkcs11_logger_globals.env_var_ring_file_path)
+    {
+        pkcs11_logger_sink_ring = (char *) malloc((size_t)pkcs11_logger_globals.ring_size);
+        if (NULL == pkcs11_logger_sink_ring)
+            return PKCS11_LOGGER_RV_ERROR;
+
+        pkcs11_logger_sink_ring_written = 0;
+    }
+
+    if (NULL != pkcs11_logger_globals.env_var_socket)
+    {
+#ifdef _WIN32
+        return PKCS11_LOGGER_RV_ERROR;
+#else
+        // Note: Port is separated by the last colon so IPv6 address needs to be enclosed in brackets
+        separator = strrchr(address, ':');
+        if ((NULL == separator) || (separator == address) || ('\0' == separator[1]))
+            return PKCS11_LOGGER_RV_ERROR;
+
+        host_len = (size_t)(separator - address);
+        if (('[' == address[0]) && (']' == address[host_len - 1]))
+        {
+            address++;
+            host_len -= 2;
+        }
+
+        host = (char *) malloc(host_len + 1);
+        if (NULL == host)
+            return PKCS11_LOGGER_RV_ERROR;
+
+        memcpy(host, address, host_len);
+        host[host_len] = '\0';
+
+        // Note: Address is resolved only once so the name resolution never blocks logging
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        if (0 != getaddrinfo(host, separator + 1, &hints, &pkcs11_logger_sink_socket_addresses))
+            pkcs11_logger_sink_socket_addresses = NULL;
+
+        CALL_N_CLEAR(free, host);
+
+        if (NULL == pkcs11_logger_sink_socket_addresses)
+            return PKCS11_LOGGER_RV_ERROR;
+#endif
+    }
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Checks whether any output other than the log file is enabled
+CK_BBOOL pkcs11_logger_sink_has_output(void)
+{
+    CK_ULONG i = 0;
+
+    for (i = 0; i < PKCS11_LOGGER_SINK_COUNT; i++)
+    {
+        if (CK_TRUE == pkcs11_logger_sinks[i].is_enabled())
+            return CK_TRUE;
+    }
+
+    return CK_FALSE;
+}
+
+
+// Writes formatted log record into all enabled outputs other than the log file (lock must be held by the caller)
+void pkcs11_logger_sink_write(const char *data, size_t len)
+{
+    CK_ULONG i = 0;
+
+    for (i = 0; i < PKCS11_LOGGER_SINK_COUNT; i++)
+    {
+        if (CK_TRUE == pkcs11_logger_sinks[i].is_enabled())
+            pkcs11_logger_sinks[i].write(data, len);
+    }
+}
+
+
+// Writes buffered data of all enabled outputs other than the log file (lock must be held by the caller)
+void pkcs11_logger_sink_flush(void)
+{
+    CK_ULONG i = 0;
+
+    for (i = 0; i < PKCS11_LOGGER_SINK_COUNT; i++)
+    {
+        if ((NULL != pkcs11_logger_sinks[i].flush) && (CK_TRUE == pkcs11_logger_sinks[i].is_enabled()))
+            pkcs11_logger_sinks[i].flush();
+    }
+}
+
+
+// Writes contents of the memory ring into its file
+void pkcs11_logger_sink_dump(void)
+{
+    pkcs11_logger_lock_acquire();
+    pkcs11_logger_sink_ring_dump();
+    pkcs11_logger_lock_release();
+}
+
+
+// Releases resources of all outputs other than the log file
+void pkcs11_logger_sink_stop(void)
+{
+    CK_ULONG i = 0;
+
+    // Note: Background writer thread is already stopped and globals are being reset so there is no need for lock
+    for (i = 0; i < PKCS11_LOGGER_SINK_COUNT; i++)
+    {
+        if (NULL != pkcs11_logger_sinks[i].stop)
+            pkcs11_logger_sinks[i].stop();
+    }
+}
@@ -0,0 +1,530 @@
+/*
+ *  Copyright 2011-2025 The Pkcs11Interop Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ *  Written for the Pkcs11Interop project by:
+ *  Jaroslav IMRICH <jimrich@jimrich.sk>
+ */
+
+
+#include "pkcs11-logger.h"
+
+
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Structure that holds latency histogram of one PKCS#11 function returning one CK_RV value
+typedef struct
+{
+    // Value returned by the function
+    CK_RV rv;
+    // Number of measured calls
+    CK_ULONG count;
+    // Sum of measured latencies in nanoseconds
+    unsigned long long sum;
+    // Lowest measured latency in nanoseconds
+    unsigned long long min;
+    // Highest measured latency in nanoseconds
+    unsigned long long max;
+    // Number of calls in each latency bucket
+    CK_ULONG buckets[PKCS11_LOGGER_STATS_BUCKETS];
+}
+PKCS11_LOGGER_STATS_HISTOGRAM;
+
+
+// Structure that holds latency histograms collected by one thread
+typedef struct PKCS11_LOGGER_STATS_THREAD
+{
+    // Next thread in the list
+    struct PKCS11_LOGGER_STATS_THREAD *next;
+    // Flag indicating whether the thread has exited and its histograms can be reused by another thread
+    CK_ULONG retired;
+    // Histograms of each function (the last one collects all CK_RV values that did not fit into the others)
+    PKCS11_LOGGER_STATS_HISTOGRAM *histograms[PKCS11_LOGGER_FUNCTION_COUNT][PKCS11_LOGGER_STATS_RV_SLOTS];
+}
+PKCS11_LOGGER_STATS_THREAD;
+
+
+// Histograms of all threads that have called PKCS#11 function
+static PKCS11_LOGGER_STATS_THREAD *pkcs11_logger_stats_threads = NULL;
+// Generation of the histograms that gets incremented whenever they are freed
+static CK_ULONG pkcs11_logger_stats_generation = 0;
+// Time in seconds when the histograms were last dumped
+static CK_ULONG pkcs11_logger_stats_last_dump = 0;
+// Flag indicating whether the dump has been requested by the signal
+static volatile CK_ULONG pkcs11_logger_stats_signaled = 0;
+#ifndef _WIN32
+// Flag indicating whether the signal handler has been installed
+static CK_BBOOL pkcs11_logger_stats_handler_installed = CK_FALSE;
+// Signal handler that was installed before the logger
+static struct sigaction pkcs11_logger_stats_old_action;
+// Key that retires histograms of the thread that exits
+static pthread_key_t pkcs11_logger_stats_key;
+// Flag indicating whether the key has been created
+static CK_BBOOL pkcs11_logger_stats_key_created = CK_FALSE;
+#endif
+
+// Histograms of the current thread
+static PKCS11_LOGGER_THREAD_LOCAL PKCS11_LOGGER_STATS_THREAD *pkcs11_logger_stats_thread = NULL;
+// Generation of the histograms of the current thread
+static PKCS11_LOGGER_THREAD_LOCAL CK_ULONG pkcs11_logger_stats_thread_generation = 0;
+// Monotonic time in nanoseconds when the current thread called the original function
+static PKCS11_LOGGER_THREAD_LOCAL unsigned long long pkcs11_logger_stats_start_time = 0;
+
+
+// Returns index of the bucket for the latency
+static CK_ULONG pkcs11_logger_stats_get_bucket(unsigned long long latency)
+{
+    CK_ULONG exponent = 0;
+
+    // Note: Each power of two is divided into PKCS11_LOGGER_STATS_SUB_BUCKETS linear buckets
+    if (latency < PKCS11_LOGGER_STATS_SUB_BUCKETS)
+        return (CK_ULONG)latency;
+
+#ifdef _WIN32
+    while ((latency >> exponent) > 1)
+        exponent++;
+#else
+    exponent = 63 - __builtin_clzll(latency);
+#endif
+
+    return (exponent - PKCS11_LOGGER_STATS_SUB_BUCKET_BITS + 1) * PKCS11_LOGGER_STATS_SUB_BUCKETS + (CK_ULONG)((latency >> (exponent - PKCS11_LOGGER_STATS_SUB_BUCKET_BITS)) & (PKCS11_LOGGER_STATS_SUB_BUCKETS - 1));
+}
+
+
+// Returns the highest latency that falls into the bucket
+static unsigned long long pkcs11_logger_stats_get_bucket_limit(CK_ULONG bucket)
+{
+    CK_ULONG shift = 0;
+    CK_ULONG sub_bucket = 0;
+
+    if (bucket < PKCS11_LOGGER_STATS_SUB_BUCKETS)
+        return bucket;
+
+    shift = bucket / PKCS11_LOGGER_STATS_SUB_BUCKETS - 1;
+    sub_bucket = bucket % PKCS11_LOGGER_STATS_SUB_BUCKETS;
+
+    return ((unsigned long long)(PKCS11_LOGGER_STATS_SUB_BUCKETS + sub_bucket + 1) << shift) - 1;
+}
+
+
+// Returns histograms of the current thread
+static PKCS11_LOGGER_STATS_THREAD* pkcs11_logger_stats_get_thread(void)
+{
+    PKCS11_LOGGER_STATS_THREAD *thread = NULL;
+    CK_ULONG generation = PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_stats_generation);
+
+    // Note: Histograms of the thread are lost when all histograms have been freed
+    if ((NULL != pkcs11_logger_stats_thread) && (generation == pkcs11_logger_stats_thread_generation))
+        return pkcs11_logger_stats_thread;
+
+    // Note: Histograms of exited threads are reused so the memory does not grow with the number of short-lived threads
+    thread = (PKCS11_LOGGER_STATS_THREAD*) PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_stats_threads, NULL, NULL);
+    for (; NULL != thread; thread = thread->next)
+    {
+        if ((0 != PKCS11_LOGGER_ATOMIC_LOAD(&(thread->retired))) && (0 != PKCS11_LOGGER_ATOMIC_XCHG(&(thread->retired), 0)))
+            break;
+    }
+
+    if (NULL == thread)
+    {
+        thread = (PKCS11_LOGGER_STATS_THREAD*) malloc(sizeof(PKCS11_LOGGER_STATS_THREAD));
+        if (NULL == thread)
+            return NULL;
+
+        memset(thread, 0, sizeof(PKCS11_LOGGER_STATS_THREAD));
+
+        // Note: Histograms of the thread are published into the list without taking the lock
+        do
+        {
+            thread->next = (PKCS11_LOGGER_STATS_THREAD*) PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_stats_threads, NULL, NULL);
+        }
+        while (thread->next != PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_stats_threads, thread->next, thread));
+    }
+
+#ifndef _WIN32
+    // Note: Histograms of the thread that exits are retired by the key destructor
+    if (CK_TRUE == pkcs11_logger_stats_key_created)
+        pthread_setspecific(pkcs11_logger_stats_key, thread);
+#endif
+
+    pkcs11_logger_stats_thread = thread;
+    pkcs11_logger_stats_thread_generation = generation;
+
+    return thread;
+}
+
+
+// Returns histogram of the function returning the value
+static PKCS11_LOGGER_STATS_HISTOGRAM* pkcs11_logger_stats_get_histogram(PKCS11_LOGGER_STATS_THREAD *thread, CK_ULONG function, CK_RV rv)
+{
+    PKCS11_LOGGER_STATS_HISTOGRAM *histogram = NULL;
+    CK_ULONG i = 0;
+
+    for (i = 0; i < PKCS11_LOGGER_STATS_RV_SLOTS; i++)
+    {
+        histogram = thread->histograms[function][i];
+
+        // Note: Last histogram collects all values that did not fit into the others
+        if ((NULL != histogram) && ((histogram->rv == rv) || (PKCS11_LOGGER_STATS_RV_SLOTS - 1 == i)))
+            return histogram;
+
+        if (NULL == histogram)
+            break;
+    }
+
+    histogram = (PKCS11_LOGGER_STATS_HISTOGRAM*) malloc(sizeof(PKCS11_LOGGER_STATS_HISTOGRAM));
+    if (NULL == histogram)
+        return NULL;
+
+    memset(histogram, 0, sizeof(PKCS11_LOGGER_STATS_HISTOGRAM));
+    histogram->rv = (PKCS11_LOGGER_STATS_RV_SLOTS - 1 == i) ? CK_UNAVAILABLE_INFORMATION : rv;
+    histogram->min = (unsigned long long)-1;
+
+    // Note: Initialized histogram becomes visible to the thread that dumps the histograms
+    (void) PKCS11_LOGGER_ATOMIC_XCHG_PTR(&(thread->histograms[function][i]), histogram);
+
+    return histogram;
+}
+
+
+#ifndef _WIN32
+
+// Retires histograms of the thread that exits
+static void pkcs11_logger_stats_destroy(void *thread)
+{
+    IGNORE_ARG(thread);
+
+    pkcs11_logger_stats_release();
+}
+
+
+// Requests dump of the histograms from the signal handler
+static void pkcs11_logger_stats_signal_handler(int signum)
+{
+    IGNORE_ARG(signum);
+
+    // Note: Logging is not async-signal-safe so the histograms are dumped by the next PKCS#11 function call
+    pkcs11_logger_stats_signaled = 1;
+}
+
+#endif
+
+
+// Dumps histograms when requested by the signal or when the dump interval has elapsed
+static void pkcs11_logger_stats_check_dump(void)
+{
+    CK_ULONG now = 0;
+    CK_ULONG last_dump = 0;
+
+    // Note: Only the thread that clears the flag dumps the histograms
+    if ((0 != pkcs11_logger_stats_signaled) && (0 != PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_stats_signaled, 0)))
+    {
+        pkcs11_logger_stats_dump("signal");
+        return;
+    }
+
+    if (0 == pkcs11_logger_globals.stats_interval)
+        return;
+
+    now = (CK_ULONG) time(NULL);
+    last_dump = PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_stats_last_dump);
+
+    // Note: First interval starts with the first measured call
+    if (0 == last_dump)
+    {
+        PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_stats_last_dump, now);
+        return;
+    }
+
+    if (now - last_dump < pkcs11_logger_globals.stats_interval)
+        return;
+
+    // Note: Only the thread that updates the time of the last dump dumps the histograms
+    if (last_dump == PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_stats_last_dump, now))
+        pkcs11_logger_stats_dump("interval");
+}
+
+
+// Prepares retirement of histograms of exiting threads and installs signal handler that requests dump of the histograms
+int pkcs11_logger_stats_start(void)
+{
+#ifdef _WIN32
+
+    if (0 != pkcs11_logger_globals.stats_signal)
+        return PKCS11_LOGGER_RV_ERROR;
+
+#else
+
+    struct sigaction action;
+
+    if (CK_TRUE != pkcs11_logger_stats_key_created)
+    {
+        if (0 != pthread_key_create(&pkcs11_logger_stats_key, pkcs11_logger_stats_destroy))
+            return PKCS11_LOGGER_RV_ERROR;
+
+        pkcs11_logger_stats_key_created = CK_TRUE;
+    }
+
+    if ((0 == pkcs11_logger_globals.stats_signal) || (CK_TRUE == pkcs11_logger_stats_handler_installed))
+        return PKCS11_LOGGER_RV_SUCCESS;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = pkcs11_logger_stats_signal_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    if (0 != sigaction((int)pkcs11_logger_globals.stats_signal, &action, &pkcs11_logger_stats_old_action))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    pkcs11_logger_stats_handler_installed = CK_TRUE;
+
+#endif
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Remembers the time when the current thread called the original function
+void pkcs11_logger_stats_begin(void)
+{
+    pkcs11_logger_stats_start_time = pkcs11_logger_utils_get_monotonic_time();
+}
+
+
+// Adds the latency of original function called by the current thread into its histogram
+CK_RV pkcs11_logger_stats_end(CK_ULONG function, CK_RV rv)
+{
+    unsigned long long latency = pkcs11_logger_utils_get_monotonic_time() - pkcs11_logger_stats_start_time;
+    PKCS11_LOGGER_STATS_THREAD *thread = NULL;
+    PKCS11_LOGGER_STATS_HISTOGRAM *histogram = NULL;
+
+    thread = pkcs11_logger_stats_get_thread();
+    if (NULL == thread)
+        return rv;
+
+    histogram = pkcs11_logger_stats_get_histogram(thread, function, rv);
+    if (NULL == histogram)
+        return rv;
+
+    // Note: Histogram is modified only by its thread so no lock or atomic operation is needed
+    histogram->count++;
+    histogram->sum += latency;
+    if (latency < histogram->min)
+        histogram->min = latency;
+    if (latency > histogram->max)
+        histogram->max = latency;
+    histogram->buckets[pkcs11_logger_stats_get_bucket(latency)]++;
+
+    pkcs11_logger_stats_check_dump();
+
+    return rv;
+}
+
+
+// Allows histograms of the current thread to be reused by another thread
+void pkcs11_logger_stats_release(void)
+{
+    PKCS11_LOGGER_STATS_THREAD *thread = pkcs11_logger_stats_thread;
+
+    if (NULL == thread)
+        return;
+
+    pkcs11_logger_stats_thread = NULL;
+
+#ifndef _WIN32
+    if (CK_TRUE == pkcs11_logger_stats_key_created)
+        pthread_setspecific(pkcs11_logger_stats_key, NULL);
+#endif
+
+    // Note: Histograms that have already been freed together with all the others must not be touched
+    if (PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_stats_generation) == pkcs11_logger_stats_thread_generation)
+        (void) PKCS11_LOGGER_ATOMIC_XCHG(&(thread->retired), 1);
+}
+
+
+// Logs latency histograms of all threads merged by function and CK_RV value
+void pkcs11_logger_stats_dump(const char *reason)
+{
+    PKCS11_LOGGER_STATS_HISTOGRAM *merged[PKCS11_LOGGER_STATS_MERGED_SLOTS];
+    PKCS11_LOGGER_STATS_HISTOGRAM *histogram = NULL;
+    PKCS11_LOGGER_STATS_THREAD *thread = NULL;
+    CK_ULONG function = 0;
+    CK_ULONG i = 0;
+    CK_ULONG j = 0;
+    CK_ULONG k = 0;
+
+    unsigned long enable_stats = ((pkcs11_logger_globals.flags & PKCS11_LOGGER_FLAG_ENABLE_STATS) == PKCS11_LOGGER_FLAG_ENABLE_STATS);
+
+    // Note: Features with their own counters report them on C_Finalize even when latency statistics are not collected
+    if (!enable_stats)
+    {
+        if ((0 != pkcs11_logger_globals.cache_ttl) || (0 != pkcs11_logger_globals.pool_size) || (0 != pkcs11_logger_globals.coalesce_size))
+        {
+            pkcs11_logger_log_separator();
+            pkcs11_logger_cache_dump(reason);
+            pkcs11_logger_pool_dump(reason);
+            pkcs11_logger_coalesce_dump(reason);
+        }
+
+        return;
+    }
+
+    pkcs11_logger_log_separator();
+    pkcs11_logger_log("Latency statistics of original library (dumped on %s)", reason);
+
+    for (function = 0; function < PKCS11_LOGGER_FUNCTION_COUNT; function++)
+    {
+        memset(merged, 0, sizeof(merged));
+
+        // Note: Histograms can be updated by their threads while they are being merged
+        thread = (PKCS11_LOGGER_STATS_THREAD*) PKCS11_LOGGER_ATOMIC_CAS_PTR(&pkcs11_logger_stats_threads, NULL, NULL);
+        for (; NULL != thread; thread = thread->next)
+        {
+            for (i = 0; i < PKCS11_LOGGER_STATS_RV_SLOTS; i++)
+            {
+                histogram = (PKCS11_LOGGER_STATS_HISTOGRAM*) PKCS11_LOGGER_ATOMIC_CAS_PTR(&(thread->histograms[function][i]), NULL, NULL);
+                if ((NULL == histogram) || (0 == histogram->count))
+                    continue;
+
+                // Note: Last merged histogram collects all values that did not fit into the others
+                for (j = 0; j < PKCS11_LOGGER_STATS_MERGED_SLOTS - 1; j++)
+                {
+                    if ((NULL == merged[j]) || (merged[j]->rv == histogram->rv))
+                        break;
+                }
+
+                if (NULL == merged[j])
+                {
+                    merged[j] = (PKCS11_LOGGER_STATS_HISTOGRAM*) malloc(sizeof(PKCS11_LOGGER_STATS_HISTOGRAM));
+                    if (NULL == merged[j])
+                        continue;
+
+                    memset(merged[j], 0, sizeof(PKCS11_LOGGER_STATS_HISTOGRAM));
+                    merged[j]->rv = (PKCS11_LOGGER_STATS_MERGED_SLOTS - 1 == j) ? CK_UNAVAILABLE_INFORMATION : histogram->rv;
+                    merged[j]->min = (unsigned long long)-1;
+                }
+
+                merged[j]->sum += histogram->sum;
+                if (histogram->min < merged[j]->min)
+                    merged[j]->min = histogram->min;
+                if (histogram->max > merged[j]->max)
+                    merged[j]->max = histogram->max;
+                for (k = 0; k < PKCS11_LOGGER_STATS_BUCKETS; k++)
+                {
+                    merged[j]->buckets[k] += histogram->buckets[k];
+                    merged[j]->count += histogram->buckets[k];
+                }
+            }
+        }
+
+        for (j = 0; j < PKCS11_LOGGER_STATS_MERGED_SLOTS; j++)
+        {
+            unsigned long long percentiles[4] = { 0, 0, 0, 0 };
+            const CK_ULONG permille[4] = { 500, 900, 990, 999 };
+            unsigned long long seen = 0;
+
+            if (NULL == merged[j])
+                continue;
+
+            if (0 == merged[j]->count)
+            {
+                CALL_N_CLEAR(free, merged[j]);
+                continue;
+            }
+
+            for (i = 0, k = 0; (i < 4) && (k < PKCS11_LOGGER_STATS_BUCKETS); k++)
+            {
+                seen += merged[j]->buckets[k];
+                while ((i < 4) && (seen * 1000 >= (unsigned long long)merged[j]->count * permille[i]))
+                    percentiles[i++] = pkcs11_logger_stats_get_bucket_limit(k);
+            }
+
+            // Note: Bucket limits are only approximations of the measured latencies
+            for (i = 0; i < 4; i++)
+            {
+                if (percentiles[i] > merged[j]->max)
+                    percentiles[i] = merged[j]->max;
+                if (percentiles[i] < merged[j]->min)
+                    percentiles[i] = merged[j]->min;
+            }
+
+            pkcs11_logger_log(" %s returning %s: count %lu, min %llu ns, mean %llu ns, p50 %llu ns, p90 %llu ns, p99 %llu ns, p99.9 %llu ns, max %llu ns",
+                pkcs11_logger_translate_function_id(function),
+                (CK_UNAVAILABLE_INFORMATION == merged[j]->rv) ? "other values" : pkcs11_logger_translate_ck_rv(merged[j]->rv),
+                merged[j]->count,
+                merged[j]->min,
+                merged[j]->sum / merged[j]->count,
+                percentiles[0],
+                percentiles[1],
+                percentiles[2],
+                percentiles[3],
+                merged[j]->max);
+
+            CALL_N_CLEAR(free, merged[j]);
+        }
+    }
+
+    pkcs11_logger_log_separator();
+    pkcs11_logger_sample_dump(reason);
+    pkcs11_logger_cache_dump(reason);
+    pkcs11_logger_pool_dump(reason);
+    pkcs11_logger_coalesce_dump(reason);
+    pkcs11_logger_arena_dump(reason);
+}
+
+
+// Removes signal handler and frees histograms of all threads
+void pkcs11_logger_stats_stop(void)
+{
+    PKCS11_LOGGER_STATS_THREAD *thread = NULL;
+    CK_ULONG i = 0;
+    CK_ULONG j = 0;
+
+#ifndef _WIN32
+    if (CK_TRUE == pkcs11_logger_stats_handler_installed)
+    {
+        sigaction((int)pkcs11_logger_globals.stats_signal, &pkcs11_logger_stats_old_action, NULL);
+        pkcs11_logger_stats_handler_installed = CK_FALSE;
+    }
+
+    // Note: Histograms of other threads are freed below so they must no longer be retired when the threads exit
+    if (CK_TRUE == pkcs11_logger_stats_key_created)
+    {
+        pthread_key_delete(pkcs11_logger_stats_key);
+        pkcs11_logger_stats_key_created = CK_FALSE;
+    }
+#endif
+
+    pkcs11_logger_stats_signaled = 0;
+    pkcs11_logger_stats_last_dump = 0;
+
+    // Note: Threads detect freed histograms by the changed generation
+    PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_stats_generation, 1);
+
+    thread = (PKCS11_LOGGER_STATS_THREAD*) PKCS11_LOGGER_ATOMIC_XCHG_PTR(&pkcs11_logger_stats_threads, NULL);
+    while (NULL != thread)
+    {
+        PKCS11_LOGGER_STATS_THREAD *next = thread->next;
+
+        for (i = 0; i < PKCS11_LOGGER_FUNCTION_COUNT; i++)
+            for (j = 0; j < PKCS11_LOGGER_STATS_RV_SLOTS; j++)
+                CALL_N_CLEAR(free, thread->histograms[i][j]);
+
+        CALL_N_CLEAR(free, thread);
+        thread = next;
+    }
+}
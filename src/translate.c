@@ -23,1068 +23,504 @@
 #include "pkcs11-logger.h"
 
 
-// Translates CK_RV to string
-const char* pkcs11_logger_translate_ck_rv(CK_RV rv)
-{
-    const char *rv_name = NULL;
-
-    switch (rv)
-    {
-        case CKR_OK:
-            rv_name = "CKR_OK";
-            break;
-        case CKR_CANCEL:
-            rv_name = "CKR_CANCEL";
-            break;
-        case CKR_HOST_MEMORY:
-            rv_name = "CKR_HOST_MEMORY";
-            break;
-        case CKR_SLOT_ID_INVALID:
-            rv_name = "CKR_SLOT_ID_INVALID";
-            break;
-        case CKR_GENERAL_ERROR:
-            rv_name = "CKR_GENERAL_ERROR";
-            break;
-        case CKR_FUNCTION_FAILED:
-            rv_name = "CKR_FUNCTION_FAILED";
-            break;
-        case CKR_ARGUMENTS_BAD:
-            rv_name = "CKR_ARGUMENTS_BAD";
-            break;
-        case CKR_NO_EVENT:
-            rv_name = "CKR_NO_EVENT";
-            break;
-        case CKR_NEED_TO_CREATE_THREADS:
-            rv_name = "CKR_NEED_TO_CREATE_THREADS";
-            break;
-        case CKR_CANT_LOCK:
-            rv_name = "CKR_CANT_LOCK";
-            break;
-        case CKR_ATTRIBUTE_READ_ONLY:
-            rv_name = "CKR_ATTRIBUTE_READ_ONLY";
-            break;
-        case CKR_ATTRIBUTE_SENSITIVE:
-            rv_name = "CKR_ATTRIBUTE_SENSITIVE";
-            break;
-        case CKR_ATTRIBUTE_TYPE_INVALID:
-            rv_name = "CKR_ATTRIBUTE_TYPE_INVALID";
-            break;
-        case CKR_ATTRIBUTE_VALUE_INVALID:
-            rv_name = "CKR_ATTRIBUTE_VALUE_INVALID";
-            break;
-        case CKR_DATA_INVALID:
-            rv_name = "CKR_DATA_INVALID";
-            break;
-        case CKR_DATA_LEN_RANGE:
-            rv_name = "CKR_DATA_LEN_RANGE";
-            break;
-        case CKR_DEVICE_ERROR:
-            rv_name = "CKR_DEVICE_ERROR";
-            break;
-        case CKR_DEVICE_MEMORY:
-            rv_name = "CKR_DEVICE_MEMORY";
-            break;
-        case CKR_DEVICE_REMOVED:
-            rv_name = "CKR_DEVICE_REMOVED";
-            break;
-        case CKR_ENCRYPTED_DATA_INVALID:
-            rv_name = "CKR_ENCRYPTED_DATA_INVALID";
-            break;
-        case CKR_ENCRYPTED_DATA_LEN_RANGE:
-            rv_name = "CKR_ENCRYPTED_DATA_LEN_RANGE";
-            break;
-        case CKR_FUNCTION_CANCELED:
-            rv_name = "CKR_FUNCTION_CANCELED";
-            break;
-        case CKR_FUNCTION_NOT_PARALLEL:
-            rv_name = "CKR_FUNCTION_NOT_PARALLEL";
-            break;
-        case CKR_FUNCTION_NOT_SUPPORTED:
-            rv_name = "CKR_FUNCTION_NOT_SUPPORTED";
-            break;
-        case CKR_KEY_HANDLE_INVALID:
-            rv_name = "CKR_KEY_HANDLE_INVALID";
-            break;
-        case CKR_KEY_SIZE_RANGE:
-            rv_name = "CKR_KEY_SIZE_RANGE";
-            break;
-        case CKR_KEY_TYPE_INCONSISTENT:
-            rv_name = "CKR_KEY_TYPE_INCONSISTENT";
-            break;
-        case CKR_KEY_NOT_NEEDED:
-            rv_name = "CKR_KEY_NOT_NEEDED";
-            break;
-        case CKR_KEY_CHANGED:
-            rv_name = "CKR_KEY_CHANGED";
-            break;
-        case CKR_KEY_NEEDED:
-            rv_name = "CKR_KEY_NEEDED";
-            break;
-        case CKR_KEY_INDIGESTIBLE:
-            rv_name = "CKR_KEY_INDIGESTIBLE";
-            break;
-        case CKR_KEY_FUNCTION_NOT_PERMITTED:
-            rv_name = "CKR_KEY_FUNCTION_NOT_PERMITTED";
-            break;
-        case CKR_KEY_NOT_WRAPPABLE:
-            rv_name = "CKR_KEY_NOT_WRAPPABLE";
-            break;
-        case CKR_KEY_UNEXTRACTABLE:
-            rv_name = "CKR_KEY_UNEXTRACTABLE";
-            break;
-        case CKR_MECHANISM_INVALID:
-            rv_name = "CKR_MECHANISM_INVALID";
-            break;
-        case CKR_MECHANISM_PARAM_INVALID:
-            rv_name = "CKR_MECHANISM_PARAM_INVALID";
-            break;
-        case CKR_OBJECT_HANDLE_INVALID:
-            rv_name = "CKR_OBJECT_HANDLE_INVALID";
-            break;
-        case CKR_OPERATION_ACTIVE:
-            rv_name = "CKR_OPERATION_ACTIVE";
-            break;
-        case CKR_OPERATION_NOT_INITIALIZED:
-            rv_name = "CKR_OPERATION_NOT_INITIALIZED";
-            break;
-        case CKR_PIN_INCORRECT:
-            rv_name = "CKR_PIN_INCORRECT";
-            break;
-        case CKR_PIN_INVALID:
-            rv_name = "CKR_PIN_INVALID";
-            break;
-        case CKR_PIN_LEN_RANGE:
-            rv_name = "CKR_PIN_LEN_RANGE";
-            break;
-        case CKR_PIN_EXPIRED:
-            rv_name = "CKR_PIN_EXPIRED";
-            break;
-        case CKR_PIN_LOCKED:
-            rv_name = "CKR_PIN_LOCKED";
-            break;
-        case CKR_SESSION_CLOSED:
-            rv_name = "CKR_SESSION_CLOSED";
-            break;
-        case CKR_SESSION_COUNT:
-            rv_name = "CKR_SESSION_COUNT";
-            break;
-        case CKR_SESSION_HANDLE_INVALID:
-            rv_name = "CKR_SESSION_HANDLE_INVALID";
-            break;
-        case CKR_SESSION_PARALLEL_NOT_SUPPORTED:
-            rv_name = "CKR_SESSION_PARALLEL_NOT_SUPPORTED";
-            break;
-        case CKR_SESSION_READ_ONLY:
-            rv_name = "CKR_SESSION_READ_ONLY";
-            break;
-        case CKR_SESSION_EXISTS:
-            rv_name = "CKR_SESSION_EXISTS";
-            break;
-        case CKR_SESSION_READ_ONLY_EXISTS:
-            rv_name = "CKR_SESSION_READ_ONLY_EXISTS";
-            break;
-        case CKR_SESSION_READ_WRITE_SO_EXISTS:
-            rv_name = "CKR_SESSION_READ_WRITE_SO_EXISTS";
-            break;
-        case CKR_SIGNATURE_INVALID:
-            rv_name = "CKR_SIGNATURE_INVALID";
-            break;
-        case CKR_SIGNATURE_LEN_RANGE:
-            rv_name = "CKR_SIGNATURE_LEN_RANGE";
-            break;
-        case CKR_TEMPLATE_INCOMPLETE:
-            rv_name = "CKR_TEMPLATE_INCOMPLETE";
-            break;
-        case CKR_TEMPLATE_INCONSISTENT:
-            rv_name = "CKR_TEMPLATE_INCONSISTENT";
-            break;
-        case CKR_TOKEN_NOT_PRESENT:
-            rv_name = "CKR_TOKEN_NOT_PRESENT";
-            break;
-        case CKR_TOKEN_NOT_RECOGNIZED:
-            rv_name = "CKR_TOKEN_NOT_RECOGNIZED";
-            break;
-        case CKR_TOKEN_WRITE_PROTECTED:
-            rv_name = "CKR_TOKEN_WRITE_PROTECTED";
-            break;
-        case CKR_UNWRAPPING_KEY_HANDLE_INVALID:
-            rv_name = "CKR_UNWRAPPING_KEY_HANDLE_INVALID";
-            break;
-        case CKR_UNWRAPPING_KEY_SIZE_RANGE:
-            rv_name = "CKR_UNWRAPPING_KEY_SIZE_RANGE";
-            break;
-        case CKR_UNWRAPPING_KEY_TYPE_INCONSISTENT:
-            rv_name = "CKR_UNWRAPPING_KEY_TYPE_INCONSISTENT";
-            break;
-        case CKR_USER_ALREADY_LOGGED_IN:
-            rv_name = "CKR_USER_ALREADY_LOGGED_IN";
-            break;
-        case CKR_USER_NOT_LOGGED_IN:
-            rv_name = "CKR_USER_NOT_LOGGED_IN";
-            break;
-        case CKR_USER_PIN_NOT_INITIALIZED:
-            rv_name = "CKR_USER_PIN_NOT_INITIALIZED";
-            break;
-        case CKR_USER_TYPE_INVALID:
-            rv_name = "CKR_USER_TYPE_INVALID";
-            break;
-        case CKR_USER_ANOTHER_ALREADY_LOGGED_IN:
-            rv_name = "CKR_USER_ANOTHER_ALREADY_LOGGED_IN";
-            break;
-        case CKR_USER_TOO_MANY_TYPES:
-            rv_name = "CKR_USER_TOO_MANY_TYPES";
-            break;
-        case CKR_WRAPPED_KEY_INVALID:
-            rv_name = "CKR_WRAPPED_KEY_INVALID";
-            break;
-        case CKR_WRAPPED_KEY_LEN_RANGE:
-            rv_name = "CKR_WRAPPED_KEY_LEN_RANGE";
-            break;
-        case CKR_WRAPPING_KEY_HANDLE_INVALID:
-            rv_name = "CKR_WRAPPING_KEY_HANDLE_INVALID";
-            break;
-        case CKR_WRAPPING_KEY_SIZE_RANGE:
-            rv_name = "CKR_WRAPPING_KEY_SIZE_RANGE";
-            break;
-        case CKR_WRAPPING_KEY_TYPE_INCONSISTENT:
-            rv_name = "CKR_WRAPPING_KEY_TYPE_INCONSISTENT";
-            break;
-        case CKR_RANDOM_SEED_NOT_SUPPORTED:
-            rv_name = "CKR_RANDOM_SEED_NOT_SUPPORTED";
-            break;
-        case CKR_RANDOM_NO_RNG:
-            rv_name = "CKR_RANDOM_NO_RNG";
-            break;
-        case CKR_DOMAIN_PARAMS_INVALID:
-            rv_name = "CKR_DOMAIN_PARAMS_INVALID";
-            break;
-        case CKR_BUFFER_TOO_SMALL:
-            rv_name = "CKR_BUFFER_TOO_SMALL";
-            break;
-        case CKR_SAVED_STATE_INVALID:
-            rv_name = "CKR_SAVED_STATE_INVALID";
-            break;
-        case CKR_INFORMATION_SENSITIVE:
-            rv_name = "CKR_INFORMATION_SENSITIVE";
-            break;
-        case CKR_STATE_UNSAVEABLE:
-            rv_name = "CKR_STATE_UNSAVEABLE";
-            break;
-        case CKR_CRYPTOKI_NOT_INITIALIZED:
-            rv_name = "CKR_CRYPTOKI_NOT_INITIALIZED";
-            break;
-        case CKR_CRYPTOKI_ALREADY_INITIALIZED:
-            rv_name = "CKR_CRYPTOKI_ALREADY_INITIALIZED";
-            break;
-        case CKR_MUTEX_BAD:
-            rv_name = "CKR_MUTEX_BAD";
-            break;
-        case CKR_MUTEX_NOT_LOCKED:
-            rv_name = "CKR_MUTEX_NOT_LOCKED";
-            break;
-        case CKR_NEW_PIN_MODE:
-            rv_name = "CKR_NEW_PIN_MODE";
-            break;
-        case CKR_NEXT_OTP:
-            rv_name = "CKR_NEXT_OTP";
-            break;
-        case CKR_FUNCTION_REJECTED:
-            rv_name = "CKR_FUNCTION_REJECTED";
-            break;
-        case CKR_VENDOR_DEFINED:
-            rv_name = "CKR_VENDOR_DEFINED";
-            break;
-        default:
-            rv_name = "Unknown";
-    }
-
-    return rv_name;
-}
-
-
-// Translates CK_MECHANISM_TYPE to string
-const char* pkcs11_logger_translate_ck_mechanism_type(CK_MECHANISM_TYPE type)
-{
-    const char *type_name = NULL;
-
-    switch (type)
-    {
-        case CKM_RSA_PKCS_KEY_PAIR_GEN:
-            type_name = "CKM_RSA_PKCS_KEY_PAIR_GEN";
-            break;
-        case CKM_RSA_PKCS:
-            type_name = "CKM_RSA_PKCS";
-            break;
-        case CKM_RSA_9796:
-            type_name = "CKM_RSA_9796";
-            break;
-        case CKM_RSA_X_509:
-            type_name = "CKM_RSA_X_509";
-            break;
-        case CKM_MD2_RSA_PKCS:
-            type_name = "CKM_MD2_RSA_PKCS";
-            break;
-        case CKM_MD5_RSA_PKCS:
-            type_name = "CKM_MD5_RSA_PKCS";
-            break;
-        case CKM_SHA1_RSA_PKCS:
-            type_name = "CKM_SHA1_RSA_PKCS";
-            break;
-        case CKM_RIPEMD128_RSA_PKCS:
-            type_name = "CKM_RIPEMD128_RSA_PKCS";
-            break;
-        case CKM_RIPEMD160_RSA_PKCS:
-            type_name = "CKM_RIPEMD160_RSA_PKCS";
-            break;
-        case CKM_RSA_PKCS_OAEP:
-            type_name = "CKM_RSA_PKCS_OAEP";
-            break;
-        case CKM_RSA_X9_31_KEY_PAIR_GEN:
-            type_name = "CKM_RSA_X9_31_KEY_PAIR_GEN";
-            break;
-        case CKM_RSA_X9_31:
-            type_name = "CKM_RSA_X9_31";
-            break;
-        case CKM_SHA1_RSA_X9_31:
-            type_name = "CKM_SHA1_RSA_X9_31";
-            break;
-        case CKM_RSA_PKCS_PSS:
-            type_name = "CKM_RSA_PKCS_PSS";
-            break;
-        case CKM_SHA1_RSA_PKCS_PSS:
-            type_name = "CKM_SHA1_RSA_PKCS_PSS";
-            break;
-        case CKM_DSA_KEY_PAIR_GEN:
-            type_name = "CKM_DSA_KEY_PAIR_GEN";
-            break;
-        case CKM_DSA:
-            type_name = "CKM_DSA";
-            break;
-        case CKM_DSA_SHA1:
-            type_name = "CKM_DSA_SHA1";
-            break;
-        case CKM_DH_PKCS_KEY_PAIR_GEN:
-            type_name = "CKM_DH_PKCS_KEY_PAIR_GEN";
-            break;
-        case CKM_DH_PKCS_DERIVE:
-            type_name = "CKM_DH_PKCS_DERIVE";
-            break;
-        case CKM_X9_42_DH_KEY_PAIR_GEN:
-            type_name = "CKM_X9_42_DH_KEY_PAIR_GEN";
-            break;
-        case CKM_X9_42_DH_DERIVE:
-            type_name = "CKM_X9_42_DH_DERIVE";
-            break;
-        case CKM_X9_42_DH_HYBRID_DERIVE:
-            type_name = "CKM_X9_42_DH_HYBRID_DERIVE";
-            break;
-        case CKM_X9_42_MQV_DERIVE:
-            type_name = "CKM_X9_42_MQV_DERIVE";
-            break;
-        case CKM_SHA256_RSA_PKCS:
-            type_name = "CKM_SHA256_RSA_PKCS";
-            break;
-        case CKM_SHA384_RSA_PKCS:
-            type_name = "CKM_SHA384_RSA_PKCS";
-            break;
-        case CKM_SHA512_RSA_PKCS:
-            type_name = "CKM_SHA512_RSA_PKCS";
-            break;
-        case CKM_SHA256_RSA_PKCS_PSS:
-            type_name = "CKM_SHA256_RSA_PKCS_PSS";
-            break;
-        case CKM_SHA384_RSA_PKCS_PSS:
-            type_name = "CKM_SHA384_RSA_PKCS_PSS";
-            break;
-        case CKM_SHA512_RSA_PKCS_PSS:
-            type_name = "CKM_SHA512_RSA_PKCS_PSS";
-            break;
-        case CKM_SHA224_RSA_PKCS:
-            type_name = "CKM_SHA224_RSA_PKCS";
-            break;
-        case CKM_SHA224_RSA_PKCS_PSS:
-            type_name = "CKM_SHA224_RSA_PKCS_PSS";
-            break;
-        case CKM_RC2_KEY_GEN:
-            type_name = "CKM_RC2_KEY_GEN";
-            break;
-        case CKM_RC2_ECB:
-            type_name = "CKM_RC2_ECB";
-            break;
-        case CKM_RC2_CBC:
-            type_name = "CKM_RC2_CBC";
-            break;
-        case CKM_RC2_MAC:
-            type_name = "CKM_RC2_MAC";
-            break;
-        case CKM_RC2_MAC_GENERAL:
-            type_name = "CKM_RC2_MAC_GENERAL";
-            break;
-        case CKM_RC2_CBC_PAD:
-            type_name = "CKM_RC2_CBC_PAD";
-            break;
-        case CKM_RC4_KEY_GEN:
-            type_name = "CKM_RC4_KEY_GEN";
-            break;
-        case CKM_RC4:
-            type_name = "CKM_RC4";
-            break;
-        case CKM_DES_KEY_GEN:
-            type_name = "CKM_DES_KEY_GEN";
-            break;
-        case CKM_DES_ECB:
-            type_name = "CKM_DES_ECB";
-            break;
-        case CKM_DES_CBC:
-            type_name = "CKM_DES_CBC";
-            break;
-        case CKM_DES_MAC:
-            type_name = "CKM_DES_MAC";
-            break;
-        case CKM_DES_MAC_GENERAL:
-            type_name = "CKM_DES_MAC_GENERAL";
-            break;
-        case CKM_DES_CBC_PAD:
-            type_name = "CKM_DES_CBC_PAD";
-            break;
-        case CKM_DES2_KEY_GEN:
-            type_name = "CKM_DES2_KEY_GEN";
-            break;
-        case CKM_DES3_KEY_GEN:
-            type_name = "CKM_DES3_KEY_GEN";
-            break;
-        case CKM_DES3_ECB:
-            type_name = "CKM_DES3_ECB";
-            break;
-        case CKM_DES3_CBC:
-            type_name = "CKM_DES3_CBC";
-            break;
-        case CKM_DES3_MAC:
-            type_name = "CKM_DES3_MAC";
-            break;
-        case CKM_DES3_MAC_GENERAL:
-            type_name = "CKM_DES3_MAC_GENERAL";
-            break;
-        case CKM_DES3_CBC_PAD:
-            type_name = "CKM_DES3_CBC_PAD";
-            break;
-        case CKM_CDMF_KEY_GEN:
-            type_name = "CKM_CDMF_KEY_GEN";
-            break;
-        case CKM_CDMF_ECB:
-            type_name = "CKM_CDMF_ECB";
-            break;
-        case CKM_CDMF_CBC:
-            type_name = "CKM_CDMF_CBC";
-            break;
-        case CKM_CDMF_MAC:
-            type_name = "CKM_CDMF_MAC";
-            break;
-        case CKM_CDMF_MAC_GENERAL:
-            type_name = "CKM_CDMF_MAC_GENERAL";
-            break;
-        case CKM_CDMF_CBC_PAD:
-            type_name = "CKM_CDMF_CBC_PAD";
-            break;
-        case CKM_DES_OFB64:
-            type_name = "CKM_DES_OFB64";
-            break;
-        case CKM_DES_OFB8:
-            type_name = "CKM_DES_OFB8";
-            break;
-        case CKM_DES_CFB64:
-            type_name = "CKM_DES_CFB64";
-            break;
-        case CKM_DES_CFB8:
-            type_name = "CKM_DES_CFB8";
-            break;
-        case CKM_MD2:
-            type_name = "CKM_MD2";
-            break;
-        case CKM_MD2_HMAC:
-            type_name = "CKM_MD2_HMAC";
-            break;
-        case CKM_MD2_HMAC_GENERAL:
-            type_name = "CKM_MD2_HMAC_GENERAL";
-            break;
-        case CKM_MD5:
-            type_name = "CKM_MD5";
-            break;
-        case CKM_MD5_HMAC:
-            type_name = "CKM_MD5_HMAC";
-            break;
-        case CKM_MD5_HMAC_GENERAL:
-            type_name = "CKM_MD5_HMAC_GENERAL";
-            break;
-        case CKM_SHA_1:
-            type_name = "CKM_SHA_1";
-            break;
-        case CKM_SHA_1_HMAC:
-            type_name = "CKM_SHA_1_HMAC";
-            break;
-        case CKM_SHA_1_HMAC_GENERAL:
-            type_name = "CKM_SHA_1_HMAC_GENERAL";
-            break;
-        case CKM_RIPEMD128:
-            type_name = "CKM_RIPEMD128";
-            break;
-        case CKM_RIPEMD128_HMAC:
-            type_name = "CKM_RIPEMD128_HMAC";
-            break;
-        case CKM_RIPEMD128_HMAC_GENERAL:
-            type_name = "CKM_RIPEMD128_HMAC_GENERAL";
-            break;
-        case CKM_RIPEMD160:
-            type_name = "CKM_RIPEMD160";
-            break;
-        case CKM_RIPEMD160_HMAC:
-            type_name = "CKM_RIPEMD160_HMAC";
-            break;
-        case CKM_RIPEMD160_HMAC_GENERAL:
-            type_name = "CKM_RIPEMD160_HMAC_GENERAL";
-            break;
-        case CKM_SHA256:
-            type_name = "CKM_SHA256";
-            break;
-        case CKM_SHA256_HMAC:
-            type_name = "CKM_SHA256_HMAC";
-            break;
-        case CKM_SHA256_HMAC_GENERAL:
-            type_name = "CKM_SHA256_HMAC_GENERAL";
-            break;
-        case CKM_SHA224:
-            type_name = "CKM_SHA224";
-            break;
-        case CKM_SHA224_HMAC:
-            type_name = "CKM_SHA224_HMAC";
-            break;
-        case CKM_SHA224_HMAC_GENERAL:
-            type_name = "CKM_SHA224_HMAC_GENERAL";
-            break;
-        case CKM_SHA384:
-            type_name = "CKM_SHA384";
-            break;
-        case CKM_SHA384_HMAC:
-            type_name = "CKM_SHA384_HMAC";
-            break;
-        case CKM_SHA384_HMAC_GENERAL:
-            type_name = "CKM_SHA384_HMAC_GENERAL";
-            break;
-        case CKM_SHA512:
-            type_name = "CKM_SHA512";
-            break;
-        case CKM_SHA512_HMAC:
-            type_name = "CKM_SHA512_HMAC";
-            break;
-        case CKM_SHA512_HMAC_GENERAL:
-            type_name = "CKM_SHA512_HMAC_GENERAL";
-            break;
-        case CKM_SECURID_KEY_GEN:
-            type_name = "CKM_SECURID_KEY_GEN";
-            break;
-        case CKM_SECURID:
-            type_name = "CKM_SECURID";
-            break;
-        case CKM_HOTP_KEY_GEN:
-            type_name = "CKM_HOTP_KEY_GEN";
-            break;
-        case CKM_HOTP:
-            type_name = "CKM_HOTP";
-            break;
-        case CKM_ACTI:
-            type_name = "CKM_ACTI";
-            break;
-        case CKM_ACTI_KEY_GEN:
-            type_name = "CKM_ACTI_KEY_GEN";
-            break;
-        case CKM_CAST_KEY_GEN:
-            type_name = "CKM_CAST_KEY_GEN";
-            break;
-        case CKM_CAST_ECB:
-            type_name = "CKM_CAST_ECB";
-            break;
-        case CKM_CAST_CBC:
-            type_name = "CKM_CAST_CBC";
-            break;
-        case CKM_CAST_MAC:
-            type_name = "CKM_CAST_MAC";
-            break;
-        case CKM_CAST_MAC_GENERAL:
-            type_name = "CKM_CAST_MAC_GENERAL";
-            break;
-        case CKM_CAST_CBC_PAD:
-            type_name = "CKM_CAST_CBC_PAD";
-            break;
-        case CKM_CAST3_KEY_GEN:
-            type_name = "CKM_CAST3_KEY_GEN";
-            break;
-        case CKM_CAST3_ECB:
-            type_name = "CKM_CAST3_ECB";
-            break;
-        case CKM_CAST3_CBC:
-            type_name = "CKM_CAST3_CBC";
-            break;
-        case CKM_CAST3_MAC:
-            type_name = "CKM_CAST3_MAC";
-            break;
-        case CKM_CAST3_MAC_GENERAL:
-            type_name = "CKM_CAST3_MAC_GENERAL";
-            break;
-        case CKM_CAST3_CBC_PAD:
-            type_name = "CKM_CAST3_CBC_PAD";
-            break;
-        // Duplicate values in PKCS#11 specification
-        // #define CKM_CAST5_KEY_GEN              0x00000320
-        // #define CKM_CAST128_KEY_GEN            0x00000320
-        case CKM_CAST5_KEY_GEN:
-            type_name = "CKM_CAST5_KEY_GEN or CKM_CAST128_KEY_GEN";
-            break;
-        // Duplicate values in PKCS#11 specification
-        // #define CKM_CAST5_ECB                  0x00000321
-        // #define CKM_CAST128_ECB                0x00000321
-        case CKM_CAST5_ECB:
-            type_name = "CKM_CAST5_ECB or CKM_CAST128_ECB";
-            break;
-        // Duplicate values in PKCS#11 specification
-        // #define CKM_CAST5_CBC                  0x00000322
-        // #define CKM_CAST128_CBC                0x00000322
-        case CKM_CAST5_CBC:
-            type_name = "CKM_CAST5_CBC or CKM_CAST128_CBC";
-            break;
-        // Duplicate values in PKCS#11 specification
-        // #define CKM_CAST5_MAC                  0x00000323
-        // #define CKM_CAST128_MAC                0x00000323
-        case CKM_CAST5_MAC:
-            type_name = "CKM_CAST5_MAC or CKM_CAST128_MAC";
-            break;
-        // Duplicate values in PKCS#11 specification
-        // #define CKM_CAST5_MAC_GENERAL          0x00000324
-        // #define CKM_CAST128_MAC_GENERAL        0x00000324
-        case CKM_CAST5_MAC_GENERAL:
-            type_name = "CKM_CAST5_MAC_GENERAL or CKM_CAST128_MAC_GENERAL";
-            break;
-        // Duplicate values in PKCS#11 specification
-        // #define CKM_CAST5_CBC_PAD              0x00000325
-        // #define CKM_CAST128_CBC_PAD            0x00000325
-        case CKM_CAST5_CBC_PAD:
-            type_name = "CKM_CAST5_CBC_PAD or CKM_CAST128_CBC_PAD";
-            break;
-        case CKM_RC5_KEY_GEN:
-            type_name = "CKM_RC5_KEY_GEN";
-            break;
-        case CKM_RC5_ECB:
-            type_name = "CKM_RC5_ECB";
-            break;
-        case CKM_RC5_CBC:
-            type_name = "CKM_RC5_CBC";
-            break;
-        case CKM_RC5_MAC:
-            type_name = "CKM_RC5_MAC";
-            break;
-        case CKM_RC5_MAC_GENERAL:
-            type_name = "CKM_RC5_MAC_GENERAL";
-            break;
-        case CKM_RC5_CBC_PAD:
-            type_name = "CKM_RC5_CBC_PAD";
-            break;
-        case CKM_IDEA_KEY_GEN:
-            type_name = "CKM_IDEA_KEY_GEN";
-            break;
-        case CKM_IDEA_ECB:
-            type_name = "CKM_IDEA_ECB";
-            break;
-        case CKM_IDEA_CBC:
-            type_name = "CKM_IDEA_CBC";
-            break;
-        case CKM_IDEA_MAC:
-            type_name = "CKM_IDEA_MAC";
-            break;
-        case CKM_IDEA_MAC_GENERAL:
-            type_name = "CKM_IDEA_MAC_GENERAL";
-            break;
-        case CKM_IDEA_CBC_PAD:
-            type_name = "CKM_IDEA_CBC_PAD";
-            break;
-        case CKM_GENERIC_SECRET_KEY_GEN:
-            type_name = "CKM_GENERIC_SECRET_KEY_GEN";
-            break;
-        case CKM_CONCATENATE_BASE_AND_KEY:
-            type_name = "CKM_CONCATENATE_BASE_AND_KEY";
-            break;
-        case CKM_CONCATENATE_BASE_AND_DATA:
-            type_name = "CKM_CONCATENATE_BASE_AND_DATA";
-            break;
-        case CKM_CONCATENATE_DATA_AND_BASE:
-            type_name = "CKM_CONCATENATE_DATA_AND_BASE";
-            break;
-        case CKM_XOR_BASE_AND_DATA:
-            type_name = "CKM_XOR_BASE_AND_DATA";
-            break;
-        case CKM_EXTRACT_KEY_FROM_KEY:
-            type_name = "CKM_EXTRACT_KEY_FROM_KEY";
-            break;
-        case CKM_SSL3_PRE_MASTER_KEY_GEN:
-            type_name = "CKM_SSL3_PRE_MASTER_KEY_GEN";
-            break;
-        case CKM_SSL3_MASTER_KEY_DERIVE:
-            type_name = "CKM_SSL3_MASTER_KEY_DERIVE";
-            break;
-        case CKM_SSL3_KEY_AND_MAC_DERIVE:
-            type_name = "CKM_SSL3_KEY_AND_MAC_DERIVE";
-            break;
-        case CKM_SSL3_MASTER_KEY_DERIVE_DH:
-            type_name = "CKM_SSL3_MASTER_KEY_DERIVE_DH";
-            break;
-        case CKM_TLS_PRE_MASTER_KEY_GEN:
-            type_name = "CKM_TLS_PRE_MASTER_KEY_GEN";
-            break;
-        case CKM_TLS_MASTER_KEY_DERIVE:
-            type_name = "CKM_TLS_MASTER_KEY_DERIVE";
-            break;
-        case CKM_TLS_KEY_AND_MAC_DERIVE:
-            type_name = "CKM_TLS_KEY_AND_MAC_DERIVE";
-            break;
-        case CKM_TLS_MASTER_KEY_DERIVE_DH:
-            type_name = "CKM_TLS_MASTER_KEY_DERIVE_DH";
-            break;
-        case CKM_TLS_PRF:
-            type_name = "CKM_TLS_PRF";
-            break;
-        case CKM_SSL3_MD5_MAC:
-            type_name = "CKM_SSL3_MD5_MAC";
-            break;
-        case CKM_SSL3_SHA1_MAC:
-            type_name = "CKM_SSL3_SHA1_MAC";
-            break;
-        case CKM_MD5_KEY_DERIVATION:
-            type_name = "CKM_MD5_KEY_DERIVATION";
-            break;
-        case CKM_MD2_KEY_DERIVATION:
-            type_name = "CKM_MD2_KEY_DERIVATION";
-            break;
-        case CKM_SHA1_KEY_DERIVATION:
-            type_name = "CKM_SHA1_KEY_DERIVATION";
-            break;
-        case CKM_SHA256_KEY_DERIVATION:
-            type_name = "CKM_SHA256_KEY_DERIVATION";
-            break;
-        case CKM_SHA384_KEY_DERIVATION:
-            type_name = "CKM_SHA384_KEY_DERIVATION";
-            break;
-        case CKM_SHA512_KEY_DERIVATION:
-            type_name = "CKM_SHA512_KEY_DERIVATION";
-            break;
-        case CKM_SHA224_KEY_DERIVATION:
-            type_name = "CKM_SHA224_KEY_DERIVATION";
-            break;
-        case CKM_PBE_MD2_DES_CBC:
-            type_name = "CKM_PBE_MD2_DES_CBC";
-            break;
-        case CKM_PBE_MD5_DES_CBC:
-            type_name = "CKM_PBE_MD5_DES_CBC";
-            break;
-        case CKM_PBE_MD5_CAST_CBC:
-            type_name = "CKM_PBE_MD5_CAST_CBC";
-            break;
-        case CKM_PBE_MD5_CAST3_CBC:
-            type_name = "CKM_PBE_MD5_CAST3_CBC";
-            break;
-        // Duplicate values in PKCS#11 specification
-        // #define CKM_PBE_MD5_CAST5_CBC          0x000003A4
-        // #define CKM_PBE_MD5_CAST128_CBC        0x000003A4
-        case CKM_PBE_MD5_CAST5_CBC:
-            type_name = "CKM_PBE_MD5_CAST5_CBC or CKM_PBE_MD5_CAST128_CBC";
-            break;
-        // Duplicate values in PKCS#11 specification
-        // #define CKM_PBE_SHA1_CAST5_CBC         0x000003A5
-        // #define CKM_PBE_SHA1_CAST128_CBC       0x000003A5
-        case CKM_PBE_SHA1_CAST5_CBC:
-            type_name = "CKM_PBE_SHA1_CAST5_CBC or CKM_PBE_SHA1_CAST128_CBC";
-            break;
-        case CKM_PBE_SHA1_RC4_128:
-            type_name = "CKM_PBE_SHA1_RC4_128";
-            break;
-        case CKM_PBE_SHA1_RC4_40:
-            type_name = "CKM_PBE_SHA1_RC4_40";
-            break;
-        case CKM_PBE_SHA1_DES3_EDE_CBC:
-            type_name = "CKM_PBE_SHA1_DES3_EDE_CBC";
-            break;
-        case CKM_PBE_SHA1_DES2_EDE_CBC:
-            type_name = "CKM_PBE_SHA1_DES2_EDE_CBC";
-            break;
-        case CKM_PBE_SHA1_RC2_128_CBC:
-            type_name = "CKM_PBE_SHA1_RC2_128_CBC";
-            break;
-        case CKM_PBE_SHA1_RC2_40_CBC:
-            type_name = "CKM_PBE_SHA1_RC2_40_CBC";
-            break;
-        case CKM_PKCS5_PBKD2:
-            type_name = "CKM_PKCS5_PBKD2";
-            break;
-        case CKM_PBA_SHA1_WITH_SHA1_HMAC:
-            type_name = "CKM_PBA_SHA1_WITH_SHA1_HMAC";
-            break;
-        case CKM_WTLS_PRE_MASTER_KEY_GEN:
-            type_name = "CKM_WTLS_PRE_MASTER_KEY_GEN";
-            break;
-        case CKM_WTLS_MASTER_KEY_DERIVE:
-            type_name = "CKM_WTLS_MASTER_KEY_DERIVE";
-            break;
-        case CKM_WTLS_MASTER_KEY_DERIVE_DH_ECC:
-            type_name = "CKM_WTLS_MASTER_KEY_DERIVE_DH_ECC";
-            break;
-        case CKM_WTLS_PRF:
-            type_name = "CKM_WTLS_PRF";
-            break;
-        case CKM_WTLS_SERVER_KEY_AND_MAC_DERIVE:
-            type_name = "CKM_WTLS_SERVER_KEY_AND_MAC_DERIVE";
-            break;
-        case CKM_WTLS_CLIENT_KEY_AND_MAC_DERIVE:
-            type_name = "CKM_WTLS_CLIENT_KEY_AND_MAC_DERIVE";
-            break;
-        case CKM_KEY_WRAP_LYNKS:
-            type_name = "CKM_KEY_WRAP_LYNKS";
-            break;
-        case CKM_KEY_WRAP_SET_OAEP:
-            type_name = "CKM_KEY_WRAP_SET_OAEP";
-            break;
-        case CKM_CMS_SIG:
-            type_name = "CKM_CMS_SIG";
-            break;
-        case CKM_KIP_DERIVE:
-            type_name = "CKM_KIP_DERIVE";
-            break;
-        case CKM_KIP_WRAP:
-            type_name = "CKM_KIP_WRAP";
-            break;
-        case CKM_KIP_MAC:
-            type_name = "CKM_KIP_MAC";
-            break;
-        case CKM_CAMELLIA_KEY_GEN:
-            type_name = "CKM_CAMELLIA_KEY_GEN";
-            break;
-        case CKM_CAMELLIA_ECB:
-            type_name = "CKM_CAMELLIA_ECB";
-            break;
-        case CKM_CAMELLIA_CBC:
-            type_name = "CKM_CAMELLIA_CBC";
-            break;
-        case CKM_CAMELLIA_MAC:
-            type_name = "CKM_CAMELLIA_MAC";
-            break;
-        case CKM_CAMELLIA_MAC_GENERAL:
-            type_name = "CKM_CAMELLIA_MAC_GENERAL";
-            break;
-        case CKM_CAMELLIA_CBC_PAD:
-            type_name = "CKM_CAMELLIA_CBC_PAD";
-            break;
-        case CKM_CAMELLIA_ECB_ENCRYPT_DATA:
-            type_name = "CKM_CAMELLIA_ECB_ENCRYPT_DATA";
-            break;
-        case CKM_CAMELLIA_CBC_ENCRYPT_DATA:
-            type_name = "CKM_CAMELLIA_CBC_ENCRYPT_DATA";
-            break;
-        case CKM_CAMELLIA_CTR:
-            type_name = "CKM_CAMELLIA_CTR";
-            break;
-        case CKM_ARIA_KEY_GEN:
-            type_name = "CKM_ARIA_KEY_GEN";
-            break;
-        case CKM_ARIA_ECB:
-            type_name = "CKM_ARIA_ECB";
-            break;
-        case CKM_ARIA_CBC:
-            type_name = "CKM_ARIA_CBC";
-            break;
-        case CKM_ARIA_MAC:
-            type_name = "CKM_ARIA_MAC";
-            break;
-        case CKM_ARIA_MAC_GENERAL:
-            type_name = "CKM_ARIA_MAC_GENERAL";
-            break;
-        case CKM_ARIA_CBC_PAD:
-            type_name = "CKM_ARIA_CBC_PAD";
-            break;
-        case CKM_ARIA_ECB_ENCRYPT_DATA:
-            type_name = "CKM_ARIA_ECB_ENCRYPT_DATA";
-            break;
-        case CKM_ARIA_CBC_ENCRYPT_DATA:
-            type_name = "CKM_ARIA_CBC_ENCRYPT_DATA";
-            break;
-        case CKM_SKIPJACK_KEY_GEN:
-            type_name = "CKM_SKIPJACK_KEY_GEN";
-            break;
-        case CKM_SKIPJACK_ECB64:
-            type_name = "CKM_SKIPJACK_ECB64";
-            break;
-        case CKM_SKIPJACK_CBC64:
-            type_name = "CKM_SKIPJACK_CBC64";
-            break;
-        case CKM_SKIPJACK_OFB64:
-            type_name = "CKM_SKIPJACK_OFB64";
-            break;
-        case CKM_SKIPJACK_CFB64:
-            type_name = "CKM_SKIPJACK_CFB64";
-            break;
-        case CKM_SKIPJACK_CFB32:
-            type_name = "CKM_SKIPJACK_CFB32";
-            break;
-        case CKM_SKIPJACK_CFB16:
-            type_name = "CKM_SKIPJACK_CFB16";
-            break;
-        case CKM_SKIPJACK_CFB8:
-            type_name = "CKM_SKIPJACK_CFB8";
-            break;
-        case CKM_SKIPJACK_WRAP:
-            type_name = "CKM_SKIPJACK_WRAP";
-            break;
-        case CKM_SKIPJACK_PRIVATE_WRAP:
-            type_name = "CKM_SKIPJACK_PRIVATE_WRAP";
-            break;
-        case CKM_SKIPJACK_RELAYX:
-            type_name = "CKM_SKIPJACK_RELAYX";
-            break;
-        case CKM_KEA_KEY_PAIR_GEN:
-            type_name = "CKM_KEA_KEY_PAIR_GEN";
-            break;
-        case CKM_KEA_KEY_DERIVE:
-            type_name = "CKM_KEA_KEY_DERIVE";
-            break;
-        case CKM_FORTEZZA_TIMESTAMP:
-            type_name = "CKM_FORTEZZA_TIMESTAMP";
-            break;
-        case CKM_BATON_KEY_GEN:
-            type_name = "CKM_BATON_KEY_GEN";
-            break;
-        case CKM_BATON_ECB128:
-            type_name = "CKM_BATON_ECB128";
-            break;
-        case CKM_BATON_ECB96:
-            type_name = "CKM_BATON_ECB96";
-            break;
-        case CKM_BATON_CBC128:
-            type_name = "CKM_BATON_CBC128";
-            break;
-        case CKM_BATON_COUNTER:
-            type_name = "CKM_BATON_COUNTER";
-            break;
-        case CKM_BATON_SHUFFLE:
-            type_name = "CKM_BATON_SHUFFLE";
-            break;
-        case CKM_BATON_WRAP:
-            type_name = "CKM_BATON_WRAP";
-            break;
-        // Duplicate values in PKCS#11 specification
-        // #define CKM_ECDSA_KEY_PAIR_GEN         0x00001040
-        // #define CKM_EC_KEY_PAIR_GEN            0x00001040
-        case CKM_ECDSA_KEY_PAIR_GEN:
-            type_name = "CKM_ECDSA_KEY_PAIR_GEN or CKM_EC_KEY_PAIR_GEN";
-            break;
-        case CKM_ECDSA:
-            type_name = "CKM_ECDSA";
-            break;
-        case CKM_ECDSA_SHA1:
-            type_name = "CKM_ECDSA_SHA1";
-            break;
-        case CKM_ECDH1_DERIVE:
-            type_name = "CKM_ECDH1_DERIVE";
-            break;
-        case CKM_ECDH1_COFACTOR_DERIVE:
-            type_name = "CKM_ECDH1_COFACTOR_DERIVE";
-            break;
-        case CKM_ECMQV_DERIVE:
-            type_name = "CKM_ECMQV_DERIVE";
-            break;
-        case CKM_JUNIPER_KEY_GEN:
-            type_name = "CKM_JUNIPER_KEY_GEN";
-            break;
-        case CKM_JUNIPER_ECB128:
-            type_name = "CKM_JUNIPER_ECB128";
-            break;
-        case CKM_JUNIPER_CBC128:
-            type_name = "CKM_JUNIPER_CBC128";
-            break;
-        case CKM_JUNIPER_COUNTER:
-            type_name = "CKM_JUNIPER_COUNTER";
-            break;
-        case CKM_JUNIPER_SHUFFLE:
-            type_name = "CKM_JUNIPER_SHUFFLE";
-            break;
-        case CKM_JUNIPER_WRAP:
-            type_name = "CKM_JUNIPER_WRAP";
-            break;
-        case CKM_FASTHASH:
-            type_name = "CKM_FASTHASH";
-            break;
-        case CKM_AES_KEY_GEN:
-            type_name = "CKM_AES_KEY_GEN";
-            break;
-        case CKM_AES_ECB:
-            type_name = "CKM_AES_ECB";
-            break;
-        case CKM_AES_CBC:
-            type_name = "CKM_AES_CBC";
-            break;
-        case CKM_AES_MAC:
-            type_name = "CKM_AES_MAC";
-            break;
-        case CKM_AES_MAC_GENERAL:
-            type_name = "CKM_AES_MAC_GENERAL";
-            break;
-        case CKM_AES_CBC_PAD:
-            type_name = "CKM_AES_CBC_PAD";
-            break;
-        case CKM_AES_CTR:
-            type_name = "CKM_AES_CTR";
-            break;
-        case CKM_BLOWFISH_KEY_GEN:
-            type_name = "CKM_BLOWFISH_KEY_GEN";
-            break;
-        case CKM_BLOWFISH_CBC:
-            type_name = "CKM_BLOWFISH_CBC";
-            break;
-        case CKM_TWOFISH_KEY_GEN:
-            type_name = "CKM_TWOFISH_KEY_GEN";
-            break;
-        case CKM_TWOFISH_CBC:
-            type_name = "CKM_TWOFISH_CBC";
-            break;
-        case CKM_DES_ECB_ENCRYPT_DATA:
-            type_name = "CKM_DES_ECB_ENCRYPT_DATA";
-            break;
-        case CKM_DES_CBC_ENCRYPT_DATA:
-            type_name = "CKM_DES_CBC_ENCRYPT_DATA";
-            break;
-        case CKM_DES3_ECB_ENCRYPT_DATA:
-            type_name = "CKM_DES3_ECB_ENCRYPT_DATA";
-            break;
-        case CKM_DES3_CBC_ENCRYPT_DATA:
-            type_name = "CKM_DES3_CBC_ENCRYPT_DATA";
-            break;
-        case CKM_AES_ECB_ENCRYPT_DATA:
-            type_name = "CKM_AES_ECB_ENCRYPT_DATA";
-            break;
-        case CKM_AES_CBC_ENCRYPT_DATA:
-            type_name = "CKM_AES_CBC_ENCRYPT_DATA";
-            break;
-        case CKM_DSA_PARAMETER_GEN:
-            type_name = "CKM_DSA_PARAMETER_GEN";
-            break;
-        case CKM_DH_PKCS_PARAMETER_GEN:
-            type_name = "CKM_DH_PKCS_PARAMETER_GEN";
-            break;
-        case CKM_X9_42_DH_PARAMETER_GEN:
-            type_name = "CKM_X9_42_DH_PARAMETER_GEN";
-            break;
-        case CKM_VENDOR_DEFINED:
-            type_name = "CKM_VENDOR_DEFINED";
-            break;
-        default:
-            type_name = "Unknown";
+// Structure that maps value of PKCS#11 type to its name
+typedef struct
+{
+    // Value
+    CK_ULONG value;
+    // Name of the value (aliases sharing the value are separated by " or ")
+    const char *name;
+}
+PKCS11_LOGGER_TRANSLATION;
+
+
+// Returns number of entries in the translation table
+#define PKCS11_LOGGER_TRANSLATION_COUNT(table) (sizeof(table) / sizeof(PKCS11_LOGGER_TRANSLATION))
+
+
+// Structure that describes class of PKCS#11 functions (range of function identifiers)
+typedef struct
+{
+    // Name of the class
+    const char *name;
+    // Identifier of the first function in the class
+    CK_ULONG first;
+    // Identifier of the last function in the class
+    CK_ULONG last;
+}
+PKCS11_LOGGER_FUNCTION_CLASS;
+
+
+// Classes of PKCS#11 functions as defined by sections of PKCS#11 specification (class can consist of more ranges)
+static const PKCS11_LOGGER_FUNCTION_CLASS pkcs11_logger_translate_function_classes[] =
+{
+    { "general", PKCS11_LOGGER_FUNCTION_C_Initialize, PKCS11_LOGGER_FUNCTION_C_GetFunctionList },
+    { "slot", PKCS11_LOGGER_FUNCTION_C_GetSlotList, PKCS11_LOGGER_FUNCTION_C_SetPIN },
+    { "slot", PKCS11_LOGGER_FUNCTION_C_WaitForSlotEvent, PKCS11_LOGGER_FUNCTION_C_WaitForSlotEvent },
+    { "session", PKCS11_LOGGER_FUNCTION_C_OpenSession, PKCS11_LOGGER_FUNCTION_C_Logout },
+    { "object", PKCS11_LOGGER_FUNCTION_C_CreateObject, PKCS11_LOGGER_FUNCTION_C_FindObjectsFinal },
+    { "encrypt", PKCS11_LOGGER_FUNCTION_C_EncryptInit, PKCS11_LOGGER_FUNCTION_C_EncryptFinal },
+    { "decrypt", PKCS11_LOGGER_FUNCTION_C_DecryptInit, PKCS11_LOGGER_FUNCTION_C_DecryptFinal },
+    { "digest", PKCS11_LOGGER_FUNCTION_C_DigestInit, PKCS11_LOGGER_FUNCTION_C_DigestFinal },
+    { "sign", PKCS11_LOGGER_FUNCTION_C_SignInit, PKCS11_LOGGER_FUNCTION_C_SignRecover },
+    { "verify", PKCS11_LOGGER_FUNCTION_C_VerifyInit, PKCS11_LOGGER_FUNCTION_C_VerifyRecover },
+    { "dual", PKCS11_LOGGER_FUNCTION_C_DigestEncryptUpdate, PKCS11_LOGGER_FUNCTION_C_DecryptVerifyUpdate },
+    { "key", PKCS11_LOGGER_FUNCTION_C_GenerateKey, PKCS11_LOGGER_FUNCTION_C_DeriveKey },
+    { "random", PKCS11_LOGGER_FUNCTION_C_SeedRandom, PKCS11_LOGGER_FUNCTION_C_GenerateRandom },
+    { "parallel", PKCS11_LOGGER_FUNCTION_C_GetFunctionStatus, PKCS11_LOGGER_FUNCTION_C_CancelFunction },
+    { "all", PKCS11_LOGGER_FUNCTION_C_Initialize, PKCS11_LOGGER_FUNCTION_COUNT - 1 }
+};
+
+// Number of ranges in classes of PKCS#11 functions
+#define PKCS11_LOGGER_FUNCTION_CLASS_COUNT (sizeof(pkcs11_logger_translate_function_classes) / sizeof(PKCS11_LOGGER_FUNCTION_CLASS))
+
+
+// Finds name of the value by binary search in the table sorted by value
+static const char* pkcs11_logger_translate_find_name(const PKCS11_LOGGER_TRANSLATION *table, CK_ULONG count, CK_ULONG value)
+{
+    CK_ULONG low = 0;
+    CK_ULONG high = count;
+    CK_ULONG middle = 0;
+
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+
+        if (table[middle].value < value)
+            low = middle + 1;
+        else if (table[middle].value > value)
+            high = middle;
+        else
+            return table[middle].name;
     }
-    
-    return type_name;
+
+    return "Unknown";
+}
+
+
+// Checks whether the name or any of its aliases matches the string ignoring case
+static CK_BBOOL pkcs11_logger_translate_name_matches(const char *name, const char *str)
+{
+    const char *separator = NULL;
+    size_t len = 0;
+    size_t str_len = strlen(str);
+
+    for (;;)
+    {
+        separator = strstr(name, " or ");
+        len = (NULL != separator) ? (size_t)(separator - name) : strlen(name);
+
+#ifdef _WIN32
+        if ((len == str_len) && (0 == _strnicmp(name, str, len)))
+            return CK_TRUE;
+#else
+        if ((len == str_len) && (0 == strncasecmp(name, str, len)))
+            return CK_TRUE;
+#endif
+
+        if (NULL == separator)
+            return CK_FALSE;
+
+        name = separator + 4;
+    }
+}
+
+
+// Finds value of the name in the table
+static int pkcs11_logger_translate_find_value(const PKCS11_LOGGER_TRANSLATION *table, CK_ULONG count, const char *str, CK_ULONG *value)
+{
+    CK_ULONG i = 0;
+
+    if ((NULL == str) || (NULL == value))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    // Note: Names are translated only when configuration is parsed so there is no need for another index
+    for (i = 0; i < count; i++)
+    {
+        if (CK_TRUE == pkcs11_logger_translate_name_matches(table[i].name, str))
+        {
+            *value = table[i].value;
+            return PKCS11_LOGGER_RV_SUCCESS;
+        }
+    }
+
+    return PKCS11_LOGGER_RV_ERROR;
+}
+
+
+// Names of CK_RV values sorted by value
+static const PKCS11_LOGGER_TRANSLATION pkcs11_logger_translate_ck_rv_names[] =
+{
+    { CKR_OK, "CKR_OK" },
+    { CKR_CANCEL, "CKR_CANCEL" },
+    { CKR_HOST_MEMORY, "CKR_HOST_MEMORY" },
+    { CKR_SLOT_ID_INVALID, "CKR_SLOT_ID_INVALID" },
+    { CKR_GENERAL_ERROR, "CKR_GENERAL_ERROR" },
+    { CKR_FUNCTION_FAILED, "CKR_FUNCTION_FAILED" },
+    { CKR_ARGUMENTS_BAD, "CKR_ARGUMENTS_BAD" },
+    { CKR_NO_EVENT, "CKR_NO_EVENT" },
+    { CKR_NEED_TO_CREATE_THREADS, "CKR_NEED_TO_CREATE_THREADS" },
+    { CKR_CANT_LOCK, "CKR_CANT_LOCK" },
+    { CKR_ATTRIBUTE_READ_ONLY, "CKR_ATTRIBUTE_READ_ONLY" },
+    { CKR_ATTRIBUTE_SENSITIVE, "CKR_ATTRIBUTE_SENSITIVE" },
+    { CKR_ATTRIBUTE_TYPE_INVALID, "CKR_ATTRIBUTE_TYPE_INVALID" },
+    { CKR_ATTRIBUTE_VALUE_INVALID, "CKR_ATTRIBUTE_VALUE_INVALID" },
+    { CKR_DATA_INVALID, "CKR_DATA_INVALID" },
+    { CKR_DATA_LEN_RANGE, "CKR_DATA_LEN_RANGE" },
+    { CKR_DEVICE_ERROR, "CKR_DEVICE_ERROR" },
+    { CKR_DEVICE_MEMORY, "CKR_DEVICE_MEMORY" },
+    { CKR_DEVICE_REMOVED, "CKR_DEVICE_REMOVED" },
+    { CKR_ENCRYPTED_DATA_INVALID, "CKR_ENCRYPTED_DATA_INVALID" },
+    { CKR_ENCRYPTED_DATA_LEN_RANGE, "CKR_ENCRYPTED_DATA_LEN_RANGE" },
+    { CKR_FUNCTION_CANCELED, "CKR_FUNCTION_CANCELED" },
+    { CKR_FUNCTION_NOT_PARALLEL, "CKR_FUNCTION_NOT_PARALLEL" },
+    { CKR_FUNCTION_NOT_SUPPORTED, "CKR_FUNCTION_NOT_SUPPORTED" },
+    { CKR_KEY_HANDLE_INVALID, "CKR_KEY_HANDLE_INVALID" },
+    { CKR_KEY_SIZE_RANGE, "CKR_KEY_SIZE_RANGE" },
+    { CKR_KEY_TYPE_INCONSISTENT, "CKR_KEY_TYPE_INCONSISTENT" },
+    { CKR_KEY_NOT_NEEDED, "CKR_KEY_NOT_NEEDED" },
+    { CKR_KEY_CHANGED, "CKR_KEY_CHANGED" },
+    { CKR_KEY_NEEDED, "CKR_KEY_NEEDED" },
+    { CKR_KEY_INDIGESTIBLE, "CKR_KEY_INDIGESTIBLE" },
+    { CKR_KEY_FUNCTION_NOT_PERMITTED, "CKR_KEY_FUNCTION_NOT_PERMITTED" },
+    { CKR_KEY_NOT_WRAPPABLE, "CKR_KEY_NOT_WRAPPABLE" },
+    { CKR_KEY_UNEXTRACTABLE, "CKR_KEY_UNEXTRACTABLE" },
+    { CKR_MECHANISM_INVALID, "CKR_MECHANISM_INVALID" },
+    { CKR_MECHANISM_PARAM_INVALID, "CKR_MECHANISM_PARAM_INVALID" },
+    { CKR_OBJECT_HANDLE_INVALID, "CKR_OBJECT_HANDLE_INVALID" },
+    { CKR_OPERATION_ACTIVE, "CKR_OPERATION_ACTIVE" },
+    { CKR_OPERATION_NOT_INITIALIZED, "CKR_OPERATION_NOT_INITIALIZED" },
+    { CKR_PIN_INCORRECT, "CKR_PIN_INCORRECT" },
+    { CKR_PIN_INVALID, "CKR_PIN_INVALID" },
+    { CKR_PIN_LEN_RANGE, "CKR_PIN_LEN_RANGE" },
+    { CKR_PIN_EXPIRED, "CKR_PIN_EXPIRED" },
+    { CKR_PIN_LOCKED, "CKR_PIN_LOCKED" },
+    { CKR_SESSION_CLOSED, "CKR_SESSION_CLOSED" },
+    { CKR_SESSION_COUNT, "CKR_SESSION_COUNT" },
+    { CKR_SESSION_HANDLE_INVALID, "CKR_SESSION_HANDLE_INVALID" },
+    { CKR_SESSION_PARALLEL_NOT_SUPPORTED, "CKR_SESSION_PARALLEL_NOT_SUPPORTED" },
+    { CKR_SESSION_READ_ONLY, "CKR_SESSION_READ_ONLY" },
+    { CKR_SESSION_EXISTS, "CKR_SESSION_EXISTS" },
+    { CKR_SESSION_READ_ONLY_EXISTS, "CKR_SESSION_READ_ONLY_EXISTS" },
+    { CKR_SESSION_READ_WRITE_SO_EXISTS, "CKR_SESSION_READ_WRITE_SO_EXISTS" },
+    { CKR_SIGNATURE_INVALID, "CKR_SIGNATURE_INVALID" },
+    { CKR_SIGNATURE_LEN_RANGE, "CKR_SIGNATURE_LEN_RANGE" },
+    { CKR_TEMPLATE_INCOMPLETE, "CKR_TEMPLATE_INCOMPLETE" },
+    { CKR_TEMPLATE_INCONSISTENT, "CKR_TEMPLATE_INCONSISTENT" },
+    { CKR_TOKEN_NOT_PRESENT, "CKR_TOKEN_NOT_PRESENT" },
+    { CKR_TOKEN_NOT_RECOGNIZED, "CKR_TOKEN_NOT_RECOGNIZED" },
+    { CKR_TOKEN_WRITE_PROTECTED, "CKR_TOKEN_WRITE_PROTECTED" },
+    { CKR_UNWRAPPING_KEY_HANDLE_INVALID, "CKR_UNWRAPPING_KEY_HANDLE_INVALID" },
+    { CKR_UNWRAPPING_KEY_SIZE_RANGE, "CKR_UNWRAPPING_KEY_SIZE_RANGE" },
+    { CKR_UNWRAPPING_KEY_TYPE_INCONSISTENT, "CKR_UNWRAPPING_KEY_TYPE_INCONSISTENT" },
+    { CKR_USER_ALREADY_LOGGED_IN, "CKR_USER_ALREADY_LOGGED_IN" },
+    { CKR_USER_NOT_LOGGED_IN, "CKR_USER_NOT_LOGGED_IN" },
+    { CKR_USER_PIN_NOT_INITIALIZED, "CKR_USER_PIN_NOT_INITIALIZED" },
+    { CKR_USER_TYPE_INVALID, "CKR_USER_TYPE_INVALID" },
+    { CKR_USER_ANOTHER_ALREADY_LOGGED_IN, "CKR_USER_ANOTHER_ALREADY_LOGGED_IN" },
+    { CKR_USER_TOO_MANY_TYPES, "CKR_USER_TOO_MANY_TYPES" },
+    { CKR_WRAPPED_KEY_INVALID, "CKR_WRAPPED_KEY_INVALID" },
+    { CKR_WRAPPED_KEY_LEN_RANGE, "CKR_WRAPPED_KEY_LEN_RANGE" },
+    { CKR_WRAPPING_KEY_HANDLE_INVALID, "CKR_WRAPPING_KEY_HANDLE_INVALID" },
+    { CKR_WRAPPING_KEY_SIZE_RANGE, "CKR_WRAPPING_KEY_SIZE_RANGE" },
+    { CKR_WRAPPING_KEY_TYPE_INCONSISTENT, "CKR_WRAPPING_KEY_TYPE_INCONSISTENT" },
+    { CKR_RANDOM_SEED_NOT_SUPPORTED, "CKR_RANDOM_SEED_NOT_SUPPORTED" },
+    { CKR_RANDOM_NO_RNG, "CKR_RANDOM_NO_RNG" },
+    { CKR_DOMAIN_PARAMS_INVALID, "CKR_DOMAIN_PARAMS_INVALID" },
+    { CKR_BUFFER_TOO_SMALL, "CKR_BUFFER_TOO_SMALL" },
+    { CKR_SAVED_STATE_INVALID, "CKR_SAVED_STATE_INVALID" },
+    { CKR_INFORMATION_SENSITIVE, "CKR_INFORMATION_SENSITIVE" },
+    { CKR_STATE_UNSAVEABLE, "CKR_STATE_UNSAVEABLE" },
+    { CKR_CRYPTOKI_NOT_INITIALIZED, "CKR_CRYPTOKI_NOT_INITIALIZED" },
+    { CKR_CRYPTOKI_ALREADY_INITIALIZED, "CKR_CRYPTOKI_ALREADY_INITIALIZED" },
+    { CKR_MUTEX_BAD, "CKR_MUTEX_BAD" },
+    { CKR_MUTEX_NOT_LOCKED, "CKR_MUTEX_NOT_LOCKED" },
+    { CKR_NEW_PIN_MODE, "CKR_NEW_PIN_MODE" },
+    { CKR_NEXT_OTP, "CKR_NEXT_OTP" },
+    { CKR_FUNCTION_REJECTED, "CKR_FUNCTION_REJECTED" },
+    { CKR_VENDOR_DEFINED, "CKR_VENDOR_DEFINED" }
+};
+
+
+// Translates CK_RV to string
+const char* pkcs11_logger_translate_ck_rv(CK_RV rv)
+{
+    return pkcs11_logger_translate_find_name(pkcs11_logger_translate_ck_rv_names, PKCS11_LOGGER_TRANSLATION_COUNT(pkcs11_logger_translate_ck_rv_names), rv);
+}
+
+
+// Translates string to CK_RV
+int pkcs11_logger_translate_string_to_ck_rv(const char *name, CK_RV *rv)
+{
+    return pkcs11_logger_translate_find_value(pkcs11_logger_translate_ck_rv_names, PKCS11_LOGGER_TRANSLATION_COUNT(pkcs11_logger_translate_ck_rv_names), name, rv);
+}
+
+
+// Names of CK_MECHANISM_TYPE values sorted by value
+static const PKCS11_LOGGER_TRANSLATION pkcs11_logger_translate_ck_mechanism_type_names[] =
+{
+    { CKM_RSA_PKCS_KEY_PAIR_GEN, "CKM_RSA_PKCS_KEY_PAIR_GEN" },
+    { CKM_RSA_PKCS, "CKM_RSA_PKCS" },
+    { CKM_RSA_9796, "CKM_RSA_9796" },
+    { CKM_RSA_X_509, "CKM_RSA_X_509" },
+    { CKM_MD2_RSA_PKCS, "CKM_MD2_RSA_PKCS" },
+    { CKM_MD5_RSA_PKCS, "CKM_MD5_RSA_PKCS" },
+    { CKM_SHA1_RSA_PKCS, "CKM_SHA1_RSA_PKCS" },
+    { CKM_RIPEMD128_RSA_PKCS, "CKM_RIPEMD128_RSA_PKCS" },
+    { CKM_RIPEMD160_RSA_PKCS, "CKM_RIPEMD160_RSA_PKCS" },
+    { CKM_RSA_PKCS_OAEP, "CKM_RSA_PKCS_OAEP" },
+    { CKM_RSA_X9_31_KEY_PAIR_GEN, "CKM_RSA_X9_31_KEY_PAIR_GEN" },
+    { CKM_RSA_X9_31, "CKM_RSA_X9_31" },
+    { CKM_SHA1_RSA_X9_31, "CKM_SHA1_RSA_X9_31" },
+    { CKM_RSA_PKCS_PSS, "CKM_RSA_PKCS_PSS" },
+    { CKM_SHA1_RSA_PKCS_PSS, "CKM_SHA1_RSA_PKCS_PSS" },
+    { CKM_DSA_KEY_PAIR_GEN, "CKM_DSA_KEY_PAIR_GEN" },
+    { CKM_DSA, "CKM_DSA" },
+    { CKM_DSA_SHA1, "CKM_DSA_SHA1" },
+    { CKM_DH_PKCS_KEY_PAIR_GEN, "CKM_DH_PKCS_KEY_PAIR_GEN" },
+    { CKM_DH_PKCS_DERIVE, "CKM_DH_PKCS_DERIVE" },
+    { CKM_X9_42_DH_KEY_PAIR_GEN, "CKM_X9_42_DH_KEY_PAIR_GEN" },
+    { CKM_X9_42_DH_DERIVE, "CKM_X9_42_DH_DERIVE" },
+    { CKM_X9_42_DH_HYBRID_DERIVE, "CKM_X9_42_DH_HYBRID_DERIVE" },
+    { CKM_X9_42_MQV_DERIVE, "CKM_X9_42_MQV_DERIVE" },
+    { CKM_SHA256_RSA_PKCS, "CKM_SHA256_RSA_PKCS" },
+    { CKM_SHA384_RSA_PKCS, "CKM_SHA384_RSA_PKCS" },
+    { CKM_SHA512_RSA_PKCS, "CKM_SHA512_RSA_PKCS" },
+    { CKM_SHA256_RSA_PKCS_PSS, "CKM_SHA256_RSA_PKCS_PSS" },
+    { CKM_SHA384_RSA_PKCS_PSS, "CKM_SHA384_RSA_PKCS_PSS" },
+    { CKM_SHA512_RSA_PKCS_PSS, "CKM_SHA512_RSA_PKCS_PSS" },
+    { CKM_SHA224_RSA_PKCS, "CKM_SHA224_RSA_PKCS" },
+    { CKM_SHA224_RSA_PKCS_PSS, "CKM_SHA224_RSA_PKCS_PSS" },
+    { CKM_RC2_KEY_GEN, "CKM_RC2_KEY_GEN" },
+    { CKM_RC2_ECB, "CKM_RC2_ECB" },
+    { CKM_RC2_CBC, "CKM_RC2_CBC" },
+    { CKM_RC2_MAC, "CKM_RC2_MAC" },
+    { CKM_RC2_MAC_GENERAL, "CKM_RC2_MAC_GENERAL" },
+    { CKM_RC2_CBC_PAD, "CKM_RC2_CBC_PAD" },
+    { CKM_RC4_KEY_GEN, "CKM_RC4_KEY_GEN" },
+    { CKM_RC4, "CKM_RC4" },
+    { CKM_DES_KEY_GEN, "CKM_DES_KEY_GEN" },
+    { CKM_DES_ECB, "CKM_DES_ECB" },
+    { CKM_DES_CBC, "CKM_DES_CBC" },
+    { CKM_DES_MAC, "CKM_DES_MAC" },
+    { CKM_DES_MAC_GENERAL, "CKM_DES_MAC_GENERAL" },
+    { CKM_DES_CBC_PAD, "CKM_DES_CBC_PAD" },
+    { CKM_DES2_KEY_GEN, "CKM_DES2_KEY_GEN" },
+    { CKM_DES3_KEY_GEN, "CKM_DES3_KEY_GEN" },
+    { CKM_DES3_ECB, "CKM_DES3_ECB" },
+    { CKM_DES3_CBC, "CKM_DES3_CBC" },
+    { CKM_DES3_MAC, "CKM_DES3_MAC" },
+    { CKM_DES3_MAC_GENERAL, "CKM_DES3_MAC_GENERAL" },
+    { CKM_DES3_CBC_PAD, "CKM_DES3_CBC_PAD" },
+    { CKM_CDMF_KEY_GEN, "CKM_CDMF_KEY_GEN" },
+    { CKM_CDMF_ECB, "CKM_CDMF_ECB" },
+    { CKM_CDMF_CBC, "CKM_CDMF_CBC" },
+    { CKM_CDMF_MAC, "CKM_CDMF_MAC" },
+    { CKM_CDMF_MAC_GENERAL, "CKM_CDMF_MAC_GENERAL" },
+    { CKM_CDMF_CBC_PAD, "CKM_CDMF_CBC_PAD" },
+    { CKM_DES_OFB64, "CKM_DES_OFB64" },
+    { CKM_DES_OFB8, "CKM_DES_OFB8" },
+    { CKM_DES_CFB64, "CKM_DES_CFB64" },
+    { CKM_DES_CFB8, "CKM_DES_CFB8" },
+    { CKM_MD2, "CKM_MD2" },
+    { CKM_MD2_HMAC, "CKM_MD2_HMAC" },
+    { CKM_MD2_HMAC_GENERAL, "CKM_MD2_HMAC_GENERAL" },
+    { CKM_MD5, "CKM_MD5" },
+    { CKM_MD5_HMAC, "CKM_MD5_HMAC" },
+    { CKM_MD5_HMAC_GENERAL, "CKM_MD5_HMAC_GENERAL" },
+    { CKM_SHA_1, "CKM_SHA_1" },
+    { CKM_SHA_1_HMAC, "CKM_SHA_1_HMAC" },
+    { CKM_SHA_1_HMAC_GENERAL, "CKM_SHA_1_HMAC_GENERAL" },
+    { CKM_RIPEMD128, "CKM_RIPEMD128" },
+    { CKM_RIPEMD128_HMAC, "CKM_RIPEMD128_HMAC" },
+    { CKM_RIPEMD128_HMAC_GENERAL, "CKM_RIPEMD128_HMAC_GENERAL" },
+    { CKM_RIPEMD160, "CKM_RIPEMD160" },
+    { CKM_RIPEMD160_HMAC, "CKM_RIPEMD160_HMAC" },
+    { CKM_RIPEMD160_HMAC_GENERAL, "CKM_RIPEMD160_HMAC_GENERAL" },
+    { CKM_SHA256, "CKM_SHA256" },
+    { CKM_SHA256_HMAC, "CKM_SHA256_HMAC" },
+    { CKM_SHA256_HMAC_GENERAL, "CKM_SHA256_HMAC_GENERAL" },
+    { CKM_SHA224, "CKM_SHA224" },
+    { CKM_SHA224_HMAC, "CKM_SHA224_HMAC" },
+    { CKM_SHA224_HMAC_GENERAL, "CKM_SHA224_HMAC_GENERAL" },
+    { CKM_SHA384, "CKM_SHA384" },
+    { CKM_SHA384_HMAC, "CKM_SHA384_HMAC" },
+    { CKM_SHA384_HMAC_GENERAL, "CKM_SHA384_HMAC_GENERAL" },
+    { CKM_SHA512, "CKM_SHA512" },
+    { CKM_SHA512_HMAC, "CKM_SHA512_HMAC" },
+    { CKM_SHA512_HMAC_GENERAL, "CKM_SHA512_HMAC_GENERAL" },
+    { CKM_SECURID_KEY_GEN, "CKM_SECURID_KEY_GEN" },
+    { CKM_SECURID, "CKM_SECURID" },
+    { CKM_HOTP_KEY_GEN, "CKM_HOTP_KEY_GEN" },
+    { CKM_HOTP, "CKM_HOTP" },
+    { CKM_ACTI, "CKM_ACTI" },
+    { CKM_ACTI_KEY_GEN, "CKM_ACTI_KEY_GEN" },
+    { CKM_CAST_KEY_GEN, "CKM_CAST_KEY_GEN" },
+    { CKM_CAST_ECB, "CKM_CAST_ECB" },
+    { CKM_CAST_CBC, "CKM_CAST_CBC" },
+    { CKM_CAST_MAC, "CKM_CAST_MAC" },
+    { CKM_CAST_MAC_GENERAL, "CKM_CAST_MAC_GENERAL" },
+    { CKM_CAST_CBC_PAD, "CKM_CAST_CBC_PAD" },
+    { CKM_CAST3_KEY_GEN, "CKM_CAST3_KEY_GEN" },
+    { CKM_CAST3_ECB, "CKM_CAST3_ECB" },
+    { CKM_CAST3_CBC, "CKM_CAST3_CBC" },
+    { CKM_CAST3_MAC, "CKM_CAST3_MAC" },
+    { CKM_CAST3_MAC_GENERAL, "CKM_CAST3_MAC_GENERAL" },
+    { CKM_CAST3_CBC_PAD, "CKM_CAST3_CBC_PAD" },
+    { CKM_CAST5_KEY_GEN, "CKM_CAST5_KEY_GEN or CKM_CAST128_KEY_GEN" },
+    { CKM_CAST5_ECB, "CKM_CAST5_ECB or CKM_CAST128_ECB" },
+    { CKM_CAST5_CBC, "CKM_CAST5_CBC or CKM_CAST128_CBC" },
+    { CKM_CAST5_MAC, "CKM_CAST5_MAC or CKM_CAST128_MAC" },
+    { CKM_CAST5_MAC_GENERAL, "CKM_CAST5_MAC_GENERAL or CKM_CAST128_MAC_GENERAL" },
+    { CKM_CAST5_CBC_PAD, "CKM_CAST5_CBC_PAD or CKM_CAST128_CBC_PAD" },
+    { CKM_RC5_KEY_GEN, "CKM_RC5_KEY_GEN" },
+    { CKM_RC5_ECB, "CKM_RC5_ECB" },
+    { CKM_RC5_CBC, "CKM_RC5_CBC" },
+    { CKM_RC5_MAC, "CKM_RC5_MAC" },
+    { CKM_RC5_MAC_GENERAL, "CKM_RC5_MAC_GENERAL" },
+    { CKM_RC5_CBC_PAD, "CKM_RC5_CBC_PAD" },
+    { CKM_IDEA_KEY_GEN, "CKM_IDEA_KEY_GEN" },
+    { CKM_IDEA_ECB, "CKM_IDEA_ECB" },
+    { CKM_IDEA_CBC, "CKM_IDEA_CBC" },
+    { CKM_IDEA_MAC, "CKM_IDEA_MAC" },
+    { CKM_IDEA_MAC_GENERAL, "CKM_IDEA_MAC_GENERAL" },
+    { CKM_IDEA_CBC_PAD, "CKM_IDEA_CBC_PAD" },
+    { CKM_GENERIC_SECRET_KEY_GEN, "CKM_GENERIC_SECRET_KEY_GEN" },
+    { CKM_CONCATENATE_BASE_AND_KEY, "CKM_CONCATENATE_BASE_AND_KEY" },
+    { CKM_CONCATENATE_BASE_AND_DATA, "CKM_CONCATENATE_BASE_AND_DATA" },
+    { CKM_CONCATENATE_DATA_AND_BASE, "CKM_CONCATENATE_DATA_AND_BASE" },
+    { CKM_XOR_BASE_AND_DATA, "CKM_XOR_BASE_AND_DATA" },
+    { CKM_EXTRACT_KEY_FROM_KEY, "CKM_EXTRACT_KEY_FROM_KEY" },
+    { CKM_SSL3_PRE_MASTER_KEY_GEN, "CKM_SSL3_PRE_MASTER_KEY_GEN" },
+    { CKM_SSL3_MASTER_KEY_DERIVE, "CKM_SSL3_MASTER_KEY_DERIVE" },
+    { CKM_SSL3_KEY_AND_MAC_DERIVE, "CKM_SSL3_KEY_AND_MAC_DERIVE" },
+    { CKM_SSL3_MASTER_KEY_DERIVE_DH, "CKM_SSL3_MASTER_KEY_DERIVE_DH" },
+    { CKM_TLS_PRE_MASTER_KEY_GEN, "CKM_TLS_PRE_MASTER_KEY_GEN" },
+    { CKM_TLS_MASTER_KEY_DERIVE, "CKM_TLS_MASTER_KEY_DERIVE" },
+    { CKM_TLS_KEY_AND_MAC_DERIVE, "CKM_TLS_KEY_AND_MAC_DERIVE" },
+    { CKM_TLS_MASTER_KEY_DERIVE_DH, "CKM_TLS_MASTER_KEY_DERIVE_DH" },
+    { CKM_TLS_PRF, "CKM_TLS_PRF" },
+    { CKM_SSL3_MD5_MAC, "CKM_SSL3_MD5_MAC" },
+    { CKM_SSL3_SHA1_MAC, "CKM_SSL3_SHA1_MAC" },
+    { CKM_MD5_KEY_DERIVATION, "CKM_MD5_KEY_DERIVATION" },
+    { CKM_MD2_KEY_DERIVATION, "CKM_MD2_KEY_DERIVATION" },
+    { CKM_SHA1_KEY_DERIVATION, "CKM_SHA1_KEY_DERIVATION" },
+    { CKM_SHA256_KEY_DERIVATION, "CKM_SHA256_KEY_DERIVATION" },
+    { CKM_SHA384_KEY_DERIVATION, "CKM_SHA384_KEY_DERIVATION" },
+    { CKM_SHA512_KEY_DERIVATION, "CKM_SHA512_KEY_DERIVATION" },
+    { CKM_SHA224_KEY_DERIVATION, "CKM_SHA224_KEY_DERIVATION" },
+    { CKM_PBE_MD2_DES_CBC, "CKM_PBE_MD2_DES_CBC" },
+    { CKM_PBE_MD5_DES_CBC, "CKM_PBE_MD5_DES_CBC" },
+    { CKM_PBE_MD5_CAST_CBC, "CKM_PBE_MD5_CAST_CBC" },
+    { CKM_PBE_MD5_CAST3_CBC, "CKM_PBE_MD5_CAST3_CBC" },
+    { CKM_PBE_MD5_CAST5_CBC, "CKM_PBE_MD5_CAST5_CBC or CKM_PBE_MD5_CAST128_CBC" },
+    { CKM_PBE_SHA1_CAST5_CBC, "CKM_PBE_SHA1_CAST5_CBC or CKM_PBE_SHA1_CAST128_CBC" },
+    { CKM_PBE_SHA1_RC4_128, "CKM_PBE_SHA1_RC4_128" },
+    { CKM_PBE_SHA1_RC4_40, "CKM_PBE_SHA1_RC4_40" },
+    { CKM_PBE_SHA1_DES3_EDE_CBC, "CKM_PBE_SHA1_DES3_EDE_CBC" },
+    { CKM_PBE_SHA1_DES2_EDE_CBC, "CKM_PBE_SHA1_DES2_EDE_CBC" },
+    { CKM_PBE_SHA1_RC2_128_CBC, "CKM_PBE_SHA1_RC2_128_CBC" },
+    { CKM_PBE_SHA1_RC2_40_CBC, "CKM_PBE_SHA1_RC2_40_CBC" },
+    { CKM_PKCS5_PBKD2, "CKM_PKCS5_PBKD2" },
+    { CKM_PBA_SHA1_WITH_SHA1_HMAC, "CKM_PBA_SHA1_WITH_SHA1_HMAC" },
+    { CKM_WTLS_PRE_MASTER_KEY_GEN, "CKM_WTLS_PRE_MASTER_KEY_GEN" },
+    { CKM_WTLS_MASTER_KEY_DERIVE, "CKM_WTLS_MASTER_KEY_DERIVE" },
+    { CKM_WTLS_MASTER_KEY_DERIVE_DH_ECC, "CKM_WTLS_MASTER_KEY_DERIVE_DH_ECC" },
+    { CKM_WTLS_PRF, "CKM_WTLS_PRF" },
+    { CKM_WTLS_SERVER_KEY_AND_MAC_DERIVE, "CKM_WTLS_SERVER_KEY_AND_MAC_DERIVE" },
+    { CKM_WTLS_CLIENT_KEY_AND_MAC_DERIVE, "CKM_WTLS_CLIENT_KEY_AND_MAC_DERIVE" },
+    { CKM_KEY_WRAP_LYNKS, "CKM_KEY_WRAP_LYNKS" },
+    { CKM_KEY_WRAP_SET_OAEP, "CKM_KEY_WRAP_SET_OAEP" },
+    { CKM_CMS_SIG, "CKM_CMS_SIG" },
+    { CKM_KIP_DERIVE, "CKM_KIP_DERIVE" },
+    { CKM_KIP_WRAP, "CKM_KIP_WRAP" },
+    { CKM_KIP_MAC, "CKM_KIP_MAC" },
+    { CKM_CAMELLIA_KEY_GEN, "CKM_CAMELLIA_KEY_GEN" },
+    { CKM_CAMELLIA_ECB, "CKM_CAMELLIA_ECB" },
+    { CKM_CAMELLIA_CBC, "CKM_CAMELLIA_CBC" },
+    { CKM_CAMELLIA_MAC, "CKM_CAMELLIA_MAC" },
+    { CKM_CAMELLIA_MAC_GENERAL, "CKM_CAMELLIA_MAC_GENERAL" },
+    { CKM_CAMELLIA_CBC_PAD, "CKM_CAMELLIA_CBC_PAD" },
+    { CKM_CAMELLIA_ECB_ENCRYPT_DATA, "CKM_CAMELLIA_ECB_ENCRYPT_DATA" },
+    { CKM_CAMELLIA_CBC_ENCRYPT_DATA, "CKM_CAMELLIA_CBC_ENCRYPT_DATA" },
+    { CKM_CAMELLIA_CTR, "CKM_CAMELLIA_CTR" },
+    { CKM_ARIA_KEY_GEN, "CKM_ARIA_KEY_GEN" },
+    { CKM_ARIA_ECB, "CKM_ARIA_ECB" },
+    { CKM_ARIA_CBC, "CKM_ARIA_CBC" },
+    { CKM_ARIA_MAC, "CKM_ARIA_MAC" },
+    { CKM_ARIA_MAC_GENERAL, "CKM_ARIA_MAC_GENERAL" },
+    { CKM_ARIA_CBC_PAD, "CKM_ARIA_CBC_PAD" },
+    { CKM_ARIA_ECB_ENCRYPT_DATA, "CKM_ARIA_ECB_ENCRYPT_DATA" },
+    { CKM_ARIA_CBC_ENCRYPT_DATA, "CKM_ARIA_CBC_ENCRYPT_DATA" },
+    { CKM_SKIPJACK_KEY_GEN, "CKM_SKIPJACK_KEY_GEN" },
+    { CKM_SKIPJACK_ECB64, "CKM_SKIPJACK_ECB64" },
+    { CKM_SKIPJACK_CBC64, "CKM_SKIPJACK_CBC64" },
+    { CKM_SKIPJACK_OFB64, "CKM_SKIPJACK_OFB64" },
+    { CKM_SKIPJACK_CFB64, "CKM_SKIPJACK_CFB64" },
+    { CKM_SKIPJACK_CFB32, "CKM_SKIPJACK_CFB32" },
+    { CKM_SKIPJACK_CFB16, "CKM_SKIPJACK_CFB16" },
+    { CKM_SKIPJACK_CFB8, "CKM_SKIPJACK_CFB8" },
+    { CKM_SKIPJACK_WRAP, "CKM_SKIPJACK_WRAP" },
+    { CKM_SKIPJACK_PRIVATE_WRAP, "CKM_SKIPJACK_PRIVATE_WRAP" },
+    { CKM_SKIPJACK_RELAYX, "CKM_SKIPJACK_RELAYX" },
+    { CKM_KEA_KEY_PAIR_GEN, "CKM_KEA_KEY_PAIR_GEN" },
+    { CKM_KEA_KEY_DERIVE, "CKM_KEA_KEY_DERIVE" },
+    { CKM_FORTEZZA_TIMESTAMP, "CKM_FORTEZZA_TIMESTAMP" },
+    { CKM_BATON_KEY_GEN, "CKM_BATON_KEY_GEN" },
+    { CKM_BATON_ECB128, "CKM_BATON_ECB128" },
+    { CKM_BATON_ECB96, "CKM_BATON_ECB96" },
+    { CKM_BATON_CBC128, "CKM_BATON_CBC128" },
+    { CKM_BATON_COUNTER, "CKM_BATON_COUNTER" },
+    { CKM_BATON_SHUFFLE, "CKM_BATON_SHUFFLE" },
+    { CKM_BATON_WRAP, "CKM_BATON_WRAP" },
+    { CKM_ECDSA_KEY_PAIR_GEN, "CKM_ECDSA_KEY_PAIR_GEN or CKM_EC_KEY_PAIR_GEN" },
+    { CKM_ECDSA, "CKM_ECDSA" },
+    { CKM_ECDSA_SHA1, "CKM_ECDSA_SHA1" },
+    { CKM_ECDH1_DERIVE, "CKM_ECDH1_DERIVE" },
+    { CKM_ECDH1_COFACTOR_DERIVE, "CKM_ECDH1_COFACTOR_DERIVE" },
+    { CKM_ECMQV_DERIVE, "CKM_ECMQV_DERIVE" },
+    { CKM_JUNIPER_KEY_GEN, "CKM_JUNIPER_KEY_GEN" },
+    { CKM_JUNIPER_ECB128, "CKM_JUNIPER_ECB128" },
+    { CKM_JUNIPER_CBC128, "CKM_JUNIPER_CBC128" },
+    { CKM_JUNIPER_COUNTER, "CKM_JUNIPER_COUNTER" },
+    { CKM_JUNIPER_SHUFFLE, "CKM_JUNIPER_SHUFFLE" },
+    { CKM_JUNIPER_WRAP, "CKM_JUNIPER_WRAP" },
+    { CKM_FASTHASH, "CKM_FASTHASH" },
+    { CKM_AES_KEY_GEN, "CKM_AES_KEY_GEN" },
+    { CKM_AES_ECB, "CKM_AES_ECB" },
+    { CKM_AES_CBC, "CKM_AES_CBC" },
+    { CKM_AES_MAC, "CKM_AES_MAC" },
+    { CKM_AES_MAC_GENERAL, "CKM_AES_MAC_GENERAL" },
+    { CKM_AES_CBC_PAD, "CKM_AES_CBC_PAD" },
+    { CKM_AES_CTR, "CKM_AES_CTR" },
+    { CKM_BLOWFISH_KEY_GEN, "CKM_BLOWFISH_KEY_GEN" },
+    { CKM_BLOWFISH_CBC, "CKM_BLOWFISH_CBC" },
+    { CKM_TWOFISH_KEY_GEN, "CKM_TWOFISH_KEY_GEN" },
+    { CKM_TWOFISH_CBC, "CKM_TWOFISH_CBC" },
+    { CKM_DES_ECB_ENCRYPT_DATA, "CKM_DES_ECB_ENCRYPT_DATA" },
+    { CKM_DES_CBC_ENCRYPT_DATA, "CKM_DES_CBC_ENCRYPT_DATA" },
+    { CKM_DES3_ECB_ENCRYPT_DATA, "CKM_DES3_ECB_ENCRYPT_DATA" },
+    { CKM_DES3_CBC_ENCRYPT_DATA, "CKM_DES3_CBC_ENCRYPT_DATA" },
+    { CKM_AES_ECB_ENCRYPT_DATA, "CKM_AES_ECB_ENCRYPT_DATA" },
+    { CKM_AES_CBC_ENCRYPT_DATA, "CKM_AES_CBC_ENCRYPT_DATA" },
+    { CKM_DSA_PARAMETER_GEN, "CKM_DSA_PARAMETER_GEN" },
+    { CKM_DH_PKCS_PARAMETER_GEN, "CKM_DH_PKCS_PARAMETER_GEN" },
+    { CKM_X9_42_DH_PARAMETER_GEN, "CKM_X9_42_DH_PARAMETER_GEN" },
+    { CKM_VENDOR_DEFINED, "CKM_VENDOR_DEFINED" }
+};
+
+
+// Translates CK_MECHANISM_TYPE to string
+const char* pkcs11_logger_translate_ck_mechanism_type(CK_MECHANISM_TYPE type)
+{
+    return pkcs11_logger_translate_find_name(pkcs11_logger_translate_ck_mechanism_type_names, PKCS11_LOGGER_TRANSLATION_COUNT(pkcs11_logger_translate_ck_mechanism_type_names), type);
+}
+
+
+// Translates string to CK_MECHANISM_TYPE
+int pkcs11_logger_translate_string_to_ck_mechanism_type(const char *name, CK_MECHANISM_TYPE *type)
+{
+    return pkcs11_logger_translate_find_value(pkcs11_logger_translate_ck_mechanism_type_names, PKCS11_LOGGER_TRANSLATION_COUNT(pkcs11_logger_translate_ck_mechanism_type_names), name, type);
 }
 
 
@@ -1142,342 +578,252 @@ const char* pkcs11_logger_translate_ck_state(CK_STATE state)
 }
 
 
-// Translates CK_BYTE_PTR to string
-char* pkcs11_logger_translate_ck_byte_ptr(CK_BYTE_PTR bytes, CK_ULONG length)
+// Translates identifier of PKCS#11 function to its name
+const char* pkcs11_logger_translate_function_id(CK_ULONG id)
+{
+    static const char *function_names[PKCS11_LOGGER_FUNCTION_COUNT] =
+    {
+        "C_Initialize",
+        "C_Finalize",
+        "C_GetInfo",
+        "C_GetFunctionList",
+        "C_GetSlotList",
+        "C_GetSlotInfo",
+        "C_GetTokenInfo",
+        "C_GetMechanismList",
+        "C_GetMechanismInfo",
+        "C_InitToken",
+        "C_InitPIN",
+        "C_SetPIN",
+        "C_OpenSession",
+        "C_CloseSession",
+        "C_CloseAllSessions",
+        "C_GetSessionInfo",
+        "C_GetOperationState",
+        "C_SetOperationState",
+        "C_Login",
+        "C_Logout",
+        "C_CreateObject",
+        "C_CopyObject",
+        "C_DestroyObject",
+        "C_GetObjectSize",
+        "C_GetAttributeValue",
+        "C_SetAttributeValue",
+        "C_FindObjectsInit",
+        "C_FindObjects",
+        "C_FindObjectsFinal",
+        "C_EncryptInit",
+        "C_Encrypt",
+        "C_EncryptUpdate",
+        "C_EncryptFinal",
+        "C_DecryptInit",
+        "C_Decrypt",
+        "C_DecryptUpdate",
+        "C_DecryptFinal",
+        "C_DigestInit",
+        "C_Digest",
+        "C_DigestUpdate",
+        "C_DigestKey",
+        "C_DigestFinal",
+        "C_SignInit",
+        "C_Sign",
+        "C_SignUpdate",
+        "C_SignFinal",
+        "C_SignRecoverInit",
+        "C_SignRecover",
+        "C_VerifyInit",
+        "C_Verify",
+        "C_VerifyUpdate",
+        "C_VerifyFinal",
+        "C_VerifyRecoverInit",
+        "C_VerifyRecover",
+        "C_DigestEncryptUpdate",
+        "C_DecryptDigestUpdate",
+        "C_SignEncryptUpdate",
+        "C_DecryptVerifyUpdate",
+        "C_GenerateKey",
+        "C_GenerateKeyPair",
+        "C_WrapKey",
+        "C_UnwrapKey",
+        "C_DeriveKey",
+        "C_SeedRandom",
+        "C_GenerateRandom",
+        "C_GetFunctionStatus",
+        "C_CancelFunction",
+        "C_WaitForSlotEvent"
+    };
+
+    if (id >= PKCS11_LOGGER_FUNCTION_COUNT)
+        return "Unknown";
+
+    return function_names[id];
+}
+
+
+// Translates name of PKCS#11 function to its identifier
+int pkcs11_logger_translate_string_to_function_id(const char *name, CK_ULONG *id)
 {
     CK_ULONG i = 0;
-    char *output = NULL;
-    CK_ULONG output_len = (length * 2) + 1;
-    const char *t = "0123456789ABCDEF";
-    
-    output = (char *) malloc(output_len);
-    if (NULL == output)
-        return NULL;
 
-    memset(output, 0, output_len);
+    if ((NULL == name) || (NULL == id))
+        return PKCS11_LOGGER_RV_ERROR;
 
-    for (i = 0; i < length; i++)
+    for (i = 0; i < PKCS11_LOGGER_FUNCTION_COUNT; i++)
     {
-        int lo = bytes[i] & 0x0F;
-        int hi = bytes[i] >> 4;
-        output[i * 2] = t[hi];
-        output[i * 2 + 1] = t[lo];
+        if (CK_TRUE == pkcs11_logger_utils_str_equals_ignore_case(name, pkcs11_logger_translate_function_id(i)))
+        {
+            *id = i;
+            return PKCS11_LOGGER_RV_SUCCESS;
+        }
     }
 
-    return output;
+    return PKCS11_LOGGER_RV_ERROR;
 }
 
 
-// Translates CK_ATTRIBUTE_TYPE to string
-const char* pkcs11_logger_translate_ck_attribute(CK_ATTRIBUTE_TYPE type)
+// Marks PKCS#11 function or all functions of the class specified by name in the bitmap
+int pkcs11_logger_translate_string_to_function_set(const char *name, CK_BYTE *functions)
 {
-    const char *type_name = NULL;
+    CK_ULONG id = 0;
+    CK_ULONG i = 0;
+    CK_BBOOL found = CK_FALSE;
 
-    switch (type)
+    if ((NULL == name) || (NULL == functions))
+        return PKCS11_LOGGER_RV_ERROR;
+
+    if (PKCS11_LOGGER_RV_SUCCESS == pkcs11_logger_translate_string_to_function_id(name, &id))
     {
-        case CKA_CLASS:
-            type_name = "CKA_CLASS";
-            break;
-        case CKA_TOKEN:
-            type_name = "CKA_TOKEN";
-            break;
-        case CKA_PRIVATE:
-            type_name = "CKA_PRIVATE";
-            break;
-        case CKA_LABEL:
-            type_name = "CKA_LABEL";
-            break;
-        case CKA_APPLICATION:
-            type_name = "CKA_APPLICATION";
-            break;
-        case CKA_VALUE:
-            type_name = "CKA_VALUE";
-            break;
-        case CKA_OBJECT_ID:
-            type_name = "CKA_OBJECT_ID";
-            break;
-        case CKA_CERTIFICATE_TYPE:
-            type_name = "CKA_CERTIFICATE_TYPE";
-            break;
-        case CKA_ISSUER:
-            type_name = "CKA_ISSUER";
-            break;
-        case CKA_SERIAL_NUMBER:
-            type_name = "CKA_SERIAL_NUMBER";
-            break;
-        case CKA_AC_ISSUER:
-            type_name = "CKA_AC_ISSUER";
-            break;
-        case CKA_OWNER:
-            type_name = "CKA_OWNER";
-            break;
-        case CKA_ATTR_TYPES:
-            type_name = "CKA_ATTR_TYPES";
-            break;
-        case CKA_TRUSTED:
-            type_name = "CKA_TRUSTED";
-            break;
-        case CKA_CERTIFICATE_CATEGORY:
-            type_name = "CKA_CERTIFICATE_CATEGORY";
-            break;
-        case CKA_JAVA_MIDP_SECURITY_DOMAIN:
-            type_name = "CKA_JAVA_MIDP_SECURITY_DOMAIN";
-            break;
-        case CKA_URL:
-            type_name = "CKA_URL";
-            break;
-        case CKA_HASH_OF_SUBJECT_PUBLIC_KEY:
-            type_name = "CKA_HASH_OF_SUBJECT_PUBLIC_KEY";
-            break;
-        case CKA_HASH_OF_ISSUER_PUBLIC_KEY:
-            type_name = "CKA_HASH_OF_ISSUER_PUBLIC_KEY";
-            break;
-        case CKA_CHECK_VALUE:
-            type_name = "CKA_CHECK_VALUE";
-            break;
-        case CKA_KEY_TYPE:
-            type_name = "CKA_KEY_TYPE";
-            break;
-        case CKA_SUBJECT:
-            type_name = "CKA_SUBJECT";
-            break;
-        case CKA_ID:
-            type_name = "CKA_ID";
-            break;
-        case CKA_SENSITIVE:
-            type_name = "CKA_SENSITIVE";
-            break;
-        case CKA_ENCRYPT:
-            type_name = "CKA_ENCRYPT";
-            break;
-        case CKA_DECRYPT:
-            type_name = "CKA_DECRYPT";
-            break;
-        case CKA_WRAP:
-            type_name = "CKA_WRAP";
-            break;
-        case CKA_UNWRAP:
-            type_name = "CKA_UNWRAP";
-            break;
-        case CKA_SIGN:
-            type_name = "CKA_SIGN";
-            break;
-        case CKA_SIGN_RECOVER:
-            type_name = "CKA_SIGN_RECOVER";
-            break;
-        case CKA_VERIFY:
-            type_name = "CKA_VERIFY";
-            break;
-        case CKA_VERIFY_RECOVER:
-            type_name = "CKA_VERIFY_RECOVER";
-            break;
-        case CKA_DERIVE:
-            type_name = "CKA_DERIVE";
-            break;
-        case CKA_START_DATE:
-            type_name = "CKA_START_DATE";
-            break;
-        case CKA_END_DATE:
-            type_name = "CKA_END_DATE";
-            break;
-        case CKA_MODULUS:
-            type_name = "CKA_MODULUS";
-            break;
-        case CKA_MODULUS_BITS:
-            type_name = "CKA_MODULUS_BITS";
-            break;
-        case CKA_PUBLIC_EXPONENT:
-            type_name = "CKA_PUBLIC_EXPONENT";
-            break;
-        case CKA_PRIVATE_EXPONENT:
-            type_name = "CKA_PRIVATE_EXPONENT";
-            break;
-        case CKA_PRIME_1:
-            type_name = "CKA_PRIME_1";
-            break;
-        case CKA_PRIME_2:
-            type_name = "CKA_PRIME_2";
-            break;
-        case CKA_EXPONENT_1:
-            type_name = "CKA_EXPONENT_1";
-            break;
-        case CKA_EXPONENT_2:
-            type_name = "CKA_EXPONENT_2";
-            break;
-        case CKA_COEFFICIENT:
-            type_name = "CKA_COEFFICIENT";
-            break;
-        case CKA_PRIME:
-            type_name = "CKA_PRIME";
-            break;
-        case CKA_SUBPRIME:
-            type_name = "CKA_SUBPRIME";
-            break;
-        case CKA_BASE:
-            type_name = "CKA_BASE";
-            break;
-        case CKA_PRIME_BITS:
-            type_name = "CKA_PRIME_BITS";
-            break;
-        // Duplicate values in PKCS#11 specification
-        // #define CKA_SUBPRIME_BITS      0x00000134
-        // #define CKA_SUB_PRIME_BITS     CKA_SUBPRIME_BITS
-        case CKA_SUBPRIME_BITS:
-            type_name = "CKA_SUBPRIME_BITS or CKA_SUB_PRIME_BITS";
-            break;
-        case CKA_VALUE_BITS:
-            type_name = "CKA_VALUE_BITS";
-            break;
-        case CKA_VALUE_LEN:
-            type_name = "CKA_VALUE_LEN";
-            break;
-        case CKA_EXTRACTABLE:
-            type_name = "CKA_EXTRACTABLE";
-            break;
-        case CKA_LOCAL:
-            type_name = "CKA_LOCAL";
-            break;
-        case CKA_NEVER_EXTRACTABLE:
-            type_name = "CKA_NEVER_EXTRACTABLE";
-            break;
-        case CKA_ALWAYS_SENSITIVE:
-            type_name = "CKA_ALWAYS_SENSITIVE";
-            break;
-        case CKA_KEY_GEN_MECHANISM:
-            type_name = "CKA_KEY_GEN_MECHANISM";
-            break;
-        case CKA_MODIFIABLE:
-            type_name = "CKA_MODIFIABLE";
-            break;
-        // Duplicate values in PKCS#11 specification    
-        // #define CKA_ECDSA_PARAMS       0x00000180
-        // #define CKA_EC_PARAMS          0x00000180
-        case CKA_EC_PARAMS:
-            type_name = "CKA_EC_PARAMS or CKA_ECDSA_PARAMS";
-            break;
-        case CKA_EC_POINT:
-            type_name = "CKA_EC_POINT";
-            break;
-        case CKA_SECONDARY_AUTH:
-            type_name = "CKA_SECONDARY_AUTH";
-            break;
-        case CKA_AUTH_PIN_FLAGS:
-            type_name = "CKA_AUTH_PIN_FLAGS";
-            break;
-        case CKA_ALWAYS_AUTHENTICATE:
-            type_name = "CKA_ALWAYS_AUTHENTICATE";
-            break;
-        case CKA_WRAP_WITH_TRUSTED:
-            type_name = "CKA_WRAP_WITH_TRUSTED";
-            break;
-        case CKA_WRAP_TEMPLATE:
-            type_name = "CKA_WRAP_TEMPLATE";
-            break;
-        case CKA_UNWRAP_TEMPLATE:
-            type_name = "CKA_UNWRAP_TEMPLATE";
-            break;
-        case CKA_OTP_FORMAT:
-            type_name = "CKA_OTP_FORMAT";
-            break;
-        case CKA_OTP_LENGTH:
-            type_name = "CKA_OTP_LENGTH";
-            break;
-        case CKA_OTP_TIME_INTERVAL:
-            type_name = "CKA_OTP_TIME_INTERVAL";
-            break;
-        case CKA_OTP_USER_FRIENDLY_MODE:
-            type_name = "CKA_OTP_USER_FRIENDLY_MODE";
-            break;
-        case CKA_OTP_CHALLENGE_REQUIREMENT:
-            type_name = "CKA_OTP_CHALLENGE_REQUIREMENT";
-            break;
-        case CKA_OTP_TIME_REQUIREMENT:
-            type_name = "CKA_OTP_TIME_REQUIREMENT";
-            break;
-        case CKA_OTP_COUNTER_REQUIREMENT:
-            type_name = "CKA_OTP_COUNTER_REQUIREMENT";
-            break;
-        case CKA_OTP_PIN_REQUIREMENT:
-            type_name = "CKA_OTP_PIN_REQUIREMENT";
-            break;
-        case CKA_OTP_COUNTER:
-            type_name = "CKA_OTP_COUNTER";
-            break;
-        case CKA_OTP_TIME:
-            type_name = "CKA_OTP_TIME";
-            break;
-        case CKA_OTP_USER_IDENTIFIER:
-            type_name = "CKA_OTP_USER_IDENTIFIER";
-            break;
-        case CKA_OTP_SERVICE_IDENTIFIER:
-            type_name = "CKA_OTP_SERVICE_IDENTIFIER";
-            break;
-        case CKA_OTP_SERVICE_LOGO:
-            type_name = "CKA_OTP_SERVICE_LOGO";
-            break;
-        case CKA_OTP_SERVICE_LOGO_TYPE:
-            type_name = "CKA_OTP_SERVICE_LOGO_TYPE";
-            break;
-        case CKA_HW_FEATURE_TYPE:
-            type_name = "CKA_HW_FEATURE_TYPE";
-            break;
-        case CKA_RESET_ON_INIT:
-            type_name = "CKA_RESET_ON_INIT";
-            break;
-        case CKA_HAS_RESET:
-            type_name = "CKA_HAS_RESET";
-            break;
-        case CKA_PIXEL_X:
-            type_name = "CKA_PIXEL_X";
-            break;
-        case CKA_PIXEL_Y:
-            type_name = "CKA_PIXEL_Y";
-            break;
-        case CKA_RESOLUTION:
-            type_name = "CKA_RESOLUTION";
-            break;
-        case CKA_CHAR_ROWS:
-            type_name = "CKA_CHAR_ROWS";
-            break;
-        case CKA_CHAR_COLUMNS:
-            type_name = "CKA_CHAR_COLUMNS";
-            break;
-        case CKA_COLOR:
-            type_name = "CKA_COLOR";
-            break;
-        case CKA_BITS_PER_PIXEL:
-            type_name = "CKA_BITS_PER_PIXEL";
-            break;
-        case CKA_CHAR_SETS:
-            type_name = "CKA_CHAR_SETS";
-            break;
-        case CKA_ENCODING_METHODS:
-            type_name = "CKA_ENCODING_METHODS";
-            break;
-        case CKA_MIME_TYPES:
-            type_name = "CKA_MIME_TYPES";
-            break;
-        case CKA_MECHANISM_TYPE:
-            type_name = "CKA_MECHANISM_TYPE";
-            break;
-        case CKA_REQUIRED_CMS_ATTRIBUTES:
-            type_name = "CKA_REQUIRED_CMS_ATTRIBUTES";
-            break;
-        case CKA_DEFAULT_CMS_ATTRIBUTES:
-            type_name = "CKA_DEFAULT_CMS_ATTRIBUTES";
-            break;
-        case CKA_SUPPORTED_CMS_ATTRIBUTES:
-            type_name = "CKA_SUPPORTED_CMS_ATTRIBUTES";
-            break;
-        case CKA_ALLOWED_MECHANISMS:
-            type_name = "CKA_ALLOWED_MECHANISMS";
-            break;
-        case CKA_VENDOR_DEFINED:
-            type_name = "CKA_VENDOR_DEFINED";
-            break;
-        default:
-            type_name = "Unknown";
+        found = CK_TRUE;
+        functions[id / 8] |= (CK_BYTE)(1 << (id % 8));
     }
-    
-    return type_name;
+
+    for (i = 0; i < PKCS11_LOGGER_FUNCTION_CLASS_COUNT; i++)
+    {
+        if (CK_TRUE != pkcs11_logger_utils_str_equals_ignore_case(name, pkcs11_logger_translate_function_classes[i].name))
+            continue;
+
+        found = CK_TRUE;
+        for (id = pkcs11_logger_translate_function_classes[i].first; id <= pkcs11_logger_translate_function_classes[i].last; id++)
+            functions[id / 8] |= (CK_BYTE)(1 << (id % 8));
+    }
+
+    return (CK_TRUE == found) ? PKCS11_LOGGER_RV_SUCCESS : PKCS11_LOGGER_RV_ERROR;
+}
+
+
+// Names of CK_ATTRIBUTE_TYPE values sorted by value
+static const PKCS11_LOGGER_TRANSLATION pkcs11_logger_translate_ck_attribute_names[] =
+{
+    { CKA_CLASS, "CKA_CLASS" },
+    { CKA_TOKEN, "CKA_TOKEN" },
+    { CKA_PRIVATE, "CKA_PRIVATE" },
+    { CKA_LABEL, "CKA_LABEL" },
+    { CKA_APPLICATION, "CKA_APPLICATION" },
+    { CKA_VALUE, "CKA_VALUE" },
+    { CKA_OBJECT_ID, "CKA_OBJECT_ID" },
+    { CKA_CERTIFICATE_TYPE, "CKA_CERTIFICATE_TYPE" },
+    { CKA_ISSUER, "CKA_ISSUER" },
+    { CKA_SERIAL_NUMBER, "CKA_SERIAL_NUMBER" },
+    { CKA_AC_ISSUER, "CKA_AC_ISSUER" },
+    { CKA_OWNER, "CKA_OWNER" },
+    { CKA_ATTR_TYPES, "CKA_ATTR_TYPES" },
+    { CKA_TRUSTED, "CKA_TRUSTED" },
+    { CKA_CERTIFICATE_CATEGORY, "CKA_CERTIFICATE_CATEGORY" },
+    { CKA_JAVA_MIDP_SECURITY_DOMAIN, "CKA_JAVA_MIDP_SECURITY_DOMAIN" },
+    { CKA_URL, "CKA_URL" },
+    { CKA_HASH_OF_SUBJECT_PUBLIC_KEY, "CKA_HASH_OF_SUBJECT_PUBLIC_KEY" },
+    { CKA_HASH_OF_ISSUER_PUBLIC_KEY, "CKA_HASH_OF_ISSUER_PUBLIC_KEY" },
+    { CKA_CHECK_VALUE, "CKA_CHECK_VALUE" },
+    { CKA_KEY_TYPE, "CKA_KEY_TYPE" },
+    { CKA_SUBJECT, "CKA_SUBJECT" },
+    { CKA_ID, "CKA_ID" },
+    { CKA_SENSITIVE, "CKA_SENSITIVE" },
+    { CKA_ENCRYPT, "CKA_ENCRYPT" },
+    { CKA_DECRYPT, "CKA_DECRYPT" },
+    { CKA_WRAP, "CKA_WRAP" },
+    { CKA_UNWRAP, "CKA_UNWRAP" },
+    { CKA_SIGN, "CKA_SIGN" },
+    { CKA_SIGN_RECOVER, "CKA_SIGN_RECOVER" },
+    { CKA_VERIFY, "CKA_VERIFY" },
+    { CKA_VERIFY_RECOVER, "CKA_VERIFY_RECOVER" },
+    { CKA_DERIVE, "CKA_DERIVE" },
+    { CKA_START_DATE, "CKA_START_DATE" },
+    { CKA_END_DATE, "CKA_END_DATE" },
+    { CKA_MODULUS, "CKA_MODULUS" },
+    { CKA_MODULUS_BITS, "CKA_MODULUS_BITS" },
+    { CKA_PUBLIC_EXPONENT, "CKA_PUBLIC_EXPONENT" },
+    { CKA_PRIVATE_EXPONENT, "CKA_PRIVATE_EXPONENT" },
+    { CKA_PRIME_1, "CKA_PRIME_1" },
+    { CKA_PRIME_2, "CKA_PRIME_2" },
+    { CKA_EXPONENT_1, "CKA_EXPONENT_1" },
+    { CKA_EXPONENT_2, "CKA_EXPONENT_2" },
+    { CKA_COEFFICIENT, "CKA_COEFFICIENT" },
+    { CKA_PRIME, "CKA_PRIME" },
+    { CKA_SUBPRIME, "CKA_SUBPRIME" },
+    { CKA_BASE, "CKA_BASE" },
+    { CKA_PRIME_BITS, "CKA_PRIME_BITS" },
+    { CKA_SUBPRIME_BITS, "CKA_SUBPRIME_BITS or CKA_SUB_PRIME_BITS" },
+    { CKA_VALUE_BITS, "CKA_VALUE_BITS" },
+    { CKA_VALUE_LEN, "CKA_VALUE_LEN" },
+    { CKA_EXTRACTABLE, "CKA_EXTRACTABLE" },
+    { CKA_LOCAL, "CKA_LOCAL" },
+    { CKA_NEVER_EXTRACTABLE, "CKA_NEVER_EXTRACTABLE" },
+    { CKA_ALWAYS_SENSITIVE, "CKA_ALWAYS_SENSITIVE" },
+    { CKA_KEY_GEN_MECHANISM, "CKA_KEY_GEN_MECHANISM" },
+    { CKA_MODIFIABLE, "CKA_MODIFIABLE" },
+    { CKA_EC_PARAMS, "CKA_EC_PARAMS or CKA_ECDSA_PARAMS" },
+    { CKA_EC_POINT, "CKA_EC_POINT" },
+    { CKA_SECONDARY_AUTH, "CKA_SECONDARY_AUTH" },
+    { CKA_AUTH_PIN_FLAGS, "CKA_AUTH_PIN_FLAGS" },
+    { CKA_ALWAYS_AUTHENTICATE, "CKA_ALWAYS_AUTHENTICATE" },
+    { CKA_WRAP_WITH_TRUSTED, "CKA_WRAP_WITH_TRUSTED" },
+    { CKA_OTP_FORMAT, "CKA_OTP_FORMAT" },
+    { CKA_OTP_LENGTH, "CKA_OTP_LENGTH" },
+    { CKA_OTP_TIME_INTERVAL, "CKA_OTP_TIME_INTERVAL" },
+    { CKA_OTP_USER_FRIENDLY_MODE, "CKA_OTP_USER_FRIENDLY_MODE" },
+    { CKA_OTP_CHALLENGE_REQUIREMENT, "CKA_OTP_CHALLENGE_REQUIREMENT" },
+    { CKA_OTP_TIME_REQUIREMENT, "CKA_OTP_TIME_REQUIREMENT" },
+    { CKA_OTP_COUNTER_REQUIREMENT, "CKA_OTP_COUNTER_REQUIREMENT" },
+    { CKA_OTP_PIN_REQUIREMENT, "CKA_OTP_PIN_REQUIREMENT" },
+    { CKA_OTP_USER_IDENTIFIER, "CKA_OTP_USER_IDENTIFIER" },
+    { CKA_OTP_SERVICE_IDENTIFIER, "CKA_OTP_SERVICE_IDENTIFIER" },
+    { CKA_OTP_SERVICE_LOGO, "CKA_OTP_SERVICE_LOGO" },
+    { CKA_OTP_SERVICE_LOGO_TYPE, "CKA_OTP_SERVICE_LOGO_TYPE" },
+    { CKA_OTP_COUNTER, "CKA_OTP_COUNTER" },
+    { CKA_OTP_TIME, "CKA_OTP_TIME" },
+    { CKA_HW_FEATURE_TYPE, "CKA_HW_FEATURE_TYPE" },
+    { CKA_RESET_ON_INIT, "CKA_RESET_ON_INIT" },
+    { CKA_HAS_RESET, "CKA_HAS_RESET" },
+    { CKA_PIXEL_X, "CKA_PIXEL_X" },
+    { CKA_PIXEL_Y, "CKA_PIXEL_Y" },
+    { CKA_RESOLUTION, "CKA_RESOLUTION" },
+    { CKA_CHAR_ROWS, "CKA_CHAR_ROWS" },
+    { CKA_CHAR_COLUMNS, "CKA_CHAR_COLUMNS" },
+    { CKA_COLOR, "CKA_COLOR" },
+    { CKA_BITS_PER_PIXEL, "CKA_BITS_PER_PIXEL" },
+    { CKA_CHAR_SETS, "CKA_CHAR_SETS" },
+    { CKA_ENCODING_METHODS, "CKA_ENCODING_METHODS" },
+    { CKA_MIME_TYPES, "CKA_MIME_TYPES" },
+    { CKA_MECHANISM_TYPE, "CKA_MECHANISM_TYPE" },
+    { CKA_REQUIRED_CMS_ATTRIBUTES, "CKA_REQUIRED_CMS_ATTRIBUTES" },
+    { CKA_DEFAULT_CMS_ATTRIBUTES, "CKA_DEFAULT_CMS_ATTRIBUTES" },
+    { CKA_SUPPORTED_CMS_ATTRIBUTES, "CKA_SUPPORTED_CMS_ATTRIBUTES" },
+    { CKA_WRAP_TEMPLATE, "CKA_WRAP_TEMPLATE" },
+    { CKA_UNWRAP_TEMPLATE, "CKA_UNWRAP_TEMPLATE" },
+    { CKA_ALLOWED_MECHANISMS, "CKA_ALLOWED_MECHANISMS" },
+    { CKA_VENDOR_DEFINED, "CKA_VENDOR_DEFINED" }
+};
+
+
+// Translates CK_ATTRIBUTE_TYPE to string
+const char* pkcs11_logger_translate_ck_attribute(CK_ATTRIBUTE_TYPE type)
+{
+    return pkcs11_logger_translate_find_name(pkcs11_logger_translate_ck_attribute_names, PKCS11_LOGGER_TRANSLATION_COUNT(pkcs11_logger_translate_ck_attribute_names), type);
+}
+
+
+// Translates string to CK_ATTRIBUTE_TYPE
+int pkcs11_logger_translate_string_to_ck_attribute(const char *name, CK_ATTRIBUTE_TYPE *type)
+{
+    return pkcs11_logger_translate_find_value(pkcs11_logger_translate_ck_attribute_names, PKCS11_LOGGER_TRANSLATION_COUNT(pkcs11_logger_translate_ck_attribute_names), name, type);
 }
@@ -23,6 +23,45 @@
 #include "pkcs11-logger.h"
 
 
+extern PKCS11_LOGGER_GLOBALS pkcs11_logger_globals;
+
+
+// Cached "YYYY-MM-DD HH:MM:" prefix of the timestamps of the current thread
+static PKCS11_LOGGER_THREAD_LOCAL char pkcs11_logger_utils_time_prefix[PKCS11_LOGGER_TIME_PREFIX_LEN];
+// Flag indicating whether the cached prefix of the current thread can be used
+static PKCS11_LOGGER_THREAD_LOCAL CK_BBOOL pkcs11_logger_utils_time_prefix_valid = CK_FALSE;
+#ifdef _WIN32
+// Local time with the minute covered by the cached prefix
+static PKCS11_LOGGER_THREAD_LOCAL SYSTEMTIME pkcs11_logger_utils_time_prefix_time;
+#else
+// System time in seconds when the minute covered by the cached prefix starts
+static PKCS11_LOGGER_THREAD_LOCAL time_t pkcs11_logger_utils_time_prefix_start = 0;
+// System time in seconds when the time zone was last checked by the current thread
+static PKCS11_LOGGER_THREAD_LOCAL time_t pkcs11_logger_utils_time_zone_checked = 0;
+// Value of TZ environment variable used for the cached prefix
+static PKCS11_LOGGER_THREAD_LOCAL char pkcs11_logger_utils_time_zone[128];
+#endif
+
+// Generation of process and thread IDs that gets incremented in the child process after fork
+static CK_ULONG pkcs11_logger_utils_ids_generation = 1;
+#ifndef _WIN32
+// Flag indicating whether the fork handler has been registered
+static CK_ULONG pkcs11_logger_utils_atfork_registered = 0;
+#endif
+// Generation of process and thread IDs cached by the current thread (zero when nothing is cached)
+static PKCS11_LOGGER_THREAD_LOCAL CK_ULONG pkcs11_logger_utils_ids_cached_generation = 0;
+// Flags that disable logging of process and thread IDs used for the cached prefix
+static PKCS11_LOGGER_THREAD_LOCAL CK_ULONG pkcs11_logger_utils_ids_cached_flags = 0;
+// ID of current process cached by the current thread
+static PKCS11_LOGGER_THREAD_LOCAL int pkcs11_logger_utils_cached_process_id = 0;
+// ID of current thread cached by the current thread
+static PKCS11_LOGGER_THREAD_LOCAL unsigned long pkcs11_logger_utils_cached_thread_id = 0;
+// Cached "process ID : thread ID : " prefix of logged messages
+static PKCS11_LOGGER_THREAD_LOCAL char pkcs11_logger_utils_ids_prefix[PKCS11_LOGGER_IDS_PREFIX_SIZE];
+// Length of the cached prefix
+static PKCS11_LOGGER_THREAD_LOCAL int pkcs11_logger_utils_ids_prefix_len = 0;
+
+
 // Converts string to long
 int pkcs11_logger_utils_str_to_long(const char *str, unsigned long *val)
 {
@@ -43,48 +82,260 @@ int pkcs11_logger_utils_str_to_long(const char *str, unsigned long *val)
 }
 
 
-// Gets current system time as string
-void pkcs11_logger_utils_get_current_time_str(char* buff, int buff_len)
+// Compares two strings ignoring case
+CK_BBOOL pkcs11_logger_utils_str_equals_ignore_case(const char *str1, const char *str2)
 {
-    if (buff_len < 27)
-        return;
+    if ((NULL == str1) || (NULL == str2))
+        return CK_FALSE;
+
+#ifdef _WIN32
+    return (0 == _stricmp(str1, str2)) ? CK_TRUE : CK_FALSE;
+#else
+    return (0 == strcasecmp(str1, str2)) ? CK_TRUE : CK_FALSE;
+#endif
+}
+
+
+// Calls the callback for each entry of comma or whitespace separated list in "<name>" or "<name>=<value>" format
+int pkcs11_logger_utils_parse_list(const char *list, PKCS11_LOGGER_LIST_CALLBACK callback, void *context)
+{
+    char entry[64];
+    size_t entry_len = 0;
+    const char *end = NULL;
+    char *value = NULL;
+
+    while ('\0' != *list)
+    {
+        // Skip separators and whitespace
+        if ((',' == *list) || (' ' == *list) || ('\t' == *list))
+        {
+            list++;
+            continue;
+        }
+
+        end = list;
+        while (('\0' != *end) && (',' != *end) && (' ' != *end) && ('\t' != *end))
+            end++;
+
+        entry_len = end - list;
+        if (entry_len >= sizeof(entry))
+            return PKCS11_LOGGER_RV_ERROR;
+
+        memcpy(entry, list, entry_len);
+        entry[entry_len] = '\0';
+
+        // Note: Value is NULL for entries without equals sign
+        value = strchr(entry, '=');
+        if (NULL != value)
+            *(value++) = '\0';
+
+        if (PKCS11_LOGGER_RV_SUCCESS != callback(entry, value, context))
+            return PKCS11_LOGGER_RV_ERROR;
+
+        list = end;
+    }
+
+    return PKCS11_LOGGER_RV_SUCCESS;
+}
+
+
+// Writes value as decimal number with the specified number of digits (padded with zeros)
+static void pkcs11_logger_utils_put_digits(char *buff, unsigned long long value, int digits)
+{
+    while (digits > 0)
+    {
+        buff[--digits] = (char)('0' + (value % 10));
+        value /= 10;
+    }
+}
+
+
+// Writes "YYYY-MM-DD HH:MM:" prefix of the timestamp
+static void pkcs11_logger_utils_put_time_prefix(char *buff, int year, int month, int day, int hour, int minute)
+{
+    pkcs11_logger_utils_put_digits(buff, year, 4);
+    buff[4] = '-';
+    pkcs11_logger_utils_put_digits(buff + 5, month, 2);
+    buff[7] = '-';
+    pkcs11_logger_utils_put_digits(buff + 8, day, 2);
+    buff[10] = ' ';
+    pkcs11_logger_utils_put_digits(buff + 11, hour, 2);
+    buff[13] = ':';
+    pkcs11_logger_utils_put_digits(buff + 14, minute, 2);
+    buff[16] = ':';
+}
+
+
+// Gets current value of monotonic clock as string with seconds and nanoseconds
+static int pkcs11_logger_utils_get_monotonic_time_str(char* buff, int buff_len)
+{
+    unsigned long long now = pkcs11_logger_utils_get_monotonic_time();
+    unsigned long long seconds = now / 1000000000ULL;
+    int digits = 1;
+    unsigned long long i = 0;
+
+    for (i = seconds; i >= 10; i /= 10)
+        digits++;
+
+    if (digits + 11 > buff_len)
+        return 0;
+
+    pkcs11_logger_utils_put_digits(buff, seconds, digits);
+    buff[digits] = '.';
+    pkcs11_logger_utils_put_digits(buff + digits + 1, now % 1000000000ULL, 9);
+    buff[digits + 10] = 0;
+
+    return digits + 10;
+}
+
+
+// Gets current system time as string and returns its length
+int pkcs11_logger_utils_get_current_time_str(char* buff, int buff_len)
+{
+    int second = 0;
+
+    if (buff_len < PKCS11_LOGGER_TIME_STR_SIZE)
+        return 0;
+
+    if (PKCS11_LOGGER_TIMESTAMP_MONOTONIC == pkcs11_logger_globals.timestamp)
+        return pkcs11_logger_utils_get_monotonic_time_str(buff, buff_len);
 
 #ifdef _WIN32
 
     SYSTEMTIME systemtime;
     memset(&systemtime, 0, sizeof(SYSTEMTIME));
 
-    memset(buff, 0, buff_len * sizeof(char));
-
+    // Note: Local time is always coarse on Windows and it already reflects time zone changes
     GetLocalTime(&systemtime);
-    GetDateFormatA(LOCALE_SYSTEM_DEFAULT, 0, &systemtime, "yyyy-MM-dd ", buff, buff_len);
-    GetTimeFormatA(LOCALE_SYSTEM_DEFAULT, 0, &systemtime, "HH:mm:ss", buff + 11, buff_len - 11);
 
-    size_t len = strlen(buff);
-    snprintf(buff + len, buff_len - len, ".%03d000", systemtime.wMilliseconds);
+    if ((CK_TRUE != pkcs11_logger_utils_time_prefix_valid) ||
+        (systemtime.wMinute != pkcs11_logger_utils_time_prefix_time.wMinute) ||
+        (systemtime.wHour != pkcs11_logger_utils_time_prefix_time.wHour) ||
+        (systemtime.wDay != pkcs11_logger_utils_time_prefix_time.wDay) ||
+        (systemtime.wMonth != pkcs11_logger_utils_time_prefix_time.wMonth) ||
+        (systemtime.wYear != pkcs11_logger_utils_time_prefix_time.wYear))
+    {
+        pkcs11_logger_utils_put_time_prefix(pkcs11_logger_utils_time_prefix, systemtime.wYear, systemtime.wMonth, systemtime.wDay, systemtime.wHour, systemtime.wMinute);
+        pkcs11_logger_utils_time_prefix_time = systemtime;
+        pkcs11_logger_utils_time_prefix_valid = CK_TRUE;
+    }
+
+    second = systemtime.wSecond;
+    memcpy(buff, pkcs11_logger_utils_time_prefix, PKCS11_LOGGER_TIME_PREFIX_LEN);
+    pkcs11_logger_utils_put_digits(buff + PKCS11_LOGGER_TIME_PREFIX_LEN, second, 2);
+    buff[19] = '.';
+    pkcs11_logger_utils_put_digits(buff + 20, (unsigned long long)systemtime.wMilliseconds * 1000, 6);
 
 #else
 
-    struct timeval tv;
+    struct timespec ts;
     struct tm tm;
-    
-    memset(buff, 0, buff_len * sizeof(char));
+    const char *tz = NULL;
+    int rv = -1;
+
+#ifdef CLOCK_REALTIME_COARSE
+    if (PKCS11_LOGGER_TIMESTAMP_COARSE == pkcs11_logger_globals.timestamp)
+        rv = clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    else
+#endif
+        rv = clock_gettime(CLOCK_REALTIME, &ts);
+
+    if (0 != rv)
+        return 0;
 
-    if (gettimeofday(&tv, NULL) == 0)
+    // Note: Time zone is checked once per second so the change of TZ environment variable is noticed
+    if (ts.tv_sec != pkcs11_logger_utils_time_zone_checked)
     {
-        if (localtime_r(&tv.tv_sec, &tm) != NULL)
+        tz = getenv("TZ");
+        if (NULL == tz)
+            tz = "";
+
+        if (0 != strncmp(tz, pkcs11_logger_utils_time_zone, sizeof(pkcs11_logger_utils_time_zone) - 1))
         {
-            strftime(buff, buff_len, "%Y-%m-%d %H:%M:%S", &tm);
+            tzset();
+            strncpy(pkcs11_logger_utils_time_zone, tz, sizeof(pkcs11_logger_utils_time_zone) - 1);
+            pkcs11_logger_utils_time_prefix_valid = CK_FALSE;
+        }
+
+        pkcs11_logger_utils_time_zone_checked = ts.tv_sec;
+    }
+
+    // Note: Time zone offsets are whole minutes so the cached prefix is valid for the whole minute
+    if ((CK_TRUE != pkcs11_logger_utils_time_prefix_valid) ||
+        (ts.tv_sec < pkcs11_logger_utils_time_prefix_start) ||
+        (ts.tv_sec >= pkcs11_logger_utils_time_prefix_start + 60))
+    {
+        if (NULL == localtime_r(&ts.tv_sec, &tm))
+            return 0;
+
+        pkcs11_logger_utils_put_time_prefix(pkcs11_logger_utils_time_prefix, tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min);
+        pkcs11_logger_utils_time_prefix_start = ts.tv_sec - tm.tm_sec;
+        pkcs11_logger_utils_time_prefix_valid = CK_TRUE;
+    }
+
+    second = (int)(ts.tv_sec - pkcs11_logger_utils_time_prefix_start);
+    memcpy(buff, pkcs11_logger_utils_time_prefix, PKCS11_LOGGER_TIME_PREFIX_LEN);
+    pkcs11_logger_utils_put_digits(buff + PKCS11_LOGGER_TIME_PREFIX_LEN, second, 2);
+    buff[19] = '.';
+    pkcs11_logger_utils_put_digits(buff + 20, (unsigned long long)ts.tv_nsec / 1000, 6);
+
+#endif
+
+    buff[26] = 0;
+
+    return 26;
+}
+
+
+// Gets current system time in microseconds since the Unix epoch
+unsigned long long pkcs11_logger_utils_get_realtime(void)
+{
+#ifdef _WIN32
+
+    FILETIME filetime;
+    ULARGE_INTEGER value;
+
+    GetSystemTimeAsFileTime(&filetime);
+    value.LowPart = filetime.dwLowDateTime;
+    value.HighPart = filetime.dwHighDateTime;
+
+    // Note: FILETIME counts 100-nanosecond intervals since 1601-01-01
+    return (value.QuadPart - 116444736000000000ULL) / 10;
 
-#ifdef __APPLE__
-            size_t len = strlen(buff);
-            snprintf(buff + len, buff_len - len, ".%06d", tv.tv_usec);
 #else
-            size_t len = strlen(buff);
-            snprintf(buff + len, buff_len - len, ".%06ld", tv.tv_usec);
+
+    struct timeval tv;
+
+    if (gettimeofday(&tv, NULL) != 0)
+        return 0;
+
+    return ((unsigned long long)tv.tv_sec * 1000000ULL) + (unsigned long long)tv.tv_usec;
+
 #endif
-        }
-    }
+}
+
+
+// Gets current value of monotonic clock in nanoseconds
+unsigned long long pkcs11_logger_utils_get_monotonic_time(void)
+{
+#ifdef _WIN32
+
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    if (!QueryPerformanceCounter(&counter) || !QueryPerformanceFrequency(&frequency))
+        return 0;
+
+    return ((unsigned long long)(counter.QuadPart / frequency.QuadPart) * 1000000000ULL) + ((unsigned long long)(counter.QuadPart % frequency.QuadPart) * 1000000000ULL / (unsigned long long)frequency.QuadPart);
+
+#else
+
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+
+    return ((unsigned long long)ts.tv_sec * 1000000000ULL) + (unsigned long long)ts.tv_nsec;
 
 #endif
 }
@@ -118,6 +369,77 @@ int pkcs11_logger_utils_get_process_id(void)
 }
 
 
+#ifndef _WIN32
+
+// Invalidates process and thread IDs cached by all threads in the child process
+static void pkcs11_logger_utils_atfork_child(void)
+{
+    PKCS11_LOGGER_ATOMIC_ADD(&pkcs11_logger_utils_ids_generation, 1);
+}
+
+#endif
+
+
+// Makes sure process and thread IDs cached by the current thread are valid
+static void pkcs11_logger_utils_refresh_ids(void)
+{
+    CK_ULONG generation = PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_utils_ids_generation);
+    CK_ULONG flags = pkcs11_logger_globals.flags & (PKCS11_LOGGER_FLAG_DISABLE_PROCESS_ID | PKCS11_LOGGER_FLAG_DISABLE_THREAD_ID);
+    int len = 0;
+
+    if ((generation == pkcs11_logger_utils_ids_cached_generation) && (flags == pkcs11_logger_utils_ids_cached_flags))
+        return;
+
+#ifndef _WIN32
+    // Note: Handler is registered only once and it is unregistered by the C runtime when the library is unloaded
+    if ((0 == PKCS11_LOGGER_ATOMIC_LOAD(&pkcs11_logger_utils_atfork_registered)) && (0 == PKCS11_LOGGER_ATOMIC_XCHG(&pkcs11_logger_utils_atfork_registered, 1)))
+        pthread_atfork(NULL, NULL, pkcs11_logger_utils_atfork_child);
+#endif
+
+    pkcs11_logger_utils_cached_process_id = pkcs11_logger_utils_get_process_id();
+    pkcs11_logger_utils_cached_thread_id = pkcs11_logger_utils_get_thread_id();
+
+    // Note: Prefix is formatted exactly the same way as it used to be formatted for every message
+    if (0 == (flags & PKCS11_LOGGER_FLAG_DISABLE_PROCESS_ID))
+        len += snprintf(pkcs11_logger_utils_ids_prefix + len, sizeof(pkcs11_logger_utils_ids_prefix) - len, "%0#10x : ", pkcs11_logger_utils_cached_process_id);
+    if (0 == (flags & PKCS11_LOGGER_FLAG_DISABLE_THREAD_ID))
+        len += snprintf(pkcs11_logger_utils_ids_prefix + len, sizeof(pkcs11_logger_utils_ids_prefix) - len, "%0#18lx : ", pkcs11_logger_utils_cached_thread_id);
+
+    pkcs11_logger_utils_ids_prefix_len = len;
+    pkcs11_logger_utils_ids_cached_flags = flags;
+    pkcs11_logger_utils_ids_cached_generation = generation;
+}
+
+
+// Gets "process ID : thread ID : " prefix of logged messages cached by the current thread and its length
+const char* pkcs11_logger_utils_get_ids_prefix(int *len)
+{
+    pkcs11_logger_utils_refresh_ids();
+
+    *len = pkcs11_logger_utils_ids_prefix_len;
+
+    return pkcs11_logger_utils_ids_prefix;
+}
+
+
+// Gets ID of current thread cached by the current thread
+unsigned long pkcs11_logger_utils_get_cached_thread_id(void)
+{
+    pkcs11_logger_utils_refresh_ids();
+
+    return pkcs11_logger_utils_cached_thread_id;
+}
+
+
+// Gets ID of current process cached by the current thread
+int pkcs11_logger_utils_get_cached_process_id(void)
+{
+    pkcs11_logger_utils_refresh_ids();
+
+    return pkcs11_logger_utils_cached_process_id;
+}
+
+
 // Determines whether the path is absolute
 CK_BBOOL pkcs11_logger_utils_path_is_absolute(const char* path)
 {
@@ -149,3 +471,22 @@ CK_BBOOL pkcs11_logger_utils_path_is_absolute(const char* path)
     return (path[0] == '/') ? CK_TRUE : CK_FALSE;
 #endif
 }
+
+
+// Determines whether the file exists
+CK_BBOOL pkcs11_logger_utils_file_exists(const char* path)
+{
+#ifdef _WIN32
+    if (NULL == path)
+        return CK_FALSE;
+
+    return (INVALID_FILE_ATTRIBUTES != GetFileAttributesA(path)) ? CK_TRUE : CK_FALSE;
+#else
+    struct stat file_stat;
+
+    if (NULL == path)
+        return CK_FALSE;
+
+    return (0 == stat(path, &file_stat)) ? CK_TRUE : CK_FALSE;
+#endif
+}
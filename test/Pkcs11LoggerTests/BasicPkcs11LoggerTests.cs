@@ -20,7 +20,10 @@
  */
 
 using System;
+using System.Collections.Generic;
 using System.IO;
+using System.Text.RegularExpressions;
+using System.Threading;
 using Net.Pkcs11Interop.Common;
 using Net.Pkcs11Interop.HighLevelAPI;
 using NUnit.Framework;
@@ -51,6 +54,161 @@ namespace Pkcs11Logger.Tests
         /// </summary>
         public const string PKCS11_LOGGER_FLAGS = "PKCS11_LOGGER_FLAGS";
 
+        /// <summary>
+        /// Environment variable that specifies maximal number of records in asynchronous log queue
+        /// </summary>
+        public const string PKCS11_LOGGER_QUEUE_SIZE = "PKCS11_LOGGER_QUEUE_SIZE";
+
+        /// <summary>
+        /// Environment variable that specifies behavior of full asynchronous log queue
+        /// </summary>
+        public const string PKCS11_LOGGER_QUEUE_POLICY = "PKCS11_LOGGER_QUEUE_POLICY";
+
+        /// <summary>
+        /// Environment variable that specifies size of memory mapped log file segment
+        /// </summary>
+        public const string PKCS11_LOGGER_MMAP_SEGMENT_SIZE = "PKCS11_LOGGER_MMAP_SEGMENT_SIZE";
+
+        /// <summary>
+        /// Environment variable that specifies size of the log file that triggers rotation
+        /// </summary>
+        public const string PKCS11_LOGGER_ROTATE_SIZE = "PKCS11_LOGGER_ROTATE_SIZE";
+
+        /// <summary>
+        /// Environment variable that specifies number of seconds after which the log file is rotated
+        /// </summary>
+        public const string PKCS11_LOGGER_ROTATE_INTERVAL = "PKCS11_LOGGER_ROTATE_INTERVAL";
+
+        /// <summary>
+        /// Environment variable that specifies number of retained rotated log files
+        /// </summary>
+        public const string PKCS11_LOGGER_ROTATE_COUNT = "PKCS11_LOGGER_ROTATE_COUNT";
+
+        /// <summary>
+        /// Environment variable that specifies compression of rotated log files
+        /// </summary>
+        public const string PKCS11_LOGGER_ROTATE_COMPRESSION = "PKCS11_LOGGER_ROTATE_COMPRESSION";
+
+        /// <summary>
+        /// Environment variable that specifies when are the logged messages flushed to the log file
+        /// </summary>
+        public const string PKCS11_LOGGER_DURABILITY = "PKCS11_LOGGER_DURABILITY";
+
+        /// <summary>
+        /// Environment variable that specifies number of records after which the log file is flushed in batch durability mode
+        /// </summary>
+        public const string PKCS11_LOGGER_FLUSH_RECORDS = "PKCS11_LOGGER_FLUSH_RECORDS";
+
+        /// <summary>
+        /// Environment variable that specifies number of milliseconds after which the log file is flushed in batch durability mode
+        /// </summary>
+        public const string PKCS11_LOGGER_FLUSH_INTERVAL = "PKCS11_LOGGER_FLUSH_INTERVAL";
+
+        /// <summary>
+        /// Environment variable that specifies path to the file whose existence enables logging
+        /// </summary>
+        public const string PKCS11_LOGGER_CONTROL_FILE = "PKCS11_LOGGER_CONTROL_FILE";
+
+        /// <summary>
+        /// Environment variable that specifies comma separated list of the only PKCS#11 functions that are logged
+        /// </summary>
+        public const string PKCS11_LOGGER_INCLUDE_FUNCTIONS = "PKCS11_LOGGER_INCLUDE_FUNCTIONS";
+
+        /// <summary>
+        /// Environment variable that specifies comma separated list of PKCS#11 functions that are not logged
+        /// </summary>
+        public const string PKCS11_LOGGER_EXCLUDE_FUNCTIONS = "PKCS11_LOGGER_EXCLUDE_FUNCTIONS";
+
+        /// <summary>
+        /// Environment variable that specifies number of seconds after which latency statistics are logged again
+        /// </summary>
+        public const string PKCS11_LOGGER_STATS_INTERVAL = "PKCS11_LOGGER_STATS_INTERVAL";
+
+        /// <summary>
+        /// Environment variable that specifies number of the signal that requests logging of latency statistics
+        /// </summary>
+        public const string PKCS11_LOGGER_STATS_SIGNAL = "PKCS11_LOGGER_STATS_SIGNAL";
+
+        /// <summary>
+        /// Environment variable that specifies clock used for timestamps of logged messages
+        /// </summary>
+        public const string PKCS11_LOGGER_TIMESTAMP = "PKCS11_LOGGER_TIMESTAMP";
+
+        /// <summary>
+        /// Environment variable that specifies host and port of TCP server that receives logged messages
+        /// </summary>
+        public const string PKCS11_LOGGER_SOCKET = "PKCS11_LOGGER_SOCKET";
+
+        /// <summary>
+        /// Environment variable that specifies path to the file where the memory ring with the most recent messages is written
+        /// </summary>
+        public const string PKCS11_LOGGER_RING_FILE_PATH = "PKCS11_LOGGER_RING_FILE_PATH";
+
+        /// <summary>
+        /// Environment variable that specifies size of the memory ring with the most recent messages
+        /// </summary>
+        public const string PKCS11_LOGGER_RING_SIZE = "PKCS11_LOGGER_RING_SIZE";
+
+        /// <summary>
+        /// Environment variable that specifies size of the arena that each thread uses for temporary strings
+        /// </summary>
+        public const string PKCS11_LOGGER_ARENA_SIZE = "PKCS11_LOGGER_ARENA_SIZE";
+
+        /// <summary>
+        /// Environment variable that specifies number of leading bytes logged from truncated byte arrays
+        /// </summary>
+        public const string PKCS11_LOGGER_BYTE_ARRAY_HEAD = "PKCS11_LOGGER_BYTE_ARRAY_HEAD";
+
+        /// <summary>
+        /// Environment variable that specifies number of trailing bytes logged from truncated byte arrays
+        /// </summary>
+        public const string PKCS11_LOGGER_BYTE_ARRAY_TAIL = "PKCS11_LOGGER_BYTE_ARRAY_TAIL";
+
+        /// <summary>
+        /// Environment variable that specifies comma separated list of sampling rates of PKCS#11 functions
+        /// </summary>
+        public const string PKCS11_LOGGER_SAMPLE_RATES = "PKCS11_LOGGER_SAMPLE_RATES";
+
+        /// <summary>
+        /// Environment variable that specifies maximal number of log records written per second
+        /// </summary>
+        public const string PKCS11_LOGGER_LIMIT_RECORDS = "PKCS11_LOGGER_LIMIT_RECORDS";
+
+        /// <summary>
+        /// Environment variable that specifies maximal number of bytes of log records written per second
+        /// </summary>
+        public const string PKCS11_LOGGER_LIMIT_BYTES = "PKCS11_LOGGER_LIMIT_BYTES";
+
+        /// <summary>
+        /// Environment variable that specifies comma separated list of maximal numbers of logged calls of PKCS#11 functions per second
+        /// </summary>
+        public const string PKCS11_LOGGER_LIMIT_CALLS = "PKCS11_LOGGER_LIMIT_CALLS";
+
+        /// <summary>
+        /// Environment variable that specifies number of seconds for which responses of original library are cached
+        /// </summary>
+        public const string PKCS11_LOGGER_CACHE_TTL = "PKCS11_LOGGER_CACHE_TTL";
+
+        /// <summary>
+        /// Environment variable that specifies maximal number of idle sessions kept open per slot and session flags
+        /// </summary>
+        public const string PKCS11_LOGGER_POOL_SIZE = "PKCS11_LOGGER_POOL_SIZE";
+
+        /// <summary>
+        /// Environment variable that specifies number of seconds after which idle pooled sessions are closed
+        /// </summary>
+        public const string PKCS11_LOGGER_POOL_IDLE_TIMEOUT = "PKCS11_LOGGER_POOL_IDLE_TIMEOUT";
+
+        /// <summary>
+        /// Environment variable that specifies size of the buffer in which small parts of multi-part operations are collected
+        /// </summary>
+        public const string PKCS11_LOGGER_COALESCE_SIZE = "PKCS11_LOGGER_COALESCE_SIZE";
+
+        /// <summary>
+        /// Environment variable that specifies comma separated list of mechanisms whose multi-part updates are buffered
+        /// </summary>
+        public const string PKCS11_LOGGER_COALESCE_MECHANISMS = "PKCS11_LOGGER_COALESCE_MECHANISMS";
+
         /// <summary>
         /// Flag that disables logging into the log file
         /// </summary>
@@ -86,6 +244,56 @@ namespace Pkcs11Logger.Tests
         /// </summary>
         public const uint PKCS11_LOGGER_FLAG_ENABLE_FCLOSE = 0x00000040;
 
+        /// <summary>
+        /// Flag that enables logging via background writer thread
+        /// </summary>
+        public const uint PKCS11_LOGGER_FLAG_ENABLE_ASYNC = 0x00000080;
+
+        /// <summary>
+        /// Flag that enables writing of all messages logged by one function call at once
+        /// </summary>
+        public const uint PKCS11_LOGGER_FLAG_ENABLE_CALL_RECORDS = 0x00000100;
+
+        /// <summary>
+        /// Flag that enables logging in compact binary format
+        /// </summary>
+        public const uint PKCS11_LOGGER_FLAG_ENABLE_BINARY = 0x00000200;
+
+        /// <summary>
+        /// Magic value at the beginning of binary log file (including terminating zero)
+        /// </summary>
+        public const string PKCS11_LOGGER_BINARY_MAGIC = "PKCS11LOGGERBIN\0";
+
+        /// <summary>
+        /// Flag that enables logging into preallocated memory mapped log file segments
+        /// </summary>
+        public const uint PKCS11_LOGGER_FLAG_ENABLE_MMAP = 0x00000400;
+
+        /// <summary>
+        /// Flag that enables collection of latency statistics of original library
+        /// </summary>
+        public const uint PKCS11_LOGGER_FLAG_ENABLE_STATS = 0x00000800;
+
+        /// <summary>
+        /// Flag that enables logging to the system logger
+        /// </summary>
+        public const uint PKCS11_LOGGER_FLAG_ENABLE_SYSLOG = 0x00001000;
+
+        /// <summary>
+        /// Flag that enables logging of CRC32C checksum instead of omitted content of byte arrays
+        /// </summary>
+        public const uint PKCS11_LOGGER_FLAG_ENABLE_CRC32C = 0x00002000;
+
+        /// <summary>
+        /// Flag that enables caching of immutable object attributes
+        /// </summary>
+        public const uint PKCS11_LOGGER_FLAG_ENABLE_ATTR_CACHE = 0x00004000;
+
+        /// <summary>
+        /// Flag that enables caching of results of searches of objects
+        /// </summary>
+        public const uint PKCS11_LOGGER_FLAG_ENABLE_FIND_CACHE = 0x00008000;
+
         #endregion
 
         /// <summary>
@@ -96,6 +304,37 @@ namespace Pkcs11Logger.Tests
             EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, null);
             EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, null);
             EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_QUEUE_SIZE, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_QUEUE_POLICY, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_MMAP_SEGMENT_SIZE, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_ROTATE_SIZE, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_ROTATE_INTERVAL, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_ROTATE_COUNT, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_ROTATE_COMPRESSION, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_DURABILITY, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLUSH_RECORDS, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLUSH_INTERVAL, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_CONTROL_FILE, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_INCLUDE_FUNCTIONS, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_EXCLUDE_FUNCTIONS, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_STATS_INTERVAL, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_STATS_SIGNAL, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_TIMESTAMP, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_SOCKET, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_RING_FILE_PATH, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_RING_SIZE, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_ARENA_SIZE, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_BYTE_ARRAY_HEAD, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_BYTE_ARRAY_TAIL, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_SAMPLE_RATES, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIMIT_RECORDS, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIMIT_BYTES, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIMIT_CALLS, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_CACHE_TTL, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_POOL_SIZE, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_POOL_IDLE_TIMEOUT, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_COALESCE_SIZE, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_COALESCE_MECHANISMS, null);
         }
 
         /// <summary>
@@ -399,6 +638,75 @@ namespace Pkcs11Logger.Tests
             ClassicAssert.IsTrue(!line.StartsWith(processId) && !line.StartsWith(threadId));
         }
 
+        /// <summary>
+        /// Test that cached "process ID : thread ID : " prefix follows PKCS11_LOGGER_FLAG_DISABLE_PROCESS_ID and PKCS11_LOGGER_FLAG_DISABLE_THREAD_ID flags on every line
+        /// </summary>
+        [Test()]
+        public void ProcessIdAndThreadIdPrefixTest()
+        {
+            DeleteEnvironmentVariables();
+
+            uint flags = 0;
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Log to Pkcs11LoggerLogPath1 with both IDs enabled
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            flags = flags & ~PKCS11_LOGGER_FLAG_DISABLE_PROCESS_ID;
+            flags = flags & ~PKCS11_LOGGER_FLAG_DISABLE_THREAD_ID;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Get ProcessID and ThreadID from the first line
+            string[] lines = File.ReadAllLines(Settings.Pkcs11LoggerLogPath1);
+            Match match = Regex.Match(lines[0], @"^(0x[0-9a-f]{8}) : (0x[0-9a-f]+) : ");
+            ClassicAssert.IsTrue(match.Success);
+            string prefix = match.Value;
+
+            // Check if every line starts with the same prefix
+            foreach (string line in lines)
+                ClassicAssert.IsTrue(line.StartsWith(prefix));
+
+            // Delete log file
+            File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Log to Pkcs11LoggerLogPath1 with both IDs disabled
+            flags = flags | PKCS11_LOGGER_FLAG_DISABLE_PROCESS_ID;
+            flags = flags | PKCS11_LOGGER_FLAG_DISABLE_THREAD_ID;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Check if prefix cached by this thread in the previous run is not used on any line
+            lines = File.ReadAllLines(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(lines.Length > 0);
+            foreach (string line in lines)
+                ClassicAssert.IsFalse(line.StartsWith("0x"));
+
+            // Delete log file
+            File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Log to Pkcs11LoggerLogPath1 with both IDs enabled again
+            flags = flags & ~PKCS11_LOGGER_FLAG_DISABLE_PROCESS_ID;
+            flags = flags & ~PKCS11_LOGGER_FLAG_DISABLE_THREAD_ID;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Check if every line starts with the original prefix again
+            lines = File.ReadAllLines(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(lines.Length > 0);
+            foreach (string line in lines)
+                ClassicAssert.IsTrue(line.StartsWith(prefix));
+
+            // Delete log file
+            File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
         /// <summary>
         /// Test PKCS11_LOGGER_FLAG_ENABLE_PIN flag
         /// </summary>
@@ -639,5 +947,1416 @@ namespace Pkcs11Logger.Tests
             // PKCS11_LOGGER_FLAG_ENABLE_FCLOSE decreases performance
             ClassicAssert.IsTrue(fcloseEnabledTicks > fcloseDisabledTicks);
         }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_FLAG_ENABLE_ASYNC flag
+        /// </summary>
+        [Test()]
+        public void EnableAsyncTest()
+        {
+            DeleteEnvironmentVariables();
+
+            uint flags = 0;
+
+            // Delete log files
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+
+            // Log to Pkcs11LoggerLogPath1 with async disabled
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            flags = flags & ~PKCS11_LOGGER_FLAG_ENABLE_ASYNC;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Log to Pkcs11LoggerLogPath2 with async enabled and the smallest possible queue
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath2);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_QUEUE_SIZE, "1");
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_ASYNC;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // All queued messages should be written by the time the library is unloaded
+            ClassicAssert.IsTrue(File.ReadAllLines(Settings.Pkcs11LoggerLogPath1).Length == File.ReadAllLines(Settings.Pkcs11LoggerLogPath2).Length);
+
+            // PKCS11_LOGGER_QUEUE_POLICY must contain a known policy
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_QUEUE_POLICY, "InvalidValue");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log files
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+        }
+
+        /// <summary>
+        /// Test that records written concurrently by multiple threads are neither lost nor reordered
+        /// </summary>
+        [Test()]
+        public void ConcurrentRecordsTest()
+        {
+            DeleteEnvironmentVariables();
+
+            int threadsCount = 8;
+            int iterations = 100;
+            string[] functions = new string[] { "C_GetInfo", "C_GetSlotInfo", "C_GetTokenInfo" };
+
+            // Records are published through lock-free stack both in synchronous and asynchronous mode
+            foreach (uint flags in new uint[] { 0, PKCS11_LOGGER_FLAG_ENABLE_ASYNC })
+            {
+                // Delete log file
+                if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                    File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_QUEUE_SIZE, "16");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                {
+                    ISlot slot = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0];
+
+                    List<Thread> threads = new List<Thread>();
+                    for (int i = 0; i < threadsCount; i++)
+                    {
+                        threads.Add(new Thread(() =>
+                        {
+                            for (int j = 0; j < iterations; j++)
+                            {
+                                pkcs11Library.GetInfo();
+                                slot.GetSlotInfo();
+                                slot.GetTokenInfo();
+                            }
+                        }));
+                    }
+
+                    foreach (Thread thread in threads)
+                        thread.Start();
+                    foreach (Thread thread in threads)
+                        thread.Join();
+                }
+
+                // Each thread must have all its calls logged in the order it made them
+                Dictionary<string, List<string>> calls = new Dictionary<string, List<string>>();
+                foreach (string line in File.ReadAllLines(Settings.Pkcs11LoggerLogPath1))
+                {
+                    Match match = Regex.Match(line, @"^\S+ : (\S+) : .*Entered (C_GetInfo|C_GetSlotInfo|C_GetTokenInfo)$");
+                    if (!match.Success)
+                        continue;
+
+                    if (!calls.ContainsKey(match.Groups[1].Value))
+                        calls.Add(match.Groups[1].Value, new List<string>());
+
+                    calls[match.Groups[1].Value].Add(match.Groups[2].Value);
+                }
+
+                int total = 0;
+                foreach (List<string> threadCalls in calls.Values)
+                {
+                    // Note: Identifier of the finished thread may be reused by the thread started later
+                    ClassicAssert.IsTrue(threadCalls.Count % functions.Length == 0);
+                    for (int i = 0; i < threadCalls.Count; i++)
+                        ClassicAssert.IsTrue(threadCalls[i] == functions[i % functions.Length]);
+
+                    total += threadCalls.Count;
+                }
+
+                ClassicAssert.IsTrue(total == threadsCount * iterations * functions.Length);
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_FLAG_ENABLE_CALL_RECORDS flag
+        /// </summary>
+        [Test()]
+        public void EnableCallRecordsTest()
+        {
+            DeleteEnvironmentVariables();
+
+            uint flags = 0;
+
+            // Delete log files
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+
+            // Log to Pkcs11LoggerLogPath1 with call records disabled
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            flags = flags & ~PKCS11_LOGGER_FLAG_ENABLE_CALL_RECORDS;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Log to Pkcs11LoggerLogPath2 with call records enabled
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath2);
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_CALL_RECORDS;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Both log files should contain the same messages
+            string[] lines1 = File.ReadAllLines(Settings.Pkcs11LoggerLogPath1);
+            string[] lines2 = File.ReadAllLines(Settings.Pkcs11LoggerLogPath2);
+            ClassicAssert.IsTrue(lines1.Length == lines2.Length);
+            ClassicAssert.IsTrue(lines2[lines2.Length - 1].Contains("Returning 0 (CKR_OK)"));
+
+            // Delete log files
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_FLAG_ENABLE_BINARY flag
+        /// </summary>
+        [Test()]
+        public void EnableBinaryTest()
+        {
+            DeleteEnvironmentVariables();
+
+            uint flags = 0;
+
+            // Delete log files
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+
+            // Log to Pkcs11LoggerLogPath1 with binary format disabled
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            flags = flags & ~PKCS11_LOGGER_FLAG_ENABLE_BINARY;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Log to Pkcs11LoggerLogPath2 with binary format enabled
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath2);
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_BINARY;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Binary log file should start with magic value and should not contain text log
+            byte[] binaryLog = File.ReadAllBytes(Settings.Pkcs11LoggerLogPath2);
+            ClassicAssert.IsTrue(binaryLog.Length > PKCS11_LOGGER_BINARY_MAGIC.Length);
+            ClassicAssert.IsTrue(System.Text.Encoding.ASCII.GetString(binaryLog, 0, PKCS11_LOGGER_BINARY_MAGIC.Length) == PKCS11_LOGGER_BINARY_MAGIC);
+            ClassicAssert.IsTrue(File.ReadAllText(Settings.Pkcs11LoggerLogPath1).Contains("Returning 0 (CKR_OK)"));
+            ClassicAssert.IsFalse(File.ReadAllText(Settings.Pkcs11LoggerLogPath2).Contains("Returning 0 (CKR_OK)"));
+
+            // Delete log files
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_FLAG_ENABLE_MMAP flag
+        /// </summary>
+        [Test()]
+        public void EnableMmapTest()
+        {
+            DeleteEnvironmentVariables();
+
+            uint flags = 0;
+            string segmentPath = Settings.Pkcs11LoggerLogPath2 + "." + System.Diagnostics.Process.GetCurrentProcess().Id + ".0";
+
+            // Delete log files
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(segmentPath))
+                File.Delete(segmentPath);
+
+            // Log to Pkcs11LoggerLogPath1 with memory mapped segments disabled
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            flags = flags & ~PKCS11_LOGGER_FLAG_ENABLE_MMAP;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Log to the first segment of Pkcs11LoggerLogPath2 with memory mapped segments enabled
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath2);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_MMAP_SEGMENT_SIZE, "1048576");
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_MMAP;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Segment should be truncated to the logged messages when the library is unloaded
+            ClassicAssert.IsTrue(File.Exists(segmentPath));
+            ClassicAssert.IsTrue(new FileInfo(segmentPath).Length < 1048576);
+            ClassicAssert.IsTrue(File.ReadAllLines(Settings.Pkcs11LoggerLogPath1).Length == File.ReadAllLines(segmentPath).Length);
+
+            // PKCS11_LOGGER_MMAP_SEGMENT_SIZE must contain a positive number
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_MMAP_SEGMENT_SIZE, "0");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log files
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(segmentPath))
+                File.Delete(segmentPath);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_ROTATE_SIZE, PKCS11_LOGGER_ROTATE_COUNT and PKCS11_LOGGER_ROTATE_COMPRESSION environment variables
+        /// </summary>
+        [Test()]
+        public void RotateTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log files
+            for (int i = 0; i <= 3; i++)
+            {
+                string path = (i == 0) ? Settings.Pkcs11LoggerLogPath1 : Settings.Pkcs11LoggerLogPath1 + "." + i;
+                if (File.Exists(path))
+                    File.Delete(path);
+            }
+
+            // Rotate log file after every write and retain two rotated files
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_ROTATE_SIZE, "1");
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_ROTATE_COUNT, "2");
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_ROTATE_COMPRESSION, "none");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Rotated files should be processed when the library is unloaded
+            ClassicAssert.IsTrue(File.Exists(Settings.Pkcs11LoggerLogPath1 + ".1"));
+            ClassicAssert.IsTrue(File.Exists(Settings.Pkcs11LoggerLogPath1 + ".2"));
+            ClassicAssert.IsFalse(File.Exists(Settings.Pkcs11LoggerLogPath1 + ".3"));
+
+            // PKCS11_LOGGER_ROTATE_COMPRESSION must contain supported compression
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_ROTATE_COMPRESSION, "unknown");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log files
+            for (int i = 0; i <= 3; i++)
+            {
+                string path = (i == 0) ? Settings.Pkcs11LoggerLogPath1 : Settings.Pkcs11LoggerLogPath1 + "." + i;
+                if (File.Exists(path))
+                    File.Delete(path);
+            }
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_DURABILITY, PKCS11_LOGGER_FLUSH_RECORDS and PKCS11_LOGGER_FLUSH_INTERVAL environment variables
+        /// </summary>
+        [Test()]
+        public void DurabilityTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log files
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+
+            // Log to Pkcs11LoggerLogPath1 with default durability
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Every durability mode should produce the same log when the library is unloaded
+            foreach (string durability in new string[] { "none", "batch", "exit", "sync" })
+            {
+                if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                    File.Delete(Settings.Pkcs11LoggerLogPath2);
+
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath2);
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_DURABILITY, durability);
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLUSH_RECORDS, "2");
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLUSH_INTERVAL, "10");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                ClassicAssert.IsTrue(File.ReadAllLines(Settings.Pkcs11LoggerLogPath1).Length == File.ReadAllLines(Settings.Pkcs11LoggerLogPath2).Length);
+            }
+
+            // PKCS11_LOGGER_DURABILITY must contain supported durability mode
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_DURABILITY, "unknown");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log files
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_CONTROL_FILE environment variable
+        /// </summary>
+        [Test()]
+        public void ControlFileTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file and control file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+
+            // Use Pkcs11LoggerLogPath2 as control file that does not exist
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_CONTROL_FILE, Settings.Pkcs11LoggerLogPath2);
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Function calls should not be logged
+            ClassicAssert.IsFalse(File.ReadAllText(Settings.Pkcs11LoggerLogPath1).Contains("C_GetInfo"));
+
+            // Create control file
+            File.WriteAllText(Settings.Pkcs11LoggerLogPath2, string.Empty);
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            // Function calls should be logged
+            ClassicAssert.IsTrue(File.ReadAllText(Settings.Pkcs11LoggerLogPath1).Contains("C_GetInfo"));
+
+            // Delete log file and control file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_INCLUDE_FUNCTIONS and PKCS11_LOGGER_EXCLUDE_FUNCTIONS environment variables
+        /// </summary>
+        [Test()]
+        public void FunctionFilterTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Exclude C_GetInfo function
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_EXCLUDE_FUNCTIONS, "C_GetInfo");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            string log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(log.Contains("Entered C_Initialize"));
+            ClassicAssert.IsFalse(log.Contains("Entered C_GetInfo"));
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Include only C_GetInfo function
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_EXCLUDE_FUNCTIONS, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_INCLUDE_FUNCTIONS, "C_GetInfo");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsFalse(log.Contains("Entered C_Initialize"));
+            ClassicAssert.IsTrue(log.Contains("Entered C_GetInfo"));
+
+            // PKCS11_LOGGER_INCLUDE_FUNCTIONS must contain valid function names
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_INCLUDE_FUNCTIONS, "C_GetInfo,C_Unknown");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test case insensitive lookup of function and mechanism names used in the configuration and in the log
+        /// </summary>
+        [Test()]
+        public void NameLookupTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Include only C_GetInfo function specified in lower case
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_INCLUDE_FUNCTIONS, "c_getinfo");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            string log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsFalse(log.Contains("Entered C_Initialize"));
+            ClassicAssert.IsTrue(log.Contains("Entered C_GetInfo"));
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Coalesce mechanisms specified in lower case and by the second name of "CKM_CAST5_ECB or CKM_CAST128_ECB" entry
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_INCLUDE_FUNCTIONS, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_COALESCE_SIZE, "64");
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_COALESCE_MECHANISMS, "ckm_sha_1,CKM_CAST128_ECB");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            {
+                ISlot slot = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0];
+                using (ISession session = slot.OpenSession(SessionType.ReadOnly))
+                {
+                    IMechanism mechanism = session.Factories.MechanismFactory.Create(CKM.CKM_SHA_1);
+                    using (MemoryStream stream = new MemoryStream(new byte[256]))
+                        session.Digest(mechanism, stream, 16);
+                }
+
+                // Note: Mock library does not provide mechanism info but the requested type is logged anyway
+                foreach (CKM type in new CKM[] { (CKM)0x7FFFFFFE, CKM.CKM_CAST128_ECB })
+                {
+                    try
+                    {
+                        slot.GetMechanismInfo(type);
+                    }
+                    catch (Pkcs11Exception)
+                    {
+                    }
+                }
+            }
+
+            log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Note: Part was buffered by the logger").Count == 16);
+            ClassicAssert.IsTrue(log.Contains(" type: 2147483646 (Unknown)"));
+            ClassicAssert.IsTrue(log.Contains(" type: 801 (CKM_CAST5_ECB or CKM_CAST128_ECB)"));
+
+            // PKCS11_LOGGER_COALESCE_MECHANISMS must contain valid mechanism names
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_COALESCE_MECHANISMS, "CKM_SHA_1,CKM_UNKNOWN");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_FLAG_ENABLE_STATS flag
+        /// </summary>
+        [Test()]
+        public void StatsTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Disable latency statistics
+            uint flags = 0;
+            flags = flags & ~PKCS11_LOGGER_FLAG_ENABLE_STATS;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            ClassicAssert.IsFalse(File.ReadAllText(Settings.Pkcs11LoggerLogPath1).Contains("Latency statistics"));
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Enable latency statistics and exclude C_GetInfo function from logging
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_STATS;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_EXCLUDE_FUNCTIONS, "C_GetInfo");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            string log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsFalse(log.Contains("Entered C_GetInfo"));
+            ClassicAssert.IsTrue(log.Contains("Latency statistics"));
+            ClassicAssert.IsTrue(log.Contains("C_GetInfo returning CKR_OK"));
+
+            // PKCS11_LOGGER_STATS_INTERVAL must be a positive number
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_STATS_INTERVAL, "0");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_TIMESTAMP environment variable
+        /// </summary>
+        [Test()]
+        public void TimestampTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Log precise local time
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_TIMESTAMP, "realtime");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            ClassicAssert.IsTrue(Regex.IsMatch(File.ReadAllText(Settings.Pkcs11LoggerLogPath1), @"\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2}\.\d{6} - Entered C_GetInfo"));
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Log monotonic time
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_TIMESTAMP, "monotonic");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            ClassicAssert.IsTrue(Regex.IsMatch(File.ReadAllText(Settings.Pkcs11LoggerLogPath1), @" \d+\.\d{9} - Entered C_GetInfo"));
+
+            // PKCS11_LOGGER_TIMESTAMP must contain valid clock name
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_TIMESTAMP, "utc");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test logging of timestamped messages longer than the buffer owned by the calling thread
+        /// </summary>
+        [Test()]
+        public void LongTimestampedMessageTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Note: Message "YYYY-MM-DD HH:MM:SS.ffffff - Loading library "<path>"" contains 47 characters besides the path so it does not fit into 4096 bytes long buffer from path length 4049
+            string pathPrefix = Path.Combine(Path.GetTempPath(), "pkcs11-logger-missing-");
+            foreach (int length in new int[] { 4047, 4048, 4049, 4050, 10000 })
+            {
+                string libraryPath = pathPrefix + new string('x', length - pathPrefix.Length);
+
+                // Loading of nonexistent library must fail
+                try
+                {
+                    EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, libraryPath);
+                    EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+                    using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                        pkcs11Library.GetInfo();
+
+                    Assert.Fail("Exception expected but not thrown");
+                }
+                catch (Exception ex)
+                {
+                    ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                    ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+                }
+
+                // Check if the whole message has been logged with the timestamp
+                bool found = false;
+                foreach (string line in File.ReadAllLines(Settings.Pkcs11LoggerLogPath1))
+                {
+                    if (line.EndsWith(" - Loading library \"" + libraryPath + "\"") && Regex.IsMatch(line, @"\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2}\.\d{6} - Loading library """))
+                        found = true;
+                }
+
+                ClassicAssert.IsTrue(found);
+
+                // Delete log file
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            }
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_RING_FILE_PATH and PKCS11_LOGGER_RING_SIZE environment variables
+        /// </summary>
+        [Test()]
+        public void RingTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log files
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+
+            // Disable log file and keep the most recent messages in memory ring
+            uint flags = 0;
+            flags = flags | PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_RING_FILE_PATH, Settings.Pkcs11LoggerLogPath2);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            ClassicAssert.IsFalse(File.Exists(Settings.Pkcs11LoggerLogPath1));
+            string ring = File.ReadAllText(Settings.Pkcs11LoggerLogPath2);
+            ClassicAssert.IsTrue(ring.Contains("Entered C_Initialize"));
+            ClassicAssert.IsTrue(ring.Contains("Entered C_GetInfo"));
+            ClassicAssert.IsTrue(ring.Contains("Entered C_Finalize"));
+
+            // Delete ring file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+
+            // Keep only the last few messages in memory ring
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_RING_SIZE, "1024");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                pkcs11Library.GetInfo();
+
+            ring = File.ReadAllText(Settings.Pkcs11LoggerLogPath2);
+            ClassicAssert.IsTrue(ring.Length <= 1024);
+            ClassicAssert.IsFalse(ring.Contains("Entered C_Initialize"));
+            ClassicAssert.IsTrue(ring.Contains("Entered C_Finalize"));
+
+            // PKCS11_LOGGER_RING_SIZE must be a positive number
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_RING_SIZE, "0");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete ring file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath2))
+                File.Delete(Settings.Pkcs11LoggerLogPath2);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_ARENA_SIZE environment variable
+        /// </summary>
+        [Test()]
+        public void ArenaTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Use small arena and log its allocation statistics
+            uint flags = 0;
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_STATS;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_ARENA_SIZE, "16");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            using (ISession session = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0].OpenSession(SessionType.ReadOnly))
+                session.GenerateRandom(256);
+
+            string log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(log.Contains("Entered C_GenerateRandom"));
+            ClassicAssert.IsTrue(log.Contains("Allocation statistics of thread arenas"));
+            ClassicAssert.IsTrue(log.Contains(" Arena size: 16 bytes"));
+            ClassicAssert.IsFalse(log.Contains(" Allocated from heap: 0 times"));
+
+            // PKCS11_LOGGER_ARENA_SIZE must be a number
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_ARENA_SIZE, "large");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_BYTE_ARRAY_HEAD and PKCS11_LOGGER_BYTE_ARRAY_TAIL environment variables and PKCS11_LOGGER_FLAG_ENABLE_CRC32C flag
+        /// </summary>
+        [Test()]
+        public void ByteArrayLimitsTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Log leading and trailing bytes of truncated byte arrays followed by their checksum
+            uint flags = 0;
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_CRC32C;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_BYTE_ARRAY_HEAD, "4");
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_BYTE_ARRAY_TAIL, "2");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            using (ISession session = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0].OpenSession(SessionType.ReadOnly))
+                session.GenerateRandom(256);
+
+            // Note: Input buffer allocated by Pkcs11Interop contains only zeros
+            string log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(log.Contains(" *RandomData: HEX(00000000...0000) CRC32C(B872B190) (256 bytes)"));
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Log only checksum of byte arrays without limits
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_BYTE_ARRAY_HEAD, null);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_BYTE_ARRAY_TAIL, null);
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            using (ISession session = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0].OpenSession(SessionType.ReadOnly))
+                session.GenerateRandom(256);
+
+            log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(log.Contains(" *RandomData: CRC32C(B872B190) (256 bytes)"));
+            ClassicAssert.IsFalse(log.Contains(" *RandomData: HEX("));
+
+            // PKCS11_LOGGER_BYTE_ARRAY_HEAD must be a number
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_BYTE_ARRAY_HEAD, "many");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test hex encoding of byte arrays with lengths around the blocks processed by SIMD encoders
+        /// </summary>
+        [Test()]
+        public void HexEncodingTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Note: Bytes of the seed contain all hex digits in both nibbles
+            const string expectedHex =
+                "0B30557A9FC4E90E33587DA2C7EC11365B80A5CAEF14395E83A8CDF2173C6186" +
+                "ABD0F51A3F6489AED3F81D42678CB1D6FB20456A8FB4D9FE23486D92B7DC0126" +
+                "4B7095BADF04294E7398BDE2072C51769BC0E50A2F54799EC3E80D32577CA1C6" +
+                "EB10355A7FA4C9EE13385D82A7CCF1163B6085AACFF4193E6388ADD2F71C4166" +
+                "8B";
+
+            int[] lengths = new int[] { 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129 };
+
+            byte[] seed = new byte[129];
+            for (int i = 0; i < seed.Length; i++)
+                seed[i] = (byte)(i * 37 + 11);
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Log seeds with lengths just below, at and above 16, 32 and 64 bytes
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            using (ISession session = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0].OpenSession(SessionType.ReadOnly))
+            {
+                foreach (int length in lengths)
+                {
+                    byte[] part = new byte[length];
+                    Array.Copy(seed, part, length);
+                    session.SeedRandom(part);
+                }
+            }
+
+            string[] lines = File.ReadAllLines(Settings.Pkcs11LoggerLogPath1);
+            foreach (int length in lengths)
+            {
+                string expectedLine = " *pSeed: HEX(" + expectedHex.Substring(0, length * 2) + ")";
+                ClassicAssert.IsTrue(Array.Exists(lines, line => line.EndsWith(expectedLine)), "Seed with " + length + " bytes was not encoded correctly");
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_SAMPLE_RATES environment variable
+        /// </summary>
+        [Test()]
+        public void SampleRatesTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Log only every fourth call of random number generation functions and count all of them
+            uint flags = 0;
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_STATS;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_SAMPLE_RATES, "random=4");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            using (ISession session = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0].OpenSession(SessionType.ReadOnly))
+            {
+                for (int i = 0; i < 8; i++)
+                    session.GenerateRandom(16);
+            }
+
+            string log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Entered C_GenerateRandom").Count == 2);
+            ClassicAssert.IsTrue(log.Contains("Entered C_OpenSession"));
+            ClassicAssert.IsTrue(log.Contains(" C_GenerateRandom sampled deterministically 1 in 4: 8 calls, 2 logged"));
+            ClassicAssert.IsTrue(log.Contains(" C_GenerateRandom returning CKR_OK: count 8,"));
+
+            // PKCS11_LOGGER_SAMPLE_RATES must contain known names with positive rates
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_SAMPLE_RATES, "C_Unknown=4");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_LIMIT_CALLS environment variable
+        /// </summary>
+        [Test()]
+        public void LimitCallsTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Log at most one call of random number generation functions per second
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(0));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIMIT_CALLS, "random=1");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            using (ISession session = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0].OpenSession(SessionType.ReadOnly))
+            {
+                for (int i = 0; i < 8; i++)
+                    session.GenerateRandom(16);
+            }
+
+            string log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Entered C_GenerateRandom").Count == 1);
+            ClassicAssert.IsTrue(log.Contains("Entered C_OpenSession"));
+            ClassicAssert.IsTrue(log.Contains("*** 7 calls of C_GenerateRandom were suppressed by the rate limit ***"));
+
+            // PKCS11_LOGGER_LIMIT_CALLS must contain known names with numbers of calls
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIMIT_CALLS, "C_Unknown=1");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_CACHE_TTL environment variable
+        /// </summary>
+        [Test()]
+        public void CacheTtlTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Answer repeated calls from the cache and count hits and misses
+            uint flags = 0;
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_STATS;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_CACHE_TTL, "3600");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            {
+                ISlot slot = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0];
+                for (int i = 0; i < 3; i++)
+                    slot.GetSlotInfo();
+            }
+
+            string log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Entered C_GetSlotInfo").Count == 3);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Note: Response was returned from the cache").Count == 2);
+            ClassicAssert.IsTrue(log.Contains(" C_GetSlotInfo: 2 hits, 1 misses"));
+
+            // PKCS11_LOGGER_CACHE_TTL must be a positive number
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_CACHE_TTL, "0");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_CACHE_TTL environment variable with disabled log file
+        /// </summary>
+        [Test()]
+        public void CacheTtlWithoutLogFileTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Cache must stay in effect even when logged messages cannot reach any output
+            uint flags = 0;
+            flags = flags | PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_CACHE_TTL, "3600");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            {
+                ISlot slot = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0];
+
+                // Cached response does not provide count of sessions
+                ITokenInfo tokenInfo1 = slot.GetTokenInfo();
+                ITokenInfo tokenInfo2 = slot.GetTokenInfo();
+                ClassicAssert.IsTrue(tokenInfo1.SessionCount != tokenInfo2.SessionCount);
+            }
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_FLAG_ENABLE_ATTR_CACHE flag
+        /// </summary>
+        [Test]
+        public void AttributeCacheTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Attributes that can be modified must always be read from the original library
+            uint flags = 0;
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_STATS;
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_ATTR_CACHE;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_CACHE_TTL, "3600");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            {
+                ISlot slot = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0];
+                using (ISession session = slot.OpenSession(SessionType.ReadOnly))
+                {
+                    List<IObjectAttribute> template = new List<IObjectAttribute>();
+                    template.Add(session.Factories.ObjectAttributeFactory.Create(CKA.CKA_CLASS, CKO.CKO_DATA));
+                    List<IObjectHandle> objects = session.FindAllObjects(template);
+                    ClassicAssert.IsTrue(objects.Count > 0);
+
+                    for (int i = 0; i < 2; i++)
+                        session.GetAttributeValue(objects[0], new List<CKA>() { CKA.CKA_LABEL });
+                }
+            }
+
+            string log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Entered C_GetAttributeValue").Count == 4);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Note: Response was returned from the cache").Count == 0);
+            ClassicAssert.IsTrue(!log.Contains(" C_GetAttributeValue: "));
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_FLAG_ENABLE_FIND_CACHE flag
+        /// </summary>
+        [Test]
+        public void FindCacheTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Answer repeated search from the cache until an object is created
+            uint flags = 0;
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_STATS;
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_FIND_CACHE;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_CACHE_TTL, "3600");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            {
+                ISlot slot = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0];
+                using (ISession session = slot.OpenSession(SessionType.ReadWrite))
+                {
+                    List<IObjectAttribute> template = new List<IObjectAttribute>();
+                    template.Add(session.Factories.ObjectAttributeFactory.Create(CKA.CKA_CLASS, CKO.CKO_DATA));
+                    template.Add(session.Factories.ObjectAttributeFactory.Create(CKA.CKA_LABEL, "Pkcs11Interop"));
+
+                    int count = session.FindAllObjects(template).Count;
+                    ClassicAssert.IsTrue(session.FindAllObjects(template).Count == count);
+
+                    session.CreateObject(template);
+                    session.FindAllObjects(template);
+                }
+            }
+
+            string log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Entered C_FindObjectsInit").Count == 3);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Note: Response was returned from the cache").Count > 0);
+            ClassicAssert.IsTrue(log.Contains(" C_FindObjectsInit: 1 hits, 2 misses"));
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_POOL_SIZE environment variable
+        /// </summary>
+        [Test()]
+        public void PoolSizeTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Lease sessions returned to the pool instead of opening new ones
+            uint flags = 0;
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_STATS;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_POOL_SIZE, "1");
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_POOL_IDLE_TIMEOUT, "3600");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            {
+                ISlot slot = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0];
+                for (int i = 0; i < 3; i++)
+                {
+                    using (ISession session = slot.OpenSession(SessionType.ReadOnly))
+                        session.GetSessionInfo();
+                }
+            }
+
+            string log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Entered C_OpenSession").Count == 3);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Note: Session was leased from the pool").Count == 2);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Note: Session was returned to the pool").Count == 3);
+            ClassicAssert.IsTrue(log.Contains(" Opened in the original library: 1"));
+
+            // PKCS11_LOGGER_POOL_SIZE must be a positive number
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_POOL_SIZE, "0");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_POOL_SIZE environment variable with disabled log file
+        /// </summary>
+        [Test()]
+        public void PoolSizeWithoutLogFileTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Pool must stay in effect even when logged messages cannot reach any output
+            uint flags = 0;
+            flags = flags | PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_POOL_SIZE, "1");
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_POOL_IDLE_TIMEOUT, "3600");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            {
+                ISlot slot = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0];
+
+                // Session leased from the pool keeps the handle of the session opened in the original library
+                List<ulong> sessionIds = new List<ulong>();
+                for (int i = 0; i < 3; i++)
+                {
+                    using (ISession session = slot.OpenSession(SessionType.ReadOnly))
+                        sessionIds.Add(session.SessionId);
+                }
+
+                ClassicAssert.IsTrue(sessionIds[0] == sessionIds[1]);
+                ClassicAssert.IsTrue(sessionIds[0] == sessionIds[2]);
+            }
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_COALESCE_SIZE environment variable
+        /// </summary>
+        [Test()]
+        public void CoalesceSizeTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+
+            // Pass small updates to the original library in larger chunks
+            uint flags = 0;
+            flags = flags | PKCS11_LOGGER_FLAG_ENABLE_STATS;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LOG_FILE_PATH, Settings.Pkcs11LoggerLogPath1);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_COALESCE_SIZE, "64");
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_COALESCE_MECHANISMS, "CKM_SHA_1");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            {
+                ISlot slot = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0];
+                using (ISession session = slot.OpenSession(SessionType.ReadOnly))
+                {
+                    IMechanism mechanism = session.Factories.MechanismFactory.Create(CKM.CKM_SHA_1);
+                    byte[] data = new byte[256];
+
+                    byte[] digest = session.Digest(mechanism, data);
+                    using (MemoryStream stream = new MemoryStream(data))
+                        ClassicAssert.IsTrue(Convert.ToBase64String(session.Digest(mechanism, stream, 16)) == Convert.ToBase64String(digest));
+                }
+            }
+
+            string log = File.ReadAllText(Settings.Pkcs11LoggerLogPath1);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Entered C_DigestUpdate").Count == 16);
+            ClassicAssert.IsTrue(Regex.Matches(log, "Note: Part was buffered by the logger").Count == 16);
+            ClassicAssert.IsTrue(log.Contains("Note: 16 updates of the session were passed to the original library in 4 calls"));
+            ClassicAssert.IsTrue(log.Contains(" Passed to the original library: 4 calls with 256 bytes"));
+
+            // PKCS11_LOGGER_COALESCE_SIZE must be a positive number
+            try
+            {
+                EnvVarUtils.SetEnvVar(PKCS11_LOGGER_COALESCE_SIZE, "0");
+                using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+                    pkcs11Library.GetInfo();
+
+                Assert.Fail("Exception expected but not thrown");
+            }
+            catch (Exception ex)
+            {
+                ClassicAssert.IsTrue(ex is Pkcs11Exception);
+                ClassicAssert.IsTrue(((Pkcs11Exception)ex).RV == CKR.CKR_GENERAL_ERROR);
+            }
+
+            // Delete log file
+            if (File.Exists(Settings.Pkcs11LoggerLogPath1))
+                File.Delete(Settings.Pkcs11LoggerLogPath1);
+        }
+
+        /// <summary>
+        /// Test PKCS11_LOGGER_COALESCE_SIZE environment variable with disabled log file
+        /// </summary>
+        [Test()]
+        public void CoalesceSizeWithoutLogFileTest()
+        {
+            DeleteEnvironmentVariables();
+
+            // Coalescing must stay in effect even when logged messages cannot reach any output
+            uint flags = 0;
+            flags = flags | PKCS11_LOGGER_FLAG_DISABLE_LOG_FILE;
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_LIBRARY_PATH, Settings.Pkcs11LibraryPath);
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_FLAGS, Convert.ToString(flags));
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_COALESCE_SIZE, "64");
+            EnvVarUtils.SetEnvVar(PKCS11_LOGGER_COALESCE_MECHANISMS, "CKM_SHA_1");
+            using (IPkcs11Library pkcs11Library = Settings.Pkcs11InteropFactories.Pkcs11LibraryFactory.LoadPkcs11Library(Settings.Pkcs11InteropFactories, Settings.Pkcs11LoggerLibraryPath, AppType.MultiThreaded))
+            {
+                ISlot slot = pkcs11Library.GetSlotList(SlotsType.WithTokenPresent)[0];
+                using (ISession session = slot.OpenSession(SessionType.ReadOnly))
+                {
+                    IMechanism mechanism = session.Factories.MechanismFactory.Create(CKM.CKM_SHA_1);
+                    byte[] data = new byte[256];
+
+                    // Buffered parts must be passed to the original library before the operation is finished
+                    byte[] digest = session.Digest(mechanism, data);
+                    using (MemoryStream stream = new MemoryStream(data))
+                        ClassicAssert.IsTrue(Convert.ToBase64String(session.Digest(mechanism, stream, 16)) == Convert.ToBase64String(digest));
+                    using (MemoryStream stream = new MemoryStream(data))
+                        ClassicAssert.IsTrue(Convert.ToBase64String(session.Digest(mechanism, stream, 100)) == Convert.ToBase64String(digest));
+                }
+            }
+        }
     }
 }